@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include "../ini/syntax_tree.hpp"
+#include "../vfs/layered_file_system.hpp"
+#include "workspace_index.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// A line of an effective definition and where it was written
+struct EffectiveField {
+    std::string token;  // field name
+    std::string value;  // tokens after the name, space separated
+    std::string uri;
+    LSP::Range range;   // the field line (the header line of a nested block)
+};
+
+// A module of an effective Object
+struct EffectiveModule {
+    std::string field;  // "Behavior", "Body", "Draw" or "ClientUpdate"
+    std::string name;   // module name
+    std::string tag;
+    std::string uri;
+    LSP::Range range;   // the header line
+    bool inherited = false;               // copied from DefaultThingTemplate, a reskin source or an earlier layer
+    bool inheritable = false;             // declared in an InheritableModule block
+    bool overrideableByLikeKind = false;  // declared in an OverrideableByLikeKind block
+    std::vector<EffectiveField> fields;   // last value of each field; nested blocks are all kept
+
+    // Last value of a field, or nullptr
+    const EffectiveField* findField(std::string_view token) const;
+};
+
+// An Object as the engine holds it once every layer that defines it is loaded
+struct EffectiveObject {
+    std::string name;
+    std::string reskinOf;                // source of the ObjectReskin the object was last copied from
+    std::vector<LSP::Location> layers;   // names of the blocks folded in, copied templates' first
+    std::vector<EffectiveField> fields;  // last value of each field; ArmorSet, WeaponSet and Prerequisites keep every block
+    std::vector<EffectiveModule> modules;
+
+    // Last value of a field, or nullptr
+    const EffectiveField* findField(std::string_view token) const;
+
+    // Module by tag, or nullptr
+    const EffectiveModule* findModule(std::string_view tag) const;
+};
+
+// Where the engine loads a file
+struct LoadPosition {
+    uint32_t rank;  // see LayeredFileSystem::loadRank
+    Vfs::LoadMode mode;
+};
+
+// Folds every Object and ObjectReskin block of a name into the template the
+// engine ends up with, the way ThingFactory::parseObjectDefinition applies
+// them in load order: a new template starts as a copy of
+// DefaultThingTemplate and a reskin as a copy of its source, each as it
+// stands when the block is loaded; an override (INI_LOAD_CREATE_OVERRIDES)
+// starts as a copy of the template so far, and a repeated block in an
+// ordinary load continues the existing one. Copied modules are dropped when a block adds one of the same kind
+// unless they are inheritable; AddModule, RemoveModule and ReplaceModule
+// edit the module list by tag. The engine clears copied modules by
+// interface mask, which the schema does not record: Draw, ClientUpdate and
+// Body modules are taken to share an interface with their own kind and
+// Behavior modules with modules of the same name.
+//
+// Results are memoized per name together with the files and names they
+// were read from, so an edit drops only the objects that read the file and
+// the objects copied from those, transitively; refresh() evaluates the
+// dropped objects again ahead of the requests that read them. Files are
+// read and parsed without holding the lock invalidateFile takes, and only
+// the most recently used trees are kept. All methods may be called from
+// any thread.
+class DefinitionEvaluator {
+public:
+    // Current syntax tree of a file, or nullptr when it cannot be read
+    using TreeSource = std::function<std::shared_ptr<const Ini::SyntaxTree>(const std::string& uri)>;
+
+    // Load position of a file, or nullopt when the engine never loads it
+    using LoadSource = std::function<std::optional<LoadPosition>(const std::string& uri)>;
+
+    DefinitionEvaluator(const WorkspaceIndex& index, TreeSource trees, LoadSource loads);
+
+    // The effective Object name, or nullptr when no block defines it. When
+    // some blocks are in files the engine loads, the others are ignored;
+    // otherwise every block is folded in index order as INI_LOAD_OVERWRITE.
+    std::shared_ptr<const EffectiveObject> evaluate(const std::string& name);
+
+    // The memoized result for name, or nullptr when it is not evaluated yet
+    std::shared_ptr<const EffectiveObject> find(const std::string& name) const;
+
+    // Evaluate the objects invalidateFile dropped since the last call
+    void refresh();
+
+    // Drop results that depend on a file; names are the definitions the
+    // file holds now, which may be new to objects evaluated before
+    void invalidateFile(const std::string& uri, const std::vector<std::string>& names);
+
+    // Drop every result, e.g. after the load order changed
+    void clear();
+
+    // Number of memoized objects
+    size_t cachedCount() const;
+
+private:
+    struct Fold;
+
+    // Where a block is read: by rank in files the engine loads, by uri otherwise
+    struct BlockPosition {
+        std::optional<uint32_t> rank;
+        std::string uri;
+        int line;
+    };
+
+    // Trees an evaluation has read, and those it needed but found neither
+    // there nor in the cache
+    struct Pass {
+        std::unordered_map<std::string, std::shared_ptr<const Ini::SyntaxTree>> trees;
+        std::vector<std::string> missing;
+    };
+
+    struct CachedTree {
+        std::shared_ptr<const Ini::SyntaxTree> tree;
+        uint64_t lastUse;
+    };
+
+    // Caller holds mutex_. With before, only the blocks loaded before that
+    // position are folded, as a reskin or new template copies its source in
+    // the state it has at that point; such partial results are not memoized,
+    // and neither are results of a pass with missing trees.
+    std::shared_ptr<const EffectiveObject> evaluateLocked(const std::string& name, Pass& pass,
+                                                          const BlockPosition* before = nullptr);
+    std::shared_ptr<const Ini::SyntaxTree> treeLocked(const std::string& uri, Pass& pass);
+    void cacheTreeLocked(const std::string& uri, std::shared_ptr<const Ini::SyntaxTree> tree);
+
+    const WorkspaceIndex& index_;
+    TreeSource trees_;
+    LoadSource loads_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const EffectiveObject>> objects_;
+    std::unordered_map<std::string, CachedTree> treeCache_;
+    uint64_t treeClock_ = 0;                                                       // lastUse of the next cache hit
+    uint64_t epoch_ = 0;                                                           // bumped whenever a file is invalidated
+    std::unordered_set<std::string> stale_;                                        // dropped names refresh() has not evaluated
+    std::unordered_map<std::string, std::unordered_set<std::string>> readers_;     // uri -> names folded from it
+    std::unordered_map<std::string, std::unordered_set<std::string>> dependents_;  // name -> names copied from it
+    std::unordered_set<std::string> evaluating_;                                   // names on the stack, to break cycles
+};
+
+} // namespace ZeroSyntax
@@ -2,6 +2,16 @@
 #pragma once
 
 #include "../protocol/lsp_messages.hpp"
+#include "../ini/syntax_tree.hpp"
+#include "piece_table.hpp"
+#include "workspace_index.hpp"
+#include "definition_evaluator.hpp"
+#include "ini_checksum.hpp"
+#include "map_index.hpp"
+#include "../vfs/layered_file_system.hpp"
+#include "../text/string_table.hpp"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -9,6 +19,10 @@
 
 namespace ZeroSyntax {
 
+// Owns the open documents. Documents are immutable once published: every
+// change builds a new Document (cheap, the PieceTable is shared) and swaps
+// it in under a lock, so the query methods may run on worker threads while
+// the protocol thread applies edits.
 class DocumentManager {
 public:
     DocumentManager();
@@ -19,6 +33,10 @@ public:
     // Update document content
     void updateDocument(const std::string& uri, int version, const std::string& text);
     
+    // Apply incremental content changes in order; a change without a range replaces the whole text
+    void applyChanges(const std::string& uri, int version,
+                      const std::vector<LSP::TextDocumentContentChangeEvent>& changes);
+    
     // Remove a document when it's closed
     void removeDocument(const std::string& uri);
     
@@ -28,30 +46,169 @@ public:
     // Check if a document exists
     bool hasDocument(const std::string& uri) const;
     
-    // Parse and validate the current document
+    // Syntax tree of the current version of a document, or nullptr
+    std::shared_ptr<const Ini::SyntaxTree> getSyntaxTree(const std::string& uri) const;
+    
+    // Check the current document against the schema (see Ini::validateTree) and the string table
     std::vector<LSP::Diagnostic> validateDocument(const std::string& uri);
     
-    // Find definition at the given position
+    // Check every string table label the workspace uses in one pass: a label
+    // the table lacks is a warning where it is used (the game shows
+    // "MISSING: 'label'"), and a label no INI file uses is a hint in
+    // Generals.str when the workspace holds it. Diagnostics are keyed by uri;
+    // nothing is reported while no string table is loaded.
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> validateLabels() const;
+    
+    // Missing label warnings of one INI file, open or not
+    std::vector<LSP::Diagnostic> validateLabels(const std::string& uri) const;
+    
+    // Check the thing templates every map in the workspace places, and the
+    // objects, upgrades, sciences and special powers its scripts name,
+    // against the definitions of the workspace and of the archived INI files,
+    // in one join per store over the maps' name sets (see MapIndex); a name
+    // no file defines is a warning on the map, as are script teams and
+    // waypoints the map lacks. Diagnostics are keyed by map uri and every
+    // map has an entry, so fixed maps are cleared.
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> validateMaps() const;
+    
+    // Read a map again if it changed on disk, or drop it if it is gone, and check it
+    std::vector<LSP::Diagnostic> refreshMap(const std::string& uri);
+    
+    // Index an INI file again after it changed on disk; an open document keeps its editor contents
+    void refreshFile(const std::string& uri);
+    
+    // Index the definitions of every INI file below a workspace root; open
+    // documents keep the definitions of their editor contents. A cache path
+    // reuses and refreshes an IndexCache from an earlier session. The game
+    // files are the workspace's loose files over its archives, then over the
+    // archives of each game directory; the string table is read from them
+    // in the given language, and the maps below the root are indexed too.
+    // Call before serving queries.
+    void indexWorkspace(const std::string& rootPath, const std::string& cachePath = {},
+                        const std::vector<std::string>& gameDirectories = {},
+                        const std::string& language = "English");
+    
+    // Definitions of the whole workspace, including open documents
+    const WorkspaceIndex& workspaceIndex() const { return index_; }
+    
+    // The game's files as the engine resolves them
+    const Vfs::LayeredFileSystem& gameFiles() const { return files_; }
+    
+    // Thing templates the workspace's maps place
+    const MapIndex& mapIndex() const { return maps_; }
+    
+    // The INI CRC multiplayer games compare, over the game files as indexed
+    const IniChecksum& iniChecksum() const { return checksum_; }
+    
+    // Hash a saved file again when the INI CRC covers it; false when it does not
+    bool refreshIniChecksum(const std::string& uri);
+    
+    // The game's strings (DisplayName labels and the like); empty until a workspace is indexed
+    std::shared_ptr<const Text::StringTable> stringTable() const;
+    
+    // The Object name as the engine assembles it from every layer, or nullptr
+    std::shared_ptr<const EffectiveObject> effectiveObject(const std::string& name);
+    
+    // Evaluate the Objects edits have dropped, so effectiveField finds them
+    // memoized; run off the protocol thread, as it may parse closed files
+    void refreshDefinitions();
+    
+    // The value in effect for the Object or module field at the given
+    // position, which may come from a later layer than the line under the
+    // cursor. Only memoized Objects are read: nullopt until refreshDefinitions
+    // has evaluated the Object.
+    std::optional<EffectiveField> effectiveField(const std::string& uri, const LSP::Position& position);
+    
+    // Find the definition at the given position that the engine ends up
+    // using: the one in the file it loads last
     std::optional<LSP::Location> findDefinition(const std::string& uri, const LSP::Position& position);
     
-    // Provide completions at the given position
-    std::vector<LSP::CompletionItem> provideCompletions(const std::string& uri, const LSP::Position& position);
+    // Definitions (when includeDeclaration) and use sites of the symbol at the given position
+    std::vector<LSP::Location> findReferences(const std::string& uri, const LSP::Position& position,
+                                              bool includeDeclaration);
+    
+    // Completions at the given position (see Ini::completionContext): schema
+    // names, workspace definitions for fields that name one, and string table
+    // labels for label fields. Once something is typed, names are ranked by
+    // Text::FuzzyMatcher (labels still go by prefix). Incomplete when there
+    // are more than fit in one response, so the client asks again as the
+    // prefix grows.
+    LSP::CompletionList provideCompletions(const std::string& uri, const LSP::Position& position);
+    
+    // Markdown about the token at the given position: for a field, its
+    // parse proc, its value as the engine stores it (Ini::convertedValue),
+    // the value in effect when a later layer sets it and the file that does;
+    // the label's text for label fields; where a header or a reference is
+    // defined. Reads only the document snapshot, the index, the string table
+    // and the evaluator's memoized objects.
+    std::optional<LSP::Hover> hover(const std::string& uri, const LSP::Position& position);
     
 private:
     // Document storage
     struct Document {
         std::string uri;
-        std::string text;
+        PieceTable text;
         std::string languageId;
         int version;
-        
-        // Parsed representation could be added here
+        std::shared_ptr<const Ini::SyntaxTree> syntax;
+    };
+    
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Document>> documents_;
+    WorkspaceIndex index_;
+    Vfs::LayeredFileSystem files_;
+    DefinitionEvaluator evaluator_;
+    IniChecksum checksum_;
+    MapIndex maps_;
+    StoreNames archivedNames_;  // what the archived INI files define, of the stores maps name
+    std::shared_ptr<const Text::StringTable> strings_;
+    std::string stringsUri_;  // the loose Generals.str strings_ was read from, or empty
+    
+    // Snapshot of the current version of a document, or nullptr
+    std::shared_ptr<const Document> findDocument(const std::string& uri) const;
+    
+    // Make a new version of a document visible to readers
+    void publishDocument(std::shared_ptr<const Document> document);
+    
+    // A name under the cursor and the store it belongs to
+    struct SymbolQuery {
+        std::string_view blockType;  // schema-owned; empty when the field is not typed
+        std::string name;
     };
     
-    std::unordered_map<std::string, Document> documents_;
+    // The definition name at a position, or nullopt when the token there names nothing
+    std::optional<SymbolQuery> symbolAt(const Document& document, const LSP::Position& position) const;
+    
+    // The definition loaded last (see LayeredFileSystem::loadRank); definitions
+    // must be non-empty and ordered by file and position
+    const Definition& effectiveDefinition(const std::vector<Definition>& definitions) const;
+    
+    // "`Data/INI/Object/Tank.ini` line 3 (load order 12 of 40, INI_LOAD_OVERWRITE)"
+    std::string describeLocation(const std::string& uri, const LSP::Position& position) const;
+    
+    // Read the string table the way GameTextManager::init picks it: Data/Generals.str
+    // when the game files hold one, Data/<language>/Generals.csf otherwise
+    void loadStringTable(const std::string& language);
+    
+    // Definitions of the INI files the engine reads from archives, which the
+    // workspace index does not cover
+    void indexArchivedDefinitions();
+    
+    // Of names by store, the ones no definition has
+    StoreNames missingDefinitions(const StoreNames& names) const;
+    
+    // Warnings for the uses whose label the table lacks; returns the index of each use's label
+    static std::vector<uint32_t> addMissingLabels(const std::vector<Reference>& uses, const Text::StringTable& table,
+                                                  std::unordered_map<std::string, std::vector<LSP::Diagnostic>>& diagnostics);
     
     // INI file parsing helpers
     void parseIniDocument(Document& document);
+    
+    // Syntax tree of an open document or of a file on disk, or nullptr
+    std::shared_ptr<const Ini::SyntaxTree> loadSyntaxTree(const std::string& uri) const;
+    
+    // Replace the workspace index entries of a document with its current definitions
+    void indexDocument(const Document& document);
 };
 
 } // namespace ZeroSyntax
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "workspace_index.hpp"
+#include "../utils/mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// What the cache knows about a file on disk. A file whose modification time
+// and size still match is reused without being read; one that changed is
+// read and reused if its contents hash the same.
+struct FileStamp {
+    int64_t modified;  // filesystem clock ticks
+    uint64_t size;
+    uint64_t hash;     // IndexCache::contentHash of the contents
+};
+
+struct CachedFile {
+    std::string uri;
+    FileStamp stamp;
+    FileSymbols symbols;
+};
+
+// On-disk snapshot of the workspace index, so reopening a workspace only
+// parses the files that changed since the last session.
+//
+// The file is a header followed by fixed-size file records (sorted by uri),
+// symbol records and one string blob, in native byte order; it is mapped
+// read-only and used in place. A cache written by another format version or
+// for another schema (references depend on the field tables) is ignored.
+class IndexCache {
+public:
+    static constexpr uint32_t kVersion = 2;
+
+    // Map a cache file; false, leaving the cache empty, when it is missing,
+    // damaged or stale
+    bool load(const std::string& path);
+
+    // Record of a file, or nullopt
+    std::optional<size_t> findFile(std::string_view uri) const;
+
+    FileStamp stamp(size_t file) const;
+
+    // Definitions, references and labels recorded for a file
+    FileSymbols symbols(size_t file) const;
+
+    size_t fileCount() const { return fileCount_; }
+
+    // Write a cache file; the previous one is replaced only once the new one is complete
+    static bool write(const std::string& path, const std::vector<CachedFile>& files);
+
+    // 64-bit FNV-1a of a file's contents
+    static uint64_t contentHash(std::string_view text);
+
+    // Per-user cache file for a workspace root
+    static std::string defaultPath(const std::string& root);
+
+private:
+    void clear();
+
+    MappedFile file_;
+    const char* data_ = nullptr;
+    size_t fileCount_ = 0;
+    size_t symbolCount_ = 0;
+};
+
+} // namespace ZeroSyntax
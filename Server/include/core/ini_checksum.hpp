@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../vfs/layered_file_system.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// The INI CRC of a game data set (see Ini::appendCrcTerms): every checksummed
+// file of the load order as the engine resolves it, in load order. Each
+// file's terms and the state before it are kept, so a changed file is hashed
+// again on its own and the fold resumes from it, stopping early once a state
+// matches the one it had before. All methods may be called from any thread.
+class IniChecksum {
+public:
+    // Read every checksummed file of files' load order; files the game
+    // cannot open are left out (the engine would fail to start)
+    void rebuild(const Vfs::LayeredFileSystem& files);
+
+    // Hash a checksummed game path again with the given contents; false
+    // when the path is not part of the checksum
+    bool update(std::string_view path, std::string_view text);
+
+    // As XferCRC::getCRC returns it (GlobalData::m_iniCRC)
+    uint32_t value() const;
+
+    // Number of files hashed
+    size_t fileCount() const;
+
+private:
+    struct File {
+        std::string path;
+        std::vector<uint32_t> terms;
+        uint32_t before;  // XferCRC state before the file
+    };
+
+    // Caller holds mutex_. Fold again from file first on, which starts from its kept state.
+    void refold(size_t first);
+
+    mutable std::mutex mutex_;
+    std::vector<File> files_;
+    std::unordered_map<std::string, size_t> positions_;
+    uint32_t state_ = 0;  // after the last file
+};
+
+} // namespace ZeroSyntax
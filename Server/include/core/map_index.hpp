@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+
+namespace Map {
+class MapFile;
+}
+
+// A thing template a map places, and how many times
+struct PlacedTemplate {
+    std::string name;
+    uint32_t count = 0;
+};
+
+// A definition the scripts of a map name
+struct ScriptReference {
+    std::string blockType;  // the store: Object, Upgrade, Science or SpecialPower
+    std::string name;
+    std::string script;     // the first script naming it
+    uint32_t count = 0;
+};
+
+// What the scripts of a map name: definitions, sorted by store and name,
+// and warnings for the teams and waypoints they name that the map lacks
+struct ScriptCheck {
+    std::vector<ScriptReference> references;
+    std::vector<LSP::Diagnostic> warnings;
+};
+
+// Names, sorted and each once, by the store that defines them
+using StoreNames = std::map<std::string, std::vector<std::string>>;
+
+// The thing templates every map (*.map) in the workspace places, and the
+// definitions its scripts name. A map is read once: its placements and
+// script parameters are reduced to sorted sets of names, and only those are
+// kept, along with the file's modification time and size so an unchanged
+// map is never read again. Checking the maps against the INI definitions
+// then joins these sets, not the maps. All methods may be called from any
+// thread.
+class MapIndex {
+public:
+    // Templates the objects of a map name, sorted, each once. Waypoints,
+    // lights, scorch marks, roads and bridges are map objects without one
+    // (see WorldHeightMap::ParseObjectData).
+    static std::vector<PlacedTemplate> collect(const Map::MapFile& map);
+
+    // Decode the scripts of a map and reduce them to what their parameters
+    // name. Teams and waypoints are checked against the map here; names the
+    // engine makes up ("<This Team>") and object type lists the scripts
+    // build are not references.
+    static ScriptCheck checkScripts(const Map::MapFile& map);
+
+    // Read every map below root in parallel; returns the number indexed
+    size_t indexDirectory(const std::string& root, size_t threadCount = 0);
+
+    // Read a map again if its modification time or size changed, or drop it
+    // if it no longer exists; false when what it names is unchanged
+    bool indexFile(const std::string& uri);
+
+    // Replace the templates and script references of a map
+    void updateFile(const std::string& uri, std::vector<PlacedTemplate> templates, ScriptCheck scripts = {});
+
+    void removeFile(const std::string& uri);
+
+    // Every definition some map places or names in a script. Placed
+    // templates are in the Object store.
+    StoreNames referencedNames() const;
+
+    // Definitions one map places or names
+    StoreNames referencedNames(const std::string& uri) const;
+
+    // Templates one map places, sorted
+    std::vector<PlacedTemplate> templates(const std::string& uri) const;
+
+    // Script references of one map
+    ScriptCheck scripts(const std::string& uri) const;
+
+    // Warnings for the placements and script references of missing
+    // definitions (from a join of referencedNames() with the definitions),
+    // and for the teams and waypoints scripts name that their map lacks,
+    // keyed by map uri. Every map has an entry, empty when it is sound, so
+    // warnings a map no longer deserves are cleared.
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> diagnose(const StoreNames& missing) const;
+
+    // Warnings of one map
+    std::vector<LSP::Diagnostic> diagnose(const std::string& uri, const StoreNames& missing) const;
+
+    size_t fileCount() const;
+
+private:
+    struct Entry {
+        int64_t modified = 0;  // filesystem clock ticks
+        uint64_t size = 0;
+        std::vector<PlacedTemplate> templates;
+        ScriptCheck scripts;
+    };
+
+    // Read the placements and scripts of a map into an entry
+    static void read(const std::string& path, Entry& entry);
+    static void addNames(const Entry& entry, StoreNames& names);
+    static std::vector<LSP::Diagnostic> diagnose(const Entry& entry, const StoreNames& missing);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> maps_;
+};
+
+} // namespace ZeroSyntax
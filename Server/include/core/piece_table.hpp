@@ -0,0 +1,151 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// Text storage for open documents.
+//
+// A document is a sequence of pieces, each referencing a slice of an
+// immutable buffer: either the text the document was opened with or the
+// text of a later insert. Pieces are kept in a treap augmented with byte and
+// line feed counts, so edits and line/column <-> offset conversions cost
+// O(log n) in the number of pieces rather than O(size of the document).
+//
+// Nodes and buffers are never modified after creation, which makes copying a
+// PieceTable O(1); the copy is an independent snapshot of the text.
+class PieceTable {
+public:
+    PieceTable();
+    explicit PieceTable(std::string text);
+
+    // Size of the document in bytes
+    size_t length() const;
+
+    // Number of lines (line feeds + 1)
+    size_t lineCount() const;
+
+    // Byte offset of the first character of a line; lines past the end map to length()
+    size_t lineOffset(size_t line) const;
+
+    // Convert an LSP position (column in UTF-16 code units) to a byte offset.
+    // Columns past the end of the line are clamped to the line end.
+    size_t offsetAt(const LSP::Position& position) const;
+
+    // Convert a byte offset to an LSP position
+    LSP::Position positionAt(size_t offset) const;
+
+    // Edit operations
+    void insert(size_t offset, std::string_view text);
+    void erase(size_t offset, size_t count);
+    void replace(size_t offset, size_t count, std::string_view text);
+    void replace(const LSP::Range& range, std::string_view text);
+
+    // Read access
+    std::string text() const;
+    std::string substr(size_t offset, size_t count) const;
+    char at(size_t offset) const;
+
+    // Visit the contiguous chunks covering [offset, offset + count) in order.
+    // The visitor takes a std::string_view and returns false to stop early.
+    template <typename Visitor>
+    void forEachChunk(size_t offset, size_t count, Visitor&& visitor) const;
+
+    // Number of pieces, mostly useful for tests and diagnostics
+    size_t pieceCount() const;
+
+private:
+    struct Buffer {
+        std::string text;
+        std::vector<size_t> lineStarts;  // offset just past every '\n'
+    };
+
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        std::shared_ptr<const Buffer> buffer;
+        size_t start;
+        size_t length;
+        size_t lineFeeds;
+        uint64_t priority;
+        NodePtr left;
+        NodePtr right;
+
+        // Aggregates over the subtree rooted at this node
+        size_t totalLength;
+        size_t totalLineFeeds;
+        size_t totalPieces;
+    };
+
+    static size_t lengthOf(const NodePtr& node) { return node ? node->totalLength : 0; }
+    static size_t lineFeedsOf(const NodePtr& node) { return node ? node->totalLineFeeds : 0; }
+    static size_t piecesOf(const NodePtr& node) { return node ? node->totalPieces : 0; }
+
+    static std::shared_ptr<const Buffer> makeBuffer(std::string text);
+    static size_t countLineFeeds(const Buffer& buffer, size_t begin, size_t end);
+    static NodePtr makeNode(std::shared_ptr<const Buffer> buffer, size_t start, size_t length,
+                            uint64_t priority, NodePtr left, NodePtr right);
+    static NodePtr withChildren(const NodePtr& node, NodePtr left, NodePtr right);
+    static NodePtr merge(const NodePtr& left, const NodePtr& right);
+
+    std::pair<NodePtr, NodePtr> split(const NodePtr& node, size_t offset);
+    uint64_t nextPriority();
+
+    // Number of line feeds in [0, offset)
+    size_t lineFeedsBefore(size_t offset) const;
+
+    template <typename Visitor>
+    static bool visitChunks(const Node* node, size_t base, size_t begin, size_t end, Visitor& visitor);
+
+    NodePtr root_;
+    uint64_t prioritySeed_;
+};
+
+template <typename Visitor>
+void PieceTable::forEachChunk(size_t offset, size_t count, Visitor&& visitor) const {
+    size_t total = length();
+    if (offset >= total) {
+        return;
+    }
+    size_t end = offset + std::min(count, total - offset);
+    visitChunks(root_.get(), 0, offset, end, visitor);
+}
+
+template <typename Visitor>
+bool PieceTable::visitChunks(const Node* node, size_t base, size_t begin, size_t end, Visitor& visitor) {
+    if (!node || begin >= end) {
+        return true;
+    }
+
+    size_t pieceBegin = base + lengthOf(node->left);
+    size_t pieceEnd = pieceBegin + node->length;
+
+    if (begin < pieceBegin && !visitChunks(node->left.get(), base, begin, end, visitor)) {
+        return false;
+    }
+
+    if (begin < pieceEnd && end > pieceBegin) {
+        size_t from = std::max(begin, pieceBegin);
+        size_t to = std::min(end, pieceEnd);
+        std::string_view chunk(node->buffer->text.data() + node->start + (from - pieceBegin), to - from);
+        if (!visitor(chunk)) {
+            return false;
+        }
+    }
+
+    if (end > pieceEnd) {
+        return visitChunks(node->right.get(), pieceEnd, begin, end, visitor);
+    }
+    return true;
+}
+
+} // namespace ZeroSyntax
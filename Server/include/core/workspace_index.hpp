@@ -0,0 +1,169 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include "../ini/syntax_tree.hpp"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// A named top-level block ("Object AmericaTankCrusader")
+struct Definition {
+    std::string name;
+    std::string_view blockType;  // theTypeTable name, owned by the generated schema
+    std::string uri;
+    LSP::Range range;            // the name token
+};
+
+// A use of a definition's name by a typed field ("Weapon = ... FireFX = FX_Boom")
+// or by the source of an ObjectReskin
+struct Reference {
+    std::string name;
+    std::string_view blockType;  // referenced block type, owned by the generated schema
+    std::string uri;
+    LSP::Range range;            // the value token
+};
+
+// Everything a file contributes to the index
+struct FileSymbols {
+    std::vector<Definition> definitions;
+    std::vector<Reference> references;
+    std::vector<Reference> labels;  // string table labels of label fields; blockType is empty
+};
+
+struct IndexOptions {
+    size_t threadCount = 0;                                   // 0 picks one per core
+    std::function<bool(const std::string& uri)> skip;         // files that keep their current entries
+    std::string cachePath;                                    // IndexCache to reuse and refresh, or empty
+};
+
+struct IndexStats {
+    size_t files = 0;   // files indexed
+    size_t parsed = 0;  // of those, files that had to be parsed
+};
+
+// Named top-level definitions of every INI file in the workspace and the
+// use sites of those names, both keyed by name. Files are indexed from disk
+// and replaced as a whole whenever an open document changes; lookups are a
+// hash probe and never touch the files. All methods may be called from any
+// thread.
+class WorkspaceIndex {
+public:
+    // Named definitions and typed references of a parsed file in source order
+    static FileSymbols collect(const std::string& uri, const Ini::SyntaxTree& tree);
+
+    // Index every *.ini file below root in parallel. With a cache path, files
+    // the cache still describes are taken from it instead of being parsed and
+    // the cache is rewritten when anything changed.
+    IndexStats indexDirectory(const std::string& root, const IndexOptions& options = {});
+
+    // Re-read one file from disk, or drop it if it no longer exists
+    void indexFile(const std::string& uri);
+
+    // Replace the definitions and references of a file
+    void updateFile(const std::string& uri, FileSymbols symbols);
+
+    // Drop the definitions and references of a file
+    void removeFile(const std::string& uri);
+
+    // Definitions of name in the store of blockType (see Ini::definitionNamespace),
+    // ordered by file and position
+    std::vector<Definition> findDefinitions(std::string_view blockType, std::string_view name) const;
+
+    // Definitions of name in any store
+    std::vector<Definition> findDefinitions(std::string_view name) const;
+
+    // Whether each of names is defined in the store of blockType. The names
+    // are sorted and merged with the store in one pass rather than looked up
+    // one by one.
+    std::vector<bool> defines(std::string_view blockType, const std::vector<std::string>& names) const;
+
+    // Use sites of name in the store of blockType, ordered by file and position
+    std::vector<Reference> findReferences(std::string_view blockType, std::string_view name) const;
+
+    // String table labels the workspace uses, ordered by file and position
+    std::vector<Reference> labelReferences() const;
+
+    // String table labels a file uses in source order
+    std::vector<Reference> labelReferences(const std::string& uri) const;
+
+    // Names a file defines, each once
+    std::vector<std::string> definitionNames(const std::string& uri) const;
+
+    // Definitions of up to limit names query fuzzily matches (see
+    // Text::FuzzyMatcher), best match first; any definitions for an empty query
+    std::vector<Definition> search(std::string_view query, size_t limit) const;
+
+    // Up to limit names defined in the store of blockType: for an empty query
+    // the first ones sorted ignoring case, otherwise the ones query fuzzily
+    // matches, best match first
+    std::vector<std::string> completeNames(std::string_view blockType, std::string_view query, size_t limit) const;
+
+    size_t definitionCount() const;
+    size_t referenceCount() const;
+    size_t labelReferenceCount() const;
+    size_t fileCount() const;
+
+private:
+    // Entries of one kind keyed by name, each list ordered by file and position
+    template <typename Entry>
+    struct NameMap {
+        std::unordered_map<std::string, std::vector<Entry>> byName;
+        size_t count = 0;
+
+        // Add the entries of a file, appending each name new to the file to names
+        void add(const std::string& uri, std::vector<Entry> entries, std::vector<std::string>& names);
+        void remove(const std::string& uri, const std::vector<std::string>& names);
+    };
+
+    // Names a file contributes, so replacing it only touches those lists,
+    // and its labels, which are only ever read all together
+    struct FileNames {
+        std::vector<std::string> definitions;
+        std::vector<std::string> references;
+        std::vector<Reference> labels;
+    };
+
+    // Names ignoring case, then exactly, so the names starting with a prefix
+    // in any case are contiguous
+    struct FoldedOrder {
+        bool operator()(const std::string& a, const std::string& b) const;
+    };
+
+    // Every defined name once, with its Text::characterMask next to the
+    // others so search can filter them in bulk; removing a name moves the
+    // last one into its slot
+    struct NameSlots {
+        std::vector<std::string> names;
+        std::vector<uint64_t> masks;
+        std::unordered_map<std::string, uint32_t> slots;
+
+        void add(const std::string& name);
+        void remove(const std::string& name);
+    };
+
+    // Slots of up to limit names query fuzzily matches, best first
+    static std::vector<uint32_t> fuzzySearch(const NameSlots& names, std::string_view query, size_t limit);
+
+    // Caller holds mutex_
+    void removeFileLocked(const std::string& uri);
+    void addFileLocked(const std::string& uri, FileSymbols symbols);
+
+    mutable std::mutex mutex_;
+    NameMap<Definition> definitions_;
+    NameMap<Reference> references_;
+    std::unordered_map<std::string, FileNames> files_;
+    size_t labelCount_ = 0;
+    // Definitions of each name per store (see Ini::definitionNamespace), and
+    // the same names in slots for fuzzy matching
+    std::unordered_map<std::string_view, std::map<std::string, uint32_t, FoldedOrder>> storeNames_;
+    std::unordered_map<std::string_view, NameSlots> storeSymbols_;
+    NameSlots symbols_;
+};
+
+} // namespace ZeroSyntax
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ini_schema.hpp"
+#include "syntax_tree.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Completion from the syntax tree and the generated schema. The position
+// decides what is offered: block types at the top level, the fields of the
+// enclosing block's table (and End) at the start of a line inside a block,
+// module names after "Behavior =", "Body =", "Draw =" and "ClientUpdate =",
+// and the names a field's parse proc accepts in its value. Every candidate
+// list is built once from the schema, sorted ignoring case for a binary
+// search by prefix, with the character masks Text::FuzzyMatcher filters by.
+
+enum class CandidateKind : uint8_t {
+    BlockType,
+    Field,
+    Module,
+    Name,     // an entry of a name list
+    Keyword,  // End, Yes/No, ALL/NONE
+};
+
+struct Candidate {
+    std::string_view label;
+    std::string_view detail;  // parse proc, module data class or name list
+};
+
+// Candidates sorted ignoring case, each label once
+class CandidateList {
+public:
+    CandidateList(CandidateKind kind, std::vector<Candidate> candidates);
+
+    CandidateKind kind() const { return kind_; }
+    size_t size() const { return candidates_.size(); }
+
+    const Candidate& operator[](size_t index) const { return candidates_[index]; }
+
+    // Text::characterMask of each label, for Text::filterMasks
+    const uint64_t* masks() const { return masks_.data(); }
+
+    // Candidates whose label starts with prefix in any case, in list order
+    SchemaRange<Candidate> withPrefix(std::string_view prefix) const;
+
+private:
+    CandidateKind kind_;
+    std::vector<Candidate> candidates_;
+    std::vector<uint64_t> masks_;
+};
+
+enum class CompletionSite : uint8_t {
+    None,        // a definition name, module tag, comment or value nothing is known about
+    BlockType,   // first token of a top-level line
+    Field,       // first token of a line inside a block
+    ModuleName,  // first value of a module header
+    Value,       // a value of a field the schema models
+};
+
+struct CompletionContext {
+    CompletionSite site = CompletionSite::None;
+    std::string_view prefix;             // typed part of the token, without a +/- edit prefix
+    char sign = 0;                       // '+' or '-' typed before a list name, or 0
+    const FieldTable* table = nullptr;   // Field: table of the enclosing block, nullptr when unknown
+    const FieldSchema* field = nullptr;  // ModuleName and Value: the line's field
+    uint32_t value = 0;                  // Value: index of the value token, 0 for the first
+};
+
+// What the token at a section-relative offset is; a position past every
+// token of its line starts a new one
+CompletionContext completionContext(const Section& section, uint32_t offset);
+
+// Context of a position after the last line of a document (or in an empty one)
+inline CompletionContext topLevelContext() {
+    CompletionContext context;
+    context.site = CompletionSite::BlockType;
+    return context;
+}
+
+// The prebuilt lists a context draws from. Reference and Label values name
+// workspace definitions and string table labels, which the caller adds.
+std::vector<const CandidateList*> completionCandidates(const CompletionContext& context);
+
+} // namespace Ini
+} // namespace ZeroSyntax
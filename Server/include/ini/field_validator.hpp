@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include "syntax_tree.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Checks field values against the schema the way the engine's parse procs
+// read them: each field kind (and, where the proc narrows it, each proc)
+// has a checker that walks the line's tokens as strtok would split them,
+// colon and percent separators included, and fails where INI::scanInt,
+// scanReal, scanBool, scanIndexList and friends would throw. Checkers work
+// on views of the section text and only allocate to build a diagnostic.
+//
+// Errors are what stops the engine loading the file: unknown fields and
+// modules, values a proc rejects, and the syntax errors of the tree.
+// Warnings are values the engine accepts but reads differently than
+// written, such as "10abc" read as 10.
+
+// Diagnostics of one section, appended to diagnostics
+void validateSection(const SyntaxTree& tree, size_t sectionIndex, std::vector<LSP::Diagnostic>& diagnostics);
+
+// Diagnostics of every section of a tree
+std::vector<LSP::Diagnostic> validateTree(const SyntaxTree& tree);
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// GlobalData::m_iniCRC, which multiplayer games and replays compare.
+// GameEngine::init opens one XferCRC and INI::readLine passes it each line of
+// the files it loads, as the line stands once the comment is cut and control
+// characters became spaces (see LineLexer). XferCRC::xferImplementation reads
+// a line as 32-bit words, each folded in by XferCRC::addCRC as
+// crc = rotl(crc, 1) + htonl(word): whole words count in big-endian byte
+// order, while the 1 to 3 bytes left over are assembled little-endian and
+// swapped twice, so they stay little-endian.
+//
+// The fold is not associative, so what a file adds depends on the state
+// before it. Callers that recompute after one file changes keep the terms of
+// every file and fold again from the file that changed.
+
+// Append the values XferCRC::addCRC receives while INI::load reads text
+void appendCrcTerms(std::string_view text, std::vector<uint32_t>& terms);
+
+// XferCRC::addCRC of each term in turn, starting from state
+uint32_t foldCrcTerms(uint32_t state, const uint32_t* terms, size_t count);
+
+// XferCRC::getCRC of a state: htonl(m_crc) on the little-endian machines the game runs on
+inline uint32_t crcValue(uint32_t state) {
+    return (state >> 24) | ((state >> 8) & 0xFF00u) | ((state << 8) & 0xFF0000u) | (state << 24);
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Block structure of the game's INI files, as needed to build the syntax tree.
+//
+// Top-level block names come from theTypeTable in INI.cpp via the generated
+// schema and are matched case-sensitively (findBlockParse uses strcmp). Nested blocks are opened by
+// the schema's Block and Module fields, whose parse procs call INI::initFromINI, and are closed
+// by "End", which is matched case-insensitively.
+
+// True if token names a block type the engine can load at the top level
+bool isTopLevelBlock(std::string_view token);
+
+// True for top-level entries that consist of a single line without "End"
+// (e.g. "ReallyLowMHz = 400", parsed by a plain INI::parseInt)
+bool isSingleLineBlock(std::string_view token);
+
+// True if field, inside a block opened by context (a top-level block type or
+// the field that opened a nested block), starts a nested block
+bool opensNestedBlock(std::string_view context, std::string_view field);
+
+// True if token is the block terminator ("End", any case)
+bool isEndToken(std::string_view token);
+
+// Block type whose store a top-level block defines its name in: ObjectReskin
+// adds to the ThingFactory like Object, and DialogEvent and MusicTrack are
+// AudioEventInfo entries like AudioEvent. Other block types are their own.
+std::string_view definitionNamespace(std::string_view blockType);
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// INI_MAX_CHARS_PER_LINE (GameEngine/Include/Common/INI.h)
+constexpr size_t kMaxCharsPerLine = 1028;
+
+// One line as INI::readLine produces it
+struct LexedLine {
+    size_t offset;            // start of the line in the source
+    size_t length;            // bytes before the line terminator
+    size_t contentLength;     // bytes before the first ';' or NUL
+    uint8_t terminatorLength; // 1 if the line ended with '\n', 0 at end of input or when truncated
+    bool truncated;           // the line filled kMaxCharsPerLine; the rest is read as the next line
+};
+
+// Splits source text into lines following INI::readLine:
+//   - '\n' ends a line; '\r' and every other control character is whitespace
+//   - ';' starts a comment that runs to the end of the line
+//   - a NUL byte ends the usable content like a comment does
+//   - at most kMaxCharsPerLine characters are read per line; a longer
+//     physical line continues as the next line
+class LineLexer {
+public:
+    explicit LineLexer(std::string_view source, size_t offset = 0);
+
+    bool atEnd() const { return offset_ >= source_.size(); }
+    size_t offset() const { return offset_; }
+
+    LexedLine next();
+
+    // Standard separators (INI::m_seps, " \n\r\t=") after control characters
+    // have been mapped to spaces
+    static bool isSeparator(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return u == ' ' || u == '=' || (u > 0 && u < 32);
+    }
+
+    // Call onToken(begin, length) for every strtok token of content, with
+    // begin relative to content
+    template <typename Callback>
+    static void tokenize(std::string_view content, Callback&& onToken);
+
+private:
+    std::string_view source_;
+    size_t offset_;
+};
+
+template <typename Callback>
+void LineLexer::tokenize(std::string_view content, Callback&& onToken) {
+    size_t i = 0;
+    size_t size = content.size();
+    while (i < size) {
+        while (i < size && isSeparator(content[i])) {
+            ++i;
+        }
+        size_t begin = i;
+        while (i < size && !isSeparator(content[i])) {
+            ++i;
+        }
+        if (i > begin) {
+            onToken(begin, i - begin);
+        }
+    }
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
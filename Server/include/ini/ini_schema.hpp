@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Compiled-in schema of the game's INI files. The records are generated at
+// build time by ZS_SchemaExtractor (Server/tools/schema_extractor.cpp) from
+// the engine's FieldParse tables, buildFieldParse overrides and name lists,
+// so nothing is loaded at runtime. Lookups go through generated perfect-hash
+// indexes: one hash of the key, at most two slot reads and one comparison,
+// and no allocation.
+
+constexpr uint16_t kNoIndex = 0xFFFF;
+
+// What a field's parse proc reads, derived from the INI::parse* proc it uses
+enum class FieldKind : uint8_t {
+    Custom,       // a parse proc the extractor does not model
+    Bool,
+    Int,
+    UnsignedInt,
+    Real,
+    Percent,      // "50%"
+    String,
+    Label,        // a string table label (parseAndTranslateLabel)
+    Color,        // R:G:B[:A]
+    Coord2D,
+    Coord3D,
+    Index,        // one name from a list, by position
+    Lookup,       // one name from a LookupListRec
+    BitString,    // any number of names from a list
+    BitFlags,     // BitFlags<N>::parseFromINI, names may be prefixed with + or -
+    FlagSet,
+    Reference,    // the name of another top-level block
+    Module,       // a module header: module name and tag, followed by a nested block
+    Block,        // a nested block with its own table
+};
+
+enum class ModuleType : uint8_t {
+    Behavior,
+    Draw,
+    ClientUpdate,
+};
+
+// A const char* or LookupListRec name list; names are kListNames[first, first + count)
+struct NameList {
+    std::string_view name;
+    bool lookup;
+    uint32_t first;
+    uint32_t count;
+};
+
+struct FieldSchema {
+    std::string_view token;
+    FieldKind kind;
+    std::string_view proc;       // parse proc as written in the engine
+    uint16_t list;               // name list for Index/Lookup/BitString/BitFlags, or kNoIndex
+    uint16_t table;              // table of a nested Block, or kNoIndex
+    std::string_view reference;  // block type named by a Reference, or empty
+};
+
+// A flattened FieldParse table (all MultiIniFieldParse parts of a
+// buildFieldParse chain in engine order); fields are kFields[firstField, firstField + fieldCount)
+struct FieldTable {
+    std::string_view name;
+    uint32_t firstField;
+    uint32_t fieldCount;
+    bool acceptsAnyField;  // the table ends in a NULL-token catch-all entry
+};
+
+// An entry of theTypeTable
+struct BlockSchema {
+    std::string_view name;
+    std::string_view proc;
+    uint16_t table;  // kNoIndex for blocks parsed by hand-written code
+};
+
+// A module registered with ModuleFactory::addModule
+struct ModuleSchema {
+    std::string_view name;
+    std::string_view dataClass;
+    ModuleType type;
+    uint16_t table;
+};
+
+// Slot of a generated perfect-hash index. Every record array (kBlocks,
+// kModules, each table's fields, each list's names) has a parallel array of
+// slots of the same length: slot i holds the displacement of bucket i and
+// the record stored at position i.
+struct HashSlot {
+    int32_t displacement;  // 0: empty bucket, > 0: seed for the second hash, < 0: -(position + 1)
+    uint16_t entry;        // record index relative to the set, or kNoIndex
+};
+
+constexpr char asciiLower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lower-cased key with a murmur finalizer, so names hash
+// the same in any case. Shared with the extractor, which picks the seeds.
+constexpr uint32_t schemaHash(std::string_view key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : key) {
+        hash ^= static_cast<uint8_t>(asciiLower(c));
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// Map a hash onto [0, size) without a division
+constexpr uint32_t hashPosition(uint32_t hash, uint32_t size) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(hash) * size) >> 32);
+}
+
+// How block, module and field tokens are compared. The engine uses strcmp for
+// them (findBlockParse, findFieldParse) and stricmp for name lists.
+enum class MatchCase : uint8_t {
+    Exact,
+    Ignore,
+};
+
+// Contiguous view over schema records
+template <typename T>
+class SchemaRange {
+public:
+    constexpr SchemaRange(const T* begin, size_t size) : begin_(begin), size_(size) {}
+
+    constexpr const T* begin() const { return begin_; }
+    constexpr const T* end() const { return begin_ + size_; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr const T& operator[](size_t index) const { return begin_[index]; }
+
+private:
+    const T* begin_;
+    size_t size_;
+};
+
+namespace Schema {
+
+SchemaRange<BlockSchema> blocks();
+SchemaRange<ModuleSchema> modules();
+SchemaRange<FieldTable> tables();
+SchemaRange<NameList> lists();
+
+// Block type by its theTypeTable name, or nullptr
+const BlockSchema* findBlock(std::string_view name, MatchCase match = MatchCase::Exact);
+
+// Module by its addModule name, or nullptr
+const ModuleSchema* findModule(std::string_view name, MatchCase match = MatchCase::Exact);
+
+// Table by index; index must not be kNoIndex
+const FieldTable& table(uint16_t index);
+
+// Fields of a table in engine order
+SchemaRange<FieldSchema> fields(const FieldTable& table);
+
+// Field by token, or nullptr; the first of several same-named entries wins
+const FieldSchema* findField(const FieldTable& table, std::string_view token, MatchCase match = MatchCase::Exact);
+
+// Name list by index; index must not be kNoIndex
+const NameList& list(uint16_t index);
+
+// Names of a list in engine order
+SchemaRange<std::string_view> names(const NameList& list);
+
+// Position of a name in a list, ignoring case like scanIndexList and
+// scanLookupList; the first match wins
+std::optional<uint32_t> findName(const NameList& list, std::string_view name);
+
+} // namespace Schema
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ini_schema.hpp"
+#include "syntax_tree.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Binds syntax tree nodes to the generated schema: which FieldParse table a
+// block's children are read with and which entry of its parent's table a
+// field is. Module headers ("Draw = W3DModelDraw ModuleTag_01") use the
+// table of the named module's data class.
+
+// Node whose header or field line is line, or kNone for trivia and End lines
+uint32_t nodeAtLine(const Section& section, uint32_t line);
+
+// Index of the token of a line that contains a section-relative offset (the
+// position just past a token counts), or kNone
+uint32_t tokenAt(const Section& section, const Line& line, uint32_t offset);
+
+// Table the children of a block node are parsed with, or nullptr when the
+// schema does not model the block
+const FieldTable* blockTable(const Section& section, uint32_t node);
+
+// Entry of the parent's table that parses a node, or nullptr for root nodes
+// and unknown fields
+const FieldSchema* nodeField(const Section& section, uint32_t node);
+
+// blockTable of every node in one preorder pass (nullptr for fields), for
+// callers that visit the whole section
+std::vector<const FieldTable*> blockTables(const Section& section);
+
+} // namespace Ini
+} // namespace ZeroSyntax
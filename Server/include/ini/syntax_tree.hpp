@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../protocol/lsp_messages.hpp"
+#include "../core/piece_table.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+// A strtok token; offsets are relative to the owning section
+struct Token {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// A line as INI::readLine returns it. Offsets are relative to the owning section.
+struct Line {
+    uint32_t offset;          // first byte of the line
+    uint32_t length;          // bytes before the line terminator
+    uint32_t contentLength;   // bytes before a ';' comment
+    uint32_t firstToken;      // index of the first token in Section::tokens
+    uint32_t tokenCount;
+    uint32_t row;             // physical line number relative to the section
+    uint32_t column;          // byte column of the line start (non-zero only after a truncation)
+    uint8_t terminatorLength; // 1 for '\n', 0 at end of input or after a truncation
+    bool truncated;           // hit kMaxCharsPerLine
+};
+
+enum class NodeKind : uint8_t {
+    Block,  // header line, children, End line
+    Field,  // single line
+};
+
+// Nodes are stored in preorder: the first child of node i is i + 1 (when
+// i + 1 < subtreeEnd) and the next sibling of a child c is nodes[c].subtreeEnd.
+struct Node {
+    NodeKind kind;
+    uint32_t line;        // header or field line
+    uint32_t endLine;     // End line of a block, kNone if missing
+    uint32_t parent;      // kNone for a section's root
+    uint32_t subtreeEnd;  // one past the last descendant
+};
+
+enum class SyntaxErrorKind : uint8_t {
+    UnknownBlock,   // top-level token missing from theTypeTable
+    MissingEnd,     // block not closed before the next block or end of file
+    UnexpectedEnd,  // End outside of any block
+    LineTooLong,    // line exceeds INI_MAX_CHARS_PER_LINE and is split by the engine
+};
+
+struct SyntaxError {
+    SyntaxErrorKind kind;
+    uint32_t offset;  // relative to the owning section
+    uint32_t length;
+};
+
+// A top-level block together with the trivia lines that follow it, or the
+// comments and blank lines before the first block. Sections own a copy of
+// their source text so token text can be read without touching the document
+// buffer; they are immutable once built and shared between tree versions.
+struct Section {
+    std::string text;
+    std::vector<Line> lines;
+    std::vector<Token> tokens;
+    std::vector<Node> nodes;  // empty for a leading trivia section
+    std::vector<SyntaxError> errors;
+    uint32_t rows;            // number of line feeds in text
+
+    bool hasRoot() const { return !nodes.empty(); }
+
+    std::string_view tokenText(const Token& token) const {
+        return std::string_view(text).substr(token.offset, token.length);
+    }
+
+    std::string_view lineText(const Line& line) const {
+        return std::string_view(text).substr(line.offset, line.length);
+    }
+
+    const Token* lineTokens(const Line& line) const { return tokens.data() + line.firstToken; }
+
+    // Token i of a node's line, or an empty view
+    std::string_view nodeToken(const Node& node, uint32_t i) const {
+        const Line& line = lines[node.line];
+        return i < line.tokenCount ? tokenText(tokens[line.firstToken + i]) : std::string_view();
+    }
+
+    // The keyword of a node: block type, field name or nested block opener
+    std::string_view keyword(const Node& node) const { return nodeToken(node, 0); }
+
+    // Index of the line containing a section-relative offset
+    uint32_t lineAt(uint32_t offset) const;
+};
+
+// Lossless concrete syntax tree of an INI document: the concatenation of the
+// section texts is exactly the source.
+class SyntaxTree {
+public:
+    SyntaxTree();
+
+    // Parse a whole document
+    static SyntaxTree parse(std::string_view source);
+
+    // Parse a single section starting at offset; used by the parser and by
+    // incremental reparsing. Stops before the next top-level block header.
+    static std::shared_ptr<const Section> parseSection(std::string_view source, size_t offset);
+
+    // Tree for text after replacing removed bytes at offset with inserted
+    // bytes. Only the sections from the one enclosing the edit up to the
+    // first unchanged block boundary are re-lexed; all other sections are
+    // shared with this tree.
+    SyntaxTree edit(const PieceTable& text, size_t offset, size_t removed, size_t inserted) const;
+
+    size_t sectionCount() const { return sections_.size(); }
+    const Section& section(size_t index) const { return *sections_[index]; }
+    const std::shared_ptr<const Section>& sectionPtr(size_t index) const { return sections_[index]; }
+
+    // Absolute byte offset and first row of a section
+    size_t sectionOffset(size_t index) const { return offsets_[index]; }
+    size_t sectionRow(size_t index) const { return rows_[index]; }
+
+    // Index of the section containing an absolute offset (the last section for offsets past the end)
+    size_t findSection(size_t offset) const;
+
+    // Index of the section containing a row
+    size_t findSectionByRow(size_t row) const;
+
+    size_t length() const { return length_; }
+
+    // Rebuild the source text from the sections
+    std::string text() const;
+
+    // LSP position of a section-relative offset
+    LSP::Position positionAt(size_t sectionIndex, uint32_t offset) const;
+
+    // Section-relative offset of an LSP position inside a section
+    uint32_t offsetAt(size_t sectionIndex, const LSP::Position& position) const;
+
+    // LSP range of a token
+    LSP::Range tokenRange(size_t sectionIndex, const Token& token) const;
+
+private:
+    void rebuildIndex(size_t from);
+
+    std::vector<std::shared_ptr<const Section>> sections_;
+    std::vector<size_t> offsets_;
+    std::vector<size_t> rows_;
+    size_t length_;
+};
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+// Several parse procs store something other than what the file says:
+// durations are written in milliseconds and kept in logic frames, angles in
+// degrees and kept in radians, speeds per second and kept per frame, and
+// percentages as fractions. These helpers redo the conversion of GameCommon.h
+// in single precision, so a value shows as the engine holds it.
+
+constexpr int kLogicFramesPerSecond = 30;  // LOGICFRAMES_PER_SECOND
+
+// What proc stores for the first value token, e.g. "3000 ms = 90 frames",
+// or nullopt when proc keeps the value as written or the token is not a number
+std::optional<std::string> convertedValue(std::string_view proc, std::string_view token);
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+
+namespace Vfs {
+class Decompressor;
+}
+
+namespace Map {
+
+// Chunk labels the server reads. The table of contents maps a file's ids to
+// kinds once, so a chunk is dispatched by indexing arrays with its kind
+// rather than by comparing labels as DataChunkInput::parse does.
+enum class ChunkKind : uint8_t {
+    Unknown,
+    HeightMapData,
+    BlendTileData,
+    WorldInfo,
+    MapPreview,
+    SidesList,
+    ObjectsList,
+    Object,
+    PolygonTriggers,
+    GlobalLighting,
+    WaypointsList,
+    PlayerScriptsList,
+    ScriptList,
+    ScriptGroup,
+    Script,
+    OrCondition,
+    Condition,
+    ScriptAction,
+    ScriptActionFalse,
+    Count
+};
+
+constexpr size_t kChunkKindCount = static_cast<size_t>(ChunkKind::Count);
+
+ChunkKind chunkKindOf(std::string_view label);
+
+// DataChunkTableOfContents: "CkMp", a count, then per name a length byte,
+// the name and its id. Names label chunks and Dict keys alike.
+class ChunkTable {
+public:
+    // Read the table at the start of input; false when the data does not
+    // start with one or it is cut short
+    bool read(Vfs::Decompressor& input);
+
+    // Name of an id, or empty
+    std::string_view name(uint32_t id) const {
+        return id < names_.size() ? std::string_view(names_[id]) : std::string_view();
+    }
+
+    ChunkKind kind(uint32_t id) const { return id < kinds_.size() ? kinds_[id] : ChunkKind::Unknown; }
+
+private:
+    std::vector<std::string> names_;  // by id
+    std::vector<ChunkKind> kinds_;    // by id
+};
+
+constexpr size_t kChunkHeaderSize = 10;
+
+// Header of a chunk: id, version and payload size
+struct ChunkHeader {
+    uint32_t id = 0;
+    uint16_t version = 0;
+    int32_t size = 0;
+};
+
+ChunkHeader parseChunkHeader(const char* bytes);
+
+// A chunk and its payload
+struct Chunk {
+    uint32_t id = 0;
+    ChunkKind kind = ChunkKind::Unknown;
+    uint16_t version = 0;
+    std::string_view data;
+};
+
+enum class DictType : uint8_t { Bool, Int, Real, AsciiString, UnicodeString };
+
+// An entry of a Dict. text holds an AsciiString, or the UTF-16LE bytes of a
+// UnicodeString; intValue also holds a Bool.
+struct DictEntry {
+    std::string_view key;
+    DictType type = DictType::Int;
+    int32_t intValue = 0;
+    float realValue = 0;
+    std::string_view text;
+};
+
+using Dict = std::vector<DictEntry>;
+
+// Entry of a key, or nullptr
+const DictEntry* findEntry(const Dict& dict, std::string_view key);
+
+// Little-endian reads from a chunk payload, as DataChunkInput makes them.
+// Each read is checked against the payload: past its end a read returns
+// zero or empty and sets failed() for good. Strings are views into the
+// payload and Dict keys views into the table.
+class ChunkReader {
+public:
+    ChunkReader(std::string_view data, const ChunkTable& table) : data_(data), table_(&table) {}
+
+    int32_t readInt();
+    float readReal();
+    uint8_t readByte();
+    std::string_view readAsciiString();
+    std::string_view readUnicodeString();  // UTF-16LE bytes
+    std::string_view readBytes(size_t size);
+    Dict readDict();
+
+    // The next nested chunk, as DataChunkInput::parse opens them; false at
+    // the end of the payload or when a chunk runs past it
+    bool nextChunk(Chunk& chunk);
+
+    bool atEnd() const { return offset_ == data_.size(); }
+    bool failed() const { return failed_; }
+    size_t offset() const { return offset_; }
+
+private:
+    bool take(size_t size, const char*& bytes);
+
+    std::string_view data_;
+    const ChunkTable* table_;
+    size_t offset_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace Map
+} // namespace ZeroSyntax
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "data_chunk.hpp"
+#include "../utils/mapped_file.hpp"
+#include "../vfs/decompressor.hpp"
+#include <array>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Map {
+
+// HeightMapData: one height byte per cell, row by row from the bottom left
+struct HeightMap {
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t border = 0;
+    std::vector<std::pair<int32_t, int32_t>> boundaries;  // playable areas, version 4
+    std::string_view heights;                            // width * height bytes
+};
+
+// An Object chunk of the ObjectsList
+struct MapObject {
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float angle = 0;
+    int32_t flags = 0;
+    std::string_view name;  // thing template
+    Dict properties;
+};
+
+// A waypoint object: the id and name kept in its properties
+struct Waypoint {
+    int32_t id = 0;
+    std::string_view name;
+    float x = 0;
+    float y = 0;
+};
+
+// A link of the WaypointsList, by waypoint id
+struct WaypointLink {
+    int32_t from = 0;
+    int32_t to = 0;
+};
+
+// A building of a side's build list
+struct BuildListEntry {
+    std::string_view name;
+    std::string_view templateName;
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float angle = 0;
+    std::string_view script;  // version 3
+};
+
+// A player of the SidesList
+struct Side {
+    Dict properties;
+    std::vector<BuildListEntry> buildList;
+};
+
+// A map file (.map), read-only. Opening it skims the chunks once: the table
+// of contents is read and the offset, size and version of each top-level
+// section recorded, and nothing inside a section is decoded. Sections are
+// decoded the first time they are asked for and kept for the file's
+// lifetime.
+//
+// A compressed map is streamed through Vfs::Decompressor on the skim. Its
+// small, structured sections (objects, sides, scripts, waypoints) are kept
+// as they go by; the terrain sections (HeightMapData, BlendTileData,
+// MapPreview), which make up most of a map, are not, and are decompressed
+// again up to their offset when asked for. An uncompressed map is read in
+// place.
+//
+// Not thread-safe while opening; const methods may be called concurrently
+// afterwards. Returned views and references stay valid until the map is
+// opened again or destroyed.
+class MapFile {
+public:
+    MapFile() = default;
+
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+
+    // Map the file and skim it; false, leaving the map empty, when it cannot
+    // be read or is not a map
+    bool open(const std::string& path);
+
+    // Skim data the caller keeps valid for the map's lifetime
+    bool load(std::string_view data);
+
+    const std::string& path() const { return path_; }
+    Vfs::Compression compression() const { return compression_; }
+    const ChunkTable& table() const { return table_; }
+
+    // Whether the map has a top-level section; the first of a kind counts
+    bool has(ChunkKind kind) const { return sections_[static_cast<size_t>(kind)].present; }
+
+    // A top-level section, its payload decoded on demand, or nullopt when
+    // the map has none or it cannot be decompressed
+    std::optional<Chunk> section(ChunkKind kind) const;
+
+    // nullptr when the map has no HeightMapData or it is corrupt
+    const HeightMap* heightMap() const;
+
+    // WorldInfo's properties
+    const Dict& worldInfo() const;
+
+    const std::vector<MapObject>& objects() const;
+    const std::vector<Waypoint>& waypoints() const;
+    const std::vector<WaypointLink>& waypointLinks() const;
+
+    const std::vector<Side>& sides() const;
+    const std::vector<Dict>& teams() const;
+
+    // PlayerScriptsList: nested in the SidesList, or on its own in older
+    // maps; nullopt when there is none
+    std::optional<Chunk> playerScripts() const;
+
+private:
+    struct Section {
+        bool present = false;
+        uint32_t id = 0;
+        uint16_t version = 0;
+        size_t offset = 0;  // in the uncompressed stream, past the header
+        size_t size = 0;
+    };
+
+    void clear();
+
+    // Read the table and record the sections; false when data is not a map
+    // or a section runs past its end
+    bool skim(std::string_view data);
+
+    // Caller holds mutex_
+    std::optional<Chunk> sectionLocked(ChunkKind kind) const;
+    void decodeSides() const;
+    void decodeObjects() const;
+
+    std::string path_;
+    MappedFile file_;
+    std::string_view source_;
+    Vfs::Compression compression_ = Vfs::Compression::None;
+    ChunkTable table_;
+    std::array<Section, kChunkKindCount> sections_;
+
+    mutable std::mutex mutex_;
+    mutable std::array<std::string, kChunkKindCount> payloads_;  // decompressed sections
+    mutable std::array<bool, kChunkKindCount> decompressed_{};
+    mutable std::optional<HeightMap> heightMap_;
+    mutable bool heightMapRead_ = false;
+    mutable std::optional<Dict> worldInfo_;
+    mutable std::optional<std::vector<MapObject>> objects_;
+    mutable std::optional<std::vector<Waypoint>> waypoints_;
+    mutable std::optional<std::vector<WaypointLink>> waypointLinks_;
+    mutable std::optional<std::vector<Side>> sides_;
+    mutable std::vector<Dict> teams_;
+    mutable std::optional<Chunk> playerScripts_;
+};
+
+} // namespace Map
+} // namespace ZeroSyntax
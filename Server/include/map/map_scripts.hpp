@@ -0,0 +1,157 @@
+#pragma once
+
+#include "data_chunk.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Map {
+
+// Parameter::ParameterType, by value as the chunks store it
+enum class ParameterType : uint8_t {
+    Int,
+    Real,
+    Script,
+    Team,
+    Counter,
+    Flag,
+    Comparison,
+    Waypoint,
+    Boolean,
+    TriggerArea,
+    TextString,
+    Side,
+    Sound,
+    ScriptSubroutine,
+    Unit,
+    ObjectType,
+    Coord3D,
+    Angle,
+    TeamState,
+    Relation,
+    AiMood,
+    Dialog,
+    Music,
+    Movie,
+    WaypointPath,
+    LocalizedText,
+    Bridge,
+    KindOf,
+    AttackPrioritySet,
+    RadarEventType,
+    SpecialPower,
+    Science,
+    Upgrade,
+    CommandButtonAbility,
+    Boundary,
+    Buildable,
+    SurfacesAllowed,
+    ShakeIntensity,
+    CommandButton,
+    FontName,
+    ObjectStatus,
+    CommandButtonAllAbilities,
+    SkirmishWaypointPath,
+    Color,
+    Emoticon,
+    ObjectPanelFlag,
+    FactionName,
+    ObjectTypeList,
+    RevealName,
+    ScienceAvailability,
+    LeftOrRight,
+    Percent,
+    Count
+};
+
+// A Parameter. A Coord3D is x, y and z; every other type stores an int, a
+// real and a string, of which it uses one.
+struct ScriptParameter {
+    ParameterType type = ParameterType::Int;
+    int32_t intValue = 0;
+    float realValue = 0;  // x of a Coord3D
+    float y = 0;
+    float z = 0;
+    std::string_view text;
+};
+
+enum class ClauseKind : uint8_t { Condition, Action, ActionFalse };
+
+// A Condition, ScriptAction or ScriptActionFalse
+struct ScriptClause {
+    ClauseKind kind = ClauseKind::Condition;
+    int32_t type = 0;        // ConditionType or ScriptActionType
+    std::string_view name;   // internal template name, which the engine trusts over type; empty in older chunks
+    uint32_t orGroup = 0;    // conditions: the OrCondition of the script they belong to
+    uint32_t firstParameter = 0;
+    uint32_t parameterCount = 0;
+};
+
+// A ScriptGroup of a player's ScriptList
+struct ScriptGroup {
+    std::string_view name;
+    uint32_t player = 0;
+    bool active = false;
+    bool subroutine = false;
+};
+
+struct Script {
+    std::string_view name;
+    std::string_view comment;
+    uint32_t player = 0;  // index of the ScriptList, which is the side's index in the SidesList
+    uint32_t group = 0;   // into groups(), or kNoGroup
+    bool active = false;
+    bool oneShot = false;
+    bool easy = false;
+    bool normal = false;
+    bool hard = false;
+    bool subroutine = false;
+    int32_t delaySeconds = 0;
+    uint32_t firstClause = 0;
+    uint32_t clauseCount = 0;
+};
+
+// The scripts of a map (a PlayerScriptsList) as flat arrays: scripts index
+// their clauses, and clauses their parameters, by range, so the whole set is
+// a few allocations and can be scanned without chasing pointers. Strings are
+// views into the chunk payload and the table, which must outlive the set.
+class MapScripts {
+public:
+    static constexpr uint32_t kNoGroup = UINT32_MAX;
+
+    MapScripts() = default;
+    MapScripts(MapScripts&&) = default;
+    MapScripts& operator=(MapScripts&&) = default;
+    MapScripts(const MapScripts&) = delete;  // parameters view renamed_
+    MapScripts& operator=(const MapScripts&) = delete;
+
+    // Decode a PlayerScriptsList as ScriptList::ParseScriptsDataChunk reads
+    // it, including the renames Parameter::ReadParameter makes. false when a
+    // chunk is corrupt; what was decoded before it is kept.
+    bool decode(const Chunk& playerScripts, const ChunkTable& table);
+
+    uint32_t playerCount() const { return playerCount_; }
+    const std::vector<Script>& scripts() const { return scripts_; }
+    const std::vector<ScriptGroup>& groups() const { return groups_; }
+    const std::vector<ScriptClause>& clauses() const { return clauses_; }
+    const std::vector<ScriptParameter>& parameters() const { return parameters_; }
+
+private:
+    bool decodeList(std::string_view data, const ChunkTable& table);
+    bool decodeScript(const Chunk& chunk, const ChunkTable& table, uint32_t group);
+    bool decodeClause(const Chunk& chunk, const ChunkTable& table, ClauseKind kind, uint32_t orGroup);
+
+    uint32_t playerCount_ = 0;
+    std::vector<Script> scripts_;
+    std::vector<ScriptGroup> groups_;
+    std::vector<ScriptClause> clauses_;
+    std::vector<ScriptParameter> parameters_;
+    std::deque<std::string> renamed_;  // parameter names the engine fixes on read; a deque never moves them
+};
+
+} // namespace Map
+} // namespace ZeroSyntax
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "protocol/lsp_messages.hpp"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// Decides when the server validates a document and whether the result is
+// worth a publishDiagnostics notification.
+//
+// A change does not validate the document right away: it (re)starts a
+// per-document wait, and only once no change has come in for the delay is
+// the document due, so a burst of keystrokes costs one validation of the
+// newest version. Results are hashed per document, and a result equal to
+// the one last published is not sent again.
+//
+// Used from the protocol thread only.
+class DiagnosticsQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DiagnosticsQueue(Clock::duration delay);
+
+    Clock::duration delay() const { return delay_; }
+    void setDelay(Clock::duration delay) { delay_ = delay; }
+
+    // Validate a document once it has not changed for the delay
+    void schedule(const std::string& uri, Clock::time_point now);
+
+    // Validate a document at the next tick, e.g. when it is opened
+    void scheduleNow(const std::string& uri, Clock::time_point now);
+
+    // Drop a document's pending validation
+    void cancel(const std::string& uri);
+
+    // Documents whose wait is over, in the order they became due
+    std::vector<std::string> takeDue(Clock::time_point now);
+
+    // Time until the next document is due, or nullopt when none is pending
+    std::optional<Clock::duration> timeUntilDue(Clock::time_point now) const;
+
+    size_t pendingCount() const { return pending_.size(); }
+
+    // Record the diagnostics about to be published for a document; false,
+    // recording nothing, when they equal the ones published last (a document
+    // nothing was published for has none)
+    bool update(const std::string& uri, const std::vector<LSP::Diagnostic>& diagnostics);
+
+    // Hash of a diagnostic set; order matters, as it does to the client
+    static uint64_t hash(const std::vector<LSP::Diagnostic>& diagnostics);
+
+private:
+    Clock::duration delay_;
+    std::unordered_map<std::string, Clock::time_point> pending_;  // uri -> when it is due
+    std::unordered_map<std::string, uint64_t> published_;         // uri -> hash of the last publish
+};
+
+} // namespace ZeroSyntax
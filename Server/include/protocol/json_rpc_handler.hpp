@@ -3,9 +3,13 @@
 #include <nlohmann/json.hpp>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <optional>
 
+#include "protocol/request_scheduler.hpp"
+
 namespace ZeroSyntax {
 
 class JsonRpcHandler {
@@ -17,13 +21,23 @@ public:
     // Register a method handler
     void registerMethod(const std::string& method, MessageCallback callback);
 
+    // Register a read-only request handler. When a scheduler is attached these
+    // requests run on its worker pool and their responses are delivered through
+    // RequestScheduler::takeCompleted() instead of being returned.
+    void registerConcurrentMethod(const std::string& method, MessageCallback callback);
+
+    // Attach the scheduler used for concurrent methods and $/cancelRequest
+    void setScheduler(RequestScheduler* scheduler);
+
     // Process a JSON-RPC message
-    std::optional<std::string> handleRequest(const std::string& message);
+    std::optional<std::string> handleRequest(std::string_view message);
     std::string createResponse(const nlohmann::json& result, const nlohmann::json& id);
     std::string createErrorResponse(int code, const std::string& message, const nlohmann::json& id, const nlohmann::json& data = nullptr);
 
 private:
     std::unordered_map<std::string, MessageCallback> methodHandlers_;
+    std::unordered_set<std::string> concurrentMethods_;
+    RequestScheduler* scheduler_;
 };
 
 } // namespace ZeroSyntax
\ No newline at end of file
@@ -51,6 +51,11 @@ struct VersionedTextDocumentIdentifier {
     int version;
 };
 
+struct TextDocumentContentChangeEvent {
+    std::optional<Range> range;  // absent for a full document replacement
+    std::string text;
+};
+
 struct TextDocumentIdentifier {
     std::string uri;
 };
@@ -67,11 +72,23 @@ struct CompletionItem {
     int kind;  // CompletionItemKind enum
 };
 
+struct SymbolInformation {
+    std::string name;
+    int kind;  // SymbolKind enum
+    Location location;
+    std::optional<std::string> containerName;
+};
+
 struct CompletionList {
     bool isIncomplete;
     std::vector<CompletionItem> items;
 };
 
+struct Hover {
+    std::string contents;  // markdown
+    std::optional<Range> range;
+};
+
 // LSP Capabilities
 struct ServerCapabilities {
     bool textDocumentSync = false;
@@ -102,6 +119,9 @@ void from_json(const nlohmann::json& j, TextDocumentItem& t);
 void to_json(nlohmann::json& j, const VersionedTextDocumentIdentifier& v);
 void from_json(const nlohmann::json& j, VersionedTextDocumentIdentifier& v);
 
+void to_json(nlohmann::json& j, const TextDocumentContentChangeEvent& c);
+void from_json(const nlohmann::json& j, TextDocumentContentChangeEvent& c);
+
 void to_json(nlohmann::json& j, const TextDocumentIdentifier& t);
 void from_json(const nlohmann::json& j, TextDocumentIdentifier& t);
 
@@ -111,9 +131,15 @@ void from_json(const nlohmann::json& j, TextDocumentPositionParams& t);
 void to_json(nlohmann::json& j, const CompletionItem& c);
 void from_json(const nlohmann::json& j, CompletionItem& c);
 
+void to_json(nlohmann::json& j, const SymbolInformation& s);
+void from_json(const nlohmann::json& j, SymbolInformation& s);
+
 void to_json(nlohmann::json& j, const CompletionList& c);
 void from_json(const nlohmann::json& j, CompletionList& c);
 
+void to_json(nlohmann::json& j, const Hover& h);
+void from_json(const nlohmann::json& j, Hover& h);
+
 void to_json(nlohmann::json& j, const ServerCapabilities& s);
 void from_json(const nlohmann::json& j, ServerCapabilities& s);
 
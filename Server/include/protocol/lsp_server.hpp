@@ -1,44 +1,26 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <memory>
 #include <string>
-#include <unordered_map>
-#include <functional>
+#include <string_view>
 #include <optional>
 
 #include "core/document_manager.hpp"
+#include "protocol/diagnostics_queue.hpp"
+#include "protocol/json_rpc_handler.hpp"
+#include "protocol/request_scheduler.hpp"
+#include "protocol/transport.hpp"
 
 namespace ZeroSyntax {
 
-class JsonRpcHandler {
-public:
-    using MessageCallback = std::function<nlohmann::json(const nlohmann::json&)>;
-    
-    JsonRpcHandler();
-    
-    // Register a method handler
-    void registerMethod(const std::string& method, MessageCallback callback);
-    
-    // Process a JSON-RPC message and return a response if needed
-    std::optional<std::string> handleRequest(const std::string& message);
-    
-    // Create a JSON-RPC response
-    std::string createResponse(const nlohmann::json& result, const nlohmann::json& id);
-    
-    // Create a JSON-RPC error response
-    std::string createErrorResponse(int code, const std::string& message,
-                                    const nlohmann::json& id,
-                                    const nlohmann::json& data = nullptr);
-private:
-    std::unordered_map<std::string, MessageCallback> methodHandlers_;
-};
-
 class LspServer {
 public:
-    LspServer();
+    // Read-only requests run on workerCount threads; 0 runs everything inline
+    explicit LspServer(size_t workerCount = RequestScheduler::defaultWorkerCount());
 
     // Process a single JSON-RPC message
-    std::optional<std::string> processMessage(const std::string& message);
+    std::optional<std::string> processMessage(std::string_view message);
 
     // Run the server's message processing loop
     void run();
@@ -46,21 +28,47 @@ public:
 private:
     // Handler methods for LSP notifications and requests
     nlohmann::json handleInitialize(const nlohmann::json& params);
+    nlohmann::json handleInitialized(const nlohmann::json& params);
     nlohmann::json handleTextDocumentDidOpen(const nlohmann::json& params);
     nlohmann::json handleTextDocumentDidChange(const nlohmann::json& params);
     nlohmann::json handleTextDocumentDidClose(const nlohmann::json& params);
+    nlohmann::json handleTextDocumentDidSave(const nlohmann::json& params);
+    nlohmann::json handleWorkspaceDidChangeWatchedFiles(const nlohmann::json& params);
     nlohmann::json handleTextDocumentCompletion(const nlohmann::json& params);
+    nlohmann::json handleTextDocumentHover(const nlohmann::json& params);
     nlohmann::json handleTextDocumentDefinition(const nlohmann::json& params);
+    nlohmann::json handleTextDocumentReferences(const nlohmann::json& params);
+    nlohmann::json handleWorkspaceSymbol(const nlohmann::json& params);
     
-    // Helper method to publish diagnostics
+    // Publish diagnostics unless they equal the ones the client already has
     void publishDiagnostics(const std::string& uri, const std::vector<LSP::Diagnostic>& diagnostics);
     
-    // Send a notification to the client
+    // Validate and publish the open documents whose debounce wait is over
+    void publishDueDiagnostics();
+    
+    // Check every map against the definitions and publish what changed
+    void publishMapDiagnostics();
+    
+    // Evaluate the Objects an edit dropped on a worker, ahead of the hovers that read them
+    void refreshDefinitions();
+    
+    // Send the INI CRC (zeroSyntax/iniCrc) unless the client already has this value
+    void publishIniCrc();
+    
+    // Queue a notification for the client; it is written at the end of the current tick
     void sendNotification(const std::string& method, const nlohmann::json& params);
     
-    // Member variables
+    // Queue the responses of requests finished by the scheduler
+    void queueCompletedResponses();
+    
+    // Member variables. The scheduler is declared last so its workers are
+    // joined before the handler and documents they use are destroyed.
+    std::unique_ptr<Transport> transport_;
     std::unique_ptr<JsonRpcHandler> rpcHandler_;
     std::unique_ptr<DocumentManager> documentManager_;
+    DiagnosticsQueue diagnostics_;
+    std::optional<uint32_t> sentIniCrc_;
+    std::unique_ptr<RequestScheduler> scheduler_;
 };
     
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// JSON-RPC error codes used when a scheduled request is dropped
+constexpr int kRequestCancelled = -32800;
+constexpr int kContentModified = -32801;
+
+// Runs read-only requests on a pool of worker threads.
+//
+// The protocol thread submits requests and collects the serialized responses
+// with takeCompleted(); workers never touch the transport. A request is
+// dropped (answered with an error instead of running) when
+//   - the client sends $/cancelRequest for it,
+//   - a newer request with the same key (method + document) is submitted, or
+//   - the document it reads changes before it has produced its result.
+//
+// With zero workers requests run inline inside submit(), which keeps the
+// behaviour identical on platforms where the event loop cannot be woken.
+class RequestScheduler {
+public:
+    // Produces the serialized response of a request
+    using Work = std::function<std::string()>;
+    // Produces the serialized error response for a dropped request
+    using Reject = std::function<std::string(int code, const std::string& message)>;
+
+    explicit RequestScheduler(size_t workerCount = defaultWorkerCount());
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // Queue a request. requestId identifies it for $/cancelRequest, key groups
+    // requests that supersede each other and uri names the document it reads.
+    void submit(const std::string& requestId, const std::string& key, const std::string& uri,
+                Work work, Reject reject);
+
+    // Queue work that produces no response, such as filling caches ahead of
+    // requests; workers take it only when no request is pending
+    void post(std::function<void()> task);
+
+    // Cancel a pending or running request
+    void cancel(const std::string& requestId);
+
+    // Invalidate requests reading an older version of a document
+    void documentChanged(const std::string& uri);
+
+    // Responses produced since the last call, in completion order
+    std::vector<std::string> takeCompleted();
+
+    // Number of requests submitted but not yet completed
+    size_t inFlight() const;
+
+    // Descriptor that becomes readable when a response is completed, or -1
+    int wakeFd() const { return wakePipe_[0]; }
+
+    size_t workerCount() const { return workers_.size(); }
+
+    static size_t defaultWorkerCount();
+
+private:
+    struct Job {
+        std::string requestId;
+        std::string key;
+        std::string uri;
+        Work work;
+        Reject reject;
+        std::atomic<bool> dropped{false};
+        int dropCode = 0;
+        std::string dropMessage;
+    };
+
+    void workerLoop();
+    void run(const std::shared_ptr<Job>& job);
+
+    // Mark a job as dropped; the caller holds mutex_
+    static void drop(Job& job, int code, const std::string& message);
+
+    // Record a response and wake the protocol thread; the caller holds mutex_
+    void complete(std::string response);
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeWorkers_;
+    std::deque<std::shared_ptr<Job>> pending_;
+    std::deque<std::function<void()>> tasks_;
+    std::unordered_map<std::string, std::shared_ptr<Job>> running_;
+    std::vector<std::string> completed_;
+    size_t inFlight_;
+    bool stopping_;
+
+    std::vector<std::thread> workers_;
+    int wakePipe_[2];
+};
+
+} // namespace ZeroSyntax
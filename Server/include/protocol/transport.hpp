@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+
+// Content-Length framed message transport over raw file descriptors.
+//
+// Incoming data is read in large blocks into a reusable buffer and frames
+// are parsed in place; readMessage() hands out a view into that buffer.
+// Outgoing messages are queued and written with a single writev() per
+// flush(), which the server calls once per event-loop tick.
+class Transport {
+public:
+    Transport(int inputFd = 0, int outputFd = 1);
+
+    // Read the next message body. The view stays valid until the next call.
+    // Returns std::nullopt on end of input or a read error.
+    std::optional<std::string_view> readMessage();
+
+    // True if a complete message is already buffered, i.e. readMessage()
+    // will not block
+    bool hasBufferedMessage() const;
+
+    // Block until input is readable, wakeFd (if >= 0) becomes readable or
+    // timeoutMs (if >= 0) has passed. Returns true when input is available,
+    // false when only woken or timed out.
+    bool waitForInput(int wakeFd, int timeoutMs = -1);
+
+    // Queue a message body for sending; the frame header is added here
+    void queueMessage(std::string message);
+
+    // Number of messages waiting to be flushed
+    size_t pendingMessages() const;
+
+    // Write every queued message. Returns false on a write error.
+    bool flush();
+
+private:
+    struct Frame {
+        size_t headerLength;
+        size_t contentLength;
+    };
+
+    // Parse the frame starting at readBegin_ if its headers are fully buffered
+    std::optional<Frame> parseFrame() const;
+
+    // Read more input into the buffer, compacting or growing it first
+    bool fill(size_t required);
+
+    int inputFd_;
+    int outputFd_;
+
+    std::vector<char> readBuffer_;
+    size_t readBegin_;
+    size_t readEnd_;
+
+    std::vector<std::string> outgoing_;  // header, body, header, body, ...
+};
+
+} // namespace ZeroSyntax
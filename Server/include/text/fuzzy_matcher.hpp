@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Text {
+
+// Fuzzy matching of long CamelCase names ("avt" finds AmericaVehicleTomahawk)
+// for completion and workspace symbols. Matching runs in three steps, each
+// cheaper than the next and rejecting most of what is left:
+//
+//   1. characterMask: a 64-bit set of the characters a name holds, kept next
+//      to the name; filterMasks tests many masks at once (SSE2 where the
+//      target has it) and drops names lacking any character of the query.
+//   2. A greedy subsequence scan of the names that pass.
+//   3. The scoring DP of FuzzyMatcher::score on the names that are
+//      subsequence matches.
+//
+// TopMatches then keeps the best few in a bounded heap, so nothing sorts the
+// whole candidate set.
+
+// Set of the characters of text ignoring case: letters, digits and '_' have
+// a bit each, other bytes share the remaining bits
+uint64_t characterMask(std::string_view text);
+
+// Append the index of every mask that holds all bits of query
+void filterMasks(const uint64_t* masks, size_t count, uint64_t query, std::vector<uint32_t>& matches);
+
+// Scores names against one query. Every query character must appear in the
+// name in order, ignoring case; each match scores, more so at the start of
+// a word (after '_' or a separator, a lower-to-upper case change or the
+// first digit) and right after the previous match, and skipped characters
+// between matches cost a little. Keeps scratch rows between calls, so use
+// one matcher per thread.
+class FuzzyMatcher {
+public:
+    explicit FuzzyMatcher(std::string_view query);
+
+    bool empty() const { return query_.empty(); }
+
+    // characterMask of the query
+    uint64_t mask() const { return mask_; }
+
+    // Score of a name, higher is better, or nullopt when the query is not a
+    // subsequence of it. An empty query scores 0 against anything.
+    std::optional<int> score(std::string_view name) const;
+
+private:
+    std::string query_;
+    std::string folded_;
+    uint64_t mask_;
+    mutable std::vector<int> previous_;
+    mutable std::vector<int> current_;
+};
+
+struct FuzzyMatch {
+    uint32_t index;   // caller's candidate index
+    int score;
+    uint32_t length;  // of the name; shorter names win ties
+};
+
+// The best limit matches offered, kept in a heap whose root is the worst
+// of them, so adding costs O(log limit) whatever the number of candidates
+class TopMatches {
+public:
+    explicit TopMatches(size_t limit);
+
+    void add(uint32_t index, int score, uint32_t length);
+
+    size_t size() const { return heap_.size(); }
+
+    // The matches kept, best first (ties by length, then index); leaves the set empty
+    std::vector<FuzzyMatch> take();
+
+private:
+    size_t limit_;
+    std::vector<FuzzyMatch> heap_;
+};
+
+} // namespace Text
+} // namespace ZeroSyntax
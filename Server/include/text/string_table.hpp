@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Text {
+
+// The game's string table, loaded from a compiled Generals.csf or a
+// Generals.str source the way GameTextManager reads them. The file is kept
+// whole as the table's arena: labels and strings are spans of it, sorted
+// ignoring case as the engine's compareLUT orders them, with a hash index
+// over the case-folded labels, so a lookup neither allocates nor copies.
+// A string is decoded to UTF-8 (and has its spaces stripped like
+// stripSpaces) the first time it is read and kept for the table's lifetime.
+// Not thread-safe while loading; const methods may be called concurrently
+// afterwards.
+class StringTable {
+public:
+    StringTable() = default;
+
+    StringTable(const StringTable&) = delete;
+    StringTable& operator=(const StringTable&) = delete;
+
+    // Read a compiled string table ("CSF " header, then one "LBL " record
+    // per label holding "STR " or "STRW" strings of inverted UTF-16); only
+    // a label's first string is kept. false, leaving the table empty, when
+    // the data is not a CSF file or a record is cut short.
+    bool loadCsf(std::string data);
+
+    // Read a string source: a label line, then lines up to END of which the
+    // first quoted one is the string and may name a speech file after the
+    // closing quote; lines starting with // are comments. false, leaving the
+    // table empty, when the file ends inside a label.
+    bool loadStr(std::string data);
+
+    // Labels are unique; when a file repeats one, the first wins
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    // CSF language id (LanguageID), 0 (US) for older files and string sources
+    uint32_t language() const { return language_; }
+
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    // Index of a label in any case, or nullopt
+    std::optional<uint32_t> find(std::string_view label) const;
+
+    // Indices of many labels at once, kMissing for those the table lacks.
+    // The labels are sorted and merged with the table in one pass rather
+    // than looked up one by one.
+    std::vector<uint32_t> resolve(const std::vector<std::string_view>& labels) const;
+
+    // Indices of the labels starting with a prefix in any case, as [first, last)
+    std::pair<uint32_t, uint32_t> withPrefix(std::string_view prefix) const;
+
+    // Label as written in the file
+    std::string_view label(uint32_t index) const { return span(entries_[index].label); }
+
+    // String of a label in UTF-8; valid for the table's lifetime
+    std::string_view text(uint32_t index) const;
+
+    // Byte offset of a label in source()
+    uint32_t labelOffset(uint32_t index) const { return entries_[index].label.offset; }
+
+    // The file the table was loaded from
+    std::string_view source() const { return data_; }
+
+    // Speech file of a label, or empty
+    std::string_view speech(uint32_t index) const { return span(entries_[index].speech); }
+
+private:
+    // Bytes of data_
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct Entry {
+        Span label;
+        Span text;  // inverted UTF-16 for CSF, the quoted bytes for STR
+        Span speech;
+    };
+
+    std::string_view span(Span s) const { return std::string_view(data_).substr(s.offset, s.size); }
+    void clear();
+
+    // Sort entries_, drop repeated labels and build slots_
+    void buildIndex();
+
+    std::string data_;
+    std::vector<Entry> entries_;    // ordered by label ignoring case
+    std::vector<uint32_t> slots_;   // open-addressed hash of folded labels -> entry index
+    uint32_t language_ = 0;
+    bool csf_ = false;
+
+    mutable std::mutex mutex_;
+    mutable std::vector<std::string_view> decoded_;  // per entry; data() is nullptr until decoded
+    mutable std::vector<std::string> blocks_;        // decoded strings; a block never grows past its capacity
+};
+
+} // namespace Text
+} // namespace ZeroSyntax
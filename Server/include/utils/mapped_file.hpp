@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ZeroSyntax {
+
+// Read-only view of a whole file. The file is memory-mapped where the
+// platform allows it and read into memory otherwise; either way contents()
+// stays valid until the MappedFile is closed or destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false, leaving the view empty, when the file cannot be opened
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    std::string_view contents() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    void* mapping_ = nullptr;  // set when data_ is a mapping
+    std::string buffer_;       // contents when the file could not be mapped
+};
+
+} // namespace ZeroSyntax
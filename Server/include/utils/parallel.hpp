@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ZeroSyntax {
+
+// Run body(index, worker) for every index in [0, count) on threadCount
+// threads (0 picks one per core); worker is in [0, returned thread count) so
+// callers can keep per-thread results without locking. Each thread owns a
+// contiguous slice of the indices and works through it front to back; a
+// thread whose slice runs dry steals the back half of the largest remaining
+// slice, so a few large items do not leave the other cores idle. The calling
+// thread is worker 0. Returns the number of threads used.
+size_t parallelFor(size_t count, size_t threadCount, const std::function<void(size_t index, size_t worker)>& body);
+
+} // namespace ZeroSyntax
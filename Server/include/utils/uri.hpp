@@ -0,0 +1,14 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+namespace ZeroSyntax {
+
+// file:// URI of an absolute filesystem path, percent-encoding reserved bytes
+std::string pathToUri(const std::string& path);
+
+// Filesystem path of a file:// URI, or nullopt for other schemes
+std::optional<std::string> uriToPath(const std::string& uri);
+
+} // namespace ZeroSyntax
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../utils/mapped_file.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+// A file stored in a BIG archive
+struct BigEntry {
+    std::string_view path;  // canonical game path (see normalizeGamePath)
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Read-only BIG archive ("BIGF"/"BIG4": a header, then one directory record
+// per file holding its big-endian offset and size and a NUL-terminated
+// path). The archive is mapped and its directory parsed once on open; paths
+// are interned into one buffer and entry contents are views into the
+// mapping, so nothing is copied or decoded until a caller reads it. Like
+// ArchiveFile::addFile, a path stored twice resolves to the later record.
+class BigArchive {
+public:
+    BigArchive() = default;
+
+    BigArchive(const BigArchive&) = delete;
+    BigArchive& operator=(const BigArchive&) = delete;
+
+    // false, leaving the archive empty, when the file is missing or is not a
+    // BIG archive; records pointing past the end of the file are dropped
+    bool open(const std::string& path);
+
+    const std::string& path() const { return path_; }
+
+    // Entries ordered by path
+    const std::vector<BigEntry>& entries() const { return entries_; }
+
+    // Entry by game path in any case and with either separator, or nullptr
+    const BigEntry* find(std::string_view path) const;
+
+    // Entries below a directory ("Data\INI\Object"), ordered by path
+    std::pair<const BigEntry*, const BigEntry*> entriesUnder(std::string_view directory) const;
+
+    // Stored bytes of an entry; valid while the archive is open
+    std::string_view contents(const BigEntry& entry) const {
+        return file_.contents().substr(entry.offset, entry.size);
+    }
+
+private:
+    void clear();
+
+    std::string path_;
+    MappedFile file_;
+    std::string paths_;  // every entry path, back to back
+    std::vector<BigEntry> entries_;
+};
+
+} // namespace Vfs
+} // namespace ZeroSyntax
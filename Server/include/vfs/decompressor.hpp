@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+// Format named by the header CompressionManager::compressData writes: four
+// bytes ("EAR\0", "EAB\0", "EAH\0", "NOX\0" or "ZL1\0".."ZL9\0"), the
+// uncompressed size as a little-endian 32-bit integer, then the codec's own
+// stream (EAC RefPack, BTree and Huffman, Nox LZHL or zlib)
+enum class Compression { None, RefPack, BTree, Huffman, NoxLzh, ZLib };
+
+// As CompressionManager::getCompressionType; None for data without a known header
+Compression compressionOf(std::string_view data);
+
+// Decode a whole buffer, copying data that is not compressed as it is. false,
+// leaving out empty, when the data is truncated or corrupt or uses NoxLzh or
+// ZLib, whose codecs are not part of the game sources.
+bool decompress(std::string_view data, std::string& out);
+
+class Codec;  // one per format, in decompressor.cpp
+
+// Reads a compressed buffer front to back, decoding a chunk at a time into a
+// window that holds only what RefPack may still copy from (128 KiB), so a
+// large .map or archive entry can be scanned without inflating all of it.
+// Every read of the input and every copy is bounds-checked: a truncated or
+// corrupt stream ends the output early and sets failed(), and never yields
+// more than size() bytes.
+class Decompressor {
+public:
+    // data must stay valid while the decompressor is used
+    explicit Decompressor(std::string_view data);
+    ~Decompressor();
+
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    Compression compression() const { return compression_; }
+
+    // Uncompressed size, from the header
+    size_t size() const { return size_; }
+
+    // Bytes read or skipped so far
+    size_t position() const { return position_; }
+
+    // Copy up to capacity of the next bytes to out; fewer only at the end of
+    // the data or when decoding failed
+    size_t read(char* out, size_t capacity);
+
+    // Decode past count bytes without copying them; false when the data ends
+    // or decoding fails first
+    bool skip(size_t count);
+
+    // The stream is corrupt or truncated, or its format is not supported
+    bool failed() const { return failed_; }
+
+private:
+    // Move up to count bytes past the read position, copying them to out unless it is null
+    size_t take(char* out, size_t count);
+
+    // Decode the next chunk into the window; false when nothing more comes
+    bool fill();
+
+    std::string_view data_;
+    Compression compression_ = Compression::None;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    bool failed_ = false;
+    bool ended_ = false;
+
+    std::unique_ptr<Codec> codec_;
+    std::vector<unsigned char> window_;
+    size_t windowSize_ = 0;  // decoded bytes in window_
+    size_t windowRead_ = 0;  // of which read
+    size_t dropped_ = 0;     // decoded bytes slid out of the window
+};
+
+} // namespace Vfs
+} // namespace ZeroSyntax
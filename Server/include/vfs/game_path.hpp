@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+// Canonical form of a game path: lower case, '/' separated, without empty
+// components ("Data\INI\\Object.ini" -> "data/ini/object.ini"). The engine
+// compares archive and loose paths the same way: lower-cased and split on
+// either separator (ArchiveFile::addFile).
+std::string normalizeGamePath(std::string_view path);
+
+// Append the canonical form of path to out
+void appendGamePath(std::string& out, std::string_view path);
+
+} // namespace Vfs
+} // namespace ZeroSyntax
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "big_archive.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+// How the engine reads a file (INILoadType)
+enum class LoadMode : uint8_t {
+    Overwrite,        // INI_LOAD_OVERWRITE: later definitions replace earlier ones
+    MultiFile,        // INI_LOAD_MULTIFILE: later definitions continue earlier ones
+    CreateOverrides,  // INI_LOAD_CREATE_OVERRIDES: map-local INIs
+};
+
+struct LoadedFile {
+    std::string path;  // canonical game path
+    LoadMode mode;
+    bool checksummed;  // part of the INI CRC multiplayer games compare (GlobalData::m_iniCRC)
+};
+
+// Where the bytes of a game path come from
+struct FileSource {
+    uint32_t layer;         // index into layers()
+    const BigEntry* entry;  // archive record, or nullptr for a loose file
+};
+
+// A loose directory or an archive
+struct Layer {
+    std::string path;
+    std::unique_ptr<BigArchive> archive;                 // nullptr for a loose directory
+    std::unordered_map<std::string, std::string> files;  // loose files: canonical path -> path below path
+};
+
+// The game's file system as the engine sees it: loose directories over BIG
+// archives. FileSystem::openFile asks TheLocalFileSystem before
+// TheArchiveFileSystem, so a loose file shadows every archive; archives are
+// merged with loadIntoDirectoryTree(overwrite = FALSE), so among archives
+// the one loaded first keeps a path. Every add precomputes which copy wins
+// for each path and the engine's INI load order, so queries are one hash
+// lookup and never touch the layers. Not thread-safe while layers are being
+// added; const methods may be called concurrently afterwards.
+class LayeredFileSystem {
+public:
+    // Add a directory of loose files; among directories, the one added first wins
+    void addDirectory(const std::string& root);
+
+    // Add one archive; false when it cannot be read
+    bool addArchive(const std::string& path);
+
+    // Add every *.big below a directory in the order loadBigFilesFromDirectory
+    // reads them (full path, ignoring case). Returns the number added.
+    size_t addArchiveDirectory(const std::string& directory);
+
+    const std::vector<Layer>& layers() const { return layers_; }
+
+    // The copy of a game path the engine reads, or nullptr
+    const FileSource* resolve(std::string_view path) const;
+
+    // Every copy of a game path, the one that wins first
+    std::vector<FileSource> sources(std::string_view path) const;
+
+    // Contents of the copy of path; false when a loose file cannot be read
+    bool read(const FileSource& source, std::string_view path, std::string& text) const;
+
+    // Filesystem path of the copy of path ("C:/Games/ZH/INIZH.big" for archived files)
+    std::string physicalPath(const FileSource& source, std::string_view path) const;
+
+    // Game paths below a directory with an extension, in INI::loadDirectory
+    // order: files directly in the directory first, then those in subdirectories
+    std::vector<std::string> listDirectory(std::string_view directory, std::string_view extension) const;
+
+    // INI files the engine loads, in load order; map-local INIs come last
+    const std::vector<LoadedFile>& loadOrder() const { return loadOrder_; }
+
+    // Position of a game path in loadOrder(), or nullopt if the engine never loads it
+    std::optional<uint32_t> loadRank(std::string_view path) const;
+
+    // Game path of a file below one of the loose directories, or nullopt
+    std::optional<std::string> gamePathOf(const std::string& filePath) const;
+
+private:
+    void addArchiveLayer(std::unique_ptr<BigArchive> archive, const std::string& path);
+    void addSource(const std::string& path, FileSource source);
+    void rebuildLoadOrder();
+
+    std::vector<Layer> layers_;
+    std::unordered_map<std::string, std::vector<FileSource>> files_;  // canonical path -> copies, winner first
+    std::vector<LoadedFile> loadOrder_;
+    std::unordered_map<std::string, uint32_t> ranks_;
+};
+
+} // namespace Vfs
+} // namespace ZeroSyntax
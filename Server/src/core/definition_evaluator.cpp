@@ -0,0 +1,478 @@
+#include "core/definition_evaluator.hpp"
+#include "ini/ini_schema.hpp"
+#include "ini/schema_context.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace ZeroSyntax {
+
+namespace {
+
+constexpr std::string_view kDefaultTemplate = "DefaultThingTemplate";
+
+// Parsed closed files kept between evaluations; a reskin chain rarely reads more
+constexpr size_t kTreeCacheSize = 64;
+
+// ThingTemplate::m_moduleParsingMode
+enum class ModuleMode : uint8_t {
+    Normal,
+    AddRemoveReplace,
+    Inheritable,
+    OverrideableByLikeKind,
+};
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// ModuleData::isAiModuleData: AIUpdateModuleData and the classes derived from it
+bool isAiModule(std::string_view name) {
+    const Ini::ModuleSchema* module = Ini::Schema::findModule(name);
+    return module && endsWith(module->dataClass, "AIUpdateModuleData");
+}
+
+// Stand-in for the interface mask test of clearCopiedFromDefaultEntries
+bool sharesInterface(const EffectiveModule& module, std::string_view field, std::string_view name) {
+    return module.field == field && (field != "Behavior" || module.name == name);
+}
+
+void setField(std::vector<EffectiveField>& fields, EffectiveField field) {
+    auto it = std::find_if(fields.begin(), fields.end(),
+                           [&](const EffectiveField& existing) { return existing.token == field.token; });
+    if (it != fields.end()) {
+        *it = std::move(field);
+    } else {
+        fields.push_back(std::move(field));
+    }
+}
+
+void eraseFields(std::vector<EffectiveField>& fields, std::string_view token) {
+    fields.erase(std::remove_if(fields.begin(), fields.end(),
+                                [&](const EffectiveField& field) { return field.token == token; }),
+                 fields.end());
+}
+
+} // namespace
+
+const EffectiveField* EffectiveModule::findField(std::string_view token) const {
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+        if (it->token == token) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+const EffectiveField* EffectiveObject::findField(std::string_view token) const {
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+        if (it->token == token) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+const EffectiveModule* EffectiveObject::findModule(std::string_view tag) const {
+    for (const auto& module : modules) {
+        if (module.tag == tag) {
+            return &module;
+        }
+    }
+    return nullptr;
+}
+
+// The template being assembled and the block being applied to it
+struct DefinitionEvaluator::Fold {
+    EffectiveObject object;
+    bool armorCopied = false;    // m_armorCopiedFromDefault
+    bool weaponsCopied = false;  // m_weaponsCopiedFromDefault
+
+    const Ini::SyntaxTree* tree = nullptr;
+    size_t sectionIndex = 0;
+    const std::string* uri = nullptr;
+    Vfs::LoadMode mode = Vfs::LoadMode::Overwrite;
+
+    const Ini::Section& section() const { return tree->section(sectionIndex); }
+
+    // ThingTemplate::copyFrom followed by setCopiedFromDefault
+    void copyFrom(const EffectiveObject& source) {
+        std::string name = std::move(object.name);
+        object = source;
+        object.name = std::move(name);
+        markCopied();
+    }
+
+    void markCopied() {
+        armorCopied = true;
+        weaponsCopied = true;
+        for (auto& module : object.modules) {
+            module.inherited = true;
+        }
+    }
+
+    EffectiveField fieldAt(uint32_t node) const {
+        const Ini::Section& current = section();
+        const Ini::Line& line = current.lines[current.nodes[node].line];
+        const Ini::Token* tokens = current.lineTokens(line);
+        EffectiveField field{std::string(current.tokenText(tokens[0])), {}, *uri, {}};
+        for (uint32_t t = 1; t < line.tokenCount; ++t) {
+            if (t > 1) {
+                field.value.push_back(' ');
+            }
+            field.value += current.tokenText(tokens[t]);
+        }
+        field.range.start = tree->tokenRange(sectionIndex, tokens[0]).start;
+        field.range.end = tree->tokenRange(sectionIndex, tokens[line.tokenCount - 1]).end;
+        return field;
+    }
+
+    // The fields of a block as ThingTemplate's field parse procs apply them
+    void applyChildren(uint32_t parent, ModuleMode moduleMode) {
+        const Ini::Section& current = section();
+        for (uint32_t node = parent + 1; node < current.nodes[parent].subtreeEnd;
+             node = current.nodes[node].subtreeEnd) {
+            const Ini::FieldSchema* field = Ini::nodeField(current, node);
+            std::string_view proc = field ? field->proc : std::string_view();
+            if (proc == "ThingTemplate::parseModuleName") {
+                addModule(node, moduleMode);
+            } else if (proc == "ThingTemplate::parseAddModule") {
+                applyChildren(node, ModuleMode::AddRemoveReplace);
+            } else if (proc == "ThingTemplate::parseReplaceModule") {
+                removeModule(current.nodeToken(current.nodes[node], 1));
+                applyChildren(node, ModuleMode::AddRemoveReplace);
+            } else if (proc == "ThingTemplate::parseInheritableModule") {
+                applyChildren(node, ModuleMode::Inheritable);
+            } else if (proc == "ThingTemplate::OverrideableByLikeKind") {
+                applyChildren(node, ModuleMode::OverrideableByLikeKind);
+            } else if (proc == "ThingTemplate::parseRemoveModule") {
+                removeModule(current.nodeToken(current.nodes[node], 1));
+            } else if (proc == "ThingTemplate::parseArmorTemplateSet") {
+                appendSet(node, armorCopied);
+            } else if (proc == "ThingTemplate::parseWeaponTemplateSet") {
+                appendSet(node, weaponsCopied);
+            } else if (proc == "ThingTemplate::parsePrerequisites") {
+                bool overriding = mode == Vfs::LoadMode::CreateOverrides;
+                appendSet(node, overriding);
+            } else {
+                setField(object.fields, fieldAt(node));
+            }
+        }
+    }
+
+    // ArmorSet, WeaponSet and Prerequisites add to a list that is emptied first when copied
+    void appendSet(uint32_t node, bool& copied) {
+        EffectiveField field = fieldAt(node);
+        if (copied) {
+            eraseFields(object.fields, field.token);
+            copied = false;
+        }
+        object.fields.push_back(std::move(field));
+    }
+
+    // ThingTemplate::parseModuleName
+    void addModule(uint32_t node, ModuleMode moduleMode) {
+        const Ini::Section& current = section();
+        const Ini::Node& header = current.nodes[node];
+        EffectiveModule module;
+        module.field = std::string(current.keyword(header));
+        module.name = std::string(current.nodeToken(header, 1));
+        module.tag = std::string(current.nodeToken(header, 2));
+        module.uri = *uri;
+        module.range = fieldAt(node).range;
+        module.inheritable = moduleMode == ModuleMode::Inheritable;
+        module.overrideableByLikeKind = moduleMode == ModuleMode::OverrideableByLikeKind;
+
+        auto& modules = object.modules;
+        if (mode != Vfs::LoadMode::CreateOverrides) {
+            modules.erase(std::remove_if(modules.begin(), modules.end(), [&](const EffectiveModule& existing) {
+                if (!existing.inherited || existing.inheritable || !sharesInterface(existing, module.field, module.name)) {
+                    return false;
+                }
+                return !existing.overrideableByLikeKind || existing.name == module.name;
+            }), modules.end());
+        }
+        if (module.field != "Draw" && module.field != "ClientUpdate" && isAiModule(module.name)) {
+            modules.erase(std::remove_if(modules.begin(), modules.end(), [](const EffectiveModule& existing) {
+                return existing.field != "Draw" && existing.field != "ClientUpdate" && isAiModule(existing.name);
+            }), modules.end());
+        }
+
+        for (uint32_t child = node + 1; child < header.subtreeEnd; child = current.nodes[child].subtreeEnd) {
+            if (current.nodes[child].kind == Ini::NodeKind::Block) {
+                module.fields.push_back(fieldAt(child));
+            } else {
+                setField(module.fields, fieldAt(child));
+            }
+        }
+        modules.push_back(std::move(module));
+    }
+
+    // ThingTemplate::removeModuleInfo
+    void removeModule(std::string_view tag) {
+        auto& modules = object.modules;
+        modules.erase(std::remove_if(modules.begin(), modules.end(),
+                                     [&](const EffectiveModule& module) { return module.tag == tag; }),
+                      modules.end());
+    }
+};
+
+DefinitionEvaluator::DefinitionEvaluator(const WorkspaceIndex& index, TreeSource trees, LoadSource loads)
+    : index_(index), trees_(std::move(trees)), loads_(std::move(loads)) {}
+
+std::shared_ptr<const EffectiveObject> DefinitionEvaluator::evaluate(const std::string& name) {
+    Pass pass;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        auto result = evaluateLocked(name, pass);
+        if (pass.missing.empty()) {
+            return result;
+        }
+
+        // Parse what the fold lacked without the lock, so invalidateFile never
+        // waits on I/O, then fold again with it; a reskin chain reveals its
+        // sources one pass at a time
+        std::vector<std::string> missing;
+        missing.swap(pass.missing);
+        uint64_t epoch = epoch_;
+        lock.unlock();
+        std::vector<std::shared_ptr<const Ini::SyntaxTree>> loaded;
+        loaded.reserve(missing.size());
+        for (const auto& uri : missing) {
+            loaded.push_back(trees_(uri));
+        }
+        lock.lock();
+
+        // A file changed meanwhile: any tree read so far may be stale
+        if (epoch != epoch_) {
+            pass.trees.clear();
+            continue;
+        }
+        for (size_t i = 0; i < missing.size(); ++i) {
+            if (loaded[i]) {
+                cacheTreeLocked(missing[i], loaded[i]);
+            }
+            pass.trees[missing[i]] = std::move(loaded[i]);
+        }
+    }
+}
+
+std::shared_ptr<const EffectiveObject> DefinitionEvaluator::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cached = objects_.find(name);
+    return cached != objects_.end() ? cached->second : nullptr;
+}
+
+void DefinitionEvaluator::refresh() {
+    std::unordered_set<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        names.swap(stale_);
+    }
+    for (const auto& name : names) {
+        evaluate(name);
+    }
+}
+
+void DefinitionEvaluator::invalidateFile(const std::string& uri, const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    treeCache_.erase(uri);
+    ++epoch_;
+
+    std::vector<std::string> stale(names);
+    auto readers = readers_.find(uri);
+    if (readers != readers_.end()) {
+        stale.insert(stale.end(), readers->second.begin(), readers->second.end());
+        readers_.erase(readers);
+    }
+
+    // Follow the reskin and default edges; dependents register again when re-evaluated
+    std::unordered_set<std::string> seen;
+    while (!stale.empty()) {
+        std::string name = std::move(stale.back());
+        stale.pop_back();
+        if (!seen.insert(name).second) {
+            continue;
+        }
+        objects_.erase(name);
+        stale_.insert(name);
+        auto dependents = dependents_.find(name);
+        if (dependents != dependents_.end()) {
+            stale.insert(stale.end(), dependents->second.begin(), dependents->second.end());
+            dependents_.erase(dependents);
+        }
+    }
+}
+
+void DefinitionEvaluator::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    objects_.clear();
+    treeCache_.clear();
+    stale_.clear();
+    ++epoch_;
+    readers_.clear();
+    dependents_.clear();
+}
+
+size_t DefinitionEvaluator::cachedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return objects_.size();
+}
+
+std::shared_ptr<const EffectiveObject> DefinitionEvaluator::evaluateLocked(const std::string& name, Pass& pass,
+                                                                         const BlockPosition* before) {
+    if (!before) {
+        auto cached = objects_.find(name);
+        if (cached != objects_.end()) {
+            return cached->second;
+        }
+    }
+    if (!evaluating_.insert(name).second) {
+        return nullptr;  // an ObjectReskin cycle, which the engine cannot load either
+    }
+
+    // Blocks in load order; files the engine never loads only count when no loaded file defines the name
+    struct Block {
+        const Definition* definition;
+        std::optional<LoadPosition> load;
+    };
+    std::vector<Definition> definitions = index_.findDefinitions("Object", name);
+    std::vector<Block> blocks;
+    blocks.reserve(definitions.size());
+    bool anyLoaded = false;
+    for (const auto& definition : definitions) {
+        std::optional<LoadPosition> load;
+        if (!blocks.empty() && blocks.back().definition->uri == definition.uri) {
+            load = blocks.back().load;
+        } else {
+            load = loads_(definition.uri);
+        }
+        anyLoaded = anyLoaded || load.has_value();
+        blocks.push_back(Block{&definition, load});
+    }
+    if (anyLoaded) {
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [](const Block& block) { return !block.load; }),
+                     blocks.end());
+        std::stable_sort(blocks.begin(), blocks.end(),
+                         [](const Block& a, const Block& b) { return a.load->rank < b.load->rank; });
+    }
+    auto positionOf = [](const Block& block) {
+        std::optional<uint32_t> rank;
+        if (block.load) {
+            rank = block.load->rank;
+        }
+        return BlockPosition{rank, block.definition->uri, block.definition->range.start.line};
+    };
+
+    bool partial = false;
+    if (before) {
+        // Positions in loaded and unloaded files do not compare; such blocks are kept
+        auto loadsLater = [&](const Block& block) {
+            BlockPosition position = positionOf(block);
+            if (position.rank.has_value() != before->rank.has_value()) {
+                return false;
+            }
+            if (position.rank && *position.rank != *before->rank) {
+                return *position.rank > *before->rank;
+            }
+            if (!position.rank && position.uri != before->uri) {
+                return position.uri > before->uri;
+            }
+            return position.line >= before->line;
+        };
+        auto end = std::remove_if(blocks.begin(), blocks.end(), loadsLater);
+        partial = end != blocks.end();
+        blocks.erase(end, blocks.end());
+        if (!partial) {
+            evaluating_.erase(name);
+            return evaluateLocked(name, pass);
+        }
+    }
+
+    Fold fold;
+    fold.object.name = name;
+    bool exists = false;
+    for (const Block& block : blocks) {
+        const Definition& definition = *block.definition;
+        readers_[definition.uri].insert(name);
+        auto tree = treeLocked(definition.uri, pass);
+        if (!tree) {
+            continue;
+        }
+        size_t sectionIndex = tree->findSectionByRow(static_cast<size_t>(definition.range.start.line));
+        const Ini::Section& section = tree->section(sectionIndex);
+        if (!section.hasRoot() || section.nodeToken(section.nodes[0], 1) != name) {
+            continue;
+        }
+        const Ini::Node& root = section.nodes[0];
+        BlockPosition position = positionOf(block);
+        fold.mode = block.load ? block.load->mode : Vfs::LoadMode::Overwrite;
+
+        // ThingFactory::parseObjectDefinition
+        if (section.keyword(root) == "ObjectReskin") {
+            std::string source(section.nodeToken(root, 2));
+            dependents_[source].insert(name);
+            auto copied = evaluateLocked(source, pass, &position);
+            if (!copied) {
+                continue;  // "ObjectReskin must come after the original Object"
+            }
+            fold.copyFrom(*copied);
+            fold.object.reskinOf = source;
+        } else if (!exists) {
+            if (name != kDefaultTemplate) {
+                std::string defaults(kDefaultTemplate);
+                dependents_[defaults].insert(name);
+                if (auto copied = evaluateLocked(defaults, pass, &position)) {
+                    fold.copyFrom(*copied);
+                    fold.object.reskinOf.clear();
+                }
+            }
+        } else if (fold.mode == Vfs::LoadMode::CreateOverrides) {
+            fold.markCopied();
+        }
+        exists = true;
+
+        fold.tree = tree.get();
+        fold.sectionIndex = sectionIndex;
+        fold.uri = &definition.uri;
+        fold.applyChildren(0, ModuleMode::Normal);
+        fold.object.layers.push_back(LSP::Location{definition.uri, definition.range});
+    }
+    evaluating_.erase(name);
+
+    if (!exists) {
+        return nullptr;
+    }
+    auto result = std::make_shared<const EffectiveObject>(std::move(fold.object));
+    if (!partial && pass.missing.empty()) {
+        objects_[name] = result;
+    }
+    return result;
+}
+
+std::shared_ptr<const Ini::SyntaxTree> DefinitionEvaluator::treeLocked(const std::string& uri, Pass& pass) {
+    auto read = pass.trees.find(uri);
+    if (read != pass.trees.end()) {
+        return read->second;
+    }
+    auto cached = treeCache_.find(uri);
+    if (cached != treeCache_.end()) {
+        cached->second.lastUse = ++treeClock_;
+        return pass.trees.emplace(uri, cached->second.tree).first->second;
+    }
+    if (std::find(pass.missing.begin(), pass.missing.end(), uri) == pass.missing.end()) {
+        pass.missing.push_back(uri);
+    }
+    return nullptr;
+}
+
+void DefinitionEvaluator::cacheTreeLocked(const std::string& uri, std::shared_ptr<const Ini::SyntaxTree> tree) {
+    treeCache_[uri] = CachedTree{std::move(tree), ++treeClock_};
+    if (treeCache_.size() > kTreeCacheSize) {
+        auto oldest = std::min_element(treeCache_.begin(), treeCache_.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        treeCache_.erase(oldest);
+    }
+}
+
+} // namespace ZeroSyntax
@@ -1,105 +1,870 @@
 #include "core/document_manager.hpp"
+#include "ini/completion.hpp"
+#include "ini/field_validator.hpp"
+#include "ini/ini_grammar.hpp"
+#include "ini/schema_context.hpp"
+#include "ini/value_units.hpp"
+#include "text/fuzzy_matcher.hpp"
 #include "utils/logger.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/parallel.hpp"
+#include "utils/uri.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <utility>
 
 namespace ZeroSyntax {
 
-DocumentManager::DocumentManager() {
+namespace {
+
+// Items of one completion response; the list is marked incomplete beyond
+constexpr size_t kMaxCompletionItems = 200;
+
+// LSP CompletionItemKind
+constexpr int kCompletionText = 1;
+constexpr int kCompletionField = 5;
+constexpr int kCompletionClass = 7;
+constexpr int kCompletionModule = 9;
+constexpr int kCompletionKeyword = 14;
+constexpr int kCompletionReference = 18;
+constexpr int kCompletionEnumMember = 20;
+
+int completionItemKind(Ini::CandidateKind kind) {
+    switch (kind) {
+        case Ini::CandidateKind::BlockType:
+            return kCompletionClass;
+        case Ini::CandidateKind::Field:
+            return kCompletionField;
+        case Ini::CandidateKind::Module:
+            return kCompletionModule;
+        case Ini::CandidateKind::Name:
+            return kCompletionEnumMember;
+        case Ini::CandidateKind::Keyword:
+            return kCompletionKeyword;
+    }
+    return kCompletionText;
+}
+
+const char* loadModeName(Vfs::LoadMode mode) {
+    switch (mode) {
+        case Vfs::LoadMode::Overwrite:
+            return "INI_LOAD_OVERWRITE";
+        case Vfs::LoadMode::MultiFile:
+            return "INI_LOAD_MULTIFILE";
+        case Vfs::LoadMode::CreateOverrides:
+            return "INI_LOAD_CREATE_OVERRIDES";
+    }
+    return "";
+}
+
+} // namespace
+
+DocumentManager::DocumentManager()
+    : evaluator_(index_,
+                 [this](const std::string& uri) { return loadSyntaxTree(uri); },
+                 [this](const std::string& uri) -> std::optional<LoadPosition> {
+                     auto path = uriToPath(uri);
+                     auto gamePath = path ? files_.gamePathOf(*path) : std::nullopt;
+                     auto rank = gamePath ? files_.loadRank(*gamePath) : std::nullopt;
+                     if (!rank) {
+                         return std::nullopt;
+                     }
+                     return LoadPosition{*rank, files_.loadOrder()[*rank].mode};
+                 }) {
     LOG_INFO("Document manager initialized");
 }
 
 void DocumentManager::addDocument(const std::string& uri, const std::string& text, const std::string& languageId) {
-    documents_[uri] = Document{uri, text, languageId, 0};
-    parseIniDocument(documents_[uri]);
+    auto document = std::make_shared<Document>(Document{uri, PieceTable(text), languageId, 0, nullptr});
+    parseIniDocument(*document);
+    indexDocument(*document);
+    publishDocument(std::move(document));
     LOG_INFO("Added document: {}", uri);
 }
 
 void DocumentManager::updateDocument(const std::string& uri, int version, const std::string& text) {
-    if (documents_.find(uri) != documents_.end()) {
-        documents_[uri].text = text;
-        documents_[uri].version = version;
-        parseIniDocument(documents_[uri]);
+    auto current = findDocument(uri);
+    if (current) {
+        auto document = std::make_shared<Document>(*current);
+        document->text = PieceTable(text);
+        document->version = version;
+        parseIniDocument(*document);
+        indexDocument(*document);
+        publishDocument(std::move(document));
         LOG_INFO("Updated document: {} to version {}", uri, version);
     } else {
         LOG_WARN("Tried to update non-existent document: {}", uri);
     }
 }
 
+void DocumentManager::applyChanges(const std::string& uri, int version,
+                                   const std::vector<LSP::TextDocumentContentChangeEvent>& changes) {
+    auto current = findDocument(uri);
+    if (!current) {
+        LOG_WARN("Tried to change non-existent document: {}", uri);
+        return;
+    }
+    
+    auto document = std::make_shared<Document>(*current);
+    for (const auto& change : changes) {
+        if (change.range) {
+            size_t start = document->text.offsetAt(change.range->start);
+            size_t end = document->text.offsetAt(change.range->end);
+            if (end < start) {
+                std::swap(start, end);
+            }
+            document->text.replace(start, end - start, change.text);
+            
+            // Re-lex only the blocks touched by the change
+            if (document->syntax) {
+                document->syntax = std::make_shared<const Ini::SyntaxTree>(
+                    document->syntax->edit(document->text, start, end - start, change.text.size()));
+            }
+        } else {
+            document->text = PieceTable(change.text);
+            document->syntax = nullptr;
+        }
+    }
+    document->version = version;
+    if (!document->syntax) {
+        parseIniDocument(*document);
+    }
+    indexDocument(*document);
+    publishDocument(std::move(document));
+    LOG_INFO("Applied {} change(s) to document: {} at version {}", changes.size(), uri, version);
+}
+
 void DocumentManager::removeDocument(const std::string& uri) {
-    auto it = documents_.find(uri);
-    if (it != documents_.end()) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = documents_.find(uri);
+        if (it == documents_.end()) {
+            return;
+        }
         documents_.erase(it);
-        LOG_INFO("Removed document: {}", uri);
     }
+    
+    // Unsaved edits are gone; the file on disk defines its symbols again
+    index_.indexFile(uri);
+    evaluator_.invalidateFile(uri, index_.definitionNames(uri));
+    LOG_INFO("Removed document: {}", uri);
 }
 
 std::string DocumentManager::getDocumentText(const std::string& uri) const {
-    auto it = documents_.find(uri);
-    if (it != documents_.end()) {
-        return it->second.text;
+    auto document = findDocument(uri);
+    if (document) {
+        return document->text.text();
     }
     return "";
 }
 
 bool DocumentManager::hasDocument(const std::string& uri) const {
-    return documents_.find(uri) != documents_.end();
+    return findDocument(uri) != nullptr;
+}
+
+std::shared_ptr<const Ini::SyntaxTree> DocumentManager::getSyntaxTree(const std::string& uri) const {
+    auto document = findDocument(uri);
+    return document ? document->syntax : nullptr;
+}
+
+std::shared_ptr<const DocumentManager::Document> DocumentManager::findDocument(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = documents_.find(uri);
+    return it != documents_.end() ? it->second : nullptr;
+}
+
+void DocumentManager::publishDocument(std::shared_ptr<const Document> document) {
+    std::string uri = document->uri;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        documents_[uri] = std::move(document);
+    }
+    // Only once readers can see the new version, or they could memoize the old one
+    evaluator_.invalidateFile(uri, index_.definitionNames(uri));
 }
 
 std::vector<LSP::Diagnostic> DocumentManager::validateDocument(const std::string& uri) {
     std::vector<LSP::Diagnostic> diagnostics;
     
-    if (!hasDocument(uri)) {
+    auto document = findDocument(uri);
+    if (!document) {
         LOG_WARN("Tried to validate non-existent document: {}", uri);
         return diagnostics;
     }
     
-    // TODO: Implement actual validation logic based on INI file parsing
-    // For now, returning empty diagnostics (no errors)
+    if (document->syntax) {
+        diagnostics = Ini::validateTree(*document->syntax);
+    }
+    auto labels = validateLabels(uri);
+    diagnostics.insert(diagnostics.end(), std::make_move_iterator(labels.begin()), std::make_move_iterator(labels.end()));
     
     LOG_INFO("Validated document: {} with {} diagnostics", uri, diagnostics.size());
     return diagnostics;
 }
 
+void DocumentManager::indexWorkspace(const std::string& rootPath, const std::string& cachePath,
+                                     const std::vector<std::string>& gameDirectories, const std::string& language) {
+    files_ = Vfs::LayeredFileSystem();
+    files_.addDirectory(rootPath);
+    files_.addArchiveDirectory(rootPath);
+    for (const auto& directory : gameDirectories) {
+        files_.addArchiveDirectory(directory);
+    }
+    
+    IndexOptions options;
+    options.skip = [this](const std::string& uri) { return hasDocument(uri); };
+    options.cachePath = cachePath;
+    index_.indexDirectory(rootPath, options);
+    evaluator_.clear();
+    loadStringTable(language);
+    checksum_.rebuild(files_);
+    // Archived definitions only matter to the map checks
+    if (maps_.indexDirectory(rootPath) > 0) {
+        indexArchivedDefinitions();
+    }
+}
+
+void DocumentManager::indexArchivedDefinitions() {
+    auto started = std::chrono::steady_clock::now();
+    std::vector<const Vfs::LoadedFile*> archived;
+    for (const Vfs::LoadedFile& loaded : files_.loadOrder()) {
+        const Vfs::FileSource* source = files_.resolve(loaded.path);
+        if (source && source->entry) {
+            archived.push_back(&loaded);
+        }
+    }
+    std::vector<StoreNames> names(archived.size());
+    parallelFor(archived.size(), 0, [&](size_t i, size_t) {
+        const std::string& path = archived[i]->path;
+        std::string text;
+        if (!files_.read(*files_.resolve(path), path, text)) {
+            return;
+        }
+        for (auto& definition : WorkspaceIndex::collect(path, Ini::SyntaxTree::parse(text)).definitions) {
+            std::string_view store = Ini::definitionNamespace(definition.blockType);
+            if (store == "Object" || store == "Upgrade" || store == "Science" || store == "SpecialPower") {
+                names[i][std::string(store)].push_back(std::move(definition.name));
+            }
+        }
+    });
+    archivedNames_.clear();
+    size_t count = 0;
+    for (auto& file : names) {
+        for (auto& [store, defined] : file) {
+            std::vector<std::string>& all = archivedNames_[store];
+            all.insert(all.end(), std::make_move_iterator(defined.begin()), std::make_move_iterator(defined.end()));
+        }
+    }
+    for (auto& store : archivedNames_) {
+        std::sort(store.second.begin(), store.second.end());
+        store.second.erase(std::unique(store.second.begin(), store.second.end()), store.second.end());
+        count += store.second.size();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("Read {} definitions from {} archived INI files in {} ms", count, archived.size(), elapsed.count());
+}
+
+StoreNames DocumentManager::missingDefinitions(const StoreNames& names) const {
+    StoreNames missing;
+    for (const auto& [store, referenced] : names) {
+        std::vector<bool> defined = index_.defines(store, referenced);
+        auto archived = archivedNames_.find(store);
+        for (size_t i = 0; i < referenced.size(); ++i) {
+            if (!defined[i] && (archived == archivedNames_.end() ||
+                                !std::binary_search(archived->second.begin(), archived->second.end(), referenced[i]))) {
+                missing[store].push_back(referenced[i]);
+            }
+        }
+    }
+    return missing;
+}
+
+std::unordered_map<std::string, std::vector<LSP::Diagnostic>> DocumentManager::validateMaps() const {
+    auto started = std::chrono::steady_clock::now();
+    StoreNames names = maps_.referencedNames();
+    StoreNames missing = missingDefinitions(names);
+    auto diagnostics = maps_.diagnose(missing);
+    size_t referenced = 0;
+    size_t unknown = 0;
+    for (const auto& store : names) {
+        referenced += store.second.size();
+    }
+    for (const auto& store : missing) {
+        unknown += store.second.size();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("Checked {} definitions placed or scripted on {} maps in {} ms: {} missing", referenced,
+             diagnostics.size(), elapsed.count(), unknown);
+    return diagnostics;
+}
+
+std::vector<LSP::Diagnostic> DocumentManager::refreshMap(const std::string& uri) {
+    maps_.indexFile(uri);
+    return maps_.diagnose(uri, missingDefinitions(maps_.referencedNames(uri)));
+}
+
+void DocumentManager::refreshFile(const std::string& uri) {
+    if (hasDocument(uri)) {
+        return;
+    }
+    index_.indexFile(uri);
+    evaluator_.invalidateFile(uri, index_.definitionNames(uri));
+}
+
+bool DocumentManager::refreshIniChecksum(const std::string& uri) {
+    // The copy the engine reads, which a saved file may not be
+    auto path = uriToPath(uri);
+    auto gamePath = path ? files_.gamePathOf(*path) : std::nullopt;
+    auto rank = gamePath ? files_.loadRank(*gamePath) : std::nullopt;
+    if (!rank || !files_.loadOrder()[*rank].checksummed) {
+        return false;
+    }
+    const Vfs::FileSource* source = files_.resolve(*gamePath);
+    std::string text;
+    if (!source || !files_.read(*source, *gamePath, text)) {
+        return false;
+    }
+    return checksum_.update(*gamePath, text);
+}
+
+std::unordered_map<std::string, std::vector<LSP::Diagnostic>> DocumentManager::validateLabels() const {
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> diagnostics;
+    std::shared_ptr<const Text::StringTable> strings;
+    std::string stringsUri;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        strings = strings_;
+        stringsUri = stringsUri_;
+    }
+    if (!strings || strings->empty()) {
+        return diagnostics;
+    }
+    auto started = std::chrono::steady_clock::now();
+    std::vector<Reference> uses = index_.labelReferences();
+    std::vector<uint32_t> indices = addMissingLabels(uses, *strings, diagnostics);
+    size_t missing = 0;
+    for (const auto& entry : diagnostics) {
+        missing += entry.second.size();
+    }
+    
+    // Unused labels, found by marking what the uses resolved to
+    std::vector<bool> used(strings->size());
+    for (uint32_t index : indices) {
+        if (index != Text::StringTable::kMissing) {
+            used[index] = true;
+        }
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> unused;  // offset, index
+    for (uint32_t index = 0; index < strings->size(); ++index) {
+        if (!used[index]) {
+            unused.emplace_back(strings->labelOffset(index), index);
+        }
+    }
+    if (!stringsUri.empty() && !unused.empty()) {
+        // Offsets to positions in one walk over the file
+        std::sort(unused.begin(), unused.end());
+        std::string_view source = strings->source();
+        auto& hints = diagnostics[stringsUri];
+        int line = 0;
+        size_t lineStart = 0;
+        size_t scanned = 0;
+        for (const auto& label : unused) {
+            for (; scanned < label.first; ++scanned) {
+                if (source[scanned] == '\n') {
+                    ++line;
+                    lineStart = scanned + 1;
+                }
+            }
+            int character = static_cast<int>(label.first - lineStart);
+            std::string_view name = strings->label(label.second);
+            hints.push_back(LSP::Diagnostic{
+                LSP::Range{{line, character}, {line, character + static_cast<int>(name.size())}},
+                LSP::DiagnosticSeverity::Hint, "Label '" + std::string(name) + "' is not used by any INI file",
+                std::string("ZeroSyntax")});
+        }
+    }
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("Checked {} label uses against {} strings in {} ms: {} missing, {} unused", uses.size(), strings->size(),
+             elapsed.count(), missing, unused.size());
+    return diagnostics;
+}
+
+std::vector<LSP::Diagnostic> DocumentManager::validateLabels(const std::string& uri) const {
+    auto strings = stringTable();
+    if (!strings || strings->empty()) {
+        return {};
+    }
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> diagnostics;
+    addMissingLabels(index_.labelReferences(uri), *strings, diagnostics);
+    return std::move(diagnostics[uri]);
+}
+
+std::vector<uint32_t> DocumentManager::addMissingLabels(const std::vector<Reference>& uses, const Text::StringTable& table,
+                                       std::unordered_map<std::string, std::vector<LSP::Diagnostic>>& diagnostics) {
+    std::vector<std::string_view> labels;
+    labels.reserve(uses.size());
+    for (const auto& use : uses) {
+        labels.push_back(use.name);
+    }
+    std::vector<uint32_t> indices = table.resolve(labels);
+    for (size_t i = 0; i < uses.size(); ++i) {
+        if (indices[i] == Text::StringTable::kMissing) {
+            diagnostics[uses[i].uri].push_back(LSP::Diagnostic{
+                uses[i].range, LSP::DiagnosticSeverity::Warning,
+                "Label '" + uses[i].name + "' is not in the string table; the game shows MISSING: '" + uses[i].name + "'",
+                std::string("ZeroSyntax")});
+        }
+    }
+    return indices;
+}
+
+std::shared_ptr<const Text::StringTable> DocumentManager::stringTable() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return strings_;
+}
+
+void DocumentManager::loadStringTable(const std::string& language) {
+    auto table = std::make_shared<Text::StringTable>();
+    std::string uri;
+    const std::string strPath = "Data/Generals.str";
+    const std::string csfPath = "Data/" + language + "/Generals.csf";
+    std::string data;
+    if (const Vfs::FileSource* source = files_.resolve(strPath)) {
+        if (files_.read(*source, strPath, data) && table->loadStr(std::move(data))) {
+            LOG_INFO("Loaded {} strings from {}", table->size(), files_.physicalPath(*source, strPath));
+            if (!source->entry) {
+                uri = pathToUri(files_.physicalPath(*source, strPath));
+            }
+        }
+    } else if (const Vfs::FileSource* source = files_.resolve(csfPath)) {
+        if (files_.read(*source, csfPath, data) && table->loadCsf(std::move(data))) {
+            LOG_INFO("Loaded {} strings from {}", table->size(), files_.physicalPath(*source, csfPath));
+        }
+    } else {
+        LOG_INFO("No string table in the game files");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    strings_ = std::move(table);
+    stringsUri_ = std::move(uri);
+}
+
 std::optional<LSP::Location> DocumentManager::findDefinition(const std::string& uri, const LSP::Position& position) {
-    if (!hasDocument(uri)) {
+    auto document = findDocument(uri);
+    if (!document) {
         LOG_WARN("Tried to find definition in non-existent document: {}", uri);
         return std::nullopt;
     }
     
-    // TODO: Implement actual definition finding logic
-    // For now, returning nullptr (no definition found)
+    auto symbol = symbolAt(*document, position);
+    if (!symbol) {
+        return std::nullopt;
+    }
+    std::vector<Definition> definitions = symbol->blockType.empty()
+        ? index_.findDefinitions(symbol->name)
+        : index_.findDefinitions(symbol->blockType, symbol->name);
     
-    LOG_INFO("No definition found at {}:{} in {}", position.line, position.character, uri);
-    return std::nullopt;
+    if (definitions.empty()) {
+        LOG_INFO("No definition found at {}:{} in {}", position.line, position.character, uri);
+        return std::nullopt;
+    }
+    const Definition& definition = effectiveDefinition(definitions);
+    return LSP::Location{definition.uri, definition.range};
 }
 
-std::vector<LSP::CompletionItem> DocumentManager::provideCompletions(const std::string& uri, const LSP::Position& position) {
-    std::vector<LSP::CompletionItem> completions;
+std::vector<LSP::Location> DocumentManager::findReferences(const std::string& uri, const LSP::Position& position,
+                                                           bool includeDeclaration) {
+    std::vector<LSP::Location> locations;
+    auto document = findDocument(uri);
+    if (!document) {
+        LOG_WARN("Tried to find references in non-existent document: {}", uri);
+        return locations;
+    }
+    
+    auto symbol = symbolAt(*document, position);
+    if (!symbol) {
+        return locations;
+    }
+    std::vector<Definition> definitions = symbol->blockType.empty()
+        ? index_.findDefinitions(symbol->name)
+        : index_.findDefinitions(symbol->blockType, symbol->name);
+    // An untyped name takes the store of whatever it resolves to
+    std::string_view blockType = symbol->blockType;
+    if (blockType.empty()) {
+        if (definitions.empty()) {
+            return locations;
+        }
+        blockType = definitions.front().blockType;
+    }
     
-    if (!hasDocument(uri)) {
+    if (includeDeclaration) {
+        for (const auto& definition : definitions) {
+            if (Ini::definitionNamespace(definition.blockType) == Ini::definitionNamespace(blockType)) {
+                locations.push_back(LSP::Location{definition.uri, definition.range});
+            }
+        }
+    }
+    for (const auto& reference : index_.findReferences(blockType, symbol->name)) {
+        locations.push_back(LSP::Location{reference.uri, reference.range});
+    }
+    return locations;
+}
+
+std::shared_ptr<const EffectiveObject> DocumentManager::effectiveObject(const std::string& name) {
+    return evaluator_.evaluate(name);
+}
+
+void DocumentManager::refreshDefinitions() {
+    evaluator_.refresh();
+}
+
+std::optional<EffectiveField> DocumentManager::effectiveField(const std::string& uri, const LSP::Position& position) {
+    auto document = findDocument(uri);
+    if (!document) {
+        LOG_WARN("Tried to evaluate a field in non-existent document: {}", uri);
+        return std::nullopt;
+    }
+    
+    // Field line under the cursor inside an Object or ObjectReskin
+    const Ini::SyntaxTree& tree = *document->syntax;
+    size_t offset = document->text.offsetAt(position);
+    size_t sectionIndex = tree.findSection(offset);
+    if (sectionIndex >= tree.sectionCount()) {
+        return std::nullopt;
+    }
+    const Ini::Section& section = tree.section(sectionIndex);
+    if (!section.hasRoot() || Ini::definitionNamespace(section.keyword(section.nodes[0])) != "Object") {
+        return std::nullopt;
+    }
+    uint32_t relative = static_cast<uint32_t>(offset - tree.sectionOffset(sectionIndex));
+    uint32_t node = Ini::nodeAtLine(section, section.lineAt(relative));
+    if (node == Ini::kNone || node == 0) {
+        return std::nullopt;
+    }
+    auto object = evaluator_.find(std::string(section.nodeToken(section.nodes[0], 1)));
+    if (!object) {
+        return std::nullopt;
+    }
+    std::string_view token = section.keyword(section.nodes[node]);
+    
+    // Fields of the module the line belongs to are looked up in the module with its tag
+    for (uint32_t ancestor = node; ancestor != 0; ancestor = section.nodes[ancestor].parent) {
+        const Ini::FieldSchema* field = Ini::nodeField(section, ancestor);
+        if (!field || field->proc != "ThingTemplate::parseModuleName") {
+            continue;
+        }
+        const EffectiveModule* module = object->findModule(section.nodeToken(section.nodes[ancestor], 2));
+        if (!module) {
+            return std::nullopt;
+        }
+        if (ancestor == node) {
+            return EffectiveField{module->field, module->name + " " + module->tag, module->uri, module->range};
+        }
+        const EffectiveField* effective = section.nodes[node].parent == ancestor ? module->findField(token) : nullptr;
+        return effective ? std::optional<EffectiveField>(*effective) : std::nullopt;
+    }
+    if (section.nodes[node].parent != 0) {
+        return std::nullopt;
+    }
+    const EffectiveField* effective = object->findField(token);
+    return effective ? std::optional<EffectiveField>(*effective) : std::nullopt;
+}
+
+LSP::CompletionList DocumentManager::provideCompletions(const std::string& uri, const LSP::Position& position) {
+    LSP::CompletionList completions{false, {}};
+    
+    auto document = findDocument(uri);
+    if (!document) {
         LOG_WARN("Tried to get completions in non-existent document: {}", uri);
         return completions;
     }
     
-    // TODO: Implement actual completion logic
-    // For now, return a simple dummy completion
+    const Ini::SyntaxTree& tree = *document->syntax;
+    size_t offset = document->text.offsetAt(position);
+    Ini::CompletionContext context = Ini::topLevelContext();
+    if (tree.sectionCount() > 0) {
+        size_t sectionIndex = tree.findSection(offset);
+        context = Ini::completionContext(tree.section(sectionIndex),
+                                         static_cast<uint32_t>(offset - tree.sectionOffset(sectionIndex)));
+    }
+    
+    auto add = [&completions](std::string_view label, std::string_view detail, int kind) {
+        if (completions.items.size() == kMaxCompletionItems) {
+            completions.isIncomplete = true;
+            return false;
+        }
+        LSP::CompletionItem item;
+        item.label = std::string(label);
+        if (!detail.empty()) {
+            item.detail = std::string(detail);
+        }
+        item.kind = kind;
+        completions.items.push_back(std::move(item));
+        return true;
+    };
     
-    LSP::CompletionItem item;
-    item.label = "Example";
-    item.detail = "Example completion";
-    item.documentation = "This is an example completion item";
-    item.kind = 1;  // Text
+    auto lists = Ini::completionCandidates(context);
+    if (context.prefix.empty()) {
+        for (const Ini::CandidateList* list : lists) {
+            for (const Ini::Candidate& candidate : list->withPrefix({})) {
+                if (!add(candidate.label, candidate.detail, completionItemKind(list->kind()))) {
+                    break;
+                }
+            }
+        }
+    } else {
+        // Rank the candidates of every list together, so "bc" finds BuildCost
+        Text::FuzzyMatcher matcher(context.prefix);
+        Text::TopMatches top(kMaxCompletionItems + 1);
+        std::vector<std::pair<const Ini::CandidateList*, uint32_t>> matched;
+        std::vector<uint32_t> hits;
+        for (const Ini::CandidateList* list : lists) {
+            hits.clear();
+            Text::filterMasks(list->masks(), list->size(), matcher.mask(), hits);
+            for (uint32_t hit : hits) {
+                std::string_view label = (*list)[hit].label;
+                if (auto score = matcher.score(label)) {
+                    top.add(static_cast<uint32_t>(matched.size()), *score, static_cast<uint32_t>(label.size()));
+                    matched.emplace_back(list, hit);
+                }
+            }
+        }
+        for (const auto& match : top.take()) {
+            const auto& [list, hit] = matched[match.index];
+            if (!add((*list)[hit].label, (*list)[hit].detail, completionItemKind(list->kind()))) {
+                break;
+            }
+        }
+    }
     
-    completions.push_back(item);
+    if (context.site == Ini::CompletionSite::Value && context.value == 0) {
+        if (context.field->kind == Ini::FieldKind::Reference) {
+            for (const auto& name : index_.completeNames(context.field->reference, context.prefix,
+                                                         kMaxCompletionItems + 1)) {
+                if (!add(name, context.field->reference, kCompletionReference)) {
+                    break;
+                }
+            }
+        } else if (context.field->kind == Ini::FieldKind::Label) {
+            if (auto strings = stringTable()) {
+                auto range = strings->withPrefix(context.prefix);
+                for (uint32_t i = range.first; i < range.second; ++i) {
+                    if (!add(strings->label(i), {}, kCompletionText)) {
+                        break;
+                    }
+                    completions.items.back().documentation = std::string(strings->text(i));
+                }
+            }
+        }
+    }
     
     LOG_INFO("Provided {} completion items for {}:{}",
-             completions.size(), position.line, position.character);
+             completions.items.size(), position.line, position.character);
     
     return completions;
 }
 
+std::optional<LSP::Hover> DocumentManager::hover(const std::string& uri, const LSP::Position& position) {
+    auto document = findDocument(uri);
+    if (!document) {
+        LOG_WARN("Tried to hover in non-existent document: {}", uri);
+        return std::nullopt;
+    }
+    
+    // Token under the cursor
+    const Ini::SyntaxTree& tree = *document->syntax;
+    size_t offset = document->text.offsetAt(position);
+    size_t sectionIndex = tree.findSection(offset);
+    if (sectionIndex >= tree.sectionCount()) {
+        return std::nullopt;
+    }
+    const Ini::Section& section = tree.section(sectionIndex);
+    uint32_t relative = static_cast<uint32_t>(offset - tree.sectionOffset(sectionIndex));
+    uint32_t lineIndex = section.lineAt(relative);
+    const Ini::Line& line = section.lines[lineIndex];
+    uint32_t node = Ini::nodeAtLine(section, lineIndex);
+    uint32_t token = Ini::tokenAt(section, line, relative);
+    if (node == Ini::kNone || token == Ini::kNone) {
+        return std::nullopt;
+    }
+    const Ini::Token* tokens = section.lineTokens(line);
+    LSP::Hover hover{{}, tree.tokenRange(sectionIndex, tokens[token])};
+    std::string& text = hover.contents;
+    
+    // Block header: the definition the engine uses and how many blocks define the name
+    const Ini::Node& current = section.nodes[node];
+    if (current.parent == Ini::kNone) {
+        const Ini::BlockSchema* block = Ini::Schema::findBlock(section.keyword(current));
+        if (!block) {
+            return std::nullopt;
+        }
+        text = "**" + std::string(block->name) + "**";
+        std::string name(section.nodeToken(current, 1));
+        if (name.empty()) {
+            return hover;
+        }
+        text += " " + name;
+        std::vector<Definition> definitions = index_.findDefinitions(block->name, name);
+        if (!definitions.empty()) {
+            const Definition& effective = effectiveDefinition(definitions);
+            text += "\n\nDefined " + std::to_string(definitions.size()) +
+                    (definitions.size() == 1 ? " time" : " times") + "; in effect: " +
+                    describeLocation(effective.uri, effective.range.start);
+        }
+        return hover;
+    }
+    
+    // Field line: the token written, its parse proc and the value the engine stores
+    std::string_view keyword = section.keyword(current);
+    const Ini::FieldSchema* field = Ini::nodeField(section, node);
+    text = "**" + std::string(keyword) + "**";
+    if (field) {
+        text += " `" + std::string(field->proc) + "`";
+    }
+    uint32_t valueToken = token > 0 ? token : 1;
+    std::string_view value = valueToken < line.tokenCount ? section.tokenText(tokens[valueToken]) : std::string_view();
+    
+    if (field && field->kind == Ini::FieldKind::Module) {
+        if (const Ini::ModuleSchema* module = Ini::Schema::findModule(section.nodeToken(current, 1))) {
+            text += "\n\nModule **" + std::string(module->name) + "**, data `" + std::string(module->dataClass) + "`";
+        }
+    } else if (field && !value.empty()) {
+        if (auto converted = Ini::convertedValue(field->proc, value)) {
+            text += "\n\n" + *converted;
+        }
+        if (field->kind == Ini::FieldKind::Label) {
+            auto strings = stringTable();
+            auto label = strings ? strings->find(value) : std::nullopt;
+            if (label) {
+                text += "\n\n" + std::string(value) + ": \"" + std::string(strings->text(*label)) + "\"";
+            } else if (strings && !strings->empty()) {
+                text += "\n\n" + std::string(value) + " is missing from the string table";
+            }
+        } else if (field->kind == Ini::FieldKind::Reference) {
+            std::vector<Definition> definitions = index_.findDefinitions(field->reference, std::string(value));
+            if (!definitions.empty()) {
+                const Definition& effective = effectiveDefinition(definitions);
+                text += "\n\n" + std::string(field->reference) + " " + std::string(value) + ": " +
+                        describeLocation(effective.uri, effective.range.start);
+            }
+        }
+    }
+    
+    // Provenance: this line, and the line a later layer overrides it with
+    LSP::Position start = tree.positionAt(sectionIndex, line.offset);
+    text += "\n\nSet in " + describeLocation(uri, start);
+    if (auto effective = effectiveField(uri, position)) {
+        if (effective->uri != uri || effective->range.start.line != start.line) {
+            text += "\n\nIn effect: `" + effective->token + " = " + effective->value + "` from " +
+                    describeLocation(effective->uri, effective->range.start);
+            std::string_view first = std::string_view(effective->value).substr(0, effective->value.find(' '));
+            if (field && !first.empty()) {
+                if (auto converted = Ini::convertedValue(field->proc, first)) {
+                    text += " (" + *converted + ")";
+                }
+            }
+        }
+    }
+    return hover;
+}
+
+std::string DocumentManager::describeLocation(const std::string& uri, const LSP::Position& position) const {
+    auto path = uriToPath(uri);
+    auto gamePath = path ? files_.gamePathOf(*path) : std::nullopt;
+    std::string text = "`" + (gamePath ? *gamePath : path ? *path : uri) + "` line " + std::to_string(position.line + 1);
+    auto rank = gamePath ? files_.loadRank(*gamePath) : std::nullopt;
+    if (!rank) {
+        return text + " (not loaded by the game)";
+    }
+    return text + " (load order " + std::to_string(*rank + 1) + " of " + std::to_string(files_.loadOrder().size()) +
+           ", " + loadModeName(files_.loadOrder()[*rank].mode) + ")";
+}
+
+std::optional<DocumentManager::SymbolQuery> DocumentManager::symbolAt(const Document& document,
+                                                                        const LSP::Position& position) const {
+    // Token under the cursor
+    const Ini::SyntaxTree& tree = *document.syntax;
+    size_t offset = document.text.offsetAt(position);
+    size_t sectionIndex = tree.findSection(offset);
+    if (sectionIndex >= tree.sectionCount()) {
+        return std::nullopt;
+    }
+    const Ini::Section& section = tree.section(sectionIndex);
+    uint32_t relative = static_cast<uint32_t>(offset - tree.sectionOffset(sectionIndex));
+    uint32_t lineIndex = section.lineAt(relative);
+    uint32_t node = Ini::nodeAtLine(section, lineIndex);
+    uint32_t token = Ini::tokenAt(section, section.lines[lineIndex], relative);
+    if (node == Ini::kNone || token == Ini::kNone || token == 0) {
+        return std::nullopt;
+    }
+    const Ini::Line& line = section.lines[lineIndex];
+    SymbolQuery symbol{{}, std::string(section.tokenText(section.lineTokens(line)[token]))};
+    
+    // Block headers name the definition itself ("ObjectReskin New Old" also names its source);
+    // typed fields name a definition of their reference type; fields the schema
+    // does not model may name a definition of any type
+    const Ini::Node& current = section.nodes[node];
+    if (current.parent == Ini::kNone) {
+        const Ini::BlockSchema* block = Ini::Schema::findBlock(section.keyword(current));
+        if (!block) {
+            return std::nullopt;
+        }
+        symbol.blockType = block->name;
+    } else if (const Ini::FieldSchema* field = Ini::nodeField(section, node)) {
+        if (field->kind == Ini::FieldKind::Reference) {
+            symbol.blockType = field->reference;
+        } else if (field->kind != Ini::FieldKind::Custom) {
+            return std::nullopt;
+        }
+    }
+    return symbol;
+}
+
+const Definition& DocumentManager::effectiveDefinition(const std::vector<Definition>& definitions) const {
+    // Later files overwrite earlier ones and so do later blocks of a file;
+    // files the engine never loads lose to any file it does
+    const Definition* effective = &definitions.front();
+    std::optional<uint32_t> effectiveRank;
+    const std::string* uri = nullptr;
+    std::optional<uint32_t> rank;
+    for (const auto& definition : definitions) {
+        if (!uri || *uri != definition.uri) {
+            uri = &definition.uri;
+            rank.reset();
+            if (auto path = uriToPath(definition.uri)) {
+                if (auto gamePath = files_.gamePathOf(*path)) {
+                    rank = files_.loadRank(*gamePath);
+                }
+            }
+        }
+        if (rank && (!effectiveRank || *rank >= *effectiveRank)) {
+            effective = &definition;
+            effectiveRank = rank;
+        }
+    }
+    return *effective;
+}
+
+std::shared_ptr<const Ini::SyntaxTree> DocumentManager::loadSyntaxTree(const std::string& uri) const {
+    if (auto document = findDocument(uri)) {
+        return document->syntax;
+    }
+    auto path = uriToPath(uri);
+    MappedFile file;
+    if (!path || !file.open(*path)) {
+        return nullptr;
+    }
+    return std::make_shared<const Ini::SyntaxTree>(Ini::SyntaxTree::parse(file.contents()));
+}
+
+void DocumentManager::indexDocument(const Document& document) {
+    index_.updateFile(document.uri, WorkspaceIndex::collect(document.uri, *document.syntax));
+}
+
 void DocumentManager::parseIniDocument(Document& document) {
-    // TODO: Implement actual INI file parsing logic based on the game code
-    LOG_INFO("Parsed document: {}", document.uri);
+    document.syntax = std::make_shared<const Ini::SyntaxTree>(Ini::SyntaxTree::parse(document.text.text()));
+    LOG_INFO("Parsed document: {} ({} sections)", document.uri, document.syntax->sectionCount());
 }
 
 } // namespace ZeroSyntax
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "core/index_cache.hpp"
+#include "ini/ini_schema.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace ZeroSyntax {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x5849535A;  // "ZSIX"
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t schema;
+    uint32_t fileCount;
+    uint32_t symbolCount;
+    uint32_t reserved;
+    uint64_t stringsSize;
+};
+
+struct FileRecord {
+    uint32_t uri;
+    uint32_t uriLength;
+    int64_t modified;
+    uint64_t size;
+    uint64_t hash;
+    uint32_t firstSymbol;
+    uint32_t definitionCount;
+    uint32_t referenceCount;
+    uint32_t labelCount;
+};
+
+// A definition, reference or label; tokens never span lines
+struct SymbolRecord {
+    uint32_t name;
+    uint32_t nameLength;
+    uint32_t line;
+    uint32_t start;
+    uint32_t end;
+    uint16_t blockType;  // index into Schema::blocks(), kNoIndex for labels
+    uint16_t reserved;
+};
+
+static_assert(sizeof(Header) == 32 && sizeof(FileRecord) == 48 && sizeof(SymbolRecord) == 24,
+              "cache records must not contain padding");
+
+const FileRecord* fileRecords(const char* data) {
+    return reinterpret_cast<const FileRecord*>(data + sizeof(Header));
+}
+
+const SymbolRecord* symbolRecords(const char* data, size_t fileCount) {
+    return reinterpret_cast<const SymbolRecord*>(data + sizeof(Header) + fileCount * sizeof(FileRecord));
+}
+
+// Changes whenever the generated schema does: block order is stored in the
+// cache and references and labels follow the field tables
+uint32_t schemaFingerprint() {
+    static const uint32_t fingerprint = [] {
+        uint32_t hash = 0;
+        auto mix = [&hash](std::string_view text) { hash = Ini::schemaHash(text, hash); };
+        for (const Ini::BlockSchema& block : Ini::Schema::blocks()) {
+            mix(block.name);
+        }
+        for (const Ini::FieldTable& table : Ini::Schema::tables()) {
+            mix(table.name);
+            for (const Ini::FieldSchema& field : Ini::Schema::fields(table)) {
+                mix(field.token);
+                mix(field.reference);
+                char kind = static_cast<char>(field.kind);
+                mix(std::string_view(&kind, 1));
+            }
+        }
+        return hash;
+    }();
+    return fingerprint;
+}
+
+uint16_t blockIndex(std::string_view name) {
+    const Ini::BlockSchema* block = Ini::Schema::findBlock(name);
+    return block ? static_cast<uint16_t>(block - Ini::Schema::blocks().begin()) : Ini::kNoIndex;
+}
+
+// Appends strings to the blob, storing each distinct one once
+class StringBlob {
+public:
+    uint32_t add(std::string_view text) {
+        auto it = offsets_.find(std::string(text));
+        if (it != offsets_.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(data_.size());
+        data_.append(text);
+        offsets_.emplace(std::string(text), offset);
+        return offset;
+    }
+
+    const std::string& data() const { return data_; }
+
+private:
+    std::string data_;
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+// Labels carry no block type; definitions and references must name a known one
+template <typename Entry>
+bool appendSymbols(const std::vector<Entry>& entries, StringBlob& strings, std::vector<SymbolRecord>& symbols,
+                   bool typed = true) {
+    for (const auto& entry : entries) {
+        uint16_t block = typed ? blockIndex(entry.blockType) : Ini::kNoIndex;
+        if (typed && block == Ini::kNoIndex) {
+            return false;
+        }
+        symbols.push_back(SymbolRecord{strings.add(entry.name), static_cast<uint32_t>(entry.name.size()),
+                                       static_cast<uint32_t>(entry.range.start.line),
+                                       static_cast<uint32_t>(entry.range.start.character),
+                                       static_cast<uint32_t>(entry.range.end.character), block, 0});
+    }
+    return true;
+}
+
+template <typename Entry>
+Entry makeEntry(const SymbolRecord& record, const char* strings, const std::string& uri) {
+    int line = static_cast<int>(record.line);
+    std::string_view blockType = record.blockType != Ini::kNoIndex ? Ini::Schema::blocks()[record.blockType].name
+                                                                   : std::string_view();
+    return Entry{std::string(strings + record.name, record.nameLength), blockType, uri,
+                 LSP::Range{{line, static_cast<int>(record.start)}, {line, static_cast<int>(record.end)}}};
+}
+
+} // namespace
+
+bool IndexCache::load(const std::string& path) {
+    clear();
+    if (!file_.open(path)) {
+        return false;
+    }
+    std::string_view contents = file_.contents();
+
+    // Check everything once so lookups can trust the records
+    auto reject = [&](const char* reason) {
+        LOG_INFO("Ignoring index cache {}: {}", path, reason);
+        clear();
+        return false;
+    };
+    if (contents.size() < sizeof(Header)) {
+        return reject("truncated");
+    }
+    Header header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != kMagic) {
+        return reject("not an index cache");
+    }
+    if (header.version != kVersion || header.schema != schemaFingerprint()) {
+        return reject("written by another version");
+    }
+    uint64_t expected = sizeof(Header) + uint64_t(header.fileCount) * sizeof(FileRecord) +
+                        uint64_t(header.symbolCount) * sizeof(SymbolRecord) + header.stringsSize;
+    if (expected != contents.size()) {
+        return reject("truncated");
+    }
+
+    const FileRecord* files = fileRecords(contents.data());
+    const SymbolRecord* symbols = symbolRecords(contents.data(), header.fileCount);
+    auto inStrings = [&](uint32_t offset, uint32_t length) { return uint64_t(offset) + length <= header.stringsSize; };
+    for (uint32_t i = 0; i < header.fileCount; ++i) {
+        const FileRecord& file = files[i];
+        uint64_t lastSymbol =
+            uint64_t(file.firstSymbol) + file.definitionCount + file.referenceCount + file.labelCount;
+        if (!inStrings(file.uri, file.uriLength) || lastSymbol > header.symbolCount) {
+            return reject("damaged file record");
+        }
+    }
+    size_t blockCount = Ini::Schema::blocks().size();
+    for (uint32_t i = 0; i < header.symbolCount; ++i) {
+        if (!inStrings(symbols[i].name, symbols[i].nameLength) ||
+            (symbols[i].blockType >= blockCount && symbols[i].blockType != Ini::kNoIndex)) {
+            return reject("damaged symbol record");
+        }
+    }
+
+    data_ = contents.data();
+    fileCount_ = header.fileCount;
+    symbolCount_ = header.symbolCount;
+    return true;
+}
+
+std::optional<size_t> IndexCache::findFile(std::string_view uri) const {
+    if (!data_) {
+        return std::nullopt;
+    }
+    const FileRecord* files = fileRecords(data_);
+    const char* strings = reinterpret_cast<const char*>(symbolRecords(data_, fileCount_) + symbolCount_);
+    auto uriOf = [&](const FileRecord& file) { return std::string_view(strings + file.uri, file.uriLength); };
+
+    const FileRecord* end = files + fileCount_;
+    const FileRecord* it = std::lower_bound(files, end, uri,
+                                            [&](const FileRecord& file, std::string_view value) { return uriOf(file) < value; });
+    if (it == end || uriOf(*it) != uri) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(it - files);
+}
+
+FileStamp IndexCache::stamp(size_t file) const {
+    const FileRecord& record = fileRecords(data_)[file];
+    return FileStamp{record.modified, record.size, record.hash};
+}
+
+FileSymbols IndexCache::symbols(size_t file) const {
+    const FileRecord& record = fileRecords(data_)[file];
+    const SymbolRecord* symbols = symbolRecords(data_, fileCount_) + record.firstSymbol;
+    const char* strings = reinterpret_cast<const char*>(symbolRecords(data_, fileCount_) + symbolCount_);
+    std::string uri(strings + record.uri, record.uriLength);
+
+    FileSymbols result;
+    result.definitions.reserve(record.definitionCount);
+    for (uint32_t i = 0; i < record.definitionCount; ++i) {
+        result.definitions.push_back(makeEntry<Definition>(symbols[i], strings, uri));
+    }
+    symbols += record.definitionCount;
+    result.references.reserve(record.referenceCount);
+    for (uint32_t i = 0; i < record.referenceCount; ++i) {
+        result.references.push_back(makeEntry<Reference>(symbols[i], strings, uri));
+    }
+    symbols += record.referenceCount;
+    result.labels.reserve(record.labelCount);
+    for (uint32_t i = 0; i < record.labelCount; ++i) {
+        result.labels.push_back(makeEntry<Reference>(symbols[i], strings, uri));
+    }
+    return result;
+}
+
+bool IndexCache::write(const std::string& path, const std::vector<CachedFile>& files) {
+    std::vector<const CachedFile*> sorted;
+    sorted.reserve(files.size());
+    for (const auto& file : files) {
+        sorted.push_back(&file);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const CachedFile* a, const CachedFile* b) { return a->uri < b->uri; });
+
+    StringBlob strings;
+    std::vector<FileRecord> fileTable;
+    std::vector<SymbolRecord> symbols;
+    for (const CachedFile* entry : sorted) {
+        const CachedFile& file = *entry;
+        size_t firstSymbol = symbols.size();
+        // Files naming a type the schema does not know are left out and simply parsed next time
+        if (!appendSymbols(file.symbols.definitions, strings, symbols) ||
+            !appendSymbols(file.symbols.references, strings, symbols) ||
+            !appendSymbols(file.symbols.labels, strings, symbols, false)) {
+            symbols.resize(firstSymbol);
+            continue;
+        }
+        fileTable.push_back(FileRecord{strings.add(file.uri), static_cast<uint32_t>(file.uri.size()),
+                                       file.stamp.modified, file.stamp.size, file.stamp.hash,
+                                       static_cast<uint32_t>(firstSymbol),
+                                       static_cast<uint32_t>(file.symbols.definitions.size()),
+                                       static_cast<uint32_t>(file.symbols.references.size()),
+                                       static_cast<uint32_t>(file.symbols.labels.size())});
+    }
+
+    Header header{kMagic, kVersion, schemaFingerprint(), static_cast<uint32_t>(fileTable.size()),
+                  static_cast<uint32_t>(symbols.size()), 0, strings.data().size()};
+
+    std::error_code error;
+    fs::path target(path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), error);
+    }
+    fs::path temporary = target;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(fileTable.data()),
+                  static_cast<std::streamsize>(fileTable.size() * sizeof(FileRecord)));
+        out.write(reinterpret_cast<const char*>(symbols.data()),
+                  static_cast<std::streamsize>(symbols.size() * sizeof(SymbolRecord)));
+        out.write(strings.data().data(), static_cast<std::streamsize>(strings.data().size()));
+        if (!out) {
+            LOG_WARN("Failed to write index cache {}", temporary.string());
+            fs::remove(temporary, error);
+            return false;
+        }
+    }
+    fs::rename(temporary, target, error);
+    if (error) {
+        LOG_WARN("Failed to replace index cache {}: {}", path, error.message());
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+uint64_t IndexCache::contentHash(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string IndexCache::defaultPath(const std::string& root) {
+    fs::path directory;
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) {
+        directory = fs::path(local) / "ZeroSyntax";
+    }
+#else
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) {
+        directory = fs::path(cache) / "zerosyntax";
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        directory = fs::path(home) / ".cache" / "zerosyntax";
+    }
+#endif
+    if (directory.empty()) {
+        std::error_code error;
+        directory = fs::temp_directory_path(error) / "zerosyntax";
+    }
+
+    std::error_code error;
+    fs::path absolute = fs::absolute(root, error).lexically_normal();
+    if (!absolute.has_filename() && absolute.has_parent_path()) {
+        absolute = absolute.parent_path();  // "/mods/a/" is "/mods/a"
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "index-%016llx.bin", static_cast<unsigned long long>(contentHash(absolute.generic_string())));
+    return (directory / name).string();
+}
+
+void IndexCache::clear() {
+    file_.close();
+    data_ = nullptr;
+    fileCount_ = 0;
+    symbolCount_ = 0;
+}
+
+} // namespace ZeroSyntax
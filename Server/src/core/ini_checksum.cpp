@@ -0,0 +1,78 @@
+#include "core/ini_checksum.hpp"
+#include "ini/ini_crc.hpp"
+#include "utils/logger.hpp"
+
+namespace ZeroSyntax {
+
+void IniChecksum::rebuild(const Vfs::LayeredFileSystem& files) {
+    std::vector<File> hashed;
+    std::unordered_map<std::string, size_t> positions;
+    std::string text;
+    for (const Vfs::LoadedFile& loaded : files.loadOrder()) {
+        if (!loaded.checksummed) {
+            continue;
+        }
+        const Vfs::FileSource* source = files.resolve(loaded.path);
+        if (!source || !files.read(*source, loaded.path, text)) {
+            LOG_WARN("Cannot read {} for the INI CRC", loaded.path);
+            continue;
+        }
+        File file{loaded.path, {}, 0};
+        Ini::appendCrcTerms(text, file.terms);
+        positions.emplace(loaded.path, hashed.size());
+        hashed.push_back(std::move(file));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_ = std::move(hashed);
+    positions_ = std::move(positions);
+    // XferCRC::open starts from zero
+    state_ = 0;
+    for (File& file : files_) {
+        file.before = state_;
+        state_ = Ini::foldCrcTerms(state_, file.terms.data(), file.terms.size());
+    }
+    LOG_INFO("INI CRC of {} files: 0x{:08X}", files_.size(), Ini::crcValue(state_));
+}
+
+bool IniChecksum::update(std::string_view path, std::string_view text) {
+    std::vector<uint32_t> terms;
+    Ini::appendCrcTerms(text, terms);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto position = positions_.find(std::string(path));
+    if (position == positions_.end()) {
+        return false;
+    }
+    File& file = files_[position->second];
+    if (file.terms != terms) {
+        file.terms = std::move(terms);
+        refold(position->second);
+    }
+    return true;
+}
+
+uint32_t IniChecksum::value() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Ini::crcValue(state_);
+}
+
+size_t IniChecksum::fileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_.size();
+}
+
+void IniChecksum::refold(size_t first) {
+    uint32_t state = files_[first].before;
+    for (size_t i = first; i < files_.size(); ++i) {
+        // The rest folds as before once a file starts from its old state
+        if (i > first && files_[i].before == state) {
+            return;
+        }
+        files_[i].before = state;
+        state = Ini::foldCrcTerms(state, files_[i].terms.data(), files_[i].terms.size());
+    }
+    state_ = state;
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,422 @@
+#include "core/map_index.hpp"
+#include "map/map_file.hpp"
+#include "map/map_scripts.hpp"
+#include "ini/ini_schema.hpp"
+#include "utils/logger.hpp"
+#include "utils/parallel.hpp"
+#include "utils/uri.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace ZeroSyntax {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// MapObject flags of road and bridge ends, which name a TerrainRoad or TerrainBridge
+constexpr int32_t kRoadOrBridgeFlags = 0x02 | 0x04 | 0x10 | 0x20;
+
+bool isMapFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), Ini::asciiLower);
+    return extension == ".map";
+}
+
+bool hasEntry(const Map::Dict& properties, std::string_view key, Map::DictType type) {
+    const Map::DictEntry* entry = Map::findEntry(properties, key);
+    return entry && entry->type == type;
+}
+
+// Modification time and size, or false when the file is gone
+bool statFile(const fs::path& path, int64_t& modified, uint64_t& size) {
+    std::error_code error;
+    auto time = fs::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    size = fs::file_size(path, error);
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    return !error;
+}
+
+// The store whose definitions a parameter of a type names, or empty
+std::string_view storeOf(Map::ParameterType type) {
+    switch (type) {
+    case Map::ParameterType::ObjectType:
+        return "Object";
+    case Map::ParameterType::Upgrade:
+        return "Upgrade";
+    case Map::ParameterType::Science:
+        return "Science";
+    case Map::ParameterType::SpecialPower:
+        return "SpecialPower";
+    default:
+        return {};
+    }
+}
+
+LSP::Diagnostic mapWarning(std::string message) {
+    return LSP::Diagnostic{LSP::Range{{0, 0}, {0, 0}}, LSP::DiagnosticSeverity::Warning, std::move(message),
+                           std::string("ZeroSyntax")};
+}
+
+bool sameTemplates(const std::vector<PlacedTemplate>& a, const std::vector<PlacedTemplate>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const PlacedTemplate& x, const PlacedTemplate& y) {
+        return x.name == y.name && x.count == y.count;
+    });
+}
+
+bool sameScripts(const ScriptCheck& a, const ScriptCheck& b) {
+    return std::equal(a.references.begin(), a.references.end(), b.references.begin(), b.references.end(),
+                      [](const ScriptReference& x, const ScriptReference& y) {
+                          return x.blockType == y.blockType && x.name == y.name && x.script == y.script &&
+                                 x.count == y.count;
+                      }) &&
+           std::equal(a.warnings.begin(), a.warnings.end(), b.warnings.begin(), b.warnings.end(),
+                      [](const LSP::Diagnostic& x, const LSP::Diagnostic& y) { return x.message == y.message; });
+}
+
+} // namespace
+
+std::vector<PlacedTemplate> MapIndex::collect(const Map::MapFile& map) {
+    std::vector<std::string_view> names;
+    for (const Map::MapObject& object : map.objects()) {
+        if (object.name.empty() || (object.flags & kRoadOrBridgeFlags) ||
+            hasEntry(object.properties, "waypointID", Map::DictType::Int) ||
+            hasEntry(object.properties, "lightHeightAboveTerrain", Map::DictType::Real) ||
+            hasEntry(object.properties, "scorchType", Map::DictType::Int)) {
+            continue;
+        }
+        names.push_back(object.name);
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<PlacedTemplate> templates;
+    for (std::string_view name : names) {
+        if (templates.empty() || templates.back().name != name) {
+            templates.push_back(PlacedTemplate{std::string(name), 0});
+        }
+        ++templates.back().count;
+    }
+    return templates;
+}
+
+ScriptCheck MapIndex::checkScripts(const Map::MapFile& map) {
+    ScriptCheck check;
+    std::optional<Map::Chunk> chunk = map.playerScripts();
+    if (!chunk) {
+        return check;
+    }
+    Map::MapScripts scripts;
+    if (!scripts.decode(*chunk, map.table())) {
+        LOG_WARN("Corrupt scripts in {}; checking the {} read", map.path(), scripts.scripts().size());
+    }
+
+    // What the map defines itself. Each player also gets a default team,
+    // "team" and its name, which the map need not list.
+    std::vector<std::string> defaultTeams;
+    for (const Map::Side& side : map.sides()) {
+        const Map::DictEntry* name = Map::findEntry(side.properties, "playerName");
+        if (name && name->type == Map::DictType::AsciiString) {
+            defaultTeams.push_back("team" + std::string(name->text));
+        }
+    }
+    std::vector<std::string_view> teams(defaultTeams.begin(), defaultTeams.end());
+    for (const Map::Dict& team : map.teams()) {
+        const Map::DictEntry* name = Map::findEntry(team, "teamName");
+        if (name && name->type == Map::DictType::AsciiString) {
+            teams.push_back(name->text);
+        }
+    }
+    std::vector<std::string_view> waypoints;
+    for (const Map::Waypoint& waypoint : map.waypoints()) {
+        waypoints.push_back(waypoint.name);
+    }
+    std::vector<std::string_view> lists;
+    for (const Map::ScriptParameter& parameter : scripts.parameters()) {
+        if (parameter.type == Map::ParameterType::ObjectTypeList) {
+            lists.push_back(parameter.text);
+        }
+    }
+    for (auto* names : {&teams, &waypoints, &lists}) {
+        std::sort(names->begin(), names->end());
+    }
+    auto defines = [](const std::vector<std::string_view>& names, std::string_view name) {
+        return std::binary_search(names.begin(), names.end(), name);
+    };
+
+    // One pass over the parameters of every clause, in script order
+    struct Use {
+        std::string_view store;
+        std::string_view name;
+        uint32_t script;
+    };
+    std::vector<Use> uses;
+    std::vector<Use> unknown;  // store is "team" or "waypoint"
+    const auto& clauses = scripts.clauses();
+    const auto& parameters = scripts.parameters();
+    for (uint32_t s = 0; s < scripts.scripts().size(); ++s) {
+        const Map::Script& script = scripts.scripts()[s];
+        for (uint32_t c = script.firstClause; c < script.firstClause + script.clauseCount; ++c) {
+            uint32_t end = clauses[c].firstParameter + clauses[c].parameterCount;
+            for (uint32_t p = clauses[c].firstParameter; p < end; ++p) {
+                const Map::ScriptParameter& parameter = parameters[p];
+                std::string_view name = parameter.text;
+                if (name.empty() || name.front() == '<') {
+                    continue;
+                }
+                if (parameter.type == Map::ParameterType::Team && !defines(teams, name)) {
+                    unknown.push_back(Use{"team", name, s});
+                } else if (parameter.type == Map::ParameterType::Waypoint && !defines(waypoints, name)) {
+                    unknown.push_back(Use{"waypoint", name, s});
+                } else if (std::string_view store = storeOf(parameter.type);
+                           !store.empty() &&
+                           !(parameter.type == Map::ParameterType::ObjectType && defines(lists, name))) {
+                    uses.push_back(Use{store, name, s});
+                }
+            }
+        }
+    }
+
+    // Collecting kept script order, so the first use of a name is the first script naming it
+    std::stable_sort(uses.begin(), uses.end(), [](const Use& a, const Use& b) {
+        return a.store != b.store ? a.store < b.store : a.name < b.name;
+    });
+    for (const Use& use : uses) {
+        if (check.references.empty() || check.references.back().blockType != use.store ||
+            check.references.back().name != use.name) {
+            check.references.push_back(ScriptReference{std::string(use.store), std::string(use.name),
+                                                       std::string(scripts.scripts()[use.script].name), 0});
+        }
+        ++check.references.back().count;
+    }
+
+    // One warning per name and script
+    std::sort(unknown.begin(), unknown.end(), [](const Use& a, const Use& b) {
+        return a.script != b.script ? a.script < b.script : a.store != b.store ? a.store < b.store : a.name < b.name;
+    });
+    auto last = std::unique(unknown.begin(), unknown.end(), [](const Use& a, const Use& b) {
+        return a.script == b.script && a.store == b.store && a.name == b.name;
+    });
+    for (auto it = unknown.begin(); it != last; ++it) {
+        check.warnings.push_back(mapWarning("Script '" + std::string(scripts.scripts()[it->script].name) + "' names " +
+                                            std::string(it->store) + " '" + std::string(it->name) +
+                                            "', which the map does not define"));
+    }
+    return check;
+}
+
+size_t MapIndex::indexDirectory(const std::string& root, size_t threadCount) {
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<fs::path> paths;
+    std::error_code error;
+    fs::path directory = fs::absolute(root, error);
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        std::error_code statError;
+        if (it->is_regular_file(statError) && isMapFile(it->path())) {
+            paths.push_back(it->path());
+        }
+    }
+    if (error) {
+        LOG_WARN("Stopped scanning {} for maps: {}", root, error.message());
+    }
+
+    std::vector<Entry> entries(paths.size());
+    std::vector<char> found(paths.size());  // not vector<bool>: written from several threads
+    size_t threads = parallelFor(paths.size(), threadCount, [&](size_t i, size_t) {
+        found[i] = statFile(paths[i], entries[i].modified, entries[i].size);
+        if (found[i]) {
+            read(paths[i].string(), entries[i]);
+        }
+    });
+
+    size_t placements = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maps_.clear();
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (found[i]) {
+                for (const PlacedTemplate& placed : entries[i].templates) {
+                    placements += placed.count;
+                }
+                maps_[pathToUri(paths[i].generic_string())] = std::move(entries[i]);
+            }
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("Indexed {} maps ({} placed objects) under {} in {} ms on {} threads", paths.size(), placements, root,
+             elapsed.count(), threads);
+    return paths.size();
+}
+
+bool MapIndex::indexFile(const std::string& uri) {
+    auto path = uriToPath(uri);
+    Entry entry;
+    if (!path || !statFile(*path, entry.modified, entry.size)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maps_.erase(uri) > 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = maps_.find(uri);
+        if (it != maps_.end() && it->second.modified == entry.modified && it->second.size == entry.size) {
+            return false;
+        }
+    }
+
+    read(*path, entry);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& current = maps_[uri];
+    bool changed = !sameTemplates(current.templates, entry.templates) || !sameScripts(current.scripts, entry.scripts);
+    current = std::move(entry);
+    return changed;
+}
+
+void MapIndex::updateFile(const std::string& uri, std::vector<PlacedTemplate> templates, ScriptCheck scripts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = maps_[uri];
+    entry.templates = std::move(templates);
+    entry.scripts = std::move(scripts);
+}
+
+void MapIndex::removeFile(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maps_.erase(uri);
+}
+
+void MapIndex::read(const std::string& path, Entry& entry) {
+    Map::MapFile map;
+    if (map.open(path)) {
+        entry.templates = collect(map);
+        entry.scripts = checkScripts(map);
+    }
+}
+
+void MapIndex::addNames(const Entry& entry, StoreNames& names) {
+    std::vector<std::string>& objects = names["Object"];
+    for (const PlacedTemplate& placed : entry.templates) {
+        objects.push_back(placed.name);
+    }
+    for (const ScriptReference& reference : entry.scripts.references) {
+        names[reference.blockType].push_back(reference.name);
+    }
+}
+
+StoreNames MapIndex::referencedNames() const {
+    StoreNames names;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& map : maps_) {
+            addNames(map.second, names);
+        }
+    }
+    for (auto& store : names) {
+        std::sort(store.second.begin(), store.second.end());
+        store.second.erase(std::unique(store.second.begin(), store.second.end()), store.second.end());
+    }
+    return names;
+}
+
+StoreNames MapIndex::referencedNames(const std::string& uri) const {
+    StoreNames names;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = maps_.find(uri);
+        if (it != maps_.end()) {
+            addNames(it->second, names);
+        }
+    }
+    for (auto& store : names) {
+        std::sort(store.second.begin(), store.second.end());
+        store.second.erase(std::unique(store.second.begin(), store.second.end()), store.second.end());
+    }
+    return names;
+}
+
+std::vector<PlacedTemplate> MapIndex::templates(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = maps_.find(uri);
+    return it != maps_.end() ? it->second.templates : std::vector<PlacedTemplate>();
+}
+
+ScriptCheck MapIndex::scripts(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = maps_.find(uri);
+    return it != maps_.end() ? it->second.scripts : ScriptCheck();
+}
+
+std::unordered_map<std::string, std::vector<LSP::Diagnostic>> MapIndex::diagnose(const StoreNames& missing) const {
+    std::unordered_map<std::string, std::vector<LSP::Diagnostic>> diagnostics;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& map : maps_) {
+        diagnostics[map.first] = diagnose(map.second, missing);
+    }
+    return diagnostics;
+}
+
+std::vector<LSP::Diagnostic> MapIndex::diagnose(const std::string& uri, const StoreNames& missing) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = maps_.find(uri);
+    return it != maps_.end() ? diagnose(it->second, missing) : std::vector<LSP::Diagnostic>();
+}
+
+std::vector<LSP::Diagnostic> MapIndex::diagnose(const Entry& entry, const StoreNames& missing) {
+    std::vector<LSP::Diagnostic> diagnostics;
+    auto objects = missing.find("Object");
+    if (objects != missing.end()) {
+        // Both lists are sorted, so one walk finds the placements of missing names
+        auto next = objects->second.begin();
+        for (const PlacedTemplate& placed : entry.templates) {
+            next = std::lower_bound(next, objects->second.end(), placed.name);
+            if (next == objects->second.end()) {
+                break;
+            }
+            if (*next != placed.name) {
+                continue;
+            }
+            std::string times = placed.count == 1 ? "once" : std::to_string(placed.count) + " times";
+            diagnostics.push_back(mapWarning("Object '" + placed.name + "' is placed " + times +
+                                             " but no INI file defines it; the game leaves it off the map"));
+        }
+    }
+
+    // References are sorted by store, then name: one walk per store
+    const std::vector<std::string>* names = nullptr;
+    std::vector<std::string>::const_iterator next;
+    for (size_t i = 0; i < entry.scripts.references.size(); ++i) {
+        const ScriptReference& reference = entry.scripts.references[i];
+        if (i == 0 || reference.blockType != entry.scripts.references[i - 1].blockType) {
+            auto store = missing.find(reference.blockType);
+            names = store != missing.end() ? &store->second : nullptr;
+            if (names) {
+                next = names->begin();
+            }
+        }
+        if (!names) {
+            continue;
+        }
+        next = std::lower_bound(next, names->end(), reference.name);
+        if (next == names->end() || *next != reference.name) {
+            continue;
+        }
+        std::string uses =
+            reference.count == 1 ? std::string() : " (used " + std::to_string(reference.count) + " times)";
+        diagnostics.push_back(mapWarning("Script '" + reference.script + "' names " + reference.blockType + " '" +
+                                         reference.name + "'" + uses + ", which no INI file defines"));
+    }
+
+    diagnostics.insert(diagnostics.end(), entry.scripts.warnings.begin(), entry.scripts.warnings.end());
+    return diagnostics;
+}
+
+size_t MapIndex::fileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maps_.size();
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,310 @@
+#include "core/piece_table.hpp"
+
+namespace ZeroSyntax {
+
+namespace {
+
+// UTF-8 continuation bytes have the form 10xxxxxx
+inline bool isContinuationByte(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Number of UTF-16 code units taken by the character starting with this lead byte
+inline size_t utf16Units(unsigned char lead) {
+    return (lead & 0xF8) == 0xF0 ? 2 : 1;
+}
+
+} // namespace
+
+PieceTable::PieceTable() : prioritySeed_(0x9E3779B97F4A7C15ull) {}
+
+PieceTable::PieceTable(std::string text) : PieceTable() {
+    if (!text.empty()) {
+        auto buffer = makeBuffer(std::move(text));
+        size_t size = buffer->text.size();
+        root_ = makeNode(std::move(buffer), 0, size, nextPriority(), nullptr, nullptr);
+    }
+}
+
+size_t PieceTable::length() const {
+    return lengthOf(root_);
+}
+
+size_t PieceTable::lineCount() const {
+    return lineFeedsOf(root_) + 1;
+}
+
+size_t PieceTable::pieceCount() const {
+    return piecesOf(root_);
+}
+
+size_t PieceTable::lineOffset(size_t line) const {
+    if (line == 0) {
+        return 0;
+    }
+    if (line > lineFeedsOf(root_)) {
+        return length();
+    }
+
+    // Find the position just past the line-th line feed
+    size_t remaining = line;
+    size_t offset = 0;
+    const Node* node = root_.get();
+    while (node) {
+        size_t leftLineFeeds = lineFeedsOf(node->left);
+        if (remaining <= leftLineFeeds) {
+            node = node->left.get();
+            continue;
+        }
+        remaining -= leftLineFeeds;
+        offset += lengthOf(node->left);
+
+        if (remaining <= node->lineFeeds) {
+            const auto& lineStarts = node->buffer->lineStarts;
+            auto first = std::upper_bound(lineStarts.begin(), lineStarts.end(), node->start);
+            return offset + (*(first + (remaining - 1)) - node->start);
+        }
+        remaining -= node->lineFeeds;
+        offset += node->length;
+        node = node->right.get();
+    }
+    return length();
+}
+
+size_t PieceTable::lineFeedsBefore(size_t offset) const {
+    size_t count = 0;
+    const Node* node = root_.get();
+    while (node) {
+        size_t leftLength = lengthOf(node->left);
+        if (offset <= leftLength) {
+            node = node->left.get();
+            continue;
+        }
+        count += lineFeedsOf(node->left);
+        offset -= leftLength;
+
+        if (offset <= node->length) {
+            return count + countLineFeeds(*node->buffer, node->start, node->start + offset);
+        }
+        count += node->lineFeeds;
+        offset -= node->length;
+        node = node->right.get();
+    }
+    return count;
+}
+
+size_t PieceTable::offsetAt(const LSP::Position& position) const {
+    if (position.line < 0) {
+        return 0;
+    }
+    if (static_cast<size_t>(position.line) >= lineCount()) {
+        return length();
+    }
+
+    size_t offset = lineOffset(static_cast<size_t>(position.line));
+    size_t units = position.character > 0 ? static_cast<size_t>(position.character) : 0;
+
+    // Walk the line one byte at a time; continuation bytes never stop the walk,
+    // so multi-byte characters split across chunks are handled transparently.
+    forEachChunk(offset, length() - offset, [&](std::string_view chunk) {
+        for (char ch : chunk) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (!isContinuationByte(c)) {
+                if (c == '\n' || units < utf16Units(c)) {
+                    return false;
+                }
+                units -= utf16Units(c);
+            }
+            ++offset;
+        }
+        return true;
+    });
+    return offset;
+}
+
+LSP::Position PieceTable::positionAt(size_t offset) const {
+    offset = std::min(offset, length());
+    size_t line = lineFeedsBefore(offset);
+    size_t lineStart = lineOffset(line);
+
+    size_t units = 0;
+    forEachChunk(lineStart, offset - lineStart, [&](std::string_view chunk) {
+        for (char ch : chunk) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (!isContinuationByte(c)) {
+                units += utf16Units(c);
+            }
+        }
+        return true;
+    });
+    return LSP::Position{static_cast<int>(line), static_cast<int>(units)};
+}
+
+void PieceTable::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, length());
+
+    auto buffer = makeBuffer(std::string(text));
+    size_t size = buffer->text.size();
+    NodePtr piece = makeNode(std::move(buffer), 0, size, nextPriority(), nullptr, nullptr);
+
+    auto [left, right] = split(root_, offset);
+    root_ = merge(merge(left, piece), right);
+}
+
+void PieceTable::erase(size_t offset, size_t count) {
+    size_t total = length();
+    if (offset >= total || count == 0) {
+        return;
+    }
+    count = std::min(count, total - offset);
+
+    auto [left, rest] = split(root_, offset);
+    auto [removed, right] = split(rest, count);
+    root_ = merge(left, right);
+}
+
+void PieceTable::replace(size_t offset, size_t count, std::string_view text) {
+    erase(offset, count);
+    insert(offset, text);
+}
+
+void PieceTable::replace(const LSP::Range& range, std::string_view text) {
+    size_t start = offsetAt(range.start);
+    size_t end = offsetAt(range.end);
+    if (end < start) {
+        std::swap(start, end);
+    }
+    replace(start, end - start, text);
+}
+
+std::string PieceTable::text() const {
+    return substr(0, length());
+}
+
+std::string PieceTable::substr(size_t offset, size_t count) const {
+    std::string result;
+    if (offset < length()) {
+        result.reserve(std::min(count, length() - offset));
+    }
+    forEachChunk(offset, count, [&](std::string_view chunk) {
+        result.append(chunk);
+        return true;
+    });
+    return result;
+}
+
+char PieceTable::at(size_t offset) const {
+    const Node* node = root_.get();
+    while (node) {
+        size_t leftLength = lengthOf(node->left);
+        if (offset < leftLength) {
+            node = node->left.get();
+            continue;
+        }
+        offset -= leftLength;
+        if (offset < node->length) {
+            return node->buffer->text[node->start + offset];
+        }
+        offset -= node->length;
+        node = node->right.get();
+    }
+    return '\0';
+}
+
+std::shared_ptr<const PieceTable::Buffer> PieceTable::makeBuffer(std::string text) {
+    auto buffer = std::make_shared<Buffer>();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            buffer->lineStarts.push_back(i + 1);
+        }
+    }
+    buffer->text = std::move(text);
+    return buffer;
+}
+
+size_t PieceTable::countLineFeeds(const Buffer& buffer, size_t begin, size_t end) {
+    // A line feed at p is recorded as p + 1, so [begin, end) maps to (begin, end]
+    const auto& lineStarts = buffer.lineStarts;
+    auto first = std::upper_bound(lineStarts.begin(), lineStarts.end(), begin);
+    auto last = std::upper_bound(first, lineStarts.end(), end);
+    return static_cast<size_t>(last - first);
+}
+
+PieceTable::NodePtr PieceTable::makeNode(std::shared_ptr<const Buffer> buffer, size_t start, size_t length,
+                                         uint64_t priority, NodePtr left, NodePtr right) {
+    auto node = std::make_shared<Node>();
+    node->lineFeeds = countLineFeeds(*buffer, start, start + length);
+    node->buffer = std::move(buffer);
+    node->start = start;
+    node->length = length;
+    node->priority = priority;
+    node->totalLength = lengthOf(left) + length + lengthOf(right);
+    node->totalLineFeeds = lineFeedsOf(left) + node->lineFeeds + lineFeedsOf(right);
+    node->totalPieces = piecesOf(left) + 1 + piecesOf(right);
+    node->left = std::move(left);
+    node->right = std::move(right);
+    return node;
+}
+
+PieceTable::NodePtr PieceTable::withChildren(const NodePtr& node, NodePtr left, NodePtr right) {
+    if (node->left == left && node->right == right) {
+        return node;
+    }
+    auto copy = std::make_shared<Node>(*node);
+    copy->totalLength = lengthOf(left) + node->length + lengthOf(right);
+    copy->totalLineFeeds = lineFeedsOf(left) + node->lineFeeds + lineFeedsOf(right);
+    copy->totalPieces = piecesOf(left) + 1 + piecesOf(right);
+    copy->left = std::move(left);
+    copy->right = std::move(right);
+    return copy;
+}
+
+PieceTable::NodePtr PieceTable::merge(const NodePtr& left, const NodePtr& right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    if (left->priority > right->priority) {
+        return withChildren(left, left->left, merge(left->right, right));
+    }
+    return withChildren(right, merge(left, right->left), right->right);
+}
+
+std::pair<PieceTable::NodePtr, PieceTable::NodePtr> PieceTable::split(const NodePtr& node, size_t offset) {
+    if (!node) {
+        return {nullptr, nullptr};
+    }
+
+    size_t leftLength = lengthOf(node->left);
+    if (offset <= leftLength) {
+        auto [first, second] = split(node->left, offset);
+        return {first, withChildren(node, second, node->right)};
+    }
+
+    offset -= leftLength;
+    if (offset >= node->length) {
+        auto [first, second] = split(node->right, offset - node->length);
+        return {withChildren(node, node->left, first), second};
+    }
+
+    // The split point falls inside this piece: cut it in two. Each half gets a
+    // fresh priority so repeated edits in one piece keep the tree balanced.
+    NodePtr head = makeNode(node->buffer, node->start, offset, nextPriority(), nullptr, nullptr);
+    NodePtr tail = makeNode(node->buffer, node->start + offset, node->length - offset, nextPriority(), nullptr, nullptr);
+    return {merge(node->left, head), merge(tail, node->right)};
+}
+
+uint64_t PieceTable::nextPriority() {
+    // splitmix64
+    uint64_t z = (prioritySeed_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,553 @@
+#include "core/workspace_index.hpp"
+#include "core/index_cache.hpp"
+#include "ini/ini_grammar.hpp"
+#include "ini/ini_schema.hpp"
+#include "ini/schema_context.hpp"
+#include "text/fuzzy_matcher.hpp"
+#include "utils/logger.hpp"
+#include "utils/parallel.hpp"
+#include "utils/uri.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+
+namespace ZeroSyntax {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool readFile(const fs::path& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+bool isIniFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), Ini::asciiLower);
+    return extension == ".ini";
+}
+
+// Entries of a name are kept sorted by file, then position, so the entries
+// of one file are contiguous
+template <typename Entry>
+bool entryOrder(const Entry& a, const Entry& b) {
+    if (a.uri != b.uri) {
+        return a.uri < b.uri;
+    }
+    if (a.range.start.line != b.range.start.line) {
+        return a.range.start.line < b.range.start.line;
+    }
+    return a.range.start.character < b.range.start.character;
+}
+
+template <typename Entry>
+std::pair<typename std::vector<Entry>::iterator, typename std::vector<Entry>::iterator>
+fileEntries(std::vector<Entry>& entries, const std::string& uri) {
+    auto first = std::lower_bound(entries.begin(), entries.end(), uri,
+                                  [](const Entry& entry, const std::string& value) { return entry.uri < value; });
+    auto last = std::upper_bound(first, entries.end(), uri,
+                                 [](const std::string& value, const Entry& entry) { return value < entry.uri; });
+    return {first, last};
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(),
+                      [](char x, char y) { return Ini::asciiLower(x) == Ini::asciiLower(y); });
+}
+
+} // namespace
+
+FileSymbols WorkspaceIndex::collect(const std::string& uri, const Ini::SyntaxTree& tree) {
+    FileSymbols symbols;
+    for (size_t i = 0; i < tree.sectionCount(); ++i) {
+        const Ini::Section& section = tree.section(i);
+        if (!section.hasRoot() || section.nodes[0].kind != Ini::NodeKind::Block) {
+            continue;
+        }
+        const Ini::BlockSchema* block = Ini::Schema::findBlock(section.keyword(section.nodes[0]));
+        if (!block) {
+            continue;
+        }
+        const Ini::Line& header = section.lines[section.nodes[0].line];
+        const Ini::Token* headerTokens = section.lineTokens(header);
+        if (header.tokenCount >= 2) {
+            const Ini::Token& name = headerTokens[1];
+            symbols.definitions.push_back(
+                Definition{std::string(section.tokenText(name)), block->name, uri, tree.tokenRange(i, name)});
+        }
+        // "ObjectReskin New Old" copies Old
+        if (header.tokenCount >= 3 && block->name == "ObjectReskin") {
+            const Ini::Token& source = headerTokens[2];
+            symbols.references.push_back(
+                Reference{std::string(section.tokenText(source)), "Object", uri, tree.tokenRange(i, source)});
+        }
+
+        // Every value of a typed reference field names a definition; "None" clears the field
+        std::vector<const Ini::FieldTable*> tables = Ini::blockTables(section);
+        for (uint32_t n = 1; n < section.nodes.size(); ++n) {
+            const Ini::Node& node = section.nodes[n];
+            const Ini::FieldTable* parent = tables[node.parent];
+            const Ini::FieldSchema* field = parent ? Ini::Schema::findField(*parent, section.keyword(node)) : nullptr;
+            if (!field) {
+                continue;
+            }
+            const Ini::Line& line = section.lines[node.line];
+            const Ini::Token* tokens = section.lineTokens(line);
+            // A label field reads one token
+            if (field->kind == Ini::FieldKind::Label && line.tokenCount >= 2) {
+                symbols.labels.push_back(
+                    Reference{std::string(section.tokenText(tokens[1])), {}, uri, tree.tokenRange(i, tokens[1])});
+                continue;
+            }
+            if (field->kind != Ini::FieldKind::Reference) {
+                continue;
+            }
+            for (uint32_t t = 1; t < line.tokenCount; ++t) {
+                std::string_view value = section.tokenText(tokens[t]);
+                if (equalsIgnoreCase(value, "None")) {
+                    continue;
+                }
+                symbols.references.push_back(
+                    Reference{std::string(value), field->reference, uri, tree.tokenRange(i, tokens[t])});
+            }
+        }
+    }
+    return symbols;
+}
+
+IndexStats WorkspaceIndex::indexDirectory(const std::string& root, const IndexOptions& options) {
+    auto started = std::chrono::steady_clock::now();
+
+    struct Source {
+        fs::path path;
+        int64_t modified;
+        uint64_t size;
+    };
+    std::vector<Source> sources;
+    std::error_code error;
+    fs::path directory = fs::absolute(root, error);
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        std::error_code statError;
+        if (it->is_regular_file(statError) && isIniFile(it->path())) {
+            auto modified = it->last_write_time(statError).time_since_epoch().count();
+            auto size = it->file_size(statError);
+            sources.push_back(Source{it->path(), static_cast<int64_t>(modified), static_cast<uint64_t>(size)});
+        }
+    }
+    if (error) {
+        LOG_WARN("Stopped scanning {}: {}", root, error.message());
+    }
+
+    IndexCache cache;
+    if (!options.cachePath.empty()) {
+        cache.load(options.cachePath);
+    }
+
+    // A file is taken from the cache when its stamp matches, or when it was
+    // touched but hashes the same. Files left to the editor are not indexed
+    // but keep their cache record.
+    enum class Outcome { Skipped, Kept, Cached, Rehashed, Parsed };
+    std::vector<Outcome> outcomes(sources.size(), Outcome::Skipped);
+    std::vector<CachedFile> files(sources.size());
+    size_t threadCount = parallelFor(sources.size(), options.threadCount, [&](size_t i, size_t) {
+        CachedFile& file = files[i];
+        file.uri = pathToUri(sources[i].path.generic_string());
+        file.stamp = FileStamp{sources[i].modified, sources[i].size, 0};
+        std::optional<size_t> cached = cache.findFile(file.uri);
+        if (options.skip && options.skip(file.uri)) {
+            if (cached) {
+                file.stamp = cache.stamp(*cached);
+                file.symbols = cache.symbols(*cached);
+                outcomes[i] = Outcome::Kept;
+            }
+            return;
+        }
+        if (cached) {
+            FileStamp stamp = cache.stamp(*cached);
+            if (stamp.modified == file.stamp.modified && stamp.size == file.stamp.size) {
+                file.stamp.hash = stamp.hash;
+                file.symbols = cache.symbols(*cached);
+                outcomes[i] = Outcome::Cached;
+                return;
+            }
+        }
+
+        std::string text;
+        if (!readFile(sources[i].path, text)) {
+            return;
+        }
+        file.stamp.hash = IndexCache::contentHash(text);
+        if (cached && cache.stamp(*cached).hash == file.stamp.hash && cache.stamp(*cached).size == text.size()) {
+            file.symbols = cache.symbols(*cached);
+            outcomes[i] = Outcome::Rehashed;
+            return;
+        }
+        file.symbols = collect(file.uri, Ini::SyntaxTree::parse(text));
+        outcomes[i] = Outcome::Parsed;
+    });
+
+    // Keep what belongs in the cache
+    IndexStats stats;
+    bool changed = false;
+    size_t kept = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (outcomes[i] == Outcome::Skipped) {
+            continue;
+        }
+        stats.files += outcomes[i] != Outcome::Kept;
+        stats.parsed += outcomes[i] == Outcome::Parsed;
+        changed |= outcomes[i] == Outcome::Parsed || outcomes[i] == Outcome::Rehashed;
+        if (kept != i) {
+            outcomes[kept] = outcomes[i];
+            files[kept] = std::move(files[i]);
+        }
+        ++kept;
+    }
+    files.resize(kept);
+    // Deleted files only show up as a shorter list
+    changed |= files.size() != cache.fileCount();
+    if (!options.cachePath.empty() && changed) {
+        IndexCache::write(options.cachePath, files);
+    }
+
+    // Merged in uri order, entries of a name are appended rather than inserted
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return files[a].uri < files[b].uri; });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i : order) {
+            if (outcomes[i] == Outcome::Kept) {
+                continue;
+            }
+            removeFileLocked(files[i].uri);
+            addFileLocked(files[i].uri, std::move(files[i].symbols));
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO("Indexed {} files ({} parsed, {} definitions, {} references, {} labels) under {} in {} ms on {} threads",
+             stats.files, stats.parsed, definitionCount(), referenceCount(), labelReferenceCount(), root,
+             elapsed.count(), threadCount);
+    return stats;
+}
+
+void WorkspaceIndex::indexFile(const std::string& uri) {
+    auto path = uriToPath(uri);
+    std::string text;
+    if (!path || !readFile(*path, text)) {
+        removeFile(uri);
+        return;
+    }
+    updateFile(uri, collect(uri, Ini::SyntaxTree::parse(text)));
+}
+
+void WorkspaceIndex::updateFile(const std::string& uri, FileSymbols symbols) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeFileLocked(uri);
+    addFileLocked(uri, std::move(symbols));
+}
+
+void WorkspaceIndex::removeFile(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeFileLocked(uri);
+}
+
+std::vector<Definition> WorkspaceIndex::findDefinitions(std::string_view blockType, std::string_view name) const {
+    std::vector<Definition> result;
+    std::string_view store = Ini::definitionNamespace(blockType);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = definitions_.byName.find(std::string(name));
+    if (it == definitions_.byName.end()) {
+        return result;
+    }
+    for (const auto& definition : it->second) {
+        if (Ini::definitionNamespace(definition.blockType) == store) {
+            result.push_back(definition);
+        }
+    }
+    return result;
+}
+
+std::vector<Definition> WorkspaceIndex::findDefinitions(std::string_view name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = definitions_.byName.find(std::string(name));
+    return it != definitions_.byName.end() ? it->second : std::vector<Definition>();
+}
+
+std::vector<bool> WorkspaceIndex::defines(std::string_view blockType, const std::vector<std::string>& names) const {
+    FoldedOrder less;
+    std::vector<uint32_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return less(names[a], names[b]); });
+
+    std::vector<bool> defined(names.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto store = storeNames_.find(Ini::definitionNamespace(blockType));
+    if (store == storeNames_.end()) {
+        return defined;
+    }
+    auto next = store->second.begin();
+    for (uint32_t i : order) {
+        while (next != store->second.end() && less(next->first, names[i])) {
+            ++next;
+        }
+        defined[i] = next != store->second.end() && next->first == names[i];
+    }
+    return defined;
+}
+
+std::vector<Reference> WorkspaceIndex::findReferences(std::string_view blockType, std::string_view name) const {
+    std::vector<Reference> result;
+    std::string_view store = Ini::definitionNamespace(blockType);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = references_.byName.find(std::string(name));
+    if (it == references_.byName.end()) {
+        return result;
+    }
+    for (const auto& reference : it->second) {
+        if (Ini::definitionNamespace(reference.blockType) == store) {
+            result.push_back(reference);
+        }
+    }
+    return result;
+}
+
+std::vector<Definition> WorkspaceIndex::search(std::string_view query, size_t limit) const {
+    std::vector<Definition> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (query.empty()) {
+        for (const auto& entry : definitions_.byName) {
+            for (const auto& definition : entry.second) {
+                if (result.size() >= limit) {
+                    return result;
+                }
+                result.push_back(definition);
+            }
+        }
+        return result;
+    }
+    for (uint32_t slot : fuzzySearch(symbols_, query, limit)) {
+        for (const auto& definition : definitions_.byName.at(symbols_.names[slot])) {
+            if (result.size() >= limit) {
+                return result;
+            }
+            result.push_back(definition);
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> WorkspaceIndex::completeNames(std::string_view blockType, std::string_view query,
+                                                       size_t limit) const {
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto store = storeNames_.find(Ini::definitionNamespace(blockType));
+    if (store == storeNames_.end()) {
+        return result;
+    }
+    if (query.empty()) {
+        for (auto it = store->second.begin(); it != store->second.end() && result.size() < limit; ++it) {
+            result.push_back(it->first);
+        }
+        return result;
+    }
+    const NameSlots& names = storeSymbols_.at(store->first);
+    for (uint32_t slot : fuzzySearch(names, query, limit)) {
+        result.push_back(names.names[slot]);
+    }
+    return result;
+}
+
+std::vector<uint32_t> WorkspaceIndex::fuzzySearch(const NameSlots& names, std::string_view query, size_t limit) {
+    Text::FuzzyMatcher matcher(query);
+    std::vector<uint32_t> candidates;
+    Text::filterMasks(names.masks.data(), names.masks.size(), matcher.mask(), candidates);
+
+    Text::TopMatches top(limit);
+    for (uint32_t slot : candidates) {
+        const std::string& name = names.names[slot];
+        if (auto score = matcher.score(name)) {
+            top.add(slot, *score, static_cast<uint32_t>(name.size()));
+        }
+    }
+    std::vector<uint32_t> slots;
+    for (const auto& match : top.take()) {
+        slots.push_back(match.index);
+    }
+    return slots;
+}
+
+size_t WorkspaceIndex::definitionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return definitions_.count;
+}
+
+size_t WorkspaceIndex::referenceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return references_.count;
+}
+
+size_t WorkspaceIndex::labelReferenceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return labelCount_;
+}
+
+std::vector<Reference> WorkspaceIndex::labelReferences() const {
+    std::vector<Reference> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.reserve(labelCount_);
+    for (const auto& file : files_) {
+        result.insert(result.end(), file.second.labels.begin(), file.second.labels.end());
+    }
+    std::stable_sort(result.begin(), result.end(), entryOrder<Reference>);
+    return result;
+}
+
+std::vector<Reference> WorkspaceIndex::labelReferences(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(uri);
+    return it != files_.end() ? it->second.labels : std::vector<Reference>();
+}
+
+std::vector<std::string> WorkspaceIndex::definitionNames(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(uri);
+    return it != files_.end() ? it->second.definitions : std::vector<std::string>();
+}
+
+size_t WorkspaceIndex::fileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_.size();
+}
+
+bool WorkspaceIndex::FoldedOrder::operator()(const std::string& a, const std::string& b) const {
+    auto folded = std::mismatch(a.begin(), a.end(), b.begin(), b.end(),
+                                [](char x, char y) { return Ini::asciiLower(x) == Ini::asciiLower(y); });
+    if (folded.first == a.end() || folded.second == b.end()) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    }
+    return static_cast<unsigned char>(Ini::asciiLower(*folded.first)) <
+           static_cast<unsigned char>(Ini::asciiLower(*folded.second));
+}
+
+void WorkspaceIndex::NameSlots::add(const std::string& name) {
+    if (slots.emplace(name, static_cast<uint32_t>(names.size())).second) {
+        names.push_back(name);
+        masks.push_back(Text::characterMask(name));
+    }
+}
+
+void WorkspaceIndex::NameSlots::remove(const std::string& name) {
+    auto it = slots.find(name);
+    if (it == slots.end()) {
+        return;
+    }
+    uint32_t slot = it->second;
+    slots.erase(it);
+    if (slot + 1 != names.size()) {
+        names[slot] = std::move(names.back());
+        masks[slot] = masks.back();
+        slots[names[slot]] = slot;
+    }
+    names.pop_back();
+    masks.pop_back();
+}
+
+template <typename Entry>
+void WorkspaceIndex::NameMap<Entry>::add(const std::string& uri, std::vector<Entry> entries,
+                                         std::vector<std::string>& names) {
+    for (auto& entry : entries) {
+        auto& list = byName[entry.name];
+        auto position = std::upper_bound(list.begin(), list.end(), entry, entryOrder<Entry>);
+        bool known = (position != list.begin() && std::prev(position)->uri == uri) ||
+                     (position != list.end() && position->uri == uri);
+        if (!known) {
+            names.push_back(entry.name);
+        }
+        list.insert(position, std::move(entry));
+        ++count;
+    }
+}
+
+template <typename Entry>
+void WorkspaceIndex::NameMap<Entry>::remove(const std::string& uri, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        auto it = byName.find(name);
+        if (it == byName.end()) {
+            continue;
+        }
+        auto range = fileEntries(it->second, uri);
+        count -= static_cast<size_t>(range.second - range.first);
+        it->second.erase(range.first, range.second);
+        if (it->second.empty()) {
+            byName.erase(it);
+        }
+    }
+}
+
+void WorkspaceIndex::removeFileLocked(const std::string& uri) {
+    auto file = files_.find(uri);
+    if (file == files_.end()) {
+        return;
+    }
+    for (const auto& name : file->second.definitions) {
+        auto entries = definitions_.byName.find(name);
+        if (entries == definitions_.byName.end()) {
+            continue;
+        }
+        auto range = fileEntries(entries->second, uri);
+        for (auto it = range.first; it != range.second; ++it) {
+            std::string_view store = Ini::definitionNamespace(it->blockType);
+            auto& names = storeNames_[store];
+            auto count = names.find(name);
+            if (count != names.end() && --count->second == 0) {
+                names.erase(count);
+                storeSymbols_[store].remove(name);
+            }
+        }
+    }
+    definitions_.remove(uri, file->second.definitions);
+    for (const auto& name : file->second.definitions) {
+        if (!definitions_.byName.count(name)) {
+            symbols_.remove(name);
+        }
+    }
+    references_.remove(uri, file->second.references);
+    labelCount_ -= file->second.labels.size();
+    files_.erase(file);
+}
+
+void WorkspaceIndex::addFileLocked(const std::string& uri, FileSymbols symbols) {
+    auto& names = files_[uri];
+    for (const auto& definition : symbols.definitions) {
+        std::string_view store = Ini::definitionNamespace(definition.blockType);
+        if (++storeNames_[store][definition.name] == 1) {
+            storeSymbols_[store].add(definition.name);
+        }
+    }
+    definitions_.add(uri, std::move(symbols.definitions), names.definitions);
+    for (const auto& name : names.definitions) {
+        symbols_.add(name);
+    }
+    references_.add(uri, std::move(symbols.references), names.references);
+    labelCount_ += symbols.labels.size();
+    names.labels = std::move(symbols.labels);
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,308 @@
+#include "ini/completion.hpp"
+#include "ini/schema_context.hpp"
+#include "text/fuzzy_matcher.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+bool foldedLess(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        auto x = static_cast<unsigned char>(asciiLower(a[i]));
+        auto y = static_cast<unsigned char>(asciiLower(b[i]));
+        if (x != y) {
+            return x < y;
+        }
+    }
+    return a.size() < b.size();
+}
+
+bool foldedStartsWith(std::string_view text, std::string_view prefix) {
+    if (text.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (asciiLower(text[i]) != asciiLower(prefix[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+}
+
+// Every list completion draws from, built on first use
+struct Catalog {
+    CandidateList blocks{CandidateKind::BlockType, {}};
+    std::vector<CandidateList> tables;  // by table index
+    std::vector<CandidateList> lists;   // by list index
+    CandidateList behaviors{CandidateKind::Module, {}};
+    CandidateList bodies{CandidateKind::Module, {}};
+    CandidateList draws{CandidateKind::Module, {}};
+    CandidateList clientUpdates{CandidateKind::Module, {}};
+    CandidateList end{CandidateKind::Keyword, {{"End", {}}}};
+    CandidateList yesNo{CandidateKind::Keyword, {{"Yes", {}}, {"No", {}}}};
+    CandidateList none{CandidateKind::Keyword, {{"NONE", {}}}};
+    CandidateList allNone{CandidateKind::Keyword, {{"ALL", {}}, {"NONE", {}}}};
+};
+
+Catalog buildCatalog() {
+    Catalog catalog;
+
+    std::vector<Candidate> candidates;
+    for (const BlockSchema& block : Schema::blocks()) {
+        candidates.push_back(Candidate{block.name, block.proc});
+    }
+    catalog.blocks = CandidateList(CandidateKind::BlockType, std::move(candidates));
+
+    catalog.tables.reserve(Schema::tables().size());
+    for (const FieldTable& table : Schema::tables()) {
+        candidates.clear();
+        for (const FieldSchema& field : Schema::fields(table)) {
+            if (!field.token.empty()) {
+                candidates.push_back(Candidate{field.token, field.proc});
+            }
+        }
+        catalog.tables.emplace_back(CandidateKind::Field, candidates);
+    }
+
+    catalog.lists.reserve(Schema::lists().size());
+    for (const NameList& list : Schema::lists()) {
+        candidates.clear();
+        for (std::string_view name : Schema::names(list)) {
+            candidates.push_back(Candidate{name, list.name});
+        }
+        catalog.lists.emplace_back(CandidateKind::Name, candidates);
+    }
+
+    // Body takes the behavior modules with the body interface and Behavior the
+    // others (ThingTemplate::parseModuleName); the schema has no interface
+    // masks, but every body module is named *Body
+    std::vector<Candidate> behaviors;
+    std::vector<Candidate> bodies;
+    std::vector<Candidate> draws;
+    std::vector<Candidate> clientUpdates;
+    for (const ModuleSchema& module : Schema::modules()) {
+        Candidate candidate{module.name, module.dataClass};
+        switch (module.type) {
+            case ModuleType::Behavior:
+                (endsWith(module.name, "Body") ? bodies : behaviors).push_back(candidate);
+                break;
+            case ModuleType::Draw:
+                draws.push_back(candidate);
+                break;
+            case ModuleType::ClientUpdate:
+                clientUpdates.push_back(candidate);
+                break;
+        }
+    }
+    catalog.behaviors = CandidateList(CandidateKind::Module, std::move(behaviors));
+    catalog.bodies = CandidateList(CandidateKind::Module, std::move(bodies));
+    catalog.draws = CandidateList(CandidateKind::Module, std::move(draws));
+    catalog.clientUpdates = CandidateList(CandidateKind::Module, std::move(clientUpdates));
+    return catalog;
+}
+
+const Catalog& catalog() {
+    static const Catalog instance = buildCatalog();
+    return instance;
+}
+
+// Innermost block whose children include a line that holds no node (blank,
+// comment or End), or kNone at the top level
+uint32_t enclosingBlock(const Section& section, uint32_t line) {
+    uint32_t enclosing = kNone;
+    for (uint32_t i = 0; i < section.nodes.size(); ++i) {
+        const Node& node = section.nodes[i];
+        if (node.line >= line) {
+            break;
+        }
+        if (node.kind == NodeKind::Block && (node.endLine == kNone || node.endLine > line)) {
+            enclosing = i;
+        }
+    }
+    return enclosing;
+}
+
+bool takesEdits(FieldKind kind) {
+    return kind == FieldKind::BitString || kind == FieldKind::BitFlags || kind == FieldKind::FlagSet;
+}
+
+} // namespace
+
+CandidateList::CandidateList(CandidateKind kind, std::vector<Candidate> candidates)
+    : kind_(kind), candidates_(std::move(candidates)) {
+    // Stable, so of a label listed twice the first entry stays first
+    std::stable_sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        if (foldedLess(a.label, b.label) || foldedLess(b.label, a.label)) {
+            return foldedLess(a.label, b.label);
+        }
+        return a.label < b.label;
+    });
+    // Tables may list a token twice; the engine uses the first entry
+    auto last = std::unique(candidates_.begin(), candidates_.end(),
+                            [](const Candidate& a, const Candidate& b) { return a.label == b.label; });
+    candidates_.erase(last, candidates_.end());
+    masks_.reserve(candidates_.size());
+    for (const Candidate& candidate : candidates_) {
+        masks_.push_back(Text::characterMask(candidate.label));
+    }
+}
+
+SchemaRange<Candidate> CandidateList::withPrefix(std::string_view prefix) const {
+    auto first = std::lower_bound(candidates_.begin(), candidates_.end(), prefix,
+                                  [](const Candidate& candidate, std::string_view key) {
+                                      return foldedLess(candidate.label, key);
+                                  });
+    auto last = std::partition_point(first, candidates_.end(), [prefix](const Candidate& candidate) {
+        return foldedStartsWith(candidate.label, prefix);
+    });
+    return SchemaRange<Candidate>(candidates_.data() + (first - candidates_.begin()), static_cast<size_t>(last - first));
+}
+
+CompletionContext completionContext(const Section& section, uint32_t offset) {
+    CompletionContext context;
+    if (section.lines.empty()) {
+        return topLevelContext();
+    }
+
+    // Token under the cursor; past the last line's terminator is a new empty line
+    uint32_t lineIndex = section.lineAt(offset);
+    const Line* line = &section.lines[lineIndex];
+    uint32_t lineEnd = line->offset + line->length;
+    if (offset > lineEnd) {
+        line = nullptr;
+        lineIndex = static_cast<uint32_t>(section.lines.size());
+    } else if (offset > line->offset + line->contentLength) {
+        return context;  // in a comment
+    }
+    uint32_t token = 0;
+    if (line) {
+        const Token* tokens = section.lineTokens(*line);
+        while (token < line->tokenCount && tokens[token].offset + tokens[token].length < offset) {
+            ++token;
+        }
+        if (token < line->tokenCount && tokens[token].offset <= offset) {
+            context.prefix = std::string_view(section.text).substr(tokens[token].offset, offset - tokens[token].offset);
+        }
+    }
+
+    uint32_t node = line ? nodeAtLine(section, lineIndex) : kNone;
+    if (node == kNone) {
+        // Nothing but a keyword may start a line that has no node yet
+        if (token != 0) {
+            return context;
+        }
+        uint32_t block = enclosingBlock(section, lineIndex);
+        if (block == kNone) {
+            context.site = CompletionSite::BlockType;
+        } else {
+            context.site = CompletionSite::Field;
+            context.table = blockTable(section, block);
+        }
+        return context;
+    }
+
+    uint32_t parent = section.nodes[node].parent;
+    if (token == 0) {
+        context.site = parent == kNone ? CompletionSite::BlockType : CompletionSite::Field;
+        context.table = parent == kNone ? nullptr : blockTable(section, parent);
+        return context;
+    }
+    const FieldSchema* field = parent == kNone ? nullptr : nodeField(section, node);
+    if (!field) {
+        return context;
+    }
+    context.field = field;
+    if (field->kind == FieldKind::Module) {
+        context.site = token == 1 ? CompletionSite::ModuleName : CompletionSite::None;
+        return context;
+    }
+    context.site = CompletionSite::Value;
+    context.value = token - 1;
+    if (takesEdits(field->kind) && !context.prefix.empty() &&
+        (context.prefix[0] == '+' || context.prefix[0] == '-')) {
+        context.sign = context.prefix[0];
+        context.prefix.remove_prefix(1);
+    }
+    return context;
+}
+
+std::vector<const CandidateList*> completionCandidates(const CompletionContext& context) {
+    const Catalog& all = catalog();
+    std::vector<const CandidateList*> lists;
+    switch (context.site) {
+        case CompletionSite::None:
+            break;
+        case CompletionSite::BlockType:
+            lists.push_back(&all.blocks);
+            break;
+        case CompletionSite::Field:
+            if (context.table) {
+                lists.push_back(&all.tables[static_cast<size_t>(context.table - Schema::tables().begin())]);
+            }
+            lists.push_back(&all.end);
+            break;
+        case CompletionSite::ModuleName: {
+            std::string_view token = context.field->token;
+            if (token == "Body") {
+                lists.push_back(&all.bodies);
+            } else if (token == "Behavior") {
+                lists.push_back(&all.behaviors);
+            } else if (token == "Draw") {
+                lists.push_back(&all.draws);
+            } else if (token == "ClientUpdate") {
+                lists.push_back(&all.clientUpdates);
+            }
+            break;
+        }
+        case CompletionSite::Value: {
+            const FieldSchema& field = *context.field;
+            const CandidateList* names = field.list != kNoIndex ? &all.lists[field.list] : nullptr;
+            switch (field.kind) {
+                case FieldKind::Bool:
+                    if (context.value == 0) {
+                        lists.push_back(&all.yesNo);
+                    }
+                    break;
+                case FieldKind::Index:
+                case FieldKind::Lookup:
+                    if (context.value == 0 && names) {
+                        lists.push_back(names);
+                    }
+                    break;
+                case FieldKind::BitString:
+                case FieldKind::BitFlags:
+                    // NONE only stands alone
+                    if (names) {
+                        lists.push_back(names);
+                    }
+                    if (context.value == 0 && !context.sign) {
+                        lists.push_back(&all.none);
+                    }
+                    break;
+                case FieldKind::FlagSet:
+                    // Names are edits of ALL or NONE and need a sign
+                    if (!context.sign) {
+                        lists.push_back(&all.allNone);
+                    } else if (names) {
+                        lists.push_back(names);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+    }
+    return lists;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
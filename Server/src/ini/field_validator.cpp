@@ -0,0 +1,542 @@
+#include "ini/field_validator.hpp"
+#include "ini/schema_context.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+// Separators the engine adds to its token separators for sub-tokens
+constexpr std::string_view kColonSeparators = ":";     // getSepsColon
+constexpr std::string_view kPercentSeparators = "%";   // getSepsPercent
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// The value tokens of a line as successive strtok(NULL, seps) calls return
+// them. The lexer already split on the engine's separators, so a call with
+// extra separators only splits the current token further; like strtok, it
+// consumes the separator that ends a sub-token.
+class TokenCursor {
+public:
+    TokenCursor(const Section& section, const Line& line)
+        : text_(section.text), tokens_(section.lineTokens(line)), count_(line.tokenCount), index_(1),
+          position_(count_ > 1 ? tokens_[1].offset : 0) {}
+
+    // Next token, or false at the end of the line
+    bool next(std::string_view extra, Token& token) {
+        while (index_ < count_) {
+            uint32_t end = tokens_[index_].offset + tokens_[index_].length;
+            while (position_ < end && isSeparator(extra, text_[position_])) {
+                ++position_;
+            }
+            if (position_ == end) {
+                advance();
+                continue;
+            }
+            uint32_t start = position_;
+            while (position_ < end && !isSeparator(extra, text_[position_])) {
+                ++position_;
+            }
+            token = Token{start, position_ - start};
+            if (position_ < end) {
+                ++position_;
+            } else {
+                advance();
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static bool isSeparator(std::string_view extra, char c) { return extra.find(c) != std::string_view::npos; }
+
+    void advance() {
+        if (++index_ < count_) {
+            position_ = tokens_[index_].offset;
+        }
+    }
+
+    std::string_view text_;
+    const Token* tokens_;
+    uint32_t count_;
+    uint32_t index_;
+    uint32_t position_;
+};
+
+// How much of a token sscanf reads for a number; length 0 when it reads nothing
+struct Scan {
+    uint32_t length = 0;
+    bool negative = false;
+    bool nonZero = false;  // some digit of the mantissa is not 0
+    int64_t value = 0;     // integers only, saturated well past 32 bits
+};
+
+// "%d" and "%u": an optional sign and decimal digits
+Scan scanInteger(std::string_view text) {
+    Scan scan;
+    size_t i = 0;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+        scan.negative = text[i] == '-';
+        ++i;
+    }
+    size_t digits = i;
+    for (; i < text.size() && isDigit(text[i]); ++i) {
+        if (scan.value < (int64_t(1) << 40)) {
+            scan.value = scan.value * 10 + (text[i] - '0');
+        }
+        scan.nonZero = scan.nonZero || text[i] != '0';
+    }
+    if (i == digits) {
+        return Scan();
+    }
+    scan.length = static_cast<uint32_t>(i);
+    if (scan.negative) {
+        scan.value = -scan.value;
+    }
+    return scan;
+}
+
+// "%f" as the game's C runtime reads it: an optional sign, digits with an
+// optional point, and an exponent only when digits follow the 'e'
+Scan scanReal(std::string_view text) {
+    Scan scan;
+    size_t i = 0;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+        scan.negative = text[i] == '-';
+        ++i;
+    }
+    size_t digits = 0;
+    for (; i < text.size() && isDigit(text[i]); ++i, ++digits) {
+        scan.nonZero = scan.nonZero || text[i] != '0';
+    }
+    if (i < text.size() && text[i] == '.') {
+        for (++i; i < text.size() && isDigit(text[i]); ++i, ++digits) {
+            scan.nonZero = scan.nonZero || text[i] != '0';
+        }
+    }
+    if (digits == 0) {
+        return Scan();
+    }
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        size_t exponent = i + 1;
+        if (exponent < text.size() && (text[exponent] == '+' || text[exponent] == '-')) {
+            ++exponent;
+        }
+        if (exponent < text.size() && isDigit(text[exponent])) {
+            for (i = exponent; i < text.size() && isDigit(text[i]); ++i) {
+            }
+        }
+    }
+    scan.length = static_cast<uint32_t>(i);
+    return scan;
+}
+
+// One field line being checked; reports go to the keyword or a value token
+class FieldCheck {
+public:
+    FieldCheck(const SyntaxTree& tree, size_t sectionIndex, const Node& node,
+               std::vector<LSP::Diagnostic>& diagnostics)
+        : tree_(tree), sectionIndex_(sectionIndex), section_(tree.section(sectionIndex)),
+          keyword_(section_.lineTokens(section_.lines[node.line])[0]), diagnostics_(diagnostics),
+          cursor_(section_, section_.lines[node.line]) {}
+
+    std::string_view text(const Token& token) const { return section_.tokenText(token); }
+
+    std::string quoted(const Token& token) const { return "'" + std::string(text(token)) + "'"; }
+
+    void report(const Token& token, LSP::DiagnosticSeverity severity, std::string message) {
+        diagnostics_.push_back(LSP::Diagnostic{tree_.tokenRange(sectionIndex_, token), severity, std::move(message),
+                                               std::string("ZeroSyntax")});
+    }
+
+    void error(const Token& token, std::string message) {
+        report(token, LSP::DiagnosticSeverity::Error, std::move(message));
+    }
+
+    // getNextToken: a missing token is reported on the field name
+    bool expect(std::string_view extra, Token& token, std::string_view what = "a value") {
+        if (cursor_.next(extra, token)) {
+            return true;
+        }
+        missing(what);
+        return false;
+    }
+
+    void missing(std::string_view what) { error(keyword_, quoted(keyword_) + " is missing " + std::string(what)); }
+
+    // getNextTokenOrNull
+    bool next(std::string_view extra, Token& token) { return cursor_.next(extra, token); }
+
+    // getNextSubToken: "name:" then the value
+    bool expectSubToken(std::string_view name, Token& value) {
+        std::string what = std::string(name) + ":";
+        Token key;
+        if (!expect(kColonSeparators, key, what)) {
+            return false;
+        }
+        if (!equalsIgnoreCase(text(key), name)) {
+            error(key, "Expected " + what + " but found " + quoted(key));
+            return false;
+        }
+        return expect(kColonSeparators, value, "a value after " + what);
+    }
+
+    // scanInt with the range the proc accepts
+    bool checkInt(const Token& token, int64_t min = INT64_MIN, int64_t max = INT64_MAX) {
+        Scan scan = scanInteger(text(token));
+        if (scan.length == 0) {
+            error(token, quoted(token) + " is not an integer");
+            return false;
+        }
+        if (scan.value < min || scan.value > max) {
+            error(token, std::string(text(token).substr(0, scan.length)) + " is out of range [" +
+                             std::to_string(min) + ", " + std::to_string(max) + "]");
+            return false;
+        }
+        checkTrailing(token, scan);
+        return true;
+    }
+
+    // scanUnsignedInt; "%u" takes a sign and wraps a negative value
+    bool checkUnsigned(const Token& token) {
+        Scan scan = scanInteger(text(token));
+        if (scan.length == 0) {
+            error(token, quoted(token) + " is not an unsigned integer");
+            return false;
+        }
+        if (scan.negative && scan.nonZero) {
+            report(token, LSP::DiagnosticSeverity::Warning,
+                   quoted(token) + " is negative; the game reads it as a very large number");
+        }
+        checkTrailing(token, scan);
+        return true;
+    }
+
+    // scanReal, or parsePositiveNonZeroReal's check
+    bool checkReal(const Token& token, bool positive = false) {
+        Scan scan = scanReal(text(token));
+        if (scan.length == 0) {
+            error(token, quoted(token) + " is not a number");
+            return false;
+        }
+        if (positive && (scan.negative || !scan.nonZero)) {
+            error(token, quoted(token) + " must be greater than 0");
+            return false;
+        }
+        checkTrailing(token, scan);
+        return true;
+    }
+
+    // scanIndexList and scanLookupList; limit is the number of positions the store holds
+    bool checkName(const Token& token, uint16_t list, uint32_t limit = UINT32_MAX) {
+        if (list == kNoIndex) {
+            return true;
+        }
+        std::optional<uint32_t> index = Schema::findName(Schema::list(list), text(token));
+        if (!index) {
+            error(token, quoted(token) + " is not a valid value for " + quoted(keyword_));
+            return false;
+        }
+        if (!Schema::list(list).lookup && *index >= limit) {
+            error(token, quoted(token) + " does not fit in " + quoted(keyword_));
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void checkTrailing(const Token& token, const Scan& scan) {
+        if (scan.length < token.length) {
+            report(token, LSP::DiagnosticSeverity::Warning,
+                   "The game reads " + quoted(token) + " as " + std::string(text(token).substr(0, scan.length)) +
+                       " and ignores the rest");
+        }
+    }
+
+    const SyntaxTree& tree_;
+    size_t sectionIndex_;
+    const Section& section_;
+    Token keyword_;
+    std::vector<LSP::Diagnostic>& diagnostics_;
+    TokenCursor cursor_;
+};
+
+// parseBitString32, BitFlags::parse: names, or +name/-name edits, or NONE alone
+void checkBitString(FieldCheck& check, const FieldSchema& field, uint32_t bits) {
+    bool foundNormal = false;
+    bool foundAddOrSub = false;
+    Token token;
+    while (check.next({}, token)) {
+        std::string_view name = check.text(token);
+        if (equalsIgnoreCase(name, "NONE")) {
+            if (foundNormal || foundAddOrSub) {
+                check.error(token, "NONE cannot be combined with other names");
+            }
+            return;
+        }
+        bool edit = name[0] == '+' || name[0] == '-';
+        if (edit ? foundNormal : foundAddOrSub) {
+            check.error(token, "Names cannot be mixed with +name and -name edits");
+            return;
+        }
+        foundNormal = foundNormal || !edit;
+        foundAddOrSub = foundAddOrSub || edit;
+        Token bare = edit ? Token{token.offset + 1, token.length - 1} : token;
+        if (!check.checkName(bare, field.list, bits)) {
+            return;
+        }
+    }
+}
+
+// parseDamageTypeFlags, parseDeathTypeFlags and parseVeterancyLevelFlags: ALL, NONE, +name and -name
+void checkFlagSet(FieldCheck& check, const FieldSchema& field) {
+    Token token;
+    if (!check.expect({}, token)) {
+        return;
+    }
+    do {
+        std::string_view name = check.text(token);
+        if (equalsIgnoreCase(name, "ALL") || equalsIgnoreCase(name, "NONE")) {
+            continue;
+        }
+        if (name[0] != '+' && name[0] != '-') {
+            check.error(token, check.quoted(token) + " must be ALL, NONE, or a name prefixed with + or -");
+            return;
+        }
+        if (!check.checkName(Token{token.offset + 1, token.length - 1}, field.list)) {
+            return;
+        }
+    } while (check.next({}, token));
+}
+
+// parseRGBColor requires R, G and B; parseRGBAColorInt and parseColorInt also take an optional A
+void checkColor(FieldCheck& check, const FieldSchema& field) {
+    static constexpr std::string_view kNames[] = {"R", "G", "B", "A"};
+    bool alpha = field.proc != "INI::parseRGBColor";
+    Token token;
+    for (size_t i = 0; i < (alpha ? 4 : 3); ++i) {
+        if (!alpha) {
+            if (!check.expectSubToken(kNames[i], token)) {
+                return;
+            }
+        } else {
+            Token key;
+            if (!check.next(kColonSeparators, key)) {
+                if (i < 3) {
+                    check.missing(std::string(kNames[i]) + ":");
+                }
+                return;
+            }
+            if (!equalsIgnoreCase(check.text(key), kNames[i])) {
+                check.error(key, "Expected " + std::string(kNames[i]) + ": but found " + check.quoted(key));
+                return;
+            }
+            if (!check.expect(kColonSeparators, token, "a value after " + std::string(kNames[i]) + ":")) {
+                return;
+            }
+        }
+        if (!check.checkInt(token, 0, 255)) {
+            return;
+        }
+    }
+}
+
+// parseCoord2D, parseICoord2D and parseCoord3D
+void checkCoord(FieldCheck& check, const FieldSchema& field) {
+    static constexpr std::string_view kNames[] = {"X", "Y", "Z"};
+    bool integer = field.proc == "INI::parseICoord2D";
+    size_t count = field.kind == FieldKind::Coord3D ? 3 : 2;
+    Token token;
+    for (size_t i = 0; i < count; ++i) {
+        if (!check.expectSubToken(kNames[i], token)) {
+            return;
+        }
+        if (!(integer ? check.checkInt(token) : check.checkReal(token))) {
+            return;
+        }
+    }
+}
+
+void checkField(FieldCheck& check, const FieldSchema& field) {
+    Token token;
+    switch (field.kind) {
+        case FieldKind::Bool:
+            if (check.expect({}, token) && !equalsIgnoreCase(check.text(token), "Yes") &&
+                !equalsIgnoreCase(check.text(token), "No")) {
+                check.error(token, check.quoted(token) + " is not Yes or No");
+            }
+            break;
+        case FieldKind::Int:
+            if (check.expect({}, token)) {
+                if (field.proc == "INI::parseShort") {
+                    check.checkInt(token, -32768, 32767);
+                } else {
+                    check.checkInt(token);
+                }
+            }
+            break;
+        case FieldKind::UnsignedInt:
+            if (!check.expect({}, token)) {
+                break;
+            }
+            // parseUnsignedByte and parseUnsignedShort read a signed int and check its range
+            if (field.proc == "INI::parseUnsignedByte") {
+                check.checkInt(token, 0, 255);
+            } else if (field.proc == "INI::parseUnsignedShort") {
+                check.checkInt(token, 0, 65535);
+            } else {
+                check.checkUnsigned(token);
+            }
+            break;
+        case FieldKind::Real:
+            if (check.expect({}, token)) {
+                check.checkReal(token, field.proc == "INI::parsePositiveNonZeroReal");
+            }
+            break;
+        case FieldKind::Percent:
+            if (check.expect(kPercentSeparators, token)) {
+                check.checkReal(token);
+            }
+            break;
+        case FieldKind::Label:
+        case FieldKind::Reference:
+            // Both need a name unless read as a plain string or a list;
+            // whether the name exists is the workspace's business
+            if (field.proc != "INI::parseAsciiString" && field.proc != "INI::parseScienceVector") {
+                check.expect({}, token);
+            }
+            break;
+        case FieldKind::Color:
+            checkColor(check, field);
+            break;
+        case FieldKind::Coord2D:
+        case FieldKind::Coord3D:
+            checkCoord(check, field);
+            break;
+        case FieldKind::Index:
+        case FieldKind::Lookup:
+            if (check.expect({}, token)) {
+                check.checkName(token, field.list, field.proc == "INI::parseByteSizedIndexList" ? 256 : UINT32_MAX);
+            }
+            break;
+        case FieldKind::BitString:
+            checkBitString(check, field, field.proc == "INI::parseBitString8" ? 8 : UINT32_MAX);
+            break;
+        case FieldKind::BitFlags:
+            checkBitString(check, field, UINT32_MAX);
+            break;
+        case FieldKind::FlagSet:
+            checkFlagSet(check, field);
+            break;
+        case FieldKind::Module:
+        case FieldKind::Block:
+        case FieldKind::String:
+        case FieldKind::Custom:
+            break;
+    }
+}
+
+// ThingTemplate::parseModuleName: a known module and a tag
+void checkModuleHeader(FieldCheck& check) {
+    Token name;
+    Token tag;
+    if (!check.expect({}, name, "a module name")) {
+        return;
+    }
+    if (!Schema::findModule(check.text(name))) {
+        check.error(name, "Unknown module " + check.quoted(name));
+        return;
+    }
+    check.expect({}, tag, "a module tag");
+}
+
+// A block as messages name it: a module by its module name, others by keyword
+std::string_view blockName(const Section& section, uint32_t node) {
+    const FieldSchema* field = nodeField(section, node);
+    return section.nodeToken(section.nodes[node], field && field->kind == FieldKind::Module ? 1 : 0);
+}
+
+std::string syntaxMessage(const Section& section, const SyntaxError& error) {
+    std::string token(std::string_view(section.text).substr(error.offset, error.length));
+    switch (error.kind) {
+        case SyntaxErrorKind::UnknownBlock:
+            return "Unknown block type '" + token + "'";
+        case SyntaxErrorKind::MissingEnd:
+            return "'" + token + "' is not closed with End";
+        case SyntaxErrorKind::UnexpectedEnd:
+            return "End outside of any block";
+        case SyntaxErrorKind::LineTooLong:
+            return "Line is longer than the game reads; the rest is read as a new line";
+    }
+    return {};
+}
+
+} // namespace
+
+void validateSection(const SyntaxTree& tree, size_t sectionIndex, std::vector<LSP::Diagnostic>& diagnostics) {
+    const Section& section = tree.section(sectionIndex);
+    for (const SyntaxError& error : section.errors) {
+        auto severity = error.kind == SyntaxErrorKind::LineTooLong ? LSP::DiagnosticSeverity::Warning
+                                                                  : LSP::DiagnosticSeverity::Error;
+        diagnostics.push_back(LSP::Diagnostic{tree.tokenRange(sectionIndex, Token{error.offset, error.length}),
+                                              severity, syntaxMessage(section, error), std::string("ZeroSyntax")});
+    }
+    if (!section.hasRoot()) {
+        return;
+    }
+
+    std::vector<const FieldTable*> tables = blockTables(section);
+    for (uint32_t i = 1; i < section.nodes.size(); ++i) {
+        const Node& node = section.nodes[i];
+        const FieldTable* parent = node.parent != kNone ? tables[node.parent] : nullptr;
+        if (!parent) {
+            continue;
+        }
+        FieldCheck check(tree, sectionIndex, node, diagnostics);
+        const Token& keyword = section.lineTokens(section.lines[node.line])[0];
+        const FieldSchema* field = Schema::findField(*parent, check.text(keyword));
+        if (!field) {
+            // findFieldParse fails and the engine throws INI_UNKNOWN_TOKEN
+            if (!parent->acceptsAnyField) {
+                check.error(keyword, check.quoted(keyword) + " is not a field of '" +
+                                         std::string(blockName(section, node.parent)) + "'");
+            }
+            continue;
+        }
+        if (field->kind == FieldKind::Module) {
+            checkModuleHeader(check);
+        } else if (node.kind == NodeKind::Field) {
+            checkField(check, *field);
+        }
+    }
+}
+
+std::vector<LSP::Diagnostic> validateTree(const SyntaxTree& tree) {
+    std::vector<LSP::Diagnostic> diagnostics;
+    for (size_t i = 0; i < tree.sectionCount(); ++i) {
+        validateSection(tree, i, diagnostics);
+    }
+    return diagnostics;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
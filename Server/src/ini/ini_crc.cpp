@@ -0,0 +1,86 @@
+#include "ini/ini_crc.hpp"
+#include "ini/ini_lexer.hpp"
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+template <typename Word>
+constexpr Word repeatByte(uint8_t byte) {
+    return static_cast<Word>(~Word(0) / 0xFF * byte);
+}
+
+// Bytes in big-endian order, so the first byte is the most significant;
+// compilers turn these into one load and a byte swap
+uint32_t loadBigEndian32(const unsigned char* bytes) {
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+
+uint64_t loadBigEndian64(const unsigned char* bytes) {
+    return (uint64_t(loadBigEndian32(bytes)) << 32) | loadBigEndian32(bytes + 4);
+}
+
+// Every byte in 1..31 becomes ' ', as INI::readLine maps control characters;
+// bytes of 0x80 and up are negative chars there and stay. Content holds no
+// NUL, and ((b & 0x7F) + 0x60) cannot carry into the next byte.
+template <typename Word>
+Word spaceControls(Word word) {
+    constexpr Word kHigh = repeatByte<Word>(0x80);
+    Word atLeastSpace = (word & repeatByte<Word>(0x7F)) + repeatByte<Word>(0x60);
+    Word control = ~(atLeastSpace | word) & kHigh;
+    Word bytes = (control >> 7) * 0xFF;
+    return (word & ~bytes) | (repeatByte<Word>(' ') & bytes);
+}
+
+unsigned char spaceControl(unsigned char c) {
+    return c > 0 && c < 32 ? ' ' : c;
+}
+
+} // namespace
+
+void appendCrcTerms(std::string_view text, std::vector<uint32_t>& terms) {
+    // Written through a pointer into room made ahead, trimmed at the end
+    size_t used = terms.size();
+    terms.resize(used + text.size() / 4 + 16);
+    LineLexer lexer(text);
+    while (!lexer.atEnd()) {
+        LexedLine line = lexer.next();
+        const auto* bytes = reinterpret_cast<const unsigned char*>(text.data() + line.offset);
+        size_t size = line.contentLength;
+        if (used + size / 4 + 1 > terms.size()) {
+            terms.resize(terms.size() * 2 + size / 4 + 1);
+        }
+        uint32_t* out = terms.data() + used;
+        size_t i = 0;
+        // Two words at a time
+        for (; i + 8 <= size; i += 8) {
+            uint64_t pair = spaceControls(loadBigEndian64(bytes + i));
+            *out++ = static_cast<uint32_t>(pair >> 32);
+            *out++ = static_cast<uint32_t>(pair);
+        }
+        if (i + 4 <= size) {
+            *out++ = spaceControls(loadBigEndian32(bytes + i));
+            i += 4;
+        }
+        if (i < size) {
+            uint32_t leftover = 0;
+            for (size_t j = 0; i + j < size; ++j) {
+                leftover |= static_cast<uint32_t>(spaceControl(bytes[i + j])) << (j * 8);
+            }
+            *out++ = leftover;
+        }
+        used = static_cast<size_t>(out - terms.data());
+    }
+    terms.resize(used);
+}
+
+uint32_t foldCrcTerms(uint32_t state, const uint32_t* terms, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        state = ((state << 1) | (state >> 31)) + terms[i];
+    }
+    return state;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
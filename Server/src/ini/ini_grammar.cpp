@@ -0,0 +1,102 @@
+#include "ini/ini_grammar.hpp"
+#include "ini/ini_schema.hpp"
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+using TokenSet = std::unordered_set<std::string_view>;
+using NestedBlocks = std::unordered_map<std::string_view, TokenSet>;
+
+// Modules a module field takes (ThingTemplate::parseModuleName): Body and
+// Behavior both take behavior modules
+ModuleType moduleTypeOf(std::string_view field) {
+    if (field == "Draw") {
+        return ModuleType::Draw;
+    }
+    if (field == "ClientUpdate") {
+        return ModuleType::ClientUpdate;
+    }
+    return ModuleType::Behavior;
+}
+
+// Record the Block and Module fields of a table under context, and what
+// they open in turn under their own tokens. The module override blocks
+// (AddModule, ...) re-enter the object's table, hence visited.
+void addNestedBlocks(NestedBlocks& blocks, std::set<std::pair<std::string_view, uint16_t>>& visited,
+                     std::string_view context, uint16_t table) {
+    if (!visited.emplace(context, table).second) {
+        return;
+    }
+    for (const FieldSchema& field : Schema::fields(Schema::table(table))) {
+        if (field.kind == FieldKind::Block) {
+            blocks[context].insert(field.token);
+            if (field.table != kNoIndex) {
+                addNestedBlocks(blocks, visited, field.token, field.table);
+            }
+        } else if (field.kind == FieldKind::Module) {
+            blocks[context].insert(field.token);
+            ModuleType type = moduleTypeOf(field.token);
+            for (const ModuleSchema& module : Schema::modules()) {
+                if (module.type == type && module.table != kNoIndex) {
+                    addNestedBlocks(blocks, visited, field.token, module.table);
+                }
+            }
+        }
+    }
+}
+
+// Fields that open a nested block, by the block they appear in, from the
+// schema's Block and Module fields
+const NestedBlocks& nestedBlocks() {
+    static const NestedBlocks blocks = [] {
+        NestedBlocks result;
+        std::set<std::pair<std::string_view, uint16_t>> visited;
+        for (const BlockSchema& block : Schema::blocks()) {
+            if (block.table != kNoIndex) {
+                addNestedBlocks(result, visited, block.name, block.table);
+            }
+        }
+        return result;
+    }();
+    return blocks;
+}
+
+} // namespace
+
+bool isTopLevelBlock(std::string_view token) {
+    return Schema::findBlock(token) != nullptr;
+}
+
+bool isSingleLineBlock(std::string_view token) {
+    return token == "ReallyLowMHz";
+}
+
+bool opensNestedBlock(std::string_view context, std::string_view field) {
+    const auto& blocks = nestedBlocks();
+    auto it = blocks.find(context);
+    return it != blocks.end() && it->second.count(field) != 0;
+}
+
+bool isEndToken(std::string_view token) {
+    return token.size() == 3 &&
+           (token[0] | 0x20) == 'e' && (token[1] | 0x20) == 'n' && (token[2] | 0x20) == 'd';
+}
+
+std::string_view definitionNamespace(std::string_view blockType) {
+    if (blockType == "ObjectReskin") {
+        return "Object";
+    }
+    if (blockType == "DialogEvent" || blockType == "MusicTrack") {
+        return "AudioEvent";
+    }
+    return blockType;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
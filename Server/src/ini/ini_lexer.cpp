@@ -0,0 +1,66 @@
+#include "ini/ini_lexer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ull;
+constexpr uint64_t kHighs = 0x8080808080808080ull;
+
+// Non-zero when a byte of word is zero; exact as a whole, though bytes after
+// a zero byte may be flagged too
+uint64_t hasZeroByte(uint64_t word) {
+    return (word - kOnes) & ~word & kHighs;
+}
+
+// Index of the first ';' or NUL in bytes, or size
+size_t contentLength(const char* bytes, size_t size) {
+    size_t i = 0;
+    // Skip eight bytes at a time while none can end the content
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        if (hasZeroByte(word) | hasZeroByte(word ^ (kOnes * ';'))) {
+            break;
+        }
+    }
+    for (; i < size; ++i) {
+        if (bytes[i] == ';' || bytes[i] == '\0') {
+            return i;
+        }
+    }
+    return size;
+}
+
+} // namespace
+
+LineLexer::LineLexer(std::string_view source, size_t offset)
+    : source_(source), offset_(std::min(offset, source.size())) {}
+
+LexedLine LineLexer::next() {
+    LexedLine line{offset_, 0, 0, 0, false};
+
+    const char* begin = source_.data() + offset_;
+    size_t available = std::min(source_.size() - offset_, kMaxCharsPerLine);
+
+    const void* newline = std::memchr(begin, '\n', available);
+    if (newline) {
+        line.length = static_cast<size_t>(static_cast<const char*>(newline) - begin);
+        line.terminatorLength = 1;
+    } else {
+        line.length = available;
+        line.truncated = available == kMaxCharsPerLine;
+    }
+
+    // Everything after ';' (or a NUL, which terminates the engine's C string) is ignored
+    line.contentLength = contentLength(begin, line.length);
+
+    offset_ += line.length + line.terminatorLength;
+    return line;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
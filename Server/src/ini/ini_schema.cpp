@@ -0,0 +1,110 @@
+#include "ini/ini_schema.hpp"
+#include "ini/ini_schema_data.hpp"
+
+namespace ZeroSyntax {
+namespace Ini {
+namespace Schema {
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Candidate record of a set for key (the only one whose name can equal key
+// ignoring case), or kNoIndex
+uint16_t probe(const HashSlot* slots, uint32_t size, std::string_view key) {
+    if (size == 0) {
+        return kNoIndex;
+    }
+    int32_t displacement = slots[hashPosition(schemaHash(key, 0), size)].displacement;
+    if (displacement == 0) {
+        return kNoIndex;
+    }
+    uint32_t position = displacement < 0 ? static_cast<uint32_t>(-displacement - 1)
+                                         : hashPosition(schemaHash(key, static_cast<uint32_t>(displacement)), size);
+    return slots[position].entry;
+}
+
+bool matches(std::string_view name, std::string_view key, MatchCase match) {
+    return match == MatchCase::Exact ? name == key : equalsIgnoreCase(name, key);
+}
+
+} // namespace
+
+SchemaRange<BlockSchema> blocks() {
+    return {SchemaData::kBlocks, SchemaData::kBlockCount};
+}
+
+SchemaRange<ModuleSchema> modules() {
+    return {SchemaData::kModules, SchemaData::kModuleCount};
+}
+
+SchemaRange<FieldTable> tables() {
+    return {SchemaData::kTables, SchemaData::kTableCount};
+}
+
+SchemaRange<NameList> lists() {
+    return {SchemaData::kLists, SchemaData::kListCount};
+}
+
+const BlockSchema* findBlock(std::string_view name, MatchCase match) {
+    uint16_t entry = probe(SchemaData::kBlockHash, SchemaData::kBlockCount, name);
+    if (entry == kNoIndex || !matches(SchemaData::kBlocks[entry].name, name, match)) {
+        return nullptr;
+    }
+    return &SchemaData::kBlocks[entry];
+}
+
+const ModuleSchema* findModule(std::string_view name, MatchCase match) {
+    uint16_t entry = probe(SchemaData::kModuleHash, SchemaData::kModuleCount, name);
+    if (entry == kNoIndex || !matches(SchemaData::kModules[entry].name, name, match)) {
+        return nullptr;
+    }
+    return &SchemaData::kModules[entry];
+}
+
+const FieldTable& table(uint16_t index) {
+    return SchemaData::kTables[index];
+}
+
+SchemaRange<FieldSchema> fields(const FieldTable& table) {
+    return {SchemaData::kFields + table.firstField, table.fieldCount};
+}
+
+const FieldSchema* findField(const FieldTable& table, std::string_view token, MatchCase match) {
+    uint16_t entry = probe(SchemaData::kFieldHash + table.firstField, table.fieldCount, token);
+    if (entry == kNoIndex) {
+        return nullptr;
+    }
+    const FieldSchema& field = SchemaData::kFields[table.firstField + entry];
+    return matches(field.token, token, match) ? &field : nullptr;
+}
+
+const NameList& list(uint16_t index) {
+    return SchemaData::kLists[index];
+}
+
+SchemaRange<std::string_view> names(const NameList& list) {
+    return {SchemaData::kListNames + list.first, list.count};
+}
+
+std::optional<uint32_t> findName(const NameList& list, std::string_view name) {
+    uint16_t entry = probe(SchemaData::kListNameHash + list.first, list.count, name);
+    if (entry == kNoIndex || !equalsIgnoreCase(SchemaData::kListNames[list.first + entry], name)) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+} // namespace Schema
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,85 @@
+#include "ini/schema_context.hpp"
+#include <algorithm>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+uint32_t nodeAtLine(const Section& section, uint32_t line) {
+    // Preorder visits lines in increasing order
+    auto it = std::lower_bound(section.nodes.begin(), section.nodes.end(), line,
+                               [](const Node& node, uint32_t value) { return node.line < value; });
+    if (it == section.nodes.end() || it->line != line) {
+        return kNone;
+    }
+    return static_cast<uint32_t>(it - section.nodes.begin());
+}
+
+uint32_t tokenAt(const Section& section, const Line& line, uint32_t offset) {
+    const Token* tokens = section.lineTokens(line);
+    for (uint32_t i = 0; i < line.tokenCount; ++i) {
+        if (offset >= tokens[i].offset && offset <= tokens[i].offset + tokens[i].length) {
+            return i;
+        }
+    }
+    return kNone;
+}
+
+const FieldTable* blockTable(const Section& section, uint32_t node) {
+    const Node& current = section.nodes[node];
+    if (current.kind != NodeKind::Block) {
+        return nullptr;
+    }
+    if (current.parent == kNone) {
+        const BlockSchema* block = Schema::findBlock(section.keyword(current));
+        return block && block->table != kNoIndex ? &Schema::table(block->table) : nullptr;
+    }
+
+    const FieldSchema* field = nodeField(section, node);
+    if (!field) {
+        return nullptr;
+    }
+    if (field->kind == FieldKind::Module) {
+        const ModuleSchema* module = Schema::findModule(section.nodeToken(current, 1));
+        return module && module->table != kNoIndex ? &Schema::table(module->table) : nullptr;
+    }
+    return field->table != kNoIndex ? &Schema::table(field->table) : nullptr;
+}
+
+const FieldSchema* nodeField(const Section& section, uint32_t node) {
+    uint32_t parent = section.nodes[node].parent;
+    if (parent == kNone) {
+        return nullptr;
+    }
+    const FieldTable* table = blockTable(section, parent);
+    return table ? Schema::findField(*table, section.keyword(section.nodes[node])) : nullptr;
+}
+
+std::vector<const FieldTable*> blockTables(const Section& section) {
+    // Parents precede their children, so each node only looks at its parent's entry
+    std::vector<const FieldTable*> tables(section.nodes.size(), nullptr);
+    for (uint32_t i = 0; i < section.nodes.size(); ++i) {
+        const Node& node = section.nodes[i];
+        if (node.kind != NodeKind::Block) {
+            continue;
+        }
+        if (node.parent == kNone) {
+            tables[i] = blockTable(section, i);
+            continue;
+        }
+        const FieldTable* parent = tables[node.parent];
+        const FieldSchema* field = parent ? Schema::findField(*parent, section.keyword(node)) : nullptr;
+        if (!field) {
+            continue;
+        }
+        if (field->kind == FieldKind::Module) {
+            const ModuleSchema* module = Schema::findModule(section.nodeToken(node, 1));
+            tables[i] = module && module->table != kNoIndex ? &Schema::table(module->table) : nullptr;
+        } else if (field->table != kNoIndex) {
+            tables[i] = &Schema::table(field->table);
+        }
+    }
+    return tables;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,334 @@
+#include "ini/syntax_tree.hpp"
+#include "ini/ini_grammar.hpp"
+#include "ini/ini_lexer.hpp"
+#include <algorithm>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+// UTF-8 continuation bytes have the form 10xxxxxx
+inline bool isContinuationByte(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Number of UTF-16 code units taken by the character starting with this lead byte
+inline uint32_t utf16Units(unsigned char lead) {
+    return (lead & 0xF8) == 0xF0 ? 2 : 1;
+}
+
+// A block that has been opened but not yet closed by End
+struct OpenBlock {
+    uint32_t node;
+    std::string_view context;  // block type or the field that opened it
+};
+
+// A top-level header written at column 0 inside an unterminated block starts
+// a new block rather than being a field of the open one. Fields that share a
+// block type name ("Armor = ...", "Weapon = ...") are told apart by the '='.
+bool startsNewBlock(std::string_view source, const LexedLine& line, size_t tokenBegin,
+                    std::string_view keyword) {
+    bool atColumnZero = line.offset == 0 || source[line.offset - 1] == '\n';
+    if (!atColumnZero || tokenBegin != 0 || !isTopLevelBlock(keyword)) {
+        return false;
+    }
+    for (size_t i = keyword.size(); i < line.contentLength; ++i) {
+        char c = source[line.offset + i];
+        if (c == '=') {
+            return false;
+        }
+        if (!LineLexer::isSeparator(c)) {
+            return true;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t Section::lineAt(uint32_t offset) const {
+    auto it = std::upper_bound(lines.begin(), lines.end(), offset,
+                               [](uint32_t value, const Line& line) { return value < line.offset; });
+    return it == lines.begin() ? 0 : static_cast<uint32_t>(it - lines.begin() - 1);
+}
+
+SyntaxTree::SyntaxTree() : length_(0) {}
+
+SyntaxTree SyntaxTree::parse(std::string_view source) {
+    SyntaxTree tree;
+    size_t offset = 0;
+    while (offset < source.size()) {
+        auto section = parseSection(source, offset);
+        offset += section->text.size();
+        tree.sections_.push_back(std::move(section));
+    }
+    tree.rebuildIndex(0);
+    return tree;
+}
+
+std::shared_ptr<const Section> SyntaxTree::parseSection(std::string_view source, size_t offset) {
+    auto section = std::make_shared<Section>();
+    section->rows = 0;
+
+    const size_t start = std::min(offset, source.size());
+    auto relative = [start](size_t absolute) { return static_cast<uint32_t>(absolute - start); };
+
+    // Column of the first line; only non-zero when the previous section ended on a truncated line
+    uint32_t column = 0;
+    if (start > 0 && source[start - 1] != '\n') {
+        size_t newline = source.rfind('\n', start - 1);
+        column = static_cast<uint32_t>(newline == std::string_view::npos ? start : start - newline - 1);
+    }
+
+    std::vector<OpenBlock> open;
+    LineLexer lexer(source, start);
+    size_t end = start;
+
+    while (!lexer.atEnd()) {
+        LexedLine lexed = lexer.next();
+        std::string_view content = source.substr(lexed.offset, lexed.contentLength);
+
+        size_t firstToken = section->tokens.size();
+        size_t firstTokenBegin = 0;
+        LineLexer::tokenize(content, [&](size_t begin, size_t length) {
+            if (section->tokens.size() == firstToken) {
+                firstTokenBegin = begin;
+            }
+            section->tokens.push_back(Token{relative(lexed.offset + begin), static_cast<uint32_t>(length)});
+        });
+        uint32_t tokenCount = static_cast<uint32_t>(section->tokens.size() - firstToken);
+        std::string_view keyword;
+        if (tokenCount > 0) {
+            keyword = content.substr(firstTokenBegin, section->tokens[firstToken].length);
+        }
+
+        bool firstLine = section->lines.empty();
+        if (tokenCount > 0 && !firstLine &&
+            (open.empty() ||
+             (!isEndToken(keyword) && !opensNestedBlock(open.back().context, keyword) &&
+              startsNewBlock(source, lexed, firstTokenBegin, keyword)))) {
+            // This line belongs to the next section
+            section->tokens.resize(firstToken);
+            break;
+        }
+
+        uint32_t lineIndex = static_cast<uint32_t>(section->lines.size());
+        section->lines.push_back(Line{relative(lexed.offset), static_cast<uint32_t>(lexed.length),
+                                      static_cast<uint32_t>(lexed.contentLength),
+                                      static_cast<uint32_t>(firstToken), tokenCount, section->rows, column,
+                                      lexed.terminatorLength, lexed.truncated});
+        end = lexer.offset();
+
+        if (lexed.truncated) {
+            section->errors.push_back(
+                SyntaxError{SyntaxErrorKind::LineTooLong, relative(lexed.offset), static_cast<uint32_t>(lexed.length)});
+        }
+        if (lexed.terminatorLength) {
+            ++section->rows;
+            column = 0;
+        } else {
+            column += static_cast<uint32_t>(lexed.length);
+        }
+
+        if (tokenCount == 0) {
+            continue;
+        }
+
+        const Token& token = section->tokens[firstToken];
+        uint32_t parent = open.empty() ? kNone : open.back().node;
+        uint32_t nodeIndex = static_cast<uint32_t>(section->nodes.size());
+
+        if (firstLine) {
+            if (isEndToken(keyword)) {
+                section->errors.push_back(SyntaxError{SyntaxErrorKind::UnexpectedEnd, token.offset, token.length});
+                section->nodes.push_back(Node{NodeKind::Field, lineIndex, kNone, kNone, nodeIndex + 1});
+            } else if (isSingleLineBlock(keyword)) {
+                section->nodes.push_back(Node{NodeKind::Field, lineIndex, kNone, kNone, nodeIndex + 1});
+            } else {
+                if (!isTopLevelBlock(keyword)) {
+                    section->errors.push_back(SyntaxError{SyntaxErrorKind::UnknownBlock, token.offset, token.length});
+                }
+                section->nodes.push_back(Node{NodeKind::Block, lineIndex, kNone, kNone, kNone});
+                open.push_back(OpenBlock{nodeIndex, keyword});
+            }
+        } else if (isEndToken(keyword)) {
+            Node& block = section->nodes[open.back().node];
+            block.endLine = lineIndex;
+            block.subtreeEnd = nodeIndex;
+            open.pop_back();
+        } else if (opensNestedBlock(open.back().context, keyword)) {
+            section->nodes.push_back(Node{NodeKind::Block, lineIndex, kNone, parent, kNone});
+            open.push_back(OpenBlock{nodeIndex, keyword});
+        } else {
+            section->nodes.push_back(Node{NodeKind::Field, lineIndex, kNone, parent, nodeIndex + 1});
+        }
+    }
+
+    // Blocks still open run to the end of the section
+    for (auto it = open.rbegin(); it != open.rend(); ++it) {
+        Node& block = section->nodes[it->node];
+        block.subtreeEnd = static_cast<uint32_t>(section->nodes.size());
+        const Token& token = section->tokens[section->lines[block.line].firstToken];
+        section->errors.push_back(SyntaxError{SyntaxErrorKind::MissingEnd, token.offset, token.length});
+    }
+
+    section->text.assign(source.substr(start, end - start));
+    return section;
+}
+
+SyntaxTree SyntaxTree::edit(const PieceTable& text, size_t offset, size_t removed, size_t inserted) const {
+    if (sections_.empty()) {
+        return parse(text.text());
+    }
+
+    // Editing a header line can merge its section into the previous block,
+    // and a section that starts mid-line depends on the line before it
+    size_t first = findSection(offset);
+    const Section& enclosing = *sections_[first];
+    if (first > 0 && offset <= offsets_[first] + enclosing.lines[0].length) {
+        --first;
+    }
+    while (first > 0 && sections_[first - 1]->lines.back().terminatorLength == 0) {
+        --first;
+    }
+
+    const size_t newLength = text.length();
+    const size_t start = offsets_[first];
+    const size_t newEditEnd = offset + inserted;
+    const size_t oldEditEnd = offset + removed;
+
+    // Fetch the new text of the affected sections plus some slack; the
+    // window grows if a section runs past it
+    size_t last = findSection(oldEditEnd);
+    size_t oldLastEnd = std::max(offsets_[last] + sections_[last]->text.size(), oldEditEnd);
+    size_t windowEnd = std::min(newLength, oldLastEnd - oldEditEnd + newEditEnd + 2 * kMaxCharsPerLine);
+    std::string window = text.substr(start, windowEnd - start);
+
+    SyntaxTree tree;
+    tree.sections_.assign(sections_.begin(), sections_.begin() + first);
+
+    size_t position = start;
+    size_t reused = sections_.size();
+    while (position < newLength) {
+        // Resynchronize at the first old block boundary past the edit
+        if (position >= newEditEnd && (tree.sections_.empty() || tree.sections_.back()->lines.back().terminatorLength)) {
+            size_t oldPosition = position + removed - inserted;
+            auto it = std::lower_bound(offsets_.begin(), offsets_.end(), oldPosition);
+            if (it != offsets_.end() && *it == oldPosition && oldPosition >= oldEditEnd) {
+                reused = static_cast<size_t>(it - offsets_.begin());
+                break;
+            }
+        }
+
+        auto section = parseSection(window, position - start);
+        size_t sectionEnd = position + section->text.size();
+
+        // The section is only complete if the line after it is in the window
+        bool complete = windowEnd == newLength || windowEnd - sectionEnd >= kMaxCharsPerLine ||
+                        window.find('\n', sectionEnd - start) != std::string::npos;
+        if (!complete) {
+            windowEnd = std::min(newLength, start + 2 * (windowEnd - start) + kMaxCharsPerLine);
+            window = text.substr(start, windowEnd - start);
+            continue;
+        }
+
+        tree.sections_.push_back(std::move(section));
+        position = sectionEnd;
+    }
+
+    tree.sections_.insert(tree.sections_.end(), sections_.begin() + reused, sections_.end());
+    tree.offsets_.assign(offsets_.begin(), offsets_.begin() + first);
+    tree.rows_.assign(rows_.begin(), rows_.begin() + first);
+    tree.rebuildIndex(first);
+    return tree;
+}
+
+size_t SyntaxTree::findSection(size_t offset) const {
+    auto it = std::upper_bound(offsets_.begin(), offsets_.end(), offset);
+    return it == offsets_.begin() ? 0 : static_cast<size_t>(it - offsets_.begin() - 1);
+}
+
+size_t SyntaxTree::findSectionByRow(size_t row) const {
+    auto it = std::upper_bound(rows_.begin(), rows_.end(), row);
+    return it == rows_.begin() ? 0 : static_cast<size_t>(it - rows_.begin() - 1);
+}
+
+std::string SyntaxTree::text() const {
+    std::string result;
+    result.reserve(length_);
+    for (const auto& section : sections_) {
+        result += section->text;
+    }
+    return result;
+}
+
+LSP::Position SyntaxTree::positionAt(size_t sectionIndex, uint32_t offset) const {
+    const Section& s = *sections_[sectionIndex];
+    offset = std::min(offset, static_cast<uint32_t>(s.text.size()));
+    if (s.lines.empty()) {
+        return LSP::Position{static_cast<int>(rows_[sectionIndex]), 0};
+    }
+    const Line& line = s.lines[s.lineAt(offset)];
+
+    // Count from the start of the physical line; bytes of a split line that
+    // lie before this section are counted as single units
+    uint32_t rowStart = line.column <= line.offset ? line.offset - line.column : 0;
+    uint32_t units = line.column - (line.offset - rowStart);
+    for (uint32_t i = rowStart; i < offset; ++i) {
+        unsigned char c = static_cast<unsigned char>(s.text[i]);
+        if (!isContinuationByte(c)) {
+            units += utf16Units(c);
+        }
+    }
+    return LSP::Position{static_cast<int>(rows_[sectionIndex] + line.row), static_cast<int>(units)};
+}
+
+uint32_t SyntaxTree::offsetAt(size_t sectionIndex, const LSP::Position& position) const {
+    const Section& s = *sections_[sectionIndex];
+    size_t firstRow = rows_[sectionIndex];
+    if (position.line < 0 || static_cast<size_t>(position.line) < firstRow) {
+        return 0;
+    }
+    uint32_t row = static_cast<uint32_t>(position.line - firstRow);
+    auto it = std::lower_bound(s.lines.begin(), s.lines.end(), row,
+                               [](const Line& line, uint32_t value) { return line.row < value; });
+    if (it == s.lines.end() || it->row != row) {
+        return static_cast<uint32_t>(s.text.size());
+    }
+
+    uint32_t offset = it->offset;
+    uint32_t units = position.character > 0 ? static_cast<uint32_t>(position.character) : 0;
+    while (offset < s.text.size()) {
+        unsigned char c = static_cast<unsigned char>(s.text[offset]);
+        if (!isContinuationByte(c)) {
+            if (c == '\n' || units < utf16Units(c)) {
+                break;
+            }
+            units -= utf16Units(c);
+        }
+        ++offset;
+    }
+    return offset;
+}
+
+LSP::Range SyntaxTree::tokenRange(size_t sectionIndex, const Token& token) const {
+    return LSP::Range{positionAt(sectionIndex, token.offset), positionAt(sectionIndex, token.offset + token.length)};
+}
+
+void SyntaxTree::rebuildIndex(size_t from) {
+    offsets_.resize(sections_.size());
+    rows_.resize(sections_.size());
+    size_t offset = from > 0 ? offsets_[from - 1] + sections_[from - 1]->text.size() : 0;
+    size_t row = from > 0 ? rows_[from - 1] + sections_[from - 1]->rows : 0;
+    for (size_t i = from; i < sections_.size(); ++i) {
+        offsets_[i] = offset;
+        rows_[i] = row;
+        offset += sections_[i]->text.size();
+        row += sections_[i]->rows;
+    }
+    length_ = offset;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
@@ -0,0 +1,87 @@
+#include "ini/value_units.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace ZeroSyntax {
+namespace Ini {
+
+namespace {
+
+constexpr float kPi = 3.14159265359f;  // PI in BaseType.h
+constexpr float kRadsPerDegree = kPi / 180.0f;
+constexpr float kFramesPerMsec = float(kLogicFramesPerSecond) / 1000.0f;  // LOGICFRAMES_PER_MSEC_REAL
+constexpr float kSecondsPerFrame = 1.0f / float(kLogicFramesPerSecond);   // SECONDS_PER_LOGICFRAME_REAL
+
+// The leading number of a token as sscanf("%f") reads it
+std::optional<float> scanReal(std::string_view token) {
+    std::string text(token);
+    char* end = nullptr;
+    float value = std::strtof(text.c_str(), &end);
+    if (end == text.c_str()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// sscanf("%u"), which also takes a sign and wraps negative values
+std::optional<uint32_t> scanUnsignedInt(std::string_view token) {
+    std::string text(token);
+    char* end = nullptr;
+    long long value = std::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+} // namespace
+
+std::optional<std::string> convertedValue(std::string_view proc, std::string_view token) {
+    if (proc == "INI::parseDurationUnsignedInt" || proc == "INI::parseDurationUnsignedShort") {
+        auto msec = scanUnsignedInt(token);
+        if (!msec) {
+            return std::nullopt;
+        }
+        // Rounded up, so partial frames count as whole ones
+        auto frames = static_cast<uint32_t>(std::ceil(static_cast<float>(*msec) * kFramesPerMsec));
+        if (proc == "INI::parseDurationUnsignedShort") {
+            frames = static_cast<uint16_t>(frames);
+        }
+        return number(*msec) + " ms = " + number(frames) + (frames == 1 ? " frame" : " frames");
+    }
+
+    auto value = proc == "INI::parsePercentToReal" ? scanReal(token.substr(0, token.find('%'))) : scanReal(token);
+    if (!value) {
+        return std::nullopt;
+    }
+    if (proc == "INI::parseDurationReal") {
+        return number(*value) + " ms = " + number(*value * kFramesPerMsec) + " frames";
+    }
+    if (proc == "INI::parseAngleReal") {
+        return number(*value) + "° = " + number(*value * kRadsPerDegree) + " rad";
+    }
+    if (proc == "INI::parseAngularVelocityReal") {
+        return number(*value) + "°/s = " + number(*value * (kSecondsPerFrame * kRadsPerDegree)) + " rad/frame";
+    }
+    if (proc == "INI::parseVelocityReal") {
+        return number(*value) + "/s = " + number(*value * kSecondsPerFrame) + "/frame";
+    }
+    if (proc == "INI::parseAccelerationReal") {
+        return number(*value) + "/s² = " + number(*value * (kSecondsPerFrame * kSecondsPerFrame)) + "/frame²";
+    }
+    if (proc == "INI::parsePercentToReal") {
+        return number(*value) + "% = " + number(*value / 100.0f);
+    }
+    return std::nullopt;
+}
+
+} // namespace Ini
+} // namespace ZeroSyntax
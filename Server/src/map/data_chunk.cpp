@@ -0,0 +1,226 @@
+#include "map/data_chunk.hpp"
+#include "vfs/decompressor.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ZeroSyntax {
+namespace Map {
+
+namespace {
+
+constexpr uint32_t kMaxChunkId = 0xFFFF;  // ids count up from 1; anything past this is corrupt
+
+struct KindLabel {
+    std::string_view label;
+    ChunkKind kind;
+};
+
+// Sorted by label
+constexpr KindLabel kKindLabels[] = {
+    {"BlendTileData", ChunkKind::BlendTileData},
+    {"Condition", ChunkKind::Condition},
+    {"GlobalLighting", ChunkKind::GlobalLighting},
+    {"HeightMapData", ChunkKind::HeightMapData},
+    {"MapPreview", ChunkKind::MapPreview},
+    {"Object", ChunkKind::Object},
+    {"ObjectsList", ChunkKind::ObjectsList},
+    {"OrCondition", ChunkKind::OrCondition},
+    {"PlayerScriptsList", ChunkKind::PlayerScriptsList},
+    {"PolygonTriggers", ChunkKind::PolygonTriggers},
+    {"Script", ChunkKind::Script},
+    {"ScriptAction", ChunkKind::ScriptAction},
+    {"ScriptActionFalse", ChunkKind::ScriptActionFalse},
+    {"ScriptGroup", ChunkKind::ScriptGroup},
+    {"ScriptList", ChunkKind::ScriptList},
+    {"SidesList", ChunkKind::SidesList},
+    {"WaypointsList", ChunkKind::WaypointsList},
+    {"WorldInfo", ChunkKind::WorldInfo},
+};
+
+// Little-endian, as the engine writes them on x86
+uint16_t loadUint16(const char* bytes) {
+    const auto* b = reinterpret_cast<const unsigned char*>(bytes);
+    return static_cast<uint16_t>(b[0] | (b[1] << 8));
+}
+
+uint32_t loadUint32(const char* bytes) {
+    const auto* b = reinterpret_cast<const unsigned char*>(bytes);
+    return uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+}
+
+float loadReal(const char* bytes) {
+    uint32_t bits = loadUint32(bytes);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool readExactly(Vfs::Decompressor& input, void* out, size_t size) {
+    return input.read(static_cast<char*>(out), size) == size;
+}
+
+} // namespace
+
+ChunkKind chunkKindOf(std::string_view label) {
+    auto found = std::lower_bound(std::begin(kKindLabels), std::end(kKindLabels), label,
+                                  [](const KindLabel& entry, std::string_view l) { return entry.label < l; });
+    return found != std::end(kKindLabels) && found->label == label ? found->kind : ChunkKind::Unknown;
+}
+
+bool ChunkTable::read(Vfs::Decompressor& input) {
+    names_.clear();
+    kinds_.clear();
+    char header[8];
+    if (!readExactly(input, header, sizeof(header)) || std::memcmp(header, "CkMp", 4) != 0) {
+        return false;
+    }
+    int32_t count = static_cast<int32_t>(loadUint32(header + 4));
+    if (count <= 0) {
+        return false;  // m_headerOpened is false for an empty table too
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        unsigned char length;
+        char name[255];
+        char id[4];
+        if (!readExactly(input, &length, 1) || !readExactly(input, name, length) || !readExactly(input, id, 4)) {
+            names_.clear();
+            kinds_.clear();
+            return false;
+        }
+        uint32_t value = loadUint32(id);
+        if (value > kMaxChunkId) {
+            continue;
+        }
+        if (value >= names_.size()) {
+            names_.resize(value + 1);
+            kinds_.resize(value + 1, ChunkKind::Unknown);
+        }
+        names_[value].assign(name, length);
+        kinds_[value] = chunkKindOf(names_[value]);
+    }
+    return true;
+}
+
+ChunkHeader parseChunkHeader(const char* bytes) {
+    return {loadUint32(bytes), loadUint16(bytes + 4), static_cast<int32_t>(loadUint32(bytes + 6))};
+}
+
+const DictEntry* findEntry(const Dict& dict, std::string_view key) {
+    for (const DictEntry& entry : dict) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool ChunkReader::take(size_t size, const char*& bytes) {
+    if (failed_ || data_.size() - offset_ < size) {
+        failed_ = true;
+        offset_ = data_.size();
+        return false;
+    }
+    bytes = data_.data() + offset_;
+    offset_ += size;
+    return true;
+}
+
+int32_t ChunkReader::readInt() {
+    const char* bytes;
+    return take(4, bytes) ? static_cast<int32_t>(loadUint32(bytes)) : 0;
+}
+
+float ChunkReader::readReal() {
+    const char* bytes;
+    return take(4, bytes) ? loadReal(bytes) : 0.0f;
+}
+
+uint8_t ChunkReader::readByte() {
+    const char* bytes;
+    return take(1, bytes) ? static_cast<uint8_t>(*bytes) : 0;
+}
+
+std::string_view ChunkReader::readBytes(size_t size) {
+    const char* bytes;
+    return take(size, bytes) ? std::string_view(bytes, size) : std::string_view();
+}
+
+std::string_view ChunkReader::readAsciiString() {
+    const char* bytes;
+    if (!take(2, bytes)) {
+        return {};
+    }
+    return readBytes(loadUint16(bytes));
+}
+
+std::string_view ChunkReader::readUnicodeString() {
+    const char* bytes;
+    if (!take(2, bytes)) {
+        return {};
+    }
+    return readBytes(size_t(loadUint16(bytes)) * 2);
+}
+
+Dict ChunkReader::readDict() {
+    Dict dict;
+    const char* bytes;
+    if (!take(2, bytes)) {
+        return dict;
+    }
+    uint16_t count = loadUint16(bytes);
+    dict.reserve(count);
+    for (uint16_t i = 0; i < count && !failed_; ++i) {
+        // The key's table id above the type
+        int32_t keyAndType = readInt();
+        DictEntry entry;
+        entry.key = table_->name(static_cast<uint32_t>(keyAndType) >> 8);
+        switch (keyAndType & 0xFF) {
+        case 0:
+            entry.type = DictType::Bool;
+            entry.intValue = readByte() ? 1 : 0;
+            break;
+        case 1:
+            entry.type = DictType::Int;
+            entry.intValue = readInt();
+            break;
+        case 2:
+            entry.type = DictType::Real;
+            entry.realValue = readReal();
+            break;
+        case 3:
+            entry.type = DictType::AsciiString;
+            entry.text = readAsciiString();
+            break;
+        case 4:
+            entry.type = DictType::UnicodeString;
+            entry.text = readUnicodeString();
+            break;
+        default:
+            failed_ = true;  // ERROR_CORRUPT_FILE_FORMAT
+            return dict;
+        }
+        dict.push_back(entry);
+    }
+    return dict;
+}
+
+bool ChunkReader::nextChunk(Chunk& chunk) {
+    // Fewer bytes than a header left over end the parse, as in DataChunkInput::parse
+    if (failed_ || data_.size() - offset_ < kChunkHeaderSize) {
+        return false;
+    }
+    ChunkHeader header = parseChunkHeader(data_.data() + offset_);
+    if (header.size < 0 || data_.size() - offset_ - kChunkHeaderSize < static_cast<size_t>(header.size)) {
+        failed_ = true;
+        return false;
+    }
+    chunk.id = header.id;
+    chunk.kind = table_->kind(header.id);
+    chunk.version = header.version;
+    chunk.data = data_.substr(offset_ + kChunkHeaderSize, static_cast<size_t>(header.size));
+    offset_ += kChunkHeaderSize + static_cast<size_t>(header.size);
+    return true;
+}
+
+} // namespace Map
+} // namespace ZeroSyntax
@@ -0,0 +1,369 @@
+#include "map/map_file.hpp"
+#include "utils/logger.hpp"
+
+namespace ZeroSyntax {
+namespace Map {
+
+namespace {
+
+// Sections of a compressed map kept as the skim streams past them; the rest
+// are decompressed again when asked for
+constexpr std::array<bool, kChunkKindCount> kKeptOnSkim = [] {
+    std::array<bool, kChunkKindCount> kept{};
+    for (ChunkKind kind : {ChunkKind::WorldInfo, ChunkKind::SidesList, ChunkKind::ObjectsList, ChunkKind::PolygonTriggers,
+                           ChunkKind::GlobalLighting, ChunkKind::WaypointsList, ChunkKind::PlayerScriptsList}) {
+        kept[static_cast<size_t>(kind)] = true;
+    }
+    return kept;
+}();
+
+constexpr size_t index(ChunkKind kind) {
+    return static_cast<size_t>(kind);
+}
+
+} // namespace
+
+bool MapFile::open(const std::string& path) {
+    clear();
+    if (!file_.open(path)) {
+        LOG_WARN("Could not open map {}", path);
+        return false;
+    }
+    path_ = path;
+    if (!skim(file_.contents())) {
+        LOG_WARN("{} is not a map, or is cut short", path);
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool MapFile::load(std::string_view data) {
+    clear();
+    if (!skim(data)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool MapFile::skim(std::string_view data) {
+    source_ = data;
+    Vfs::Decompressor input(data);
+    compression_ = input.compression();
+    if (input.failed() || !table_.read(input)) {
+        return false;
+    }
+    bool compressed = compression_ != Vfs::Compression::None;
+
+    // As DataChunkInput::parse, a tail shorter than a header is ignored
+    char bytes[kChunkHeaderSize];
+    while (input.size() - input.position() >= kChunkHeaderSize) {
+        if (input.read(bytes, kChunkHeaderSize) != kChunkHeaderSize) {
+            return false;
+        }
+        ChunkHeader header = parseChunkHeader(bytes);
+        if (header.size < 0 || input.size() - input.position() < static_cast<size_t>(header.size)) {
+            return false;
+        }
+        size_t size = static_cast<size_t>(header.size);
+        ChunkKind kind = table_.kind(header.id);
+        Section& section = sections_[index(kind)];
+        bool first = kind != ChunkKind::Unknown && !section.present;
+        if (first) {
+            section = {true, header.id, header.version, input.position(), size};
+        }
+        if (first && compressed && kKeptOnSkim[index(kind)]) {
+            std::string& payload = payloads_[index(kind)];
+            payload.resize(size);
+            if (input.read(payload.data(), size) != size) {
+                return false;
+            }
+            decompressed_[index(kind)] = true;
+        } else if (!input.skip(size)) {
+            return false;
+        }
+    }
+    return !input.failed();
+}
+
+void MapFile::clear() {
+    path_.clear();
+    file_.close();
+    source_ = {};
+    compression_ = Vfs::Compression::None;
+    table_ = ChunkTable();
+    sections_ = {};
+    for (std::string& payload : payloads_) {
+        payload = std::string();
+    }
+    decompressed_ = {};
+    heightMap_.reset();
+    heightMapRead_ = false;
+    worldInfo_.reset();
+    objects_.reset();
+    waypoints_.reset();
+    waypointLinks_.reset();
+    sides_.reset();
+    teams_.clear();
+    playerScripts_.reset();
+}
+
+std::optional<Chunk> MapFile::section(ChunkKind kind) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sectionLocked(kind);
+}
+
+std::optional<Chunk> MapFile::sectionLocked(ChunkKind kind) const {
+    const Section& section = sections_[index(kind)];
+    if (!section.present) {
+        return std::nullopt;
+    }
+    Chunk chunk{section.id, kind, section.version, {}};
+    if (compression_ == Vfs::Compression::None) {
+        chunk.data = source_.substr(section.offset, section.size);
+        return chunk;
+    }
+    std::string& payload = payloads_[index(kind)];
+    if (!decompressed_[index(kind)]) {
+        Vfs::Decompressor input(source_);
+        payload.resize(section.size);
+        if (!input.skip(section.offset) || input.read(payload.data(), section.size) != section.size) {
+            LOG_WARN("Could not decompress {} of {}", table_.name(section.id), path_);
+            payload = std::string();
+            return std::nullopt;
+        }
+        decompressed_[index(kind)] = true;
+    }
+    chunk.data = payload;
+    return chunk;
+}
+
+const HeightMap* MapFile::heightMap() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heightMapRead_) {
+        return heightMap_ ? &*heightMap_ : nullptr;
+    }
+    heightMapRead_ = true;
+    std::optional<Chunk> chunk = sectionLocked(ChunkKind::HeightMapData);
+    if (!chunk) {
+        return nullptr;
+    }
+
+    // WorldHeightMap::ParseHeightMapData
+    ChunkReader reader(chunk->data, table_);
+    HeightMap map;
+    map.width = reader.readInt();
+    map.height = reader.readInt();
+    if (chunk->version >= 3) {
+        map.border = reader.readInt();
+    }
+    if (chunk->version >= 4) {
+        int32_t count = reader.readInt();
+        if (count < 0 || static_cast<size_t>(count) > chunk->data.size() / 8) {
+            LOG_WARN("Corrupt HeightMapData in {}", path_);
+            return nullptr;
+        }
+        map.boundaries.reserve(static_cast<size_t>(count));
+        for (int32_t i = 0; i < count; ++i) {
+            int32_t x = reader.readInt();
+            map.boundaries.emplace_back(x, reader.readInt());
+        }
+    }
+    int32_t size = reader.readInt();
+    if (map.width < 0 || map.height < 0 || int64_t(map.width) * map.height != size) {
+        LOG_WARN("Corrupt HeightMapData in {}", path_);
+        return nullptr;
+    }
+    map.heights = reader.readBytes(static_cast<size_t>(size));
+    if (reader.failed()) {
+        LOG_WARN("Corrupt HeightMapData in {}", path_);
+        return nullptr;
+    }
+    heightMap_ = std::move(map);
+    return &*heightMap_;
+}
+
+const Dict& MapFile::worldInfo() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!worldInfo_) {
+        worldInfo_.emplace();
+        if (std::optional<Chunk> chunk = sectionLocked(ChunkKind::WorldInfo)) {
+            ChunkReader reader(chunk->data, table_);
+            *worldInfo_ = reader.readDict();
+            if (reader.failed()) {
+                LOG_WARN("Corrupt WorldInfo in {}", path_);
+            }
+        }
+    }
+    return *worldInfo_;
+}
+
+void MapFile::decodeObjects() const {
+    objects_.emplace();
+    std::optional<Chunk> list = sectionLocked(ChunkKind::ObjectsList);
+    if (!list) {
+        return;
+    }
+    // ParseObjectsDataChunk, then ParseObjectDataChunk for each Object
+    ChunkReader reader(list->data, table_);
+    Chunk chunk;
+    while (reader.nextChunk(chunk)) {
+        if (chunk.kind != ChunkKind::Object) {
+            continue;
+        }
+        ChunkReader fields(chunk.data, table_);
+        MapObject object;
+        object.x = fields.readReal();
+        object.y = fields.readReal();
+        object.z = fields.readReal();
+        object.angle = fields.readReal();
+        object.flags = fields.readInt();
+        object.name = fields.readAsciiString();
+        if (chunk.version >= 2) {
+            object.properties = fields.readDict();
+        }
+        if (chunk.version <= 2) {
+            object.z = 0;  // the height was not saved before version 3
+        }
+        if (fields.failed()) {
+            LOG_WARN("Corrupt Object in {}", path_);
+            continue;
+        }
+        objects_->push_back(std::move(object));
+    }
+    if (reader.failed()) {
+        LOG_WARN("Corrupt ObjectsList in {}", path_);
+    }
+}
+
+const std::vector<MapObject>& MapFile::objects() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!objects_) {
+        decodeObjects();
+    }
+    return *objects_;
+}
+
+const std::vector<Waypoint>& MapFile::waypoints() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!waypoints_) {
+        if (!objects_) {
+            decodeObjects();
+        }
+        waypoints_.emplace();
+        for (const MapObject& object : *objects_) {
+            const DictEntry* id = findEntry(object.properties, "waypointID");
+            if (!id || id->type != DictType::Int) {
+                continue;
+            }
+            const DictEntry* name = findEntry(object.properties, "waypointName");
+            waypoints_->push_back({id->intValue, name ? name->text : std::string_view(), object.x, object.y});
+        }
+    }
+    return *waypoints_;
+}
+
+const std::vector<WaypointLink>& MapFile::waypointLinks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!waypointLinks_) {
+        waypointLinks_.emplace();
+        if (std::optional<Chunk> chunk = sectionLocked(ChunkKind::WaypointsList)) {
+            // ParseWaypointDataChunk
+            ChunkReader reader(chunk->data, table_);
+            int32_t count = reader.readInt();
+            if (count < 0 || static_cast<size_t>(count) > chunk->data.size() / 8) {
+                LOG_WARN("Corrupt WaypointsList in {}", path_);
+                return *waypointLinks_;
+            }
+            waypointLinks_->reserve(static_cast<size_t>(count));
+            for (int32_t i = 0; i < count; ++i) {
+                int32_t from = reader.readInt();
+                waypointLinks_->push_back({from, reader.readInt()});
+            }
+            if (reader.failed()) {
+                LOG_WARN("Corrupt WaypointsList in {}", path_);
+                waypointLinks_->clear();
+            }
+        }
+    }
+    return *waypointLinks_;
+}
+
+void MapFile::decodeSides() const {
+    sides_.emplace();
+    std::optional<Chunk> chunk = sectionLocked(ChunkKind::SidesList);
+    if (chunk) {
+        // SidesList::ParseSidesDataChunk
+        ChunkReader reader(chunk->data, table_);
+        int32_t count = reader.readInt();
+        for (int32_t i = 0; i < count && !reader.failed(); ++i) {
+            Side side;
+            side.properties = reader.readDict();
+            int32_t buildings = reader.readInt();
+            for (int32_t j = 0; j < buildings && !reader.failed(); ++j) {
+                BuildListEntry entry;
+                entry.name = reader.readAsciiString();
+                entry.templateName = reader.readAsciiString();
+                entry.x = reader.readReal();
+                entry.y = reader.readReal();
+                entry.z = reader.readReal();
+                entry.angle = reader.readReal();
+                reader.readByte();  // initially built
+                reader.readInt();   // rebuilds
+                if (chunk->version >= 3) {
+                    entry.script = reader.readAsciiString();
+                    reader.readInt();  // health
+                    reader.readBytes(3);  // whiner, unsellable, repairable
+                }
+                side.buildList.push_back(entry);
+            }
+            sides_->push_back(std::move(side));
+        }
+        if (chunk->version >= 2) {
+            int32_t count = reader.readInt();
+            for (int32_t i = 0; i < count && !reader.failed(); ++i) {
+                teams_.push_back(reader.readDict());
+            }
+        }
+        Chunk nested;
+        while (reader.nextChunk(nested)) {
+            if (nested.kind == ChunkKind::PlayerScriptsList && !playerScripts_) {
+                playerScripts_ = nested;
+            }
+        }
+        if (reader.failed()) {
+            LOG_WARN("Corrupt SidesList in {}", path_);
+        }
+    }
+    if (!playerScripts_) {
+        playerScripts_ = sectionLocked(ChunkKind::PlayerScriptsList);
+    }
+}
+
+const std::vector<Side>& MapFile::sides() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!sides_) {
+        decodeSides();
+    }
+    return *sides_;
+}
+
+const std::vector<Dict>& MapFile::teams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!sides_) {
+        decodeSides();
+    }
+    return teams_;
+}
+
+std::optional<Chunk> MapFile::playerScripts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!sides_) {
+        decodeSides();
+    }
+    return playerScripts_;
+}
+
+} // namespace Map
+} // namespace ZeroSyntax
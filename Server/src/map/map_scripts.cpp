@@ -0,0 +1,187 @@
+#include "map/map_scripts.hpp"
+
+namespace ZeroSyntax {
+namespace Map {
+
+namespace {
+
+// Script::MAX_PARMS
+constexpr int32_t kMaxParameters = 12;
+
+constexpr std::string_view kOldSidePrefix = "Fundamentalist";
+
+} // namespace
+
+bool MapScripts::decode(const Chunk& playerScripts, const ChunkTable& table) {
+    playerCount_ = 0;
+    scripts_.clear();
+    groups_.clear();
+    clauses_.clear();
+    parameters_.clear();
+    renamed_.clear();
+
+    // ScriptList::ParseScriptsDataChunk: a ScriptList per player, in SidesList order
+    ChunkReader reader(playerScripts.data, table);
+    Chunk chunk;
+    bool intact = true;
+    while (intact && reader.nextChunk(chunk)) {
+        if (chunk.kind == ChunkKind::ScriptList) {
+            intact = decodeList(chunk.data, table);
+            ++playerCount_;
+        }
+    }
+    return intact && reader.atEnd();
+}
+
+bool MapScripts::decodeList(std::string_view data, const ChunkTable& table) {
+    // ScriptList::ParseScriptListDataChunk
+    uint32_t player = playerCount_;
+    ChunkReader reader(data, table);
+    Chunk chunk;
+    while (reader.nextChunk(chunk)) {
+        if (chunk.kind == ChunkKind::Script) {
+            if (!decodeScript(chunk, table, kNoGroup)) {
+                return false;
+            }
+        } else if (chunk.kind == ChunkKind::ScriptGroup) {
+            // ScriptGroup::ParseGroupDataChunk
+            ChunkReader fields(chunk.data, table);
+            ScriptGroup group;
+            group.name = fields.readAsciiString();
+            group.player = player;
+            group.active = fields.readByte() != 0;
+            if (chunk.version == 2) {
+                group.subroutine = fields.readByte() != 0;
+            }
+            if (fields.failed()) {
+                return false;
+            }
+            uint32_t index = static_cast<uint32_t>(groups_.size());
+            groups_.push_back(group);
+            Chunk nested;
+            while (fields.nextChunk(nested)) {
+                if (nested.kind == ChunkKind::Script && !decodeScript(nested, table, index)) {
+                    return false;
+                }
+            }
+            if (!fields.atEnd()) {
+                return false;
+            }
+        }
+    }
+    return reader.atEnd();
+}
+
+bool MapScripts::decodeScript(const Chunk& chunk, const ChunkTable& table, uint32_t group) {
+    // Script::ParseScriptFromDataChunk
+    ChunkReader reader(chunk.data, table);
+    Script script;
+    script.player = playerCount_;
+    script.group = group;
+    script.name = reader.readAsciiString();
+    script.comment = reader.readAsciiString();
+    reader.readAsciiString();  // condition comment
+    reader.readAsciiString();  // action comment
+    script.active = reader.readByte() != 0;
+    script.oneShot = reader.readByte() != 0;
+    script.easy = reader.readByte() != 0;
+    script.normal = reader.readByte() != 0;
+    script.hard = reader.readByte() != 0;
+    script.subroutine = reader.readByte() != 0;
+    if (chunk.version >= 2) {
+        script.delaySeconds = reader.readInt();
+    }
+    if (reader.failed()) {
+        return false;
+    }
+    script.firstClause = static_cast<uint32_t>(clauses_.size());
+
+    uint32_t orGroup = 0;
+    Chunk nested;
+    while (reader.nextChunk(nested)) {
+        bool intact = true;
+        if (nested.kind == ChunkKind::OrCondition) {
+            // OrCondition::ParseOrConditionDataChunk: a list of Conditions
+            ChunkReader conditions(nested.data, table);
+            Chunk condition;
+            while (intact && conditions.nextChunk(condition)) {
+                if (condition.kind == ChunkKind::Condition) {
+                    intact = decodeClause(condition, table, ClauseKind::Condition, orGroup);
+                }
+            }
+            intact = intact && conditions.atEnd();
+            ++orGroup;
+        } else if (nested.kind == ChunkKind::ScriptAction) {
+            intact = decodeClause(nested, table, ClauseKind::Action, 0);
+        } else if (nested.kind == ChunkKind::ScriptActionFalse) {
+            intact = decodeClause(nested, table, ClauseKind::ActionFalse, 0);
+        }
+        if (!intact) {
+            return false;
+        }
+    }
+    script.clauseCount = static_cast<uint32_t>(clauses_.size()) - script.firstClause;
+    scripts_.push_back(script);
+    return reader.atEnd();
+}
+
+bool MapScripts::decodeClause(const Chunk& chunk, const ChunkTable& table, ClauseKind kind, uint32_t orGroup) {
+    // Condition::ParseConditionDataChunk and ScriptAction::ParseActionDataChunk;
+    // the name key appeared in version 4 of a Condition and 2 of an action
+    ChunkReader reader(chunk.data, table);
+    ScriptClause clause;
+    clause.kind = kind;
+    clause.orGroup = orGroup;
+    clause.type = reader.readInt();
+    if (chunk.version >= (kind == ClauseKind::Condition ? 4 : 2)) {
+        clause.name = table.name(static_cast<uint32_t>(reader.readInt()) >> 8);
+    }
+    int32_t count = reader.readInt();
+    if (reader.failed() || count < 0 || count > kMaxParameters) {
+        return false;
+    }
+    clause.firstParameter = static_cast<uint32_t>(parameters_.size());
+    clause.parameterCount = static_cast<uint32_t>(count);
+
+    // Parameter::ReadParameter
+    for (int32_t i = 0; i < count; ++i) {
+        ScriptParameter parameter;
+        int32_t type = reader.readInt();
+        if (type < 0 || type >= static_cast<int32_t>(ParameterType::Count)) {
+            parameters_.resize(clause.firstParameter);
+            return false;
+        }
+        parameter.type = static_cast<ParameterType>(type);
+        if (parameter.type == ParameterType::Coord3D) {
+            parameter.realValue = reader.readReal();
+            parameter.y = reader.readReal();
+            parameter.z = reader.readReal();
+        } else {
+            parameter.intValue = reader.readInt();
+            parameter.realValue = reader.readReal();
+            parameter.text = reader.readAsciiString();
+        }
+        // The engine renamed the GLA and merged the capture upgrades after
+        // maps were made, and fixes their names as it reads them
+        if (parameter.type == ParameterType::ObjectType &&
+            parameter.text.substr(0, kOldSidePrefix.size()) == kOldSidePrefix) {
+            renamed_.push_back("GLA" + std::string(parameter.text.substr(kOldSidePrefix.size())));
+            parameter.text = renamed_.back();
+        } else if (parameter.type == ParameterType::Upgrade &&
+                   (parameter.text == "Upgrade_AmericaRangerCaptureBuilding" ||
+                    parameter.text == "Upgrade_ChinaRedguardCaptureBuilding" ||
+                    parameter.text == "Upgrade_GLARebelCaptureBuilding")) {
+            parameter.text = "Upgrade_InfantryCaptureBuilding";
+        }
+        parameters_.push_back(parameter);
+    }
+    if (reader.failed()) {
+        parameters_.resize(clause.firstParameter);
+        return false;
+    }
+    clauses_.push_back(clause);
+    return true;
+}
+
+} // namespace Map
+} // namespace ZeroSyntax
@@ -0,0 +1,108 @@
+#include "protocol/diagnostics_queue.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace ZeroSyntax {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+void mix(uint64_t& hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= kFnvPrime;
+    }
+}
+
+void mix(uint64_t& hash, const std::string& text) {
+    // The length keeps "ab" + "c" apart from "a" + "bc"
+    mix(hash, text.size());
+    for (char c : text) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= kFnvPrime;
+    }
+}
+
+} // namespace
+
+DiagnosticsQueue::DiagnosticsQueue(Clock::duration delay) : delay_(delay) {}
+
+void DiagnosticsQueue::schedule(const std::string& uri, Clock::time_point now) {
+    pending_[uri] = now + delay_;
+}
+
+void DiagnosticsQueue::scheduleNow(const std::string& uri, Clock::time_point now) {
+    pending_[uri] = now;
+}
+
+void DiagnosticsQueue::cancel(const std::string& uri) {
+    pending_.erase(uri);
+}
+
+std::vector<std::string> DiagnosticsQueue::takeDue(Clock::time_point now) {
+    std::vector<std::pair<Clock::time_point, std::string>> due;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second <= now) {
+            due.emplace_back(it->second, it->first);
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::sort(due.begin(), due.end());
+
+    std::vector<std::string> uris;
+    uris.reserve(due.size());
+    for (auto& entry : due) {
+        uris.push_back(std::move(entry.second));
+    }
+    return uris;
+}
+
+std::optional<DiagnosticsQueue::Clock::duration> DiagnosticsQueue::timeUntilDue(Clock::time_point now) const {
+    if (pending_.empty()) {
+        return std::nullopt;
+    }
+    auto first = std::min_element(pending_.begin(), pending_.end(),
+                                  [](const auto& a, const auto& b) { return a.second < b.second; });
+    return std::max(first->second - now, Clock::duration::zero());
+}
+
+bool DiagnosticsQueue::update(const std::string& uri, const std::vector<LSP::Diagnostic>& diagnostics) {
+    uint64_t value = hash(diagnostics);
+    auto it = published_.find(uri);
+    uint64_t previous = it != published_.end() ? it->second : hash({});
+    if (value == previous) {
+        return false;
+    }
+    // An empty set is what the client assumes for a document it heard nothing about
+    if (diagnostics.empty()) {
+        published_.erase(it);
+    } else {
+        published_[uri] = value;
+    }
+    return true;
+}
+
+uint64_t DiagnosticsQueue::hash(const std::vector<LSP::Diagnostic>& diagnostics) {
+    uint64_t hash = kFnvOffset;
+    mix(hash, diagnostics.size());
+    for (const auto& diagnostic : diagnostics) {
+        mix(hash, static_cast<uint64_t>(static_cast<uint32_t>(diagnostic.range.start.line)) << 32 |
+                      static_cast<uint32_t>(diagnostic.range.start.character));
+        mix(hash, static_cast<uint64_t>(static_cast<uint32_t>(diagnostic.range.end.line)) << 32 |
+                      static_cast<uint32_t>(diagnostic.range.end.character));
+        mix(hash, static_cast<uint64_t>(diagnostic.severity));
+        mix(hash, diagnostic.message);
+        if (diagnostic.source) {
+            mix(hash, *diagnostic.source);
+        } else {
+            mix(hash, UINT64_MAX);
+        }
+    }
+    return hash;
+}
+
+} // namespace ZeroSyntax
@@ -4,16 +4,25 @@
 
 namespace ZeroSyntax {
     
-JsonRpcHandler::JsonRpcHandler() {}
+JsonRpcHandler::JsonRpcHandler() : scheduler_(nullptr) {}
 
 void JsonRpcHandler::registerMethod(const std::string& method, MessageCallback callback) {
     methodHandlers_[method] = std::move(callback);
     LOG_DEBUG("Registered method handler: {}", method);
 }
 
-std::optional<std::string> JsonRpcHandler::handleRequest(const std::string& message) {
+void JsonRpcHandler::registerConcurrentMethod(const std::string& method, MessageCallback callback) {
+    registerMethod(method, std::move(callback));
+    concurrentMethods_.insert(method);
+}
+
+void JsonRpcHandler::setScheduler(RequestScheduler* scheduler) {
+    scheduler_ = scheduler;
+}
+
+std::optional<std::string> JsonRpcHandler::handleRequest(std::string_view message) {
     try {
-        nlohmann::json jsonRequest = nlohmann::json::parse(message);
+        nlohmann::json jsonRequest = nlohmann::json::parse(message.begin(), message.end());
         
         // Check if this is a valid JSON-RPC request
         if (!jsonRequest.contains("jsonrpc") || jsonRequest["jsonrpc"] != "2.0") {
@@ -39,8 +48,38 @@ std::optional<std::string> JsonRpcHandler::handleRequest(const std::string& mess
         
         LOG_DEBUG("Received {} for method: {}", hasId ? "request" : "notification", method);
         
+        // Cancellation is handled by the scheduler, the client expects no reply
+        if (method == "$/cancelRequest") {
+            if (scheduler_ && params.contains("id")) {
+                scheduler_->cancel(params["id"].dump());
+            }
+            return std::nullopt;
+        }
+        
         // Find and execute the handler for the method
         auto it = methodHandlers_.find(method);
+        if (it != methodHandlers_.end() && hasId && scheduler_ && concurrentMethods_.count(method)) {
+            std::string uri;
+            if (params.contains("textDocument") && params["textDocument"].contains("uri")) {
+                uri = params["textDocument"]["uri"].get<std::string>();
+            }
+            
+            MessageCallback callback = it->second;
+            scheduler_->submit(id.dump(), method + " " + uri, uri,
+                [this, callback, method, params = std::move(params), id]() {
+                    try {
+                        return createResponse(callback(params), id);
+                    } catch (const std::exception& e) {
+                        LOG_ERROR("Error handling method {}: {}", method, e.what());
+                        return createErrorResponse(-32603, "Internal error", id, e.what());
+                    }
+                },
+                [this, id](int code, const std::string& message) {
+                    return createErrorResponse(code, message, id);
+                });
+            return std::nullopt;
+        }
+        
         if (it != methodHandlers_.end()) {
             try {
                 nlohmann::json result = it->second(params);
@@ -97,6 +97,27 @@ void from_json(const nlohmann::json& j, VersionedTextDocumentIdentifier& v) {
     j.at("version").get_to(v.version);
 }
 
+// TextDocumentContentChangeEvent conversion
+void to_json(nlohmann::json& j, const TextDocumentContentChangeEvent& c) {
+    j = nlohmann::json{
+        {"text", c.text}
+    };
+    
+    if (c.range) {
+        j["range"] = *c.range;
+    }
+}
+
+void from_json(const nlohmann::json& j, TextDocumentContentChangeEvent& c) {
+    j.at("text").get_to(c.text);
+    
+    if (j.contains("range")) {
+        c.range = j.at("range").get<Range>();
+    } else {
+        c.range = std::nullopt;
+    }
+}
+
 // TextDocumentIdentifier conversion
 void to_json(nlohmann::json& j, const TextDocumentIdentifier& t) {
     j = nlohmann::json{
@@ -154,6 +175,31 @@ void from_json(const nlohmann::json& j, CompletionItem& c) {
     }
 }
 
+// SymbolInformation conversion
+void to_json(nlohmann::json& j, const SymbolInformation& s) {
+    j = nlohmann::json{
+        {"name", s.name},
+        {"kind", s.kind},
+        {"location", s.location}
+    };
+    
+    if (s.containerName) {
+        j["containerName"] = *s.containerName;
+    }
+}
+
+void from_json(const nlohmann::json& j, SymbolInformation& s) {
+    j.at("name").get_to(s.name);
+    j.at("kind").get_to(s.kind);
+    j.at("location").get_to(s.location);
+    
+    if (j.contains("containerName")) {
+        s.containerName = j.at("containerName").get<std::string>();
+    } else {
+        s.containerName = std::nullopt;
+    }
+}
+
 // CompletionList conversion
 void to_json(nlohmann::json& j, const CompletionList& c) {
     j = nlohmann::json{
@@ -167,13 +213,35 @@ void from_json(const nlohmann::json& j, CompletionList& c) {
     j.at("items").get_to(c.items);
 }
 
+// Hover conversion
+void to_json(nlohmann::json& j, const Hover& h) {
+    j = nlohmann::json{
+        {"contents", {{"kind", "markdown"}, {"value", h.contents}}}
+    };
+    
+    if (h.range) {
+        j["range"] = *h.range;
+    }
+}
+
+void from_json(const nlohmann::json& j, Hover& h) {
+    const auto& contents = j.at("contents");
+    h.contents = contents.is_string() ? contents.get<std::string>() : contents.at("value").get<std::string>();
+    
+    if (j.contains("range")) {
+        h.range = j.at("range").get<Range>();
+    } else {
+        h.range = std::nullopt;
+    }
+}
+
 // ServerCapabilities conversion
 void to_json(nlohmann::json& j, const ServerCapabilities& s) {
     j = nlohmann::json{};
     
     if (s.textDocumentSync) {
-        // Use full sync mode (1)
-        j["textDocumentSync"] = 1;
+        // Use incremental sync mode (2)
+        j["textDocumentSync"] = 2;
     }
     
     if (s.completionProvider) {
@@ -1,20 +1,53 @@
 // LanguageServer/src/protocol/lsp_server.cpp
 #include "protocol/lsp_server.hpp"
+#include "core/index_cache.hpp"
 #include "utils/logger.hpp"
-#include <iostream>
+#include "utils/uri.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 
 namespace ZeroSyntax
 {
 
-    LspServer::LspServer()
-        : rpcHandler_(std::make_unique<JsonRpcHandler>()),
-          documentManager_(std::make_unique<DocumentManager>())
+    namespace
     {
+        // How long a document must stay unchanged before it is validated
+#ifdef _WIN32
+        // The event loop cannot wait with a timeout there, so validate with the change
+        constexpr std::chrono::milliseconds kDiagnosticsDelay{0};
+#else
+        constexpr std::chrono::milliseconds kDiagnosticsDelay{150};
+        // Longest delay a client may ask for; past it diagnostics would seem broken
+        constexpr uint64_t kMaxDiagnosticsDelay = 10000;
+#endif
+
+        // Whether a uri names a file with an extension, in any case
+        bool hasExtension(const std::string &uri, std::string_view extension)
+        {
+            return uri.size() >= extension.size() &&
+                   std::equal(extension.rbegin(), extension.rend(), uri.rbegin(),
+                              [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); });
+        }
+    }
+
+    LspServer::LspServer(size_t workerCount)
+        : transport_(std::make_unique<Transport>()),
+          rpcHandler_(std::make_unique<JsonRpcHandler>()),
+          documentManager_(std::make_unique<DocumentManager>()),
+          diagnostics_(kDiagnosticsDelay),
+          scheduler_(std::make_unique<RequestScheduler>(workerCount))
+    {
+        rpcHandler_->setScheduler(scheduler_.get());
 
         // Register LSP methods
         rpcHandler_->registerMethod("initialize", [this](const nlohmann::json &params)
                                     { return this->handleInitialize(params); });
 
+        rpcHandler_->registerMethod("initialized", [this](const nlohmann::json &params)
+                                    { return this->handleInitialized(params); });
+
         rpcHandler_->registerMethod("textDocument/didOpen", [this](const nlohmann::json &params)
                                     { return this->handleTextDocumentDidOpen(params); });
 
@@ -24,16 +57,32 @@ namespace ZeroSyntax
         rpcHandler_->registerMethod("textDocument/didClose", [this](const nlohmann::json &params)
                                     { return this->handleTextDocumentDidClose(params); });
 
-        rpcHandler_->registerMethod("textDocument/completion", [this](const nlohmann::json &params)
+        rpcHandler_->registerMethod("textDocument/didSave", [this](const nlohmann::json &params)
+                                    { return this->handleTextDocumentDidSave(params); });
+
+        rpcHandler_->registerMethod("workspace/didChangeWatchedFiles", [this](const nlohmann::json &params)
+                                    { return this->handleWorkspaceDidChangeWatchedFiles(params); });
+
+        // Read-only requests run on the scheduler's workers against document snapshots
+        rpcHandler_->registerConcurrentMethod("textDocument/completion", [this](const nlohmann::json &params)
                                     { return this->handleTextDocumentCompletion(params); });
 
-        rpcHandler_->registerMethod("textDocument/definition", [this](const nlohmann::json &params)
+        rpcHandler_->registerConcurrentMethod("textDocument/hover", [this](const nlohmann::json &params)
+                                    { return this->handleTextDocumentHover(params); });
+
+        rpcHandler_->registerConcurrentMethod("textDocument/definition", [this](const nlohmann::json &params)
                                     { return this->handleTextDocumentDefinition(params); });
 
+        rpcHandler_->registerConcurrentMethod("textDocument/references", [this](const nlohmann::json &params)
+                                    { return this->handleTextDocumentReferences(params); });
+
+        rpcHandler_->registerConcurrentMethod("workspace/symbol", [this](const nlohmann::json &params)
+                                    { return this->handleWorkspaceSymbol(params); });
+
         LOG_INFO("LSP server initialized");
     }
 
-    std::optional<std::string> LspServer::processMessage(const std::string &message)
+    std::optional<std::string> LspServer::processMessage(std::string_view message)
     {
         return rpcHandler_->handleRequest(message);
     }
@@ -42,53 +91,53 @@ namespace ZeroSyntax
     {
         LOG_INFO("Starting LSP server");
 
-        // Message processing loop
-        std::string line;
-        std::string content;
-        int contentLength = -1;
-
-        while (std::getline(std::cin, line))
+        // Message processing loop. Replies and notifications are queued while
+        // processing and written together once no complete message is left in
+        // the input buffer, so a burst of requests costs a single write. While
+        // idle the loop also wakes up when a worker finishes a request and
+        // when the next document's diagnostics are due.
+        while (true)
         {
-            // Remove carriage return if present
-            if (!line.empty() && line.back() == '\r')
+            queueCompletedResponses();
+            publishDueDiagnostics();
+
+            if (!transport_->hasBufferedMessage())
             {
-                line.pop_back();
+                transport_->flush();
+                auto wait = diagnostics_.timeUntilDue(DiagnosticsQueue::Clock::now());
+                int timeoutMs = wait ? static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(*wait).count()) : -1;
+                if (!transport_->waitForInput(scheduler_->wakeFd(), timeoutMs))
+                {
+                    continue;
+                }
             }
 
-            if (line.empty())
+            auto message = transport_->readMessage();
+            if (!message)
             {
-                // End of headers, start reading content if length is known
-                if (contentLength > 0)
-                {
-                    content.resize(contentLength);
-                    std::cin.read(&content[0], contentLength);
+                break;
+            }
 
-                    LOG_DEBUG("Received message: {}", content);
+            LOG_DEBUG("Received message: {}", *message);
 
-                    // Process the message
-                    auto response = processMessage(content);
-                    if (response)
-                    {
-                        // Send the response
-                        std::string responseMsg = *response;
-                        LOG_DEBUG("Sending response: {}", responseMsg);
-                        std::cout << "Content-Length: " << responseMsg.size() << "\r\n\r\n";
-                        std::cout << responseMsg;
-                        std::cout.flush();
-                    }
-
-                    // Reset for next message
-                    contentLength = -1;
-                    content.clear();
-                }
-            }
-            else if (line.rfind("Content-Length: ", 0) == 0)
+            auto response = processMessage(*message);
+            if (response)
             {
-                // Parse content length
-                contentLength = std::stoi(line.substr(16));
-                LOG_DEBUG("Content length: {}", contentLength);
+                LOG_DEBUG("Sending response: {}", *response);
+                transport_->queueMessage(std::move(*response));
             }
-            // Ignore other headers for now
+        }
+
+        queueCompletedResponses();
+        transport_->flush();
+    }
+
+    void LspServer::queueCompletedResponses()
+    {
+        for (auto &response : scheduler_->takeCompleted())
+        {
+            LOG_DEBUG("Sending response: {}", response);
+            transport_->queueMessage(std::move(response));
         }
     }
 
@@ -96,11 +145,60 @@ namespace ZeroSyntax
     {
         LOG_INFO("Handling initialize request");
 
+        // Index the workspace so definitions in files that are not open can be found
+        std::optional<std::string> rootPath;
+        if (params.contains("rootUri") && params["rootUri"].is_string())
+        {
+            rootPath = uriToPath(params["rootUri"].get<std::string>());
+        }
+        else if (params.contains("rootPath") && params["rootPath"].is_string())
+        {
+            rootPath = params["rootPath"].get<std::string>();
+        }
+        if (rootPath)
+        {
+            // The cache lives outside the workspace unless the client picks a file
+            std::string cachePath = IndexCache::defaultPath(*rootPath);
+            // Install directories whose archives sit below the workspace's files
+            std::vector<std::string> gameDirectories;
+            std::string language = "English";
+            if (params.contains("initializationOptions") && params["initializationOptions"].is_object())
+            {
+                const auto& options = params["initializationOptions"];
+                cachePath = options.value("indexCachePath", cachePath);
+                language = options.value("language", language);
+#ifndef _WIN32
+                if (options.contains("diagnosticsDelay") && options["diagnosticsDelay"].is_number_unsigned())
+                {
+                    uint64_t delay = std::min(options["diagnosticsDelay"].get<uint64_t>(), kMaxDiagnosticsDelay);
+                    diagnostics_.setDelay(std::chrono::milliseconds(delay));
+                }
+#endif
+                if (options.contains("gameDirectories") && options["gameDirectories"].is_array())
+                {
+                    for (const auto& directory : options["gameDirectories"])
+                    {
+                        if (directory.is_string())
+                        {
+                            gameDirectories.push_back(directory.get<std::string>());
+                        }
+                    }
+                }
+            }
+            documentManager_->indexWorkspace(*rootPath, cachePath, gameDirectories, language);
+        }
+
         // Set up server capabilities
         nlohmann::json capabilities = {
-            {"textDocumentSync", 1}, // 1 = full sync mode
+            {"textDocumentSync", {
+                {"openClose", true},
+                {"change", 2}, // 2 = incremental sync mode
+                {"save", {{"includeText", false}}}}},
             {"completionProvider", nlohmann::json::object()},
-            {"definitionProvider", true}};
+            {"hoverProvider", true},
+            {"definitionProvider", true},
+            {"referencesProvider", true},
+            {"workspaceSymbolProvider", true}};
 
         nlohmann::json result = {
             {"capabilities", capabilities}};
@@ -108,6 +206,29 @@ namespace ZeroSyntax
         return result;
     }
 
+    nlohmann::json LspServer::handleInitialized(const nlohmann::json & /*params*/)
+    {
+        try
+        {
+            // Workspace-wide checks, once the client accepts notifications
+            for (const auto &entry : documentManager_->validateLabels())
+            {
+                if (!documentManager_->hasDocument(entry.first))
+                {
+                    publishDiagnostics(entry.first, entry.second);
+                }
+            }
+            publishMapDiagnostics();
+            publishIniCrc();
+            return nlohmann::json({});
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in initialized: {}", e.what());
+            return nlohmann::json({});
+        }
+    }
+
     nlohmann::json LspServer::handleTextDocumentDidOpen(const nlohmann::json &params)
     {
         try
@@ -121,10 +242,10 @@ namespace ZeroSyntax
             LOG_INFO("Document opened: {}", uri);
 
             documentManager_->addDocument(uri, text, languageId);
+            refreshDefinitions();
 
-            // Validate and publish diagnostics
-            auto diagnostics = documentManager_->validateDocument(uri);
-            publishDiagnostics(uri, diagnostics);
+            // Validated before the next read, without waiting for more changes
+            diagnostics_.scheduleNow(uri, DiagnosticsQueue::Clock::now());
 
             return nlohmann::json({});
         }
@@ -146,15 +267,19 @@ namespace ZeroSyntax
 
             LOG_INFO("Document changed: {}", uri);
 
-            // For simplicity, we assume the first change contains the entire document
+            // Pending reads of the previous version are now stale
+            scheduler_->documentChanged(uri);
+
+            // Ranged changes are applied in order to the document's piece table;
+            // a change without a range replaces the whole text
             if (!changes.empty())
             {
-                std::string newText = changes[0]["text"];
-                documentManager_->updateDocument(uri, version, newText);
+                auto contentChanges = changes.get<std::vector<LSP::TextDocumentContentChangeEvent>>();
+                documentManager_->applyChanges(uri, version, contentChanges);
+                refreshDefinitions();
 
-                // Validate and publish diagnostics
-                auto diagnostics = documentManager_->validateDocument(uri);
-                publishDiagnostics(uri, diagnostics);
+                // Validated once the edits stop coming in, at the version current then
+                diagnostics_.schedule(uri, DiagnosticsQueue::Clock::now());
             }
 
             return nlohmann::json({});
@@ -175,10 +300,17 @@ namespace ZeroSyntax
 
             LOG_INFO("Document closed: {}", uri);
 
+            scheduler_->documentChanged(uri);
+            diagnostics_.cancel(uri);
+
             documentManager_->removeDocument(uri);
+            refreshDefinitions();
+
+            // Only what the file on disk gets wrong workspace-wide remains
+            publishDiagnostics(uri, documentManager_->validateLabels(uri));
 
-            // Clear diagnostics when document is closed
-            publishDiagnostics(uri, {});
+            // Unsaved definitions the maps relied on are gone
+            publishMapDiagnostics();
 
             return nlohmann::json({});
         }
@@ -189,6 +321,67 @@ namespace ZeroSyntax
         }
     }
 
+    nlohmann::json LspServer::handleTextDocumentDidSave(const nlohmann::json &params)
+    {
+        try
+        {
+            auto textDocument = params["textDocument"];
+            std::string uri = textDocument["uri"];
+
+            LOG_INFO("Document saved: {}", uri);
+
+            // The engine hashes the files on disk, so the CRC follows saves rather than edits
+            if (documentManager_->refreshIniChecksum(uri))
+            {
+                publishIniCrc();
+            }
+
+            // The maps are checked against the definitions as saved
+            publishMapDiagnostics();
+
+            return nlohmann::json({});
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in didSave: {}", e.what());
+            return nlohmann::json({});
+        }
+    }
+
+    nlohmann::json LspServer::handleWorkspaceDidChangeWatchedFiles(const nlohmann::json &params)
+    {
+        try
+        {
+            // A changed map is read again and checked on its own; changed INI
+            // files are indexed again, then every map is checked against them
+            bool iniChanged = false;
+            for (const auto &change : params["changes"])
+            {
+                std::string uri = change["uri"];
+                if (hasExtension(uri, ".map"))
+                {
+                    publishDiagnostics(uri, documentManager_->refreshMap(uri));
+                }
+                else if (hasExtension(uri, ".ini"))
+                {
+                    documentManager_->refreshFile(uri);
+                    iniChanged = true;
+                }
+            }
+            if (iniChanged)
+            {
+                refreshDefinitions();
+                publishMapDiagnostics();
+            }
+            return nlohmann::json({});
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in didChangeWatchedFiles: {}", e.what());
+            return nlohmann::json({});
+        }
+    }
+
     nlohmann::json LspServer::handleTextDocumentCompletion(const nlohmann::json &params)
     {
         try
@@ -212,6 +405,34 @@ namespace ZeroSyntax
         }
     }
 
+    nlohmann::json LspServer::handleTextDocumentHover(const nlohmann::json &params)
+    {
+        try
+        {
+            auto textDocument = params["textDocument"];
+            std::string uri = textDocument["uri"];
+            auto position = params["position"];
+            int line = position["line"];
+            int character = position["character"];
+
+            LOG_INFO("Hover requested at {}:{} in {}", line, character, uri);
+
+            auto hover = documentManager_->hover(uri, {line, character});
+
+            if (hover)
+            {
+                return nlohmann::json(*hover);
+            }
+
+            return nlohmann::json(nullptr);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in hover: {}", e.what());
+            return nlohmann::json(nullptr);
+        }
+    }
+
     nlohmann::json LspServer::handleTextDocumentDefinition(const nlohmann::json &params)
     {
         try
@@ -240,20 +461,123 @@ namespace ZeroSyntax
         }
     }
 
+    nlohmann::json LspServer::handleTextDocumentReferences(const nlohmann::json &params)
+    {
+        try
+        {
+            std::string uri = params["textDocument"]["uri"];
+            auto position = params["position"];
+            int line = position["line"];
+            int character = position["character"];
+            bool includeDeclaration = params.value("context", nlohmann::json::object()).value("includeDeclaration", false);
+
+            LOG_INFO("References requested at {}:{} in {}", line, character, uri);
+
+            return nlohmann::json(documentManager_->findReferences(uri, {line, character}, includeDeclaration));
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in references: {}", e.what());
+            return nlohmann::json::array();
+        }
+    }
+
+    nlohmann::json LspServer::handleWorkspaceSymbol(const nlohmann::json &params)
+    {
+        try
+        {
+            std::string query = params.value("query", "");
+
+            LOG_INFO("Workspace symbols requested for '{}'", query);
+
+            constexpr size_t kMaxSymbols = 1000;
+            nlohmann::json symbols = nlohmann::json::array();
+            for (const auto &definition : documentManager_->workspaceIndex().search(query, kMaxSymbols))
+            {
+                // Objects are classes, everything else is plain data
+                int kind = definition.blockType == "Object" || definition.blockType == "ObjectReskin" ? 5 : 23;
+                symbols.push_back(LSP::SymbolInformation{definition.name, kind,
+                                                         {definition.uri, definition.range},
+                                                         std::string(definition.blockType)});
+            }
+
+            return symbols;
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Error in workspace symbol: {}", e.what());
+            return nlohmann::json::array();
+        }
+    }
+
     void LspServer::publishDiagnostics(const std::string &uri, const std::vector<LSP::Diagnostic> &diagnostics)
     {
+        if (!diagnostics_.update(uri, diagnostics))
+        {
+            LOG_DEBUG("Diagnostics of {} unchanged", uri);
+            return;
+        }
+
         nlohmann::json params = {
             {"uri", uri},
-            {"diagnostics", nlohmann::json::array()}};
+            {"diagnostics", diagnostics}};
 
-        for (const auto &diag : diagnostics)
+        sendNotification("textDocument/publishDiagnostics", params);
+    }
+
+    void LspServer::publishDueDiagnostics()
+    {
+        for (const auto &uri : diagnostics_.takeDue(DiagnosticsQueue::Clock::now()))
         {
-            params["diagnostics"].push_back({{"range", {{"start", {{"line", diag.range.start.line}, {"character", diag.range.start.character}}}, {"end", {{"line", diag.range.end.line}, {"character", diag.range.end.character}}}}},
-                                             {"severity", static_cast<int>(diag.severity)},
-                                             {"message", diag.message}});
+            try
+            {
+                if (documentManager_->hasDocument(uri))
+                {
+                    publishDiagnostics(uri, documentManager_->validateDocument(uri));
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Error validating {}: {}", uri, e.what());
+            }
         }
+    }
 
-        sendNotification("textDocument/publishDiagnostics", params);
+    void LspServer::publishMapDiagnostics()
+    {
+        if (documentManager_->mapIndex().fileCount() == 0)
+        {
+            return;
+        }
+        for (const auto &entry : documentManager_->validateMaps())
+        {
+            publishDiagnostics(entry.first, entry.second);
+        }
+    }
+
+    void LspServer::refreshDefinitions()
+    {
+        scheduler_->post([this]
+                         { documentManager_->refreshDefinitions(); });
+    }
+
+    void LspServer::publishIniCrc()
+    {
+        const IniChecksum &checksum = documentManager_->iniChecksum();
+        uint32_t crc = checksum.value();
+        if (sentIniCrc_ == crc)
+        {
+            return;
+        }
+        sentIniCrc_ = crc;
+
+        char hex[16];
+        std::snprintf(hex, sizeof(hex), "0x%08X", crc);
+        nlohmann::json params = {
+            {"crc", hex},
+            {"files", checksum.fileCount()}};
+
+        sendNotification("zeroSyntax/iniCrc", params);
     }
 
     void LspServer::sendNotification(const std::string &method, const nlohmann::json &params)
@@ -263,10 +587,7 @@ namespace ZeroSyntax
             {"method", method},
             {"params", params}};
 
-        std::string message = notification.dump();
-        std::cout << "Content-Length: " << message.size() << "\r\n\r\n";
-        std::cout << message;
-        std::cout.flush();
+        transport_->queueMessage(notification.dump());
     }
 
 } // namespace ZeroSyntax
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "protocol/request_scheduler.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ZeroSyntax {
+
+RequestScheduler::RequestScheduler(size_t workerCount)
+    : inFlight_(0), stopping_(false), wakePipe_{-1, -1} {
+#ifndef _WIN32
+    if (workerCount > 0) {
+        if (pipe(wakePipe_) == 0) {
+            fcntl(wakePipe_[0], F_SETFL, fcntl(wakePipe_[0], F_GETFL) | O_NONBLOCK);
+            fcntl(wakePipe_[1], F_SETFL, fcntl(wakePipe_[1], F_GETFL) | O_NONBLOCK);
+        } else {
+            LOG_WARN("Failed to create scheduler wake pipe, running requests inline");
+            wakePipe_[0] = wakePipe_[1] = -1;
+            workerCount = 0;
+        }
+    }
+#else
+    // Without a way to wake the event loop, completed requests could sit in
+    // the queue until the next message arrives
+    workerCount = 0;
+#endif
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+    LOG_INFO("Request scheduler started with {} worker(s)", workers_.size());
+}
+
+RequestScheduler::~RequestScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeWorkers_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+
+#ifndef _WIN32
+    for (int fd : wakePipe_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+size_t RequestScheduler::defaultWorkerCount() {
+#ifdef _WIN32
+    return 0;
+#else
+    // Leave one core for the protocol thread
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+#endif
+}
+
+void RequestScheduler::submit(const std::string& requestId, const std::string& key, const std::string& uri,
+                              Work work, Reject reject) {
+    auto job = std::make_shared<Job>();
+    job->requestId = requestId;
+    job->key = key;
+    job->uri = uri;
+    job->work = std::move(work);
+    job->reject = std::move(reject);
+
+    if (workers_.empty()) {
+        std::string response = job->work();
+        std::lock_guard<std::mutex> lock(mutex_);
+        complete(std::move(response));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // An older request of the same kind for the same document is obsolete
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if ((*it)->key == key) {
+                LOG_DEBUG("Request {} superseded by {}", (*it)->requestId, requestId);
+                complete((*it)->reject(kRequestCancelled, "Request superseded"));
+                --inFlight_;
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pending_.push_back(job);
+        ++inFlight_;
+    }
+    wakeWorkers_.notify_one();
+}
+
+void RequestScheduler::post(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wakeWorkers_.notify_one();
+}
+
+void RequestScheduler::cancel(const std::string& requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = std::find_if(pending_.begin(), pending_.end(),
+                           [&](const std::shared_ptr<Job>& job) { return job->requestId == requestId; });
+    if (it != pending_.end()) {
+        LOG_DEBUG("Cancelled pending request {}", requestId);
+        complete((*it)->reject(kRequestCancelled, "Request cancelled"));
+        --inFlight_;
+        pending_.erase(it);
+        return;
+    }
+
+    auto running = running_.find(requestId);
+    if (running != running_.end()) {
+        LOG_DEBUG("Cancelled running request {}", requestId);
+        drop(*running->second, kRequestCancelled, "Request cancelled");
+    }
+}
+
+void RequestScheduler::documentChanged(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if ((*it)->uri == uri) {
+            complete((*it)->reject(kContentModified, "Content modified"));
+            --inFlight_;
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto& entry : running_) {
+        if (entry.second->uri == uri) {
+            drop(*entry.second, kContentModified, "Content modified");
+        }
+    }
+}
+
+std::vector<std::string> RequestScheduler::takeCompleted() {
+    std::vector<std::string> responses;
+    std::lock_guard<std::mutex> lock(mutex_);
+    responses.swap(completed_);
+
+#ifndef _WIN32
+    if (wakePipe_[0] >= 0) {
+        char drain[64];
+        while (read(wakePipe_[0], drain, sizeof(drain)) > 0) {
+        }
+    }
+#endif
+    return responses;
+}
+
+size_t RequestScheduler::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inFlight_;
+}
+
+void RequestScheduler::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeWorkers_.wait(lock, [this] { return stopping_ || !pending_.empty() || !tasks_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            if (!pending_.empty()) {
+                job = pending_.front();
+                pending_.pop_front();
+                running_[job->requestId] = job;
+            } else {
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+        }
+        if (job) {
+            run(job);
+        } else {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Error running background task: {}", e.what());
+            }
+        }
+    }
+}
+
+void RequestScheduler::run(const std::shared_ptr<Job>& job) {
+    std::string response;
+    try {
+        response = job->work();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error running request {}: {}", job->requestId, e.what());
+        response = job->reject(-32603, e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_.erase(job->requestId);
+    if (job->dropped) {
+        response = job->reject(job->dropCode, job->dropMessage);
+    }
+    complete(std::move(response));
+    --inFlight_;
+}
+
+void RequestScheduler::drop(Job& job, int code, const std::string& message) {
+    if (!job.dropped) {
+        job.dropCode = code;
+        job.dropMessage = message;
+        job.dropped = true;
+    }
+}
+
+void RequestScheduler::complete(std::string response) {
+    completed_.push_back(std::move(response));
+
+#ifndef _WIN32
+    if (wakePipe_[1] >= 0) {
+        char signal = 1;
+        // A full pipe already guarantees a wake-up
+        (void)!write(wakePipe_[1], &signal, 1);
+    }
+#endif
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,261 @@
+#include "protocol/transport.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace ZeroSyntax {
+
+namespace {
+
+constexpr size_t kInitialReadBufferSize = 64 * 1024;
+constexpr size_t kMaxIovecsPerWrite = 1024;
+
+bool startsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+    if (text.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        char a = text[i];
+        char b = prefix[i];
+        if (a >= 'A' && a <= 'Z') a = static_cast<char>(a - 'A' + 'a');
+        if (b >= 'A' && b <= 'Z') b = static_cast<char>(b - 'A' + 'a');
+        if (a != b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+long readFd(int fd, char* data, size_t size) {
+#ifdef _WIN32
+    return _read(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1u << 30)));
+#else
+    return static_cast<long>(::read(fd, data, size));
+#endif
+}
+
+} // namespace
+
+Transport::Transport(int inputFd, int outputFd)
+    : inputFd_(inputFd),
+      outputFd_(outputFd),
+      readBuffer_(kInitialReadBufferSize),
+      readBegin_(0),
+      readEnd_(0) {
+#ifdef _WIN32
+    // Content-Length counts bytes, so newline translation must be off
+    _setmode(inputFd_, _O_BINARY);
+    _setmode(outputFd_, _O_BINARY);
+#endif
+}
+
+std::optional<Transport::Frame> Transport::parseFrame() const {
+    const char* data = readBuffer_.data() + readBegin_;
+    size_t size = readEnd_ - readBegin_;
+
+    size_t contentLength = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        const void* newline = std::memchr(data + pos, '\n', size - pos);
+        if (!newline) {
+            return std::nullopt;
+        }
+
+        size_t lineEnd = static_cast<size_t>(static_cast<const char*>(newline) - data);
+        std::string_view line(data + pos, lineEnd - pos);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        pos = lineEnd + 1;
+
+        // An empty line ends the headers
+        if (line.empty()) {
+            return Frame{pos, contentLength};
+        }
+
+        constexpr std::string_view kContentLength = "Content-Length:";
+        if (startsWithIgnoreCase(line, kContentLength)) {
+            contentLength = 0;
+            for (char c : line.substr(kContentLength.size())) {
+                if (c >= '0' && c <= '9') {
+                    contentLength = contentLength * 10 + static_cast<size_t>(c - '0');
+                } else if (c != ' ') {
+                    break;
+                }
+            }
+        }
+        // Other headers (Content-Type) are ignored
+    }
+    return std::nullopt;
+}
+
+bool Transport::hasBufferedMessage() const {
+    auto frame = parseFrame();
+    return frame && readEnd_ - readBegin_ >= frame->headerLength + frame->contentLength;
+}
+
+bool Transport::waitForInput(int wakeFd, int timeoutMs) {
+    if (hasBufferedMessage()) {
+        return true;
+    }
+#ifdef _WIN32
+    (void)wakeFd;
+    (void)timeoutMs;
+    return true;
+#else
+    if (wakeFd < 0 && timeoutMs < 0) {
+        return true;
+    }
+
+    pollfd fds[2] = {{inputFd_, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (true) {
+        int ready = ::poll(fds, wakeFd >= 0 ? 2 : 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            // Let the following read report the problem
+            return true;
+        }
+        return fds[0].revents != 0;
+    }
+#endif
+}
+
+std::optional<std::string_view> Transport::readMessage() {
+    while (true) {
+        auto frame = parseFrame();
+        if (frame) {
+            size_t total = frame->headerLength + frame->contentLength;
+            if (readEnd_ - readBegin_ >= total) {
+                std::string_view body(readBuffer_.data() + readBegin_ + frame->headerLength, frame->contentLength);
+                readBegin_ += total;
+
+                // A frame without a body carries nothing to dispatch
+                if (body.empty()) {
+                    continue;
+                }
+                return body;
+            }
+            if (!fill(total)) {
+                return std::nullopt;
+            }
+        } else if (!fill(readEnd_ - readBegin_ + 1)) {
+            return std::nullopt;
+        }
+    }
+}
+
+bool Transport::fill(size_t required) {
+    if (readBegin_ == readEnd_) {
+        readBegin_ = readEnd_ = 0;
+    }
+
+    // Move the unread tail to the front when the frame would not fit behind it
+    if (readBuffer_.size() - readBegin_ < required || readEnd_ == readBuffer_.size()) {
+        std::memmove(readBuffer_.data(), readBuffer_.data() + readBegin_, readEnd_ - readBegin_);
+        readEnd_ -= readBegin_;
+        readBegin_ = 0;
+    }
+    if (readBuffer_.size() < required || readEnd_ == readBuffer_.size()) {
+        readBuffer_.resize(std::max(required, readBuffer_.size() * 2));
+    }
+
+    while (true) {
+        long count = readFd(inputFd_, readBuffer_.data() + readEnd_, readBuffer_.size() - readEnd_);
+        if (count > 0) {
+            readEnd_ += static_cast<size_t>(count);
+            return true;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            LOG_ERROR("Failed to read from input: {}", std::strerror(errno));
+        }
+        return false;
+    }
+}
+
+void Transport::queueMessage(std::string message) {
+    outgoing_.push_back("Content-Length: " + std::to_string(message.size()) + "\r\n\r\n");
+    outgoing_.push_back(std::move(message));
+}
+
+size_t Transport::pendingMessages() const {
+    return outgoing_.size() / 2;
+}
+
+bool Transport::flush() {
+    if (outgoing_.empty()) {
+        return true;
+    }
+
+    bool ok = true;
+#ifdef _WIN32
+    std::string joined;
+    for (const auto& part : outgoing_) {
+        joined += part;
+    }
+    size_t written = 0;
+    while (written < joined.size()) {
+        int count = _write(outputFd_, joined.data() + written,
+                           static_cast<unsigned int>(std::min<size_t>(joined.size() - written, 1u << 30)));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to write to output: {}", std::strerror(errno));
+            ok = false;
+            break;
+        }
+        written += static_cast<size_t>(count);
+    }
+#else
+    std::vector<iovec> iov;
+    iov.reserve(outgoing_.size());
+    for (auto& part : outgoing_) {
+        iov.push_back(iovec{part.data(), part.size()});
+    }
+
+    size_t index = 0;
+    while (index < iov.size()) {
+        int count = static_cast<int>(std::min(iov.size() - index, kMaxIovecsPerWrite));
+        ssize_t written = ::writev(outputFd_, &iov[index], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to write to output: {}", std::strerror(errno));
+            ok = false;
+            break;
+        }
+
+        // Skip fully written buffers and trim a partially written one
+        size_t remaining = static_cast<size_t>(written);
+        while (index < iov.size() && remaining >= iov[index].iov_len) {
+            remaining -= iov[index].iov_len;
+            ++index;
+        }
+        if (remaining > 0) {
+            iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + remaining;
+            iov[index].iov_len -= remaining;
+        }
+    }
+#endif
+
+    outgoing_.clear();
+    return ok;
+}
+
+} // namespace ZeroSyntax
@@ -0,0 +1,209 @@
+#include "text/fuzzy_matcher.hpp"
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZS_HAVE_SSE2 1
+#endif
+
+namespace ZeroSyntax {
+namespace Text {
+
+namespace {
+
+constexpr int kMatch = 16;
+constexpr int kGapStart = -3;           // first skipped character between two matches
+constexpr int kGapExtension = -1;       // each further one
+constexpr int kBoundaryBonus = 8;       // match at the start of the name or after a separator
+constexpr int kCamelBonus = 7;          // match at a lower-to-upper change or the first digit
+constexpr int kConsecutiveBonus = 4;    // match right after the previous one
+constexpr int kFirstCharMultiplier = 2; // the query's first character counts its bonus twice
+constexpr int kCaseBonus = 1;           // match in the query's case
+constexpr int kNoScore = std::numeric_limits<int>::min() / 2;
+
+char fold(char c) {
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+bool isLower(char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+bool isUpper(char c) {
+    return c >= 'A' && c <= 'Z';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isWordChar(char c) {
+    return isLower(c) || isUpper(c) || isDigit(c);
+}
+
+// Bonus for matching name[i], from the character before it
+int positionBonus(std::string_view name, size_t i) {
+    if (i == 0 || !isWordChar(name[i - 1])) {
+        return kBoundaryBonus;
+    }
+    char previous = name[i - 1];
+    char current = name[i];
+    if ((isLower(previous) && isUpper(current)) || (!isDigit(previous) && isDigit(current))) {
+        return kCamelBonus;
+    }
+    return 0;
+}
+
+uint32_t maskBit(char c) {
+    auto u = static_cast<unsigned char>(fold(c));
+    if (u >= 'a' && u <= 'z') {
+        return u - 'a';
+    }
+    if (u >= '0' && u <= '9') {
+        return 26 + (u - '0');
+    }
+    if (u == '_') {
+        return 36;
+    }
+    return 37 + u % 27;
+}
+
+bool better(const FuzzyMatch& a, const FuzzyMatch& b) {
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    if (a.length != b.length) {
+        return a.length < b.length;
+    }
+    return a.index < b.index;
+}
+
+} // namespace
+
+uint64_t characterMask(std::string_view text) {
+    uint64_t mask = 0;
+    for (char c : text) {
+        mask |= uint64_t(1) << maskBit(c);
+    }
+    return mask;
+}
+
+void filterMasks(const uint64_t* masks, size_t count, uint64_t query, std::vector<uint32_t>& matches) {
+    size_t i = 0;
+#ifdef ZS_HAVE_SSE2
+    // Four masks per step: the query bits a mask lacks are query & ~mask, and
+    // a mask passes when all eight bytes of that are zero
+    const __m128i want = _mm_set1_epi64x(static_cast<long long>(query));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + i + 2));
+        int passLow = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_andnot_si128(low, want), zero));
+        int passHigh = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_andnot_si128(high, want), zero));
+        unsigned lanes = static_cast<unsigned>(passLow) | static_cast<unsigned>(passHigh) << 16;
+        if (lanes == 0) {
+            continue;
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            if (((lanes >> (lane * 8)) & 0xFF) == 0xFF) {
+                matches.push_back(static_cast<uint32_t>(i + lane));
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if ((masks[i] & query) == query) {
+            matches.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+FuzzyMatcher::FuzzyMatcher(std::string_view query) : query_(query), folded_(query), mask_(characterMask(query)) {
+    std::transform(folded_.begin(), folded_.end(), folded_.begin(), fold);
+}
+
+std::optional<int> FuzzyMatcher::score(std::string_view name) const {
+    const size_t m = folded_.size();
+    const size_t n = name.size();
+    if (m == 0) {
+        return 0;
+    }
+    if (m > n) {
+        return std::nullopt;
+    }
+
+    // Greedy scan: a subsequence at all?
+    size_t next = 0;
+    for (size_t j = 0; j < n && next < m; ++j) {
+        if (fold(name[j]) == folded_[next]) {
+            ++next;
+        }
+    }
+    if (next < m) {
+        return std::nullopt;
+    }
+
+    // previous_[j] / current_[j]: best score with query[i - 1] / query[i] matched at name[j]
+    // The first row reads nothing from previous_ and every row writes all of current_
+    if (current_.size() < n) {
+        previous_.resize(n);
+        current_.resize(n);
+    }
+    for (size_t i = 0; i < m; ++i) {
+        int gapped = kNoScore;  // best previous_[k] for k < j - 1, minus the gap after it
+        for (size_t j = 0; j < n; ++j) {
+            if (i > 0 && j >= 2) {
+                gapped = std::max(gapped == kNoScore ? kNoScore : gapped + kGapExtension,
+                                  previous_[j - 2] == kNoScore ? kNoScore : previous_[j - 2] + kGapStart);
+            }
+            current_[j] = kNoScore;
+            if (fold(name[j]) != folded_[i]) {
+                continue;
+            }
+            int bonus = positionBonus(name, j) * (i == 0 ? kFirstCharMultiplier : 1) +
+                        (name[j] == query_[i] ? kCaseBonus : 0);
+            if (i == 0) {
+                current_[j] = kMatch + bonus;
+                continue;
+            }
+            int best = kNoScore;
+            if (j >= 1 && previous_[j - 1] != kNoScore) {
+                best = previous_[j - 1] + kMatch + std::max(bonus, kConsecutiveBonus);
+            }
+            if (gapped != kNoScore) {
+                best = std::max(best, gapped + kMatch + bonus);
+            }
+            current_[j] = best;
+        }
+        std::swap(previous_, current_);
+    }
+    int best = *std::max_element(previous_.begin(), previous_.begin() + n);
+    return best == kNoScore ? std::nullopt : std::optional<int>(best);
+}
+
+TopMatches::TopMatches(size_t limit) : limit_(limit) {
+    heap_.reserve(std::min<size_t>(limit, 1024));
+}
+
+void TopMatches::add(uint32_t index, int score, uint32_t length) {
+    FuzzyMatch match{index, score, length};
+    if (heap_.size() < limit_) {
+        heap_.push_back(match);
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    } else if (limit_ > 0 && better(match, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), better);
+        heap_.back() = match;
+        std::push_heap(heap_.begin(), heap_.end(), better);
+    }
+}
+
+std::vector<FuzzyMatch> TopMatches::take() {
+    std::sort_heap(heap_.begin(), heap_.end(), better);
+    std::vector<FuzzyMatch> matches;
+    matches.swap(heap_);
+    return matches;
+}
+
+} // namespace Text
+} // namespace ZeroSyntax
@@ -0,0 +1,464 @@
+#include "text/string_table.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ZeroSyntax {
+namespace Text {
+
+namespace {
+
+// Chunk ids as GameText.cpp compares them, read as little-endian integers
+constexpr uint32_t fourCC(char a, char b, char c, char d) {
+    return (uint32_t(uint8_t(a)) << 24) | (uint32_t(uint8_t(b)) << 16) | (uint32_t(uint8_t(c)) << 8) | uint8_t(d);
+}
+
+constexpr uint32_t kCsfId = fourCC('C', 'S', 'F', ' ');
+constexpr uint32_t kCsfLabel = fourCC('L', 'B', 'L', ' ');
+constexpr uint32_t kCsfString = fourCC('S', 'T', 'R', ' ');
+constexpr uint32_t kCsfStringWithWave = fourCC('S', 'T', 'R', 'W');
+constexpr size_t kCsfHeaderSize = 24;  // id, version, labels, strings, skip, language
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr uint32_t kEmptySlot = std::numeric_limits<uint32_t>::max();
+
+uint32_t readLittleEndian(const char* bytes) {
+    const auto* b = reinterpret_cast<const unsigned char*>(bytes);
+    return uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+}
+
+char fold(char c) {
+    return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+}
+
+// stricmp order
+bool foldedLess(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        auto x = static_cast<unsigned char>(fold(a[i]));
+        auto y = static_cast<unsigned char>(fold(b[i]));
+        if (x != y) {
+            return x < y;
+        }
+    }
+    return a.size() < b.size();
+}
+
+bool foldedStartsWith(std::string_view text, std::string_view prefix) {
+    if (text.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (fold(text[i]) != fold(prefix[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool foldedEquals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && foldedStartsWith(a, b);
+}
+
+// FNV-1a over the folded bytes
+uint32_t foldedHash(std::string_view text) {
+    uint32_t hash = 2166136261u;
+    for (char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(fold(c))) * 16777619u;
+    }
+    return hash;
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+bool isWaveChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// GameTextManager::stripSpaces: drop leading spaces and those around line
+// breaks and tabs, and collapse runs of spaces
+void stripSpaces(std::u16string& text) {
+    size_t out = 0;
+    char16_t last = 0;
+    bool skipAll = true;
+    for (char16_t ch : text) {
+        if (ch == u' ' && (last == u' ' || skipAll)) {
+            continue;
+        }
+        if (ch == u'\n' || ch == u'\t') {
+            if (last == u' ') {
+                --out;
+            }
+            skipAll = true;
+            last = text[out++] = ch;
+            continue;
+        }
+        last = text[out++] = ch;
+        skipAll = false;
+    }
+    if (last == u' ') {
+        --out;
+    }
+    text.resize(out);
+}
+
+void appendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out.push_back(char(code));
+    } else if (code < 0x800) {
+        out.push_back(char(0xC0 | (code >> 6)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(char(0xE0 | (code >> 12)));
+        out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(char(0xF0 | (code >> 18)));
+        out.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    }
+}
+
+std::string toUtf8(const std::u16string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t code = text[i];
+        if (code >= 0xD800 && code < 0xDC00 && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] < 0xE000) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (text[++i] - 0xDC00);
+        } else if (code >= 0xD800 && code < 0xE000) {
+            code = 0xFFFD;
+        }
+        appendUtf8(out, code);
+    }
+    return out;
+}
+
+// A CSF string: each UTF-16 unit is stored inverted, and like the engine's
+// C strings it ends at the first NUL either way round
+std::u16string decodeCsf(std::string_view bytes) {
+    std::u16string text;
+    text.reserve(bytes.size() / 2);
+    for (size_t i = 0; i + 1 < bytes.size(); i += 2) {
+        auto raw = char16_t(uint8_t(bytes[i]) | (uint8_t(bytes[i + 1]) << 8));
+        if (raw == 0 || raw == 0xFFFF) {
+            break;
+        }
+        text.push_back(char16_t(~raw));
+    }
+    return text;
+}
+
+// A quoted STR string: whitespace becomes spaces as in readToEndOfQuote,
+// then escapes are resolved as in translateCopy; bytes are Latin-1
+std::u16string decodeStr(std::string_view bytes) {
+    std::u16string text;
+    text.reserve(bytes.size());
+    bool slash = false;
+    for (char c : bytes) {
+        if (isSpace(c)) {
+            c = ' ';
+        }
+        if (slash) {
+            slash = false;
+            switch (c) {
+                case 't': text.push_back(u'\t'); break;
+                case 'n': text.push_back(u'\n'); break;
+                default: text.push_back(char16_t(uint8_t(c))); break;
+            }
+        } else if (c == '\\') {
+            slash = true;
+        } else {
+            text.push_back(char16_t(uint8_t(c)));
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+bool StringTable::loadCsf(std::string data) {
+    clear();
+    if (data.size() < kCsfHeaderSize || data.size() > std::numeric_limits<uint32_t>::max()
+        || readLittleEndian(data.data()) != kCsfId) {
+        LOG_WARN("String table is not a CSF file");
+        return false;
+    }
+    data_ = std::move(data);
+    const char* base = data_.data();
+    uint32_t version = readLittleEndian(base + 4);
+    uint32_t labels = readLittleEndian(base + 8);
+    language_ = version >= 2 ? readLittleEndian(base + 20) : 0;
+    entries_.reserve(std::min<size_t>(labels, data_.size() / 12));
+
+    size_t cursor = kCsfHeaderSize;
+    auto remaining = [&]() { return data_.size() - cursor; };
+    auto readWord = [&](uint32_t& value) {
+        if (remaining() < 4) {
+            return false;
+        }
+        value = readLittleEndian(base + cursor);
+        cursor += 4;
+        return true;
+    };
+    auto readSpan = [&](uint64_t size, Span& span) {
+        if (remaining() < size) {
+            return false;
+        }
+        span = Span{uint32_t(cursor), uint32_t(size)};
+        cursor += size;
+        return true;
+    };
+
+    // Like parseCSF, stop cleanly only where a label id would start
+    uint32_t id = 0;
+    while (readWord(id)) {
+        Entry entry;
+        uint32_t strings = 0;
+        uint32_t length = 0;
+        bool ok = id == kCsfLabel && readWord(strings) && readWord(length) && readSpan(length, entry.label);
+        for (uint32_t i = 0; ok && i < strings; ++i) {
+            Span text;
+            Span speech;
+            ok = readWord(id) && (id == kCsfString || id == kCsfStringWithWave) && readWord(length)
+                 && readSpan(uint64_t(length) * 2, text);
+            if (ok && id == kCsfStringWithWave) {
+                ok = readWord(length) && readSpan(length, speech);
+            }
+            if (ok && i == 0) {
+                entry.text = text;
+                entry.speech = speech;
+            }
+        }
+        if (!ok) {
+            LOG_WARN("String table record {} is malformed at byte {}", entries_.size(), cursor);
+            clear();
+            return false;
+        }
+        entries_.push_back(entry);
+    }
+    csf_ = true;
+    buildIndex();
+    return true;
+}
+
+bool StringTable::loadStr(std::string data) {
+    clear();
+    if (data.size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    data_ = std::move(data);
+    std::string_view text(data_);
+    size_t cursor = 0;
+    int lineNumber = 0;
+
+    // Next line without its surrounding whitespace, as readLine and
+    // removeLeadingAndTrailing leave it
+    auto nextLine = [&](std::string_view& line, size_t& offset) {
+        if (cursor >= text.size()) {
+            return false;
+        }
+        size_t end = text.find('\n', cursor);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        size_t first = cursor;
+        size_t last = end;
+        while (first < last && isSpace(text[first])) {
+            ++first;
+        }
+        while (last > first && isSpace(text[last - 1])) {
+            --last;
+        }
+        line = text.substr(first, last - first);
+        offset = first;
+        cursor = end + 1;
+        ++lineNumber;
+        return true;
+    };
+
+    std::string_view line;
+    size_t offset = 0;
+    while (nextLine(line, offset)) {
+        if (line.empty() || line.compare(0, 2, "//") == 0) {
+            continue;
+        }
+        Entry entry;
+        entry.label = Span{uint32_t(offset), uint32_t(line.size())};
+        int labelLine = lineNumber;
+        bool readString = false;
+        bool ended = false;
+        while (nextLine(line, offset)) {
+            if (foldedEquals(line, "END")) {
+                ended = true;
+                break;
+            }
+            if (line.empty() || line.front() != '"') {
+                continue;
+            }
+
+            // The string runs to the next unescaped quote, across lines
+            size_t start = offset + 1;
+            size_t end = start;
+            bool slash = false;
+            for (; end < text.size(); ++end) {
+                char c = text[end];
+                if (c == '\n') {
+                    slash = false;
+                    ++lineNumber;
+                } else if (c == '\\') {
+                    slash = !slash;
+                } else if (c == '"' && !slash) {
+                    break;
+                } else {
+                    slash = false;
+                }
+            }
+
+            // The rest of its last line may name the speech file: "text" = name
+            size_t lineEnd = end < text.size() ? text.find('\n', end) : std::string_view::npos;
+            if (lineEnd == std::string_view::npos) {
+                lineEnd = text.size();
+            }
+            size_t wave = end + 1;
+            while (wave < lineEnd && (isSpace(text[wave]) || text[wave] == '=')) {
+                ++wave;
+            }
+            size_t waveEnd = wave;
+            while (waveEnd < lineEnd && isWaveChar(text[waveEnd])) {
+                ++waveEnd;
+            }
+            cursor = lineEnd + 1;
+
+            // Only one string per label; later ones are ignored
+            if (!readString) {
+                entry.text = Span{uint32_t(start), uint32_t(std::min(end, text.size()) - start)};
+                if (waveEnd > wave) {
+                    entry.speech = Span{uint32_t(wave), uint32_t(waveEnd - wave)};
+                }
+                readString = true;
+            }
+        }
+        if (!ended) {
+            LOG_WARN("String table ends inside label {} from line {}", span(entry.label), labelLine);
+            clear();
+            return false;
+        }
+        entries_.push_back(entry);
+    }
+    buildIndex();
+    return true;
+}
+
+std::optional<uint32_t> StringTable::find(std::string_view label) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = foldedHash(label) & mask;; slot = (slot + 1) & mask) {
+        uint32_t index = slots_[slot];
+        if (index == kEmptySlot) {
+            return std::nullopt;
+        }
+        if (foldedEquals(span(entries_[index].label), label)) {
+            return index;
+        }
+    }
+}
+
+std::vector<uint32_t> StringTable::resolve(const std::vector<std::string_view>& labels) const {
+    std::vector<uint32_t> result(labels.size(), kMissing);
+    std::vector<uint32_t> order(labels.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&labels](uint32_t a, uint32_t b) { return foldedLess(labels[a], labels[b]); });
+    uint32_t entry = 0;
+    for (uint32_t i : order) {
+        while (entry < entries_.size() && foldedLess(span(entries_[entry].label), labels[i])) {
+            ++entry;
+        }
+        if (entry < entries_.size() && foldedEquals(span(entries_[entry].label), labels[i])) {
+            result[i] = entry;
+        }
+    }
+    return result;
+}
+
+std::pair<uint32_t, uint32_t> StringTable::withPrefix(std::string_view prefix) const {
+    auto first = std::lower_bound(entries_.begin(), entries_.end(), prefix, [this](const Entry& entry, std::string_view key) {
+        return foldedLess(span(entry.label), key);
+    });
+    auto last = std::partition_point(first, entries_.end(), [this, prefix](const Entry& entry) {
+        return foldedStartsWith(span(entry.label), prefix);
+    });
+    return {uint32_t(first - entries_.begin()), uint32_t(last - entries_.begin())};
+}
+
+std::string_view StringTable::text(uint32_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string_view& decoded = decoded_[index];
+    if (decoded.data()) {
+        return decoded;
+    }
+    std::string_view bytes = span(entries_[index].text);
+    std::u16string units = csf_ ? decodeCsf(bytes) : decodeStr(bytes);
+    stripSpaces(units);
+    std::string utf8 = toUtf8(units);
+
+    // Blocks are reserved up front and never grow past their capacity, so
+    // earlier views stay valid; a string longer than a block gets its own
+    if (blocks_.empty() || blocks_.back().capacity() - blocks_.back().size() < utf8.size()) {
+        blocks_.emplace_back();
+        blocks_.back().reserve(std::max(kBlockSize, utf8.size()));
+    }
+    std::string& block = blocks_.back();
+    size_t start = block.size();
+    block += utf8;
+    decoded = std::string_view(block.data() + start, utf8.size());
+    return decoded;
+}
+
+void StringTable::clear() {
+    data_.clear();
+    entries_.clear();
+    slots_.clear();
+    language_ = 0;
+    csf_ = false;
+    decoded_.clear();
+    blocks_.clear();
+}
+
+void StringTable::buildIndex() {
+    std::stable_sort(entries_.begin(), entries_.end(), [this](const Entry& a, const Entry& b) {
+        return foldedLess(span(a.label), span(b.label));
+    });
+    auto last = std::unique(entries_.begin(), entries_.end(), [this](const Entry& a, const Entry& b) {
+        return foldedEquals(span(a.label), span(b.label));
+    });
+    if (last != entries_.end()) {
+        LOG_WARN("String table defines {} labels more than once; the first definitions are used",
+                 entries_.end() - last);
+        entries_.erase(last, entries_.end());
+    }
+    entries_.shrink_to_fit();
+
+    size_t capacity = 1;
+    while (capacity < entries_.size() * 2) {
+        capacity <<= 1;
+    }
+    slots_.assign(entries_.empty() ? 0 : capacity, kEmptySlot);
+    size_t mask = capacity - 1;
+    for (uint32_t index = 0; index < entries_.size(); ++index) {
+        size_t slot = foldedHash(span(entries_[index].label)) & mask;
+        while (slots_[slot] != kEmptySlot) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = index;
+    }
+    decoded_.assign(entries_.size(), std::string_view());
+}
+
+} // namespace Text
+} // namespace ZeroSyntax
@@ -12,8 +12,8 @@ void initLogging(spdlog::level::level_enum level) {
         // Create logs directory if it doesn't exist
         std::filesystem::create_directories("logs");
         
-        // Create console sink
-        auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+        // Create console sink (stderr: stdout carries the LSP protocol stream)
+        auto console_sink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
         console_sink->set_level(level);
         
         // Create file sink
@@ -0,0 +1,65 @@
+#include "utils/mapped_file.hpp"
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ZeroSyntax {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifndef _WIN32
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            mapping_ = mapping;
+            data_ = static_cast<const char*>(mapping);
+            size_ = static_cast<size_t>(info.st_size);
+        }
+    }
+    ::close(descriptor);
+    if (data_) {
+        return true;
+    }
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    buffer_ = contents.str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapping_) {
+        ::munmap(mapping_, size_);
+    }
+#endif
+    mapping_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    buffer_.clear();
+}
+
+} // namespace ZeroSyntax
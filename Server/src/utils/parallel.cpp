@@ -0,0 +1,101 @@
+#include "utils/parallel.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ZeroSyntax {
+
+namespace {
+
+// Indices [begin, end) a thread has yet to run; the owner takes from the
+// front, thieves from the back
+struct alignas(64) Slice {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+bool takeFront(Slice& slice, size_t& index) {
+    std::lock_guard<std::mutex> lock(slice.mutex);
+    if (slice.begin == slice.end) {
+        return false;
+    }
+    index = slice.begin++;
+    return true;
+}
+
+// Move the back half of the largest other slice into own; false once every slice is empty
+bool steal(Slice* slices, size_t threadCount, size_t own) {
+    for (;;) {
+        size_t victim = threadCount;
+        size_t largest = 0;
+        for (size_t i = 0; i < threadCount; ++i) {
+            if (i == own) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(slices[i].mutex);
+            if (slices[i].end - slices[i].begin > largest) {
+                largest = slices[i].end - slices[i].begin;
+                victim = i;
+            }
+        }
+        if (victim == threadCount) {
+            return false;
+        }
+
+        size_t begin;
+        size_t end;
+        {
+            std::lock_guard<std::mutex> lock(slices[victim].mutex);
+            size_t remaining = slices[victim].end - slices[victim].begin;
+            if (remaining == 0) {
+                continue;  // drained while we looked; pick again
+            }
+            end = slices[victim].end;
+            begin = end - (remaining + 1) / 2;
+            slices[victim].end = begin;
+        }
+        std::lock_guard<std::mutex> lock(slices[own].mutex);
+        slices[own].begin = begin;
+        slices[own].end = end;
+        return true;
+    }
+}
+
+} // namespace
+
+size_t parallelFor(size_t count, size_t threadCount, const std::function<void(size_t index, size_t worker)>& body) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min(threadCount, std::max<size_t>(count, 1));
+
+    std::unique_ptr<Slice[]> slices(new Slice[threadCount]);
+    for (size_t i = 0; i < threadCount; ++i) {
+        slices[i].begin = count * i / threadCount;
+        slices[i].end = count * (i + 1) / threadCount;
+    }
+
+    auto worker = [&](size_t self) {
+        size_t index;
+        do {
+            while (takeFront(slices[self], index)) {
+                body(index, self);
+            }
+        } while (steal(slices.get(), threadCount, self));
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return threadCount;
+}
+
+} // namespace ZeroSyntax
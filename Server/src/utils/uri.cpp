@@ -0,0 +1,84 @@
+#include "utils/uri.hpp"
+
+namespace ZeroSyntax {
+
+namespace {
+
+bool isUnreserved(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '.' || c == '_' || c == '~' || c == '/';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace
+
+std::string pathToUri(const std::string& path) {
+    static const char* digits = "0123456789ABCDEF";
+
+    std::string generic = path;
+    for (char& c : generic) {
+        if (c == '\\') {
+            c = '/';
+        }
+    }
+
+    // Windows drive letters get a leading slash and keep their colon
+    std::string uri = "file://";
+    size_t start = 0;
+    if (generic.size() >= 2 && generic[1] == ':') {
+        uri += '/';
+        uri += generic.substr(0, 2);
+        start = 2;
+    }
+    for (size_t i = start; i < generic.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(generic[i]);
+        if (isUnreserved(c)) {
+            uri += static_cast<char>(c);
+        } else {
+            uri += '%';
+            uri += digits[c >> 4];
+            uri += digits[c & 0xF];
+        }
+    }
+    return uri;
+}
+
+std::optional<std::string> uriToPath(const std::string& uri) {
+    const std::string scheme = "file://";
+    if (uri.compare(0, scheme.size(), scheme) != 0) {
+        return std::nullopt;
+    }
+
+    std::string path;
+    for (size_t i = scheme.size(); i < uri.size(); ++i) {
+        int high = 0;
+        int low = 0;
+        if (uri[i] == '%' && i + 2 < uri.size() && (high = hexValue(uri[i + 1])) >= 0 &&
+            (low = hexValue(uri[i + 2])) >= 0) {
+            path += static_cast<char>(high * 16 + low);
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+
+    // "/c:/mod" -> "c:/mod"
+    if (path.size() >= 3 && path[0] == '/' && path[2] == ':') {
+        path.erase(0, 1);
+    }
+    return path;
+}
+
+} // namespace ZeroSyntax
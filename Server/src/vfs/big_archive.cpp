@@ -0,0 +1,121 @@
+#include "vfs/big_archive.hpp"
+#include "vfs/game_path.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+namespace {
+
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kRecordSize = 8;  // offset and size, followed by the path
+
+uint32_t readBigEndian(const char* bytes) {
+    const auto* b = reinterpret_cast<const unsigned char*>(bytes);
+    return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+
+bool pathLess(const BigEntry& entry, std::string_view path) {
+    return entry.path < path;
+}
+
+} // namespace
+
+bool BigArchive::open(const std::string& path) {
+    clear();
+    if (!file_.open(path)) {
+        LOG_WARN("Could not open archive {}", path);
+        return false;
+    }
+    std::string_view data = file_.contents();
+    if (data.size() < kHeaderSize || (data.compare(0, 4, "BIGF") != 0 && data.compare(0, 4, "BIG4") != 0)) {
+        LOG_WARN("{} is not a BIG archive", path);
+        clear();
+        return false;
+    }
+
+    // Bytes 4-7 hold the archive size in the other byte order and 12-15 the
+    // end of the directory; the engine trusts neither, and neither do we
+    uint32_t count = readBigEndian(data.data() + 8);
+    const char* cursor = data.data() + kHeaderSize;
+    const char* end = data.data() + data.size();
+    paths_.reserve(std::min<size_t>(data.size(), size_t(count) * 32));
+    entries_.reserve(std::min<size_t>(count, data.size() / (kRecordSize + 1)));
+
+    // Record paths first, then point the entries into the finished buffer
+    std::vector<std::pair<size_t, size_t>> spans;
+    spans.reserve(entries_.capacity());
+    size_t dropped = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (end - cursor < static_cast<ptrdiff_t>(kRecordSize)) {
+            LOG_WARN("Directory of {} ends after {} of {} records", path, i, count);
+            break;
+        }
+        uint32_t offset = readBigEndian(cursor);
+        uint32_t size = readBigEndian(cursor + 4);
+        const char* name = cursor + kRecordSize;
+        const char* terminator = static_cast<const char*>(std::memchr(name, 0, end - name));
+        if (!terminator) {
+            LOG_WARN("Directory of {} ends after {} of {} records", path, i, count);
+            break;
+        }
+        cursor = terminator + 1;
+        if (uint64_t(offset) + size > data.size()) {
+            ++dropped;
+            continue;
+        }
+        size_t start = paths_.size();
+        appendGamePath(paths_, std::string_view(name, terminator - name));
+        spans.emplace_back(start, paths_.size() - start);
+        entries_.push_back(BigEntry{{}, offset, size});
+    }
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        entries_[i].path = std::string_view(paths_).substr(spans[i].first, spans[i].second);
+    }
+    if (dropped > 0) {
+        LOG_WARN("Dropped {} records of {} that point past the end of the file", dropped, path);
+    }
+
+    // Sort by path keeping the later of duplicate records
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const BigEntry& a, const BigEntry& b) { return a.path < b.path; });
+    auto last = std::unique(entries_.rbegin(), entries_.rend(),
+                            [](const BigEntry& a, const BigEntry& b) { return a.path == b.path; });
+    entries_.erase(entries_.begin(), last.base());
+
+    path_ = path;
+    return true;
+}
+
+const BigEntry* BigArchive::find(std::string_view path) const {
+    std::string key = normalizeGamePath(path);
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), key, pathLess);
+    return it != entries_.end() && it->path == key ? &*it : nullptr;
+}
+
+std::pair<const BigEntry*, const BigEntry*> BigArchive::entriesUnder(std::string_view directory) const {
+    std::string prefix = normalizeGamePath(directory);
+    if (!prefix.empty()) {
+        prefix.push_back('/');
+    }
+    auto first = std::lower_bound(entries_.begin(), entries_.end(), prefix, pathLess);
+    // '0' sorts right after '/', so it bounds every path below the prefix
+    std::string limit = prefix;
+    if (!limit.empty()) {
+        limit.back() = '0';
+    }
+    auto last = limit.empty() ? entries_.end() : std::lower_bound(first, entries_.end(), limit, pathLess);
+    return {entries_.data() + (first - entries_.begin()), entries_.data() + (last - entries_.begin())};
+}
+
+void BigArchive::clear() {
+    file_.close();
+    path_.clear();
+    paths_.clear();
+    entries_.clear();
+}
+
+} // namespace Vfs
+} // namespace ZeroSyntax
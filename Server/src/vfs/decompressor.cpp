@@ -0,0 +1,788 @@
+#include "vfs/decompressor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+namespace {
+
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kHistory = 128 * 1024;  // farthest a RefPack copy reaches back
+constexpr size_t kChunk = 64 * 1024;     // decoded per fill when streaming
+constexpr size_t kSlack = 2 * 1024;      // above the longest RefPack command (1031 bytes)
+constexpr size_t kUntilEnd = std::numeric_limits<size_t>::max();
+
+uint32_t loadBigEndian(const unsigned char* bytes, size_t count) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+} // namespace
+
+// Decoded bytes go to data[size..capacity); data[0..size) is the history
+// back references copy from. capacity never reaches past the uncompressed
+// size, so a stream that decodes to more is caught as soon as it tries.
+struct Output {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+};
+
+enum class Progress { More, End, Failed };
+
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    // Uncompressed size from the codec's own header, or -1 when it is not valid
+    int64_t size() const { return size_; }
+
+    // Decode until out holds want bytes, the stream ends or turns out corrupt;
+    // resumes where the last call stopped
+    virtual Progress decode(Output& out, size_t want) = 0;
+
+protected:
+    int64_t size_ = -1;
+};
+
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+// RefPack (refdecode.cpp): commands of up to three literals and a copy from
+// at most 128 KiB back, runs of up to 112 literals, and an end command
+// ------------------------------------------------------------------------------------------------
+
+class RefPackCodec : public Codec {
+public:
+    explicit RefPackCodec(std::string_view stream)
+        : in_(reinterpret_cast<const unsigned char*>(stream.data())), end_(in_ + stream.size()) {
+        // 10fb, with 11fb naming a size field to skip and 90fb/91fb 4-byte sizes
+        if (stream.size() < 2) {
+            return;
+        }
+        uint32_t type = loadBigEndian(in_, 2);
+        if ((type & ~0x8100u) != 0x10fb) {
+            return;
+        }
+        size_t sizeBytes = (type & 0x8000) ? 4 : 3;
+        size_t skipped = (type & 0x100) ? sizeBytes : 0;
+        if (stream.size() < 2 + skipped + sizeBytes) {
+            return;
+        }
+        size_ = loadBigEndian(in_ + 2 + skipped, sizeBytes);
+        in_ += 2 + skipped + sizeBytes;
+    }
+
+    Progress decode(Output& out, size_t want) override {
+        const unsigned char* s = in_;
+        unsigned char* d = out.data + out.size;
+        unsigned char* const limit = out.data + out.capacity;
+        Progress progress = Progress::More;
+        while (static_cast<size_t>(d - out.data) < want) {
+            if (s == end_) {
+                progress = Progress::Failed;
+                break;
+            }
+            unsigned int first = s[0];
+            size_t available = static_cast<size_t>(end_ - s);
+            size_t commandSize;
+            size_t literals;
+            size_t offset = 0;
+            size_t length = 0;
+            bool last = false;
+            if (!(first & 0x80)) {
+                commandSize = 2;
+                if (available < commandSize) {
+                    progress = Progress::Failed;
+                    break;
+                }
+                literals = first & 3;
+                offset = ((first & 0x60) << 3) + s[1] + 1;
+                length = ((first & 0x1c) >> 2) + 3;
+            } else if (!(first & 0x40)) {
+                commandSize = 3;
+                if (available < commandSize) {
+                    progress = Progress::Failed;
+                    break;
+                }
+                literals = s[1] >> 6;
+                offset = ((s[1] & 0x3f) << 8) + s[2] + 1;
+                length = (first & 0x3f) + 4;
+            } else if (!(first & 0x20)) {
+                commandSize = 4;
+                if (available < commandSize) {
+                    progress = Progress::Failed;
+                    break;
+                }
+                literals = first & 3;
+                offset = ((first & 0x10) << 12) + (s[1] << 8) + s[2] + 1;
+                length = ((first & 0x0c) << 6) + s[3] + 5;
+            } else {
+                commandSize = 1;
+                literals = ((first & 0x1f) << 2) + 4;
+                if (literals > 112) {
+                    literals = first & 3;
+                    last = true;
+                }
+            }
+            size_t room = static_cast<size_t>(limit - d);
+            if (available - commandSize < literals || room < literals + length) {
+                progress = Progress::Failed;
+                break;
+            }
+            s += commandSize;
+            if (literals <= 3 && available - commandSize >= 4 && room >= 4) {
+                std::memcpy(d, s, 4);  // the usual handful, copied as one word
+            } else {
+                std::memcpy(d, s, literals);
+            }
+            s += literals;
+            d += literals;
+            room -= literals;
+            if (length) {
+                if (offset > static_cast<size_t>(d - out.data)) {
+                    progress = Progress::Failed;
+                    break;
+                }
+                const unsigned char* from = d - offset;
+                if (offset >= 8 && room >= length + 8) {
+                    // Eight bytes at a time, none read before they are written;
+                    // up to seven bytes past the copy are overwritten later
+                    for (size_t i = 0; i < length; i += 8) {
+                        std::memcpy(d + i, from + i, 8);
+                    }
+                } else {
+                    // Overlapping, repeating the last offset bytes
+                    for (size_t i = 0; i < length; ++i) {
+                        d[i] = from[i];
+                    }
+                }
+                d += length;
+            }
+            if (last) {
+                progress = Progress::End;
+                break;
+            }
+        }
+        in_ = s;
+        out.size = static_cast<size_t>(d - out.data);
+        return progress;
+    }
+
+private:
+    const unsigned char* in_;
+    const unsigned char* end_;
+};
+
+// ------------------------------------------------------------------------------------------------
+// BTree (btreedecode.cpp): byte pairs replaced by otherwise unused byte values,
+// expanded again here with an explicit stack; a clue byte escapes literals and
+// ends the stream
+// ------------------------------------------------------------------------------------------------
+
+class BTreeCodec : public Codec {
+public:
+    explicit BTreeCodec(std::string_view stream)
+        : in_(reinterpret_cast<const unsigned char*>(stream.data())), end_(in_ + stream.size()) {
+        // 46fb, or 47fb followed by a size field to skip
+        if (stream.size() < 2) {
+            return;
+        }
+        uint32_t type = loadBigEndian(in_, 2);
+        if (type != 0x46fb && type != 0x47fb) {
+            return;
+        }
+        size_t header = type == 0x47fb ? 5 : 2;
+        if (stream.size() < header + 5) {
+            return;
+        }
+        uint32_t size = loadBigEndian(in_ + header, 3);
+        const unsigned char* s = in_ + header + 3;
+        std::fill(std::begin(kinds_), std::end(kinds_), Leaf);
+        kinds_[*s++] = Clue;
+        size_t nodes = *s++;
+        if (static_cast<size_t>(end_ - s) < nodes * 3) {
+            return;
+        }
+        for (size_t i = 0; i < nodes; ++i, s += 3) {
+            kinds_[s[0]] = Pair;
+            left_[s[0]] = s[1];
+            right_[s[0]] = s[2];
+        }
+        for (int node = 0; node < 256; ++node) {
+            expansions_[node][0] = static_cast<unsigned char>(node);
+            expansionSizes_[node] = kinds_[node] == Leaf ? 1 : kUnknown;
+        }
+        for (int node = 0; node < 256; ++node) {
+            expand(static_cast<unsigned char>(node));
+        }
+        in_ = s;
+        size_ = size;
+    }
+
+    Progress decode(Output& out, size_t want) override {
+        while (out.size < want) {
+            if (depth_) {
+                // Expand the innermost pending node
+                unsigned char node = stack_[--depth_];
+                if (kinds_[node] == Pair) {
+                    if (depth_ + 2 > kMaxDepth) {
+                        return Progress::Failed;  // a node that contains itself
+                    }
+                    stack_[depth_++] = right_[node];
+                    stack_[depth_++] = left_[node];
+                    continue;
+                }
+                if (kinds_[node] == Clue || out.size == out.capacity) {
+                    return Progress::Failed;
+                }
+                out.data[out.size++] = node;
+                continue;
+            }
+            if (in_ == end_) {
+                return Progress::Failed;
+            }
+            unsigned char node = *in_++;
+            size_t expansionSize = expansionSizes_[node];
+            if (expansionSize <= kShortExpansion) {
+                size_t room = out.capacity - out.size;
+                if (room >= kShortExpansion) {
+                    std::memcpy(out.data + out.size, expansions_[node], kShortExpansion);
+                } else if (room >= expansionSize) {
+                    std::memcpy(out.data + out.size, expansions_[node], expansionSize);
+                } else {
+                    return Progress::Failed;
+                }
+                out.size += expansionSize;
+                continue;
+            }
+            if (kinds_[node] == Pair) {
+                stack_[depth_++] = node;
+                continue;
+            }
+            if (kinds_[node] == Clue) {
+                // Followed by a literal, or zero at the end
+                if (in_ == end_) {
+                    return Progress::Failed;
+                }
+                node = *in_++;
+                if (!node) {
+                    return Progress::End;
+                }
+            }
+            if (out.size == out.capacity) {
+                return Progress::Failed;
+            }
+            out.data[out.size++] = node;
+        }
+        return Progress::More;
+    }
+
+private:
+    enum Kind : unsigned char { Leaf, Pair, Clue };
+
+    static constexpr size_t kShortExpansion = 16;
+    static constexpr unsigned char kUnknown = 0;
+    static constexpr unsigned char kLong = 0xff;  // expanded on the stack
+
+    // Size of what node stands for, kept in expansions_ when it is short
+    unsigned char expand(unsigned char node) {
+        if (expansionSizes_[node] != kUnknown) {
+            return expansionSizes_[node];
+        }
+        // Marked first, so a node that contains itself is left to the stack
+        expansionSizes_[node] = kLong;
+        if (kinds_[node] != Pair) {
+            return kLong;
+        }
+        size_t left = expand(left_[node]);
+        size_t right = expand(right_[node]);
+        if (left + right <= kShortExpansion) {
+            std::memcpy(expansions_[node], expansions_[left_[node]], left);
+            std::memcpy(expansions_[node] + left, expansions_[right_[node]], right);
+            expansionSizes_[node] = static_cast<unsigned char>(left + right);
+        }
+        return expansionSizes_[node];
+    }
+
+    // Nodes are defined in terms of earlier ones, so a valid stream nests at
+    // most 256 deep and leaves one right branch pending per level
+    static constexpr size_t kMaxDepth = 2 * 256 + 2;
+
+    const unsigned char* in_;
+    const unsigned char* end_;
+    Kind kinds_[256];
+    unsigned char left_[256];
+    unsigned char right_[256];
+    unsigned char expansions_[256][kShortExpansion];
+    unsigned char expansionSizes_[256];
+    unsigned char stack_[kMaxDepth];
+    size_t depth_ = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Huffman (huffdecode.cpp): canonical codes of up to 16 bits read most
+// significant bit first, a clue code introducing runs of the last byte,
+// explicit bytes and the end, and optionally one or two levels of delta coding
+// ------------------------------------------------------------------------------------------------
+
+class BitReader {
+public:
+    BitReader(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+    // Next n bits (n <= 32), zeros past the end of the data
+    uint32_t peek(int n) {
+        if (count_ < n) {
+            refill();
+        }
+        return n ? static_cast<uint32_t>(bits_ >> (64 - n)) : 0;
+    }
+
+    // Drop n bits, which peek must have made available
+    void consume(int n) {
+        bits_ <<= n;
+        count_ -= n;
+    }
+
+    uint32_t get(int n) {
+        uint32_t value = peek(n);
+        consume(n);
+        return value;
+    }
+
+    // More bits were taken than the data holds
+    bool overrun() const { return padding_ * 8 > static_cast<size_t>(count_); }
+
+private:
+    void refill() {
+        if (size_ - offset_ >= 8) {
+            // A whole word; the bits below the last whole byte taken are
+            // loaded again, identically, next time
+            uint64_t word = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                word = (word << 8) | data_[offset_ + i];
+            }
+            bits_ |= word >> count_;
+            size_t bytes = static_cast<size_t>(63 - count_) / 8;
+            offset_ += bytes;
+            count_ += static_cast<int>(bytes * 8);
+            return;
+        }
+        while (count_ <= 56) {
+            uint64_t byte = 0;
+            if (offset_ < size_) {
+                byte = data_[offset_++];
+            } else {
+                ++padding_;
+            }
+            bits_ |= byte << (56 - count_);
+            count_ += 8;
+        }
+    }
+
+    const unsigned char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    size_t padding_ = 0;  // zero bytes read past the end
+    uint64_t bits_ = 0;   // next bits, most significant first
+    int count_ = 0;
+};
+
+class HuffmanCodec : public Codec {
+public:
+    explicit HuffmanCodec(std::string_view stream)
+        : bits_(reinterpret_cast<const unsigned char*>(stream.data()), stream.size()) {
+        // 30fb/32fb/34fb (plain, delta, double delta), +0x100 with a size field
+        // to skip, +0x8000 with 4-byte sizes
+        type_ = bits_.get(16);
+        uint32_t plain = type_ & ~0x8100u;
+        if (plain != 0x30fb && plain != 0x32fb && plain != 0x34fb) {
+            return;
+        }
+        int sizeBits = (type_ & 0x8000) ? 32 : 24;
+        if (type_ & 0x100) {
+            bits_.get(sizeBits);
+        }
+        uint32_t size = bits_.get(sizeBits);
+        type_ = plain;
+        if (readTables() && !bits_.overrun()) {
+            size_ = size;
+        }
+    }
+
+    Progress decode(Output& out, size_t want) override {
+        size_t first = out.size;
+        Progress progress = decodeSymbols(out, want);
+        // Runs repeat the byte before delta decoding, so it is undone on the
+        // way out of each call rather than in place as decoding goes
+        if (type_ == 0x32fb) {
+            for (size_t i = first; i < out.size; ++i) {
+                sum_ += out.data[i];
+                out.data[i] = static_cast<unsigned char>(sum_);
+            }
+        } else if (type_ == 0x34fb) {
+            for (size_t i = first; i < out.size; ++i) {
+                sum_ += out.data[i];
+                accumulated_ += sum_;
+                out.data[i] = static_cast<unsigned char>(accumulated_);
+            }
+        }
+        return progress;
+    }
+
+private:
+    // Numbers are n - 2 zero bits, a one and n more bits, counting from
+    // (1 << n) - 4; HUFF_writenum never writes more than 18 zeros
+    bool readNumber(uint32_t& value) {
+        int zeros = 0;
+        while (!bits_.get(1)) {
+            if (++zeros > 18 || bits_.overrun()) {
+                return false;
+            }
+        }
+        int n = zeros + 2;
+        value = bits_.get(n) + (1u << n) - 4;
+        return true;
+    }
+
+    bool readTables() {
+        clue_ = static_cast<unsigned char>(bits_.get(8));
+
+        // Count of codes per length; each length's codes follow the shorter
+        // ones, so limits_[n] bounds the n-bit codes left-justified in 16 bits
+        uint32_t base = 0;
+        uint32_t count = 0;
+        uint32_t limit = 0;
+        codeCount_ = 0;
+        int length = 0;
+        do {
+            if (++length > 16) {
+                return false;
+            }
+            base <<= 1;
+            deltas_[length] = base - codeCount_;
+            if (!readNumber(count)) {
+                return false;
+            }
+            counts_[length] = count;
+            codeCount_ += count;
+            base += count;
+            if (codeCount_ > 256 || base > (1u << length)) {
+                return false;
+            }
+            limit = count ? (base << (16 - length)) & 0xffff : 0;
+            limits_[length] = limit;
+        } while (!count || limit);
+        longest_ = length;
+        limits_[longest_] = 0xffffffff;
+
+        // Symbols in code order, each given as how many unused byte values to
+        // leap over from the previous one
+        bool used[256] = {};
+        unsigned char next = 255;
+        for (uint32_t i = 0; i < codeCount_; ++i) {
+            uint32_t leap;
+            if (!readNumber(leap)) {
+                return false;
+            }
+            leap = leap % (256 - i) + 1;
+            do {
+                ++next;
+                if (!used[next]) {
+                    --leap;
+                }
+            } while (leap);
+            used[next] = true;
+            symbols_[i] = next;
+        }
+
+        // Codes of up to 8 bits straight from the next byte of input; the clue
+        // and longer codes are left at zero length for the slow path
+        std::memset(quickLengths_, 0, sizeof(quickLengths_));
+        size_t entry = 0;
+        size_t symbol = 0;
+        for (int bits = 1; bits <= std::min(longest_, 8); ++bits) {
+            size_t entries = size_t(1) << (8 - bits);
+            for (uint32_t i = 0; i < counts_[bits]; ++i, ++symbol) {
+                unsigned char code = symbols_[symbol];
+                for (size_t j = 0; j < entries; ++j, ++entry) {
+                    quickSymbols_[entry] = code;
+                    quickLengths_[entry] = code == clue_ ? 0 : static_cast<unsigned char>(bits);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool readSymbol(unsigned char& symbol) {
+        uint32_t head = bits_.peek(16);
+        int length = 1;
+        while (head >= limits_[length]) {
+            ++length;
+        }
+        uint32_t index = (head >> (16 - length)) - deltas_[length];
+        if (index >= codeCount_) {
+            return false;
+        }
+        bits_.consume(length);
+        symbol = symbols_[index];
+        return true;
+    }
+
+    Progress decodeSymbols(Output& out, size_t want) {
+        while (out.size < want) {
+            if (run_) {
+                size_t count = std::min(run_, out.capacity - out.size);
+                if (!count) {
+                    return Progress::Failed;
+                }
+                std::memset(out.data + out.size, last_, count);
+                out.size += count;
+                run_ -= count;
+                continue;
+            }
+            // Short codes in a tight loop; bits read past the end are caught below
+            size_t stop = std::min(want, out.capacity);
+            uint32_t quick = bits_.peek(8);
+            if (quickLengths_[quick] && out.size < stop) {
+                do {
+                    bits_.consume(quickLengths_[quick]);
+                    out.data[out.size++] = quickSymbols_[quick];
+                    quick = bits_.peek(8);
+                } while (quickLengths_[quick] && out.size < stop);
+                last_ = out.data[out.size - 1];
+                hasLast_ = true;
+            }
+            if (bits_.overrun()) {
+                return Progress::Failed;
+            }
+            if (out.size >= want) {
+                break;
+            }
+            unsigned char symbol;
+            if (!readSymbol(symbol)) {
+                return Progress::Failed;
+            }
+            if (symbol == clue_) {
+                uint32_t run;
+                if (!readNumber(run)) {
+                    return Progress::Failed;
+                }
+                if (run) {
+                    if (!hasLast_) {
+                        return Progress::Failed;
+                    }
+                    run_ = run;
+                    continue;
+                }
+                // Zero: an end bit, or an explicit byte
+                if (bits_.get(1)) {
+                    return bits_.overrun() ? Progress::Failed : Progress::End;
+                }
+                symbol = static_cast<unsigned char>(bits_.get(8));
+            }
+            if (out.size == out.capacity) {
+                return Progress::Failed;
+            }
+            out.data[out.size++] = symbol;
+            last_ = symbol;
+            hasLast_ = true;
+        }
+        return Progress::More;
+    }
+
+    BitReader bits_;
+    uint32_t type_ = 0;
+    unsigned char clue_ = 0;
+    int longest_ = 0;
+    uint32_t codeCount_ = 0;
+    uint32_t counts_[17] = {};
+    uint32_t deltas_[17] = {};
+    uint32_t limits_[17] = {};
+    unsigned char symbols_[256] = {};
+    unsigned char quickSymbols_[256] = {};
+    unsigned char quickLengths_[256] = {};
+
+    size_t run_ = 0;
+    unsigned char last_ = 0;
+    bool hasLast_ = false;
+    unsigned int sum_ = 0;
+    unsigned int accumulated_ = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+bool readHeader(std::string_view data, Compression& compression, size_t& size) {
+    compression = compressionOf(data);
+    if (compression == Compression::None) {
+        size = data.size();
+        return true;
+    }
+    // Little-endian, as CompressionManager writes it on x86; negative sizes are corrupt
+    uint32_t bytes = static_cast<uint32_t>(static_cast<unsigned char>(data[4])) |
+                     static_cast<uint32_t>(static_cast<unsigned char>(data[5])) << 8 |
+                     static_cast<uint32_t>(static_cast<unsigned char>(data[6])) << 16 |
+                     static_cast<uint32_t>(static_cast<unsigned char>(data[7])) << 24;
+    size = bytes;
+    return bytes <= static_cast<uint32_t>(std::numeric_limits<int32_t>::max());
+}
+
+// Codec for the stream after the header, or null when the format is not
+// supported or its header does not agree with size
+std::unique_ptr<Codec> openCodec(Compression compression, std::string_view data, size_t size) {
+    std::string_view stream = data.substr(kHeaderSize);
+    std::unique_ptr<Codec> codec;
+    switch (compression) {
+    case Compression::RefPack:
+        codec = std::make_unique<RefPackCodec>(stream);
+        break;
+    case Compression::BTree:
+        codec = std::make_unique<BTreeCodec>(stream);
+        break;
+    case Compression::Huffman:
+        codec = std::make_unique<HuffmanCodec>(stream);
+        break;
+    default:
+        return nullptr;
+    }
+    if (codec->size() != static_cast<int64_t>(size)) {
+        return nullptr;
+    }
+    return codec;
+}
+
+} // namespace
+
+Compression compressionOf(std::string_view data) {
+    if (data.size() < kHeaderSize) {
+        return Compression::None;
+    }
+    std::string_view magic = data.substr(0, 4);
+    using namespace std::string_view_literals;
+    if (magic == "EAR\0"sv) {
+        return Compression::RefPack;
+    }
+    if (magic == "EAB\0"sv) {
+        return Compression::BTree;
+    }
+    if (magic == "EAH\0"sv) {
+        return Compression::Huffman;
+    }
+    if (magic == "NOX\0"sv) {
+        return Compression::NoxLzh;
+    }
+    if (magic[0] == 'Z' && magic[1] == 'L' && magic[2] >= '1' && magic[2] <= '9' && magic[3] == '\0') {
+        return Compression::ZLib;
+    }
+    return Compression::None;
+}
+
+bool decompress(std::string_view data, std::string& out) {
+    out.clear();
+    Compression compression;
+    size_t size;
+    if (!readHeader(data, compression, size)) {
+        return false;
+    }
+    if (compression == Compression::None) {
+        out.assign(data);
+        return true;
+    }
+    std::unique_ptr<Codec> codec = openCodec(compression, data, size);
+    if (!codec) {
+        return false;
+    }
+    out.resize(size);
+    Output output{reinterpret_cast<unsigned char*>(&out[0]), 0, size};
+    if (codec->decode(output, kUntilEnd) != Progress::End || output.size != size) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+Decompressor::Decompressor(std::string_view data) : data_(data) {
+    if (!readHeader(data, compression_, size_)) {
+        size_ = 0;
+        failed_ = true;
+        return;
+    }
+    if (compression_ == Compression::None) {
+        return;
+    }
+    codec_ = openCodec(compression_, data, size_);
+    if (!codec_) {
+        failed_ = true;
+        return;
+    }
+    window_.resize(std::min(size_, kHistory + kChunk + kSlack));
+}
+
+Decompressor::~Decompressor() = default;
+
+size_t Decompressor::read(char* out, size_t capacity) {
+    return take(out, capacity);
+}
+
+bool Decompressor::skip(size_t count) {
+    return take(nullptr, count) == count;
+}
+
+size_t Decompressor::take(char* out, size_t count) {
+    if (compression_ == Compression::None) {
+        count = std::min(count, size_ - position_);
+        if (out) {
+            std::memcpy(out, data_.data() + position_, count);
+        }
+        position_ += count;
+        return count;
+    }
+    size_t taken = 0;
+    while (taken < count) {
+        if (windowRead_ == windowSize_ && !fill()) {
+            break;
+        }
+        size_t part = std::min(count - taken, windowSize_ - windowRead_);
+        if (out) {
+            std::memcpy(out + taken, window_.data() + windowRead_, part);
+        }
+        windowRead_ += part;
+        taken += part;
+    }
+    position_ += taken;
+    return taken;
+}
+
+bool Decompressor::fill() {
+    if (ended_ || failed_ || !codec_) {
+        return false;
+    }
+    // Keep only what later copies can reach once the window runs short of room
+    if (windowSize_ > kHistory && window_.size() - windowSize_ < kChunk + kSlack) {
+        size_t drop = windowSize_ - kHistory;
+        std::memmove(window_.data(), window_.data() + drop, kHistory);
+        dropped_ += drop;
+        windowSize_ = kHistory;
+        windowRead_ = kHistory;
+    }
+
+    size_t remaining = size_ - dropped_ - windowSize_;
+    Output output{window_.data(), windowSize_, windowSize_ + std::min(remaining, window_.size() - windowSize_)};
+    // With everything decoded, one more call reads the end of the stream
+    size_t want = remaining ? std::min(output.capacity, windowSize_ + kChunk) : kUntilEnd;
+    Progress progress = codec_->decode(output, want);
+    windowSize_ = output.size;
+    if (progress == Progress::Failed || (progress == Progress::End && dropped_ + windowSize_ != size_)) {
+        failed_ = true;
+    }
+    ended_ = progress != Progress::More;
+    return windowSize_ > windowRead_;
+}
+
+} // namespace Vfs
+} // namespace ZeroSyntax
@@ -0,0 +1,30 @@
+#include "vfs/game_path.hpp"
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+std::string normalizeGamePath(std::string_view path) {
+    std::string result;
+    result.reserve(path.size());
+    appendGamePath(result, path);
+    return result;
+}
+
+void appendGamePath(std::string& out, std::string_view path) {
+    size_t start = out.size();
+    for (char c : path) {
+        if (c == '\\' || c == '/') {
+            if (out.size() > start && out.back() != '/') {
+                out.push_back('/');
+            }
+        } else {
+            out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+    }
+    if (out.size() > start && out.back() == '/') {
+        out.pop_back();
+    }
+}
+
+} // namespace Vfs
+} // namespace ZeroSyntax
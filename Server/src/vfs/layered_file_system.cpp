@@ -0,0 +1,339 @@
+#include "vfs/layered_file_system.hpp"
+#include "vfs/game_path.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace ZeroSyntax {
+namespace Vfs {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// One ini.load or ini.loadDirectory call
+struct LoadStep {
+    const char* path;
+    bool directory;
+    bool checksummed;  // loaded with GameEngine::init's XferCRC
+};
+
+// INI files read at startup, ordered as GameEngine::init brings up the
+// subsystems that load them; a store's Default\ file always precedes its
+// override. Debug-only files are left out.
+constexpr LoadStep kLoadPlan[] = {
+    {"Data\\INI\\GameLOD.ini", false, false},
+    {"Data\\INI\\GameLODPresets.ini", false, false},
+    {"Data\\INI\\Default\\GameData.ini", false, true},
+    {"Data\\INI\\GameData.ini", false, true},
+    {"Data\\INI\\Default\\Water.ini", false, true},
+    {"Data\\INI\\Water.ini", false, true},
+    {"Data\\INI\\Default\\Weather.ini", false, true},
+    {"Data\\INI\\Weather.ini", false, true},
+    {"Data\\INI\\Default\\Science.ini", false, true},
+    {"Data\\INI\\Science.ini", false, true},
+    {"Data\\INI\\Default\\Multiplayer.ini", false, true},
+    {"Data\\INI\\Multiplayer.ini", false, true},
+    {"Data\\INI\\Default\\Terrain.ini", false, true},
+    {"Data\\INI\\Terrain.ini", false, true},
+    {"Data\\INI\\Default\\Roads.ini", false, true},
+    {"Data\\INI\\Roads.ini", false, true},
+    {"Data\\INI\\AudioSettings.ini", false, false},
+    {"Data\\INI\\Default\\Music.ini", false, false},
+    {"Data\\INI\\Music.ini", false, false},
+    {"Data\\INI\\Default\\SoundEffects.ini", false, false},
+    {"Data\\INI\\SoundEffects.ini", false, false},
+    {"Data\\INI\\Default\\Speech.ini", false, false},
+    {"Data\\INI\\Speech.ini", false, false},
+    {"Data\\INI\\Default\\Voice.ini", false, false},
+    {"Data\\INI\\Voice.ini", false, false},
+    {"Data\\INI\\MiscAudio.ini", false, false},
+    {"Data\\INI\\Rank.ini", false, true},
+    {"Data\\INI\\Default\\PlayerTemplate.ini", false, true},
+    {"Data\\INI\\PlayerTemplate.ini", false, true},
+    {"Data\\INI\\ParticleSystem.ini", false, false},
+    {"Data\\INI\\Default\\FXList.ini", false, true},
+    {"Data\\INI\\FXList.ini", false, true},
+    {"Data\\INI\\Weapon.ini", false, true},
+    {"Data\\INI\\Default\\ObjectCreationList.ini", false, true},
+    {"Data\\INI\\ObjectCreationList.ini", false, true},
+    {"Data\\INI\\Locomotor.ini", false, true},
+    {"Data\\INI\\Default\\SpecialPower.ini", false, true},
+    {"Data\\INI\\SpecialPower.ini", false, true},
+    {"Data\\INI\\DamageFX.ini", false, true},
+    {"Data\\INI\\Armor.ini", false, true},
+    {"Data\\INI\\Default\\Object.ini", false, true},
+    {"Data\\INI\\Object", true, true},
+    {"Data\\INI\\Default\\Upgrade.ini", false, true},
+    {"Data\\INI\\Upgrade.ini", false, true},
+    {"Data\\INI\\DrawGroupInfo.ini", false, false},
+    {"Data\\INI\\MappedImages\\TextureSize_512", true, false},
+    {"Data\\INI\\MappedImages\\HandCreated", true, false},
+    {"Data\\INI\\Animation2D.ini", false, false},
+    {"Data\\INI\\InGameUI.ini", false, false},
+    {"Data\\INI\\WindowTransitions.ini", false, false},
+    {"Data\\INI\\Default\\CommandButton.ini", false, false},
+    {"Data\\INI\\CommandButton.ini", false, false},
+    {"Data\\INI\\CommandSet.ini", false, false},
+    {"Data\\INI\\Default\\ControlBarScheme.ini", false, false},
+    {"Data\\INI\\ControlBarScheme.ini", false, false},
+    {"Data\\INI\\Default\\ShellMenuScheme.ini", false, false},
+    {"Data\\INI\\ShellMenuScheme.ini", false, false},
+    {"Data\\INI\\ControlBarResizer.ini", false, false},
+    {"Data\\INI\\Mouse.ini", false, false},
+    {"Data\\INI\\Eva.ini", false, false},
+    {"Data\\INI\\Default\\Video.ini", false, false},
+    {"Data\\INI\\Video.ini", false, false},
+    {"Data\\INI\\Campaign.ini", false, false},
+    {"Data\\INI\\ChallengeMode.ini", false, false},
+    {"Data\\INI\\Credits.ini", false, false},
+    {"Data\\INI\\Webpages.ini", false, false},
+    {"Data\\INI\\Default\\AIData.ini", false, true},
+    {"Data\\INI\\AIData.ini", false, true},
+    {"Data\\INI\\Default\\Crate.ini", false, true},
+    {"Data\\INI\\Crate.ini", false, true},
+    {"Data\\INI\\CommandMap.ini", false, false},
+};
+
+// Map-local INIs GameLogic::startNewGame loads next to "Maps\Name\Name.map"
+constexpr const char* kMapIniNames[] = {"map.ini", "solo.ini"};
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool startsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+    if (text.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// FilenameList order: _stricmp over the engine's backslash-separated
+// paths. Normalized paths use '/', which sorts before digits where '\\'
+// sorts after them, so "civ/a.ini" must still follow "civ2/b.ini".
+bool filenameListLess(const std::string& a, const std::string& b) {
+    auto key = [](char c) {
+        return c == '/' ? '\\' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    };
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [&](char x, char y) {
+        return static_cast<unsigned char>(key(x)) < static_cast<unsigned char>(key(y));
+    });
+}
+
+} // namespace
+
+void LayeredFileSystem::addDirectory(const std::string& root) {
+    std::error_code error;
+    fs::path directory = fs::absolute(root, error).lexically_normal();
+    uint32_t layer = static_cast<uint32_t>(layers_.size());
+    Layer loose{directory.generic_string(), nullptr, {}};
+
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        std::error_code statError;
+        if (it->is_regular_file(statError)) {
+            std::string relative = it->path().lexically_relative(directory).generic_string();
+            std::string path = normalizeGamePath(relative);
+            if (loose.files.emplace(path, std::move(relative)).second) {
+                addSource(path, FileSource{layer, nullptr});
+            }
+        }
+    }
+    size_t count = loose.files.size();
+    layers_.push_back(std::move(loose));
+    if (error) {
+        LOG_WARN("Stopped scanning {}: {}", root, error.message());
+    }
+    rebuildLoadOrder();
+    LOG_INFO("Added {} loose files from {}", count, root);
+}
+
+bool LayeredFileSystem::addArchive(const std::string& path) {
+    auto archive = std::make_unique<BigArchive>();
+    if (!archive->open(path)) {
+        return false;
+    }
+    addArchiveLayer(std::move(archive), path);
+    rebuildLoadOrder();
+    return true;
+}
+
+size_t LayeredFileSystem::addArchiveDirectory(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        std::error_code statError;
+        if (it->is_regular_file(statError) && normalizeGamePath(it->path().extension().string()) == ".big") {
+            paths.push_back(it->path().string());
+        }
+    }
+    // FilenameList is a std::set ordered with less_than_nocase
+    std::sort(paths.begin(), paths.end(), [](const std::string& a, const std::string& b) {
+        return filenameListLess(normalizeGamePath(a), normalizeGamePath(b));
+    });
+
+    size_t added = 0;
+    for (const auto& path : paths) {
+        auto archive = std::make_unique<BigArchive>();
+        if (archive->open(path)) {
+            addArchiveLayer(std::move(archive), path);
+            ++added;
+        }
+    }
+    rebuildLoadOrder();
+    LOG_INFO("Added {} archives from {}", added, directory);
+    return added;
+}
+
+const FileSource* LayeredFileSystem::resolve(std::string_view path) const {
+    auto it = files_.find(normalizeGamePath(path));
+    return it != files_.end() ? &it->second.front() : nullptr;
+}
+
+std::vector<FileSource> LayeredFileSystem::sources(std::string_view path) const {
+    auto it = files_.find(normalizeGamePath(path));
+    return it != files_.end() ? it->second : std::vector<FileSource>();
+}
+
+bool LayeredFileSystem::read(const FileSource& source, std::string_view path, std::string& text) const {
+    const Layer& layer = layers_[source.layer];
+    if (source.entry) {
+        std::string_view contents = layer.archive->contents(*source.entry);
+        text.assign(contents.data(), contents.size());
+        return true;
+    }
+    std::ifstream file(physicalPath(source, path), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+std::string LayeredFileSystem::physicalPath(const FileSource& source, std::string_view path) const {
+    const Layer& layer = layers_[source.layer];
+    if (source.entry) {
+        return layer.path;
+    }
+    auto file = layer.files.find(normalizeGamePath(path));
+    return layer.path + "/" + (file != layer.files.end() ? file->second : std::string(path));
+}
+
+std::vector<std::string> LayeredFileSystem::listDirectory(std::string_view directory,
+                                                          std::string_view extension) const {
+    std::string prefix = normalizeGamePath(directory);
+    if (!prefix.empty()) {
+        prefix.push_back('/');
+    }
+    std::string suffix = normalizeGamePath(extension);
+
+    std::vector<std::string> paths;
+    for (const auto& file : files_) {
+        if (file.first.compare(0, prefix.size(), prefix) == 0 && endsWith(file.first, suffix)) {
+            paths.push_back(file.first);
+        }
+    }
+    std::sort(paths.begin(), paths.end(), filenameListLess);
+    std::stable_partition(paths.begin(), paths.end(), [&](const std::string& path) {
+        return path.find('/', prefix.size()) == std::string::npos;
+    });
+    return paths;
+}
+
+std::optional<uint32_t> LayeredFileSystem::loadRank(std::string_view path) const {
+    auto it = ranks_.find(normalizeGamePath(path));
+    if (it == ranks_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<std::string> LayeredFileSystem::gamePathOf(const std::string& filePath) const {
+    std::error_code error;
+    std::string path = fs::absolute(filePath, error).lexically_normal().generic_string();
+    for (const auto& layer : layers_) {
+        if (layer.archive || !startsWithIgnoreCase(path, layer.path)) {
+            continue;
+        }
+        if (path.size() > layer.path.size() && path[layer.path.size()] == '/') {
+            return normalizeGamePath(std::string_view(path).substr(layer.path.size() + 1));
+        }
+    }
+    return std::nullopt;
+}
+
+void LayeredFileSystem::addArchiveLayer(std::unique_ptr<BigArchive> archive, const std::string& path) {
+    uint32_t layer = static_cast<uint32_t>(layers_.size());
+    for (const BigEntry& entry : archive->entries()) {
+        addSource(std::string(entry.path), FileSource{layer, &entry});
+    }
+    LOG_INFO("Added {} files from {}", archive->entries().size(), path);
+    layers_.push_back(Layer{path, std::move(archive), {}});
+}
+
+void LayeredFileSystem::addSource(const std::string& path, FileSource source) {
+    // Loose files first, then by the order their layers were added
+    auto& copies = files_[path];
+    auto position = std::upper_bound(copies.begin(), copies.end(), source,
+                                     [](const FileSource& a, const FileSource& b) {
+                                         bool looseA = a.entry == nullptr;
+                                         bool looseB = b.entry == nullptr;
+                                         return looseA != looseB ? looseA : a.layer < b.layer;
+                                     });
+    copies.insert(position, source);
+}
+
+void LayeredFileSystem::rebuildLoadOrder() {
+    loadOrder_.clear();
+    ranks_.clear();
+    auto append = [this](const std::string& path, LoadMode mode, bool checksummed) {
+        if (ranks_.emplace(path, static_cast<uint32_t>(loadOrder_.size())).second) {
+            loadOrder_.push_back(LoadedFile{path, mode, checksummed});
+        }
+    };
+
+    for (const LoadStep& step : kLoadPlan) {
+        if (step.directory) {
+            for (const auto& path : listDirectory(step.path, ".ini")) {
+                append(path, LoadMode::Overwrite, step.checksummed);
+            }
+        } else if (std::string path = normalizeGamePath(step.path); files_.count(path)) {
+            append(path, LoadMode::Overwrite, step.checksummed);
+        }
+    }
+
+    // "maps/<name>/map.ini", then solo.ini, per map
+    std::vector<std::string> maps;
+    for (const auto& file : files_) {
+        std::string_view path = file.first;
+        size_t slash = path.find('/', 5);
+        if (path.compare(0, 5, "maps/") != 0 || slash == std::string_view::npos ||
+            path.find('/', slash + 1) != std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = path.substr(slash + 1);
+        if (std::find(std::begin(kMapIniNames), std::end(kMapIniNames), name) != std::end(kMapIniNames)) {
+            maps.push_back(file.first);
+        }
+    }
+    // Per map, map.ini sorts before solo.ini
+    std::sort(maps.begin(), maps.end());
+    for (const auto& path : maps) {
+        append(path, LoadMode::CreateOverrides, false);
+    }
+}
+
+} // namespace Vfs
+} // namespace ZeroSyntax
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "vfs/big_archive.hpp"
+#include "vfs/game_path.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using namespace ZeroSyntax::Vfs;
+namespace fs = std::filesystem;
+
+void putBigEndian(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+// A BIGF archive holding files in the given order
+std::string makeArchive(const std::vector<std::pair<std::string, std::string>>& files) {
+    size_t directorySize = 16;
+    for (const auto& file : files) {
+        directorySize += 8 + file.first.size() + 1;
+    }
+    std::string archive = "BIGF";
+    archive.append(4, '\0');
+    putBigEndian(archive, static_cast<uint32_t>(files.size()));
+    putBigEndian(archive, static_cast<uint32_t>(directorySize));
+    size_t offset = directorySize;
+    for (const auto& file : files) {
+        putBigEndian(archive, static_cast<uint32_t>(offset));
+        putBigEndian(archive, static_cast<uint32_t>(file.second.size()));
+        archive += file.first;
+        archive.push_back('\0');
+        offset += file.second.size();
+    }
+    for (const auto& file : files) {
+        archive += file.second;
+    }
+    return archive;
+}
+
+class BigArchiveTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (fs::temp_directory_path() / "zs_big_archive_test.big").string();
+    }
+
+    void TearDown() override {
+        fs::remove(path);
+    }
+
+    void write(const std::string& bytes) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    }
+
+    std::string path;
+};
+
+TEST(GamePathTest, Normalize) {
+    EXPECT_EQ(normalizeGamePath("Data\\INI\\Object\\AmericaTank.ini"), "data/ini/object/americatank.ini");
+    EXPECT_EQ(normalizeGamePath("\\Data//INI\\"), "data/ini");
+    EXPECT_EQ(normalizeGamePath(""), "");
+}
+
+TEST_F(BigArchiveTest, ReadsTheDirectory) {
+    write(makeArchive({{"Data\\INI\\Weapon.ini", "Weapon Gun\nEnd\n"},
+                       {"Data\\INI\\Object\\Tank.ini", "Object Tank\nEnd\n"},
+                       {"Art\\Textures\\tank.tga", "TGA"},
+                       {"Data\\INI\\Default\\Weapon.ini", "; defaults\n"}}));
+
+    BigArchive archive;
+    ASSERT_TRUE(archive.open(path));
+    ASSERT_EQ(archive.entries().size(), 4u);
+    EXPECT_EQ(archive.entries()[0].path, "art/textures/tank.tga");
+
+    const BigEntry* weapon = archive.find("DATA/ini\\weapon.INI");
+    ASSERT_NE(weapon, nullptr);
+    EXPECT_EQ(archive.contents(*weapon), "Weapon Gun\nEnd\n");
+    EXPECT_EQ(archive.find("Data\\INI\\Missing.ini"), nullptr);
+
+    auto ini = archive.entriesUnder("Data\\INI");
+    std::vector<std::string_view> paths;
+    for (const BigEntry* entry = ini.first; entry != ini.second; ++entry) {
+        paths.push_back(entry->path);
+    }
+    EXPECT_THAT(paths, ::testing::ElementsAre("data/ini/default/weapon.ini", "data/ini/object/tank.ini",
+                                              "data/ini/weapon.ini"));
+    auto objects = archive.entriesUnder("data/ini/object/");
+    EXPECT_EQ(objects.second - objects.first, 1);
+    auto all = archive.entriesUnder("");
+    EXPECT_EQ(all.second - all.first, 4);
+}
+
+TEST_F(BigArchiveTest, LaterDuplicateWins) {
+    write(makeArchive({{"Data\\INI\\Weapon.ini", "old"}, {"data/ini/weapon.ini", "new"}}));
+
+    BigArchive archive;
+    ASSERT_TRUE(archive.open(path));
+    ASSERT_EQ(archive.entries().size(), 1u);
+    EXPECT_EQ(archive.contents(*archive.find("data/ini/weapon.ini")), "new");
+}
+
+TEST_F(BigArchiveTest, RejectsDamagedArchives) {
+    BigArchive archive;
+    EXPECT_FALSE(archive.open(path));
+
+    write("NOTABIGFILE.....");
+    EXPECT_FALSE(archive.open(path));
+    EXPECT_TRUE(archive.entries().empty());
+
+    // Records past the end of the file are dropped, a cut directory ends the listing
+    std::string bytes = makeArchive({{"a.ini", "aaaa"}, {"b.ini", "bbbb"}});
+    write(bytes.substr(0, bytes.size() - 2));
+    ASSERT_TRUE(archive.open(path));
+    ASSERT_EQ(archive.entries().size(), 1u);
+    EXPECT_EQ(archive.entries()[0].path, "a.ini");
+
+    write(bytes.substr(0, 30));
+    ASSERT_TRUE(archive.open(path));
+    EXPECT_TRUE(archive.entries().empty());
+}
+
+} // namespace
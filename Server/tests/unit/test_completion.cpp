@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "ini/completion.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace ZeroSyntax;
+
+const char* kSource =
+    "Object Tank\n"
+    "  KindOf = SELECTABLE VEH\n"                       // 1
+    "  IsTrainable = \n"                                // 2
+    "  Body = ActiveBody ModuleTag_01\n"                // 3
+    "    MaxHealth = 300.0\n"
+    "    \n"                                            // 5
+    "  End\n"
+    "  Behavior = SlowDeathBehavior ModuleTag_02\n"     // 7
+    "    DeathTypes = ALL -CRU\n"                       // 8
+    "  End\n"
+    "  ; comment\n"                                     // 10
+    "End\n"
+    "\n";                                               // 12
+
+class CompletionTest : public ::testing::Test {
+protected:
+    Ini::SyntaxTree tree = Ini::SyntaxTree::parse(kSource);
+
+    Ini::CompletionContext contextAt(int line, int character) {
+        size_t offset = 0;
+        std::string source = kSource;
+        for (int i = 0; i < line; ++i) {
+            offset = source.find('\n', offset) + 1;
+        }
+        offset += character;
+        size_t sectionIndex = tree.findSection(offset);
+        return Ini::completionContext(tree.section(sectionIndex),
+                                      static_cast<uint32_t>(offset - tree.sectionOffset(sectionIndex)));
+    }
+
+    std::vector<std::string> labels(const Ini::CompletionContext& context) {
+        std::vector<std::string> result;
+        for (const Ini::CandidateList* list : Ini::completionCandidates(context)) {
+            for (const Ini::Candidate& candidate : list->withPrefix(context.prefix)) {
+                result.emplace_back(candidate.label);
+            }
+        }
+        return result;
+    }
+};
+
+TEST_F(CompletionTest, ContextFollowsTheCursor) {
+    auto context = contextAt(0, 3);
+    EXPECT_EQ(context.site, Ini::CompletionSite::BlockType);
+    EXPECT_EQ(context.prefix, "Obj");
+
+    context = contextAt(1, 2);
+    EXPECT_EQ(context.site, Ini::CompletionSite::Field);
+    ASSERT_NE(context.table, nullptr);
+    EXPECT_NE(Ini::Schema::findField(*context.table, "KindOf"), nullptr);
+
+    context = contextAt(1, 25);
+    EXPECT_EQ(context.site, Ini::CompletionSite::Value);
+    EXPECT_EQ(context.field->token, "KindOf");
+    EXPECT_EQ(context.value, 1u);
+    EXPECT_EQ(context.prefix, "VEH");
+
+    context = contextAt(3, 9);
+    EXPECT_EQ(context.site, Ini::CompletionSite::ModuleName);
+    EXPECT_EQ(context.prefix, "");
+
+    // A line without a node takes the fields of the block around it
+    context = contextAt(5, 4);
+    EXPECT_EQ(context.site, Ini::CompletionSite::Field);
+    ASSERT_NE(context.table, nullptr);
+    EXPECT_NE(Ini::Schema::findField(*context.table, "MaxHealth"), nullptr);
+
+    context = contextAt(8, 25);
+    EXPECT_EQ(context.site, Ini::CompletionSite::Value);
+    EXPECT_EQ(context.sign, '-');
+    EXPECT_EQ(context.prefix, "CRU");
+
+    EXPECT_EQ(contextAt(12, 0).site, Ini::CompletionSite::BlockType);
+    EXPECT_EQ(contextAt(0, 9).site, Ini::CompletionSite::None);   // the definition name
+    EXPECT_EQ(contextAt(3, 21).site, Ini::CompletionSite::None);  // the module tag
+    EXPECT_EQ(contextAt(10, 6).site, Ini::CompletionSite::None);  // a comment
+}
+
+TEST_F(CompletionTest, OffersWhatTheFieldAccepts) {
+    EXPECT_THAT(labels(contextAt(0, 3)), ::testing::IsSupersetOf({"Object", "ObjectReskin"}));
+    EXPECT_THAT(labels(contextAt(1, 2)), ::testing::IsSupersetOf({"KindOf", "Body", "End"}));
+    EXPECT_THAT(labels(contextAt(1, 25)), ::testing::ElementsAre("VEHICLE"));
+    EXPECT_THAT(labels(contextAt(1, 11)), ::testing::IsSupersetOf({"NONE", "SELECTABLE"}));
+    EXPECT_THAT(labels(contextAt(2, 16)), ::testing::ElementsAre("No", "Yes"));
+    EXPECT_THAT(labels(contextAt(8, 25)), ::testing::ElementsAre("CRUSHED"));
+    EXPECT_THAT(labels(contextAt(8, 18)), ::testing::ElementsAre("ALL"));
+
+    // Body takes body modules only and Behavior everything else
+    auto bodies = labels(contextAt(3, 9));
+    EXPECT_THAT(bodies, ::testing::Contains("ActiveBody"));
+    EXPECT_THAT(bodies, ::testing::Not(::testing::Contains("SlowDeathBehavior")));
+    auto behaviors = labels(contextAt(7, 13));
+    EXPECT_THAT(behaviors, ::testing::Contains("SlowDeathBehavior"));
+    EXPECT_THAT(behaviors, ::testing::Not(::testing::Contains("ActiveBody")));
+}
+
+TEST(CandidateListTest, SearchesSortedPrefixes) {
+    Ini::CandidateList list(Ini::CandidateKind::Name, {{"b", {}}, {"A", {}}, {"ab", {}}, {"a", {}}, {"B", {}}, {"a", {}}});
+    std::vector<std::string> all;
+    for (const auto& candidate : list.withPrefix("")) {
+        all.emplace_back(candidate.label);
+    }
+    EXPECT_THAT(all, ::testing::ElementsAre("A", "a", "ab", "B", "b"));
+    EXPECT_EQ(list.withPrefix("A").size(), 3u);
+    EXPECT_EQ(list.withPrefix("aB").size(), 1u);
+    EXPECT_TRUE(list.withPrefix("c").empty());
+}
+
+} // namespace
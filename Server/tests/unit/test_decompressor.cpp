@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+#include "vfs/decompressor.hpp"
+#include <random>
+
+namespace {
+
+using namespace ZeroSyntax::Vfs;
+
+// CompressionManager's header: the magic, then the size little-endian
+std::string withHeader(const char* magic, size_t size, const std::string& stream) {
+    std::string data(magic, 3);
+    data.push_back('\0');
+    for (int shift = 0; shift < 32; shift += 8) {
+        data.push_back(static_cast<char>((size >> shift) & 0xFF));
+    }
+    return data + stream;
+}
+
+void putBigEndian(std::string& out, uint32_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+// RefPack commands, keeping the bytes they stand for
+class RefPackWriter {
+public:
+    // Four to 112 bytes, a multiple of four
+    void literals(const std::string& bytes) {
+        commands_.push_back(static_cast<char>(0xE0 | ((bytes.size() - 4) >> 2)));
+        commands_ += bytes;
+        expected_ += bytes;
+    }
+
+    // Up to three literals, then length bytes from offset back
+    void copy(size_t offset, size_t length, const std::string& literals = "") {
+        size_t o = offset - 1;
+        size_t n = literals.size();
+        if (offset <= 1024 && length >= 3 && length <= 10) {
+            commands_.push_back(static_cast<char>(((o >> 8) << 5) | ((length - 3) << 2) | n));
+            commands_.push_back(static_cast<char>(o & 0xFF));
+        } else if (offset <= 16384 && length >= 4 && length <= 67) {
+            commands_.push_back(static_cast<char>(0x80 | (length - 4)));
+            commands_.push_back(static_cast<char>((n << 6) | (o >> 8)));
+            commands_.push_back(static_cast<char>(o & 0xFF));
+        } else {
+            commands_.push_back(static_cast<char>(0xC0 | ((o >> 16) << 4) | (((length - 5) >> 8) << 2) | n));
+            commands_.push_back(static_cast<char>((o >> 8) & 0xFF));
+            commands_.push_back(static_cast<char>(o & 0xFF));
+            commands_.push_back(static_cast<char>((length - 5) & 0xFF));
+        }
+        commands_ += literals;
+        expected_ += literals;
+        for (size_t i = 0; i < length; ++i) {
+            expected_.push_back(expected_[expected_.size() - offset]);
+        }
+    }
+
+    std::string finish(const std::string& literals = "") {
+        commands_.push_back(static_cast<char>(0xFC | literals.size()));
+        commands_ += literals;
+        expected_ += literals;
+        std::string stream;
+        putBigEndian(stream, 0x10fb, 2);
+        putBigEndian(stream, static_cast<uint32_t>(expected_.size()), 3);
+        return withHeader("EAR", expected_.size(), stream + commands_);
+    }
+
+    const std::string& expected() const { return expected_; }
+
+private:
+    std::string commands_;
+    std::string expected_;
+};
+
+// Bits most significant first, as huffencode.cpp writes them
+class BitWriter {
+public:
+    void put(uint32_t value, int count) {
+        for (int i = count - 1; i >= 0; --i) {
+            if (bits_ % 8 == 0) {
+                bytes_.push_back('\0');
+            }
+            if ((value >> i) & 1) {
+                bytes_.back() = static_cast<char>(bytes_.back() | (0x80 >> (bits_ % 8)));
+            }
+            ++bits_;
+        }
+    }
+
+    // As HUFF_writenum: n - 2 zeros, a one, then n bits counting from (1 << n) - 4
+    void number(uint32_t value) {
+        int n = 2;
+        while (value >= (1u << (n + 1)) - 4) {
+            ++n;
+        }
+        put(1, n - 1);
+        put(value - ((1u << n) - 4), n);
+    }
+
+    const std::string& bytes() const { return bytes_; }
+
+private:
+    std::string bytes_;
+    size_t bits_ = 0;
+};
+
+// Codes 'a' = 0, 'b' = 10 and the clue 0xF0 = 11, decoding to "aabbbbZ"
+std::string huffmanStream(uint32_t type) {
+    BitWriter bits;
+    bits.put(type, 16);
+    bits.put(7, 24);
+    bits.put(0xF0, 8);
+    bits.number(1);  // one 1-bit code
+    bits.number(2);  // two 2-bit codes
+    bits.number(0x61);  // 'a', 0x62 unused bytes on from 0xFF
+    bits.number(0);     // 'b'
+    bits.number(0x8D);  // 0xF0
+    bits.put(0b0010, 4);  // a a b
+    bits.put(0b11, 2);    // a run of three
+    bits.number(3);
+    bits.put(0b11, 2);  // an explicit byte
+    bits.number(0);
+    bits.put(0, 1);
+    bits.put('Z', 8);
+    bits.put(0b11, 2);  // the end
+    bits.number(0);
+    bits.put(1, 1);
+    return withHeader("EAH", 7, bits.bytes());
+}
+
+// Pair nodes 0x80 = ab, 0x81 = abab, 0x83 = 8 bytes, 0x84 = 16 and 0x85 = 32;
+// 0xFF escapes literals
+std::string btreeStream(const std::string& body, size_t size) {
+    std::string stream;
+    putBigEndian(stream, 0x46fb, 2);
+    putBigEndian(stream, static_cast<uint32_t>(size), 3);
+    stream.push_back('\xFF');
+    stream.push_back(5);
+    stream += std::string("\x80" "ab" "\x81\x80\x80" "\x83\x81\x81" "\x84\x83\x83" "\x85\x84\x84", 15);
+    return withHeader("EAB", size, stream + body);
+}
+
+std::string readAll(Decompressor& decompressor, size_t chunk) {
+    std::string out;
+    std::string buffer(chunk, '\0');
+    while (size_t read = decompressor.read(&buffer[0], chunk)) {
+        out.append(buffer, 0, read);
+    }
+    return out;
+}
+
+TEST(DecompressorTest, DetectsTheFormat) {
+    EXPECT_EQ(compressionOf(withHeader("EAR", 0, "")), Compression::RefPack);
+    EXPECT_EQ(compressionOf(withHeader("EAB", 0, "")), Compression::BTree);
+    EXPECT_EQ(compressionOf(withHeader("EAH", 0, "")), Compression::Huffman);
+    EXPECT_EQ(compressionOf(withHeader("NOX", 0, "")), Compression::NoxLzh);
+    EXPECT_EQ(compressionOf(withHeader("ZL5", 0, "")), Compression::ZLib);
+    EXPECT_EQ(compressionOf(withHeader("ZL0", 0, "")), Compression::None);
+    EXPECT_EQ(compressionOf("EAR"), Compression::None);
+    EXPECT_EQ(compressionOf("HeightMapData"), Compression::None);
+}
+
+TEST(DecompressorTest, RefPack) {
+    RefPackWriter small;
+    small.copy(3, 9, "abc");
+    std::string data = small.finish("X");
+    std::string out;
+    ASSERT_TRUE(decompress(data, out));
+    EXPECT_EQ(out, "abcabcabcabcX");
+
+    // Copies from across the whole 128 KiB window, read in odd chunks
+    std::mt19937 random(22);
+    RefPackWriter large;
+    for (int i = 0; i < 1500; ++i) {
+        std::string bytes(112, '\0');
+        for (char& c : bytes) {
+            c = static_cast<char>(random());
+        }
+        large.literals(bytes);
+    }
+    for (int i = 0; i < 600; ++i) {
+        large.copy(131072 - random() % 1000, 5 + random() % 1024);
+        large.copy(1 + random() % 1024, 3 + random() % 8, std::string(random() % 4, 'q'));
+        large.copy(1 + random() % 16384, 4 + random() % 64);
+    }
+    data = large.finish();
+    ASSERT_TRUE(decompress(data, out));
+    EXPECT_EQ(out, large.expected());
+
+    for (size_t chunk : {size_t(1) << 20, size_t(4093), size_t(7)}) {
+        Decompressor decompressor(data);
+        EXPECT_EQ(decompressor.compression(), Compression::RefPack);
+        EXPECT_EQ(decompressor.size(), large.expected().size());
+        EXPECT_EQ(readAll(decompressor, chunk), large.expected());
+        EXPECT_FALSE(decompressor.failed());
+    }
+
+    Decompressor skipping(data);
+    ASSERT_TRUE(skipping.skip(300000));
+    std::string tail = readAll(skipping, 65536);
+    EXPECT_EQ(tail, large.expected().substr(300000));
+    EXPECT_EQ(skipping.position(), large.expected().size());
+    EXPECT_FALSE(skipping.skip(1));
+}
+
+TEST(DecompressorTest, BTree) {
+    std::string data = btreeStream(std::string("\x80\x81" "c\xFF\x80\xFF\x00", 7), 8);
+    std::string out;
+    ASSERT_TRUE(decompress(data, out));
+    EXPECT_EQ(out, "abababc\x80");
+
+    // Expansions too long for the table go through the stack
+    std::string thirtyTwo;
+    for (int i = 0; i < 16; ++i) {
+        thirtyTwo += "ab";
+    }
+    data = btreeStream(std::string("\x85" "c\x84\xFF\x00", 5), 49);
+    ASSERT_TRUE(decompress(data, out));
+    EXPECT_EQ(out, thirtyTwo + "c" + thirtyTwo.substr(0, 16));
+    Decompressor decompressor(data);
+    EXPECT_EQ(readAll(decompressor, 3), out);
+    EXPECT_FALSE(decompressor.failed());
+}
+
+TEST(DecompressorTest, Huffman) {
+    std::string out;
+    ASSERT_TRUE(decompress(huffmanStream(0x30fb), out));
+    EXPECT_EQ(out, "aabbbbZ");
+
+    // Delta coded: runs repeat the byte before the sums are taken
+    std::string sums;
+    unsigned char sum = 0;
+    for (char c : std::string("aabbbbZ")) {
+        sum = static_cast<unsigned char>(sum + c);
+        sums.push_back(static_cast<char>(sum));
+    }
+    ASSERT_TRUE(decompress(huffmanStream(0x32fb), out));
+    EXPECT_EQ(out, sums);
+
+    Decompressor decompressor(huffmanStream(0x32fb));
+    EXPECT_EQ(readAll(decompressor, 2), sums);
+    EXPECT_FALSE(decompressor.failed());
+}
+
+TEST(DecompressorTest, RejectsCorruptData) {
+    RefPackWriter refPack;
+    refPack.literals("abcd");
+    refPack.copy(4, 8);
+    std::vector<std::string> streams = {
+        refPack.finish(),
+        btreeStream(std::string("\x80\x81" "c\xFF\x80\xFF\x00", 7), 8),
+        huffmanStream(0x30fb),
+    };
+    std::string out;
+    for (const std::string& data : streams) {
+        ASSERT_TRUE(decompress(data, out));
+        // Every truncation fails, in one shot and streaming
+        for (size_t size = 8; size < data.size(); ++size) {
+            std::string truncated = data.substr(0, size);
+            EXPECT_FALSE(decompress(truncated, out)) << size;
+            EXPECT_TRUE(out.empty());
+            Decompressor decompressor(truncated);
+            readAll(decompressor, 5);
+            EXPECT_TRUE(decompressor.failed()) << size;
+        }
+        // A header size the stream does not agree with
+        std::string resized = data;
+        resized[4] = static_cast<char>(resized[4] + 1);
+        EXPECT_FALSE(decompress(resized, out));
+    }
+
+    // A copy from before the start
+    std::string early;
+    putBigEndian(early, 0x10fb, 2);
+    putBigEndian(early, 8, 3);
+    early += std::string("\xE0" "abcd" "\x04\x04" "\xFC", 8);
+    EXPECT_FALSE(decompress(withHeader("EAR", 8, early), out));
+
+    // A node that contains itself
+    std::string looping;
+    putBigEndian(looping, 0x46fb, 2);
+    putBigEndian(looping, 4, 3);
+    looping += std::string("\xFF\x01" "\x86\x86" "a" "\x86\xFF\x00", 8);
+    EXPECT_FALSE(decompress(withHeader("EAB", 4, looping), out));
+
+    // Formats the game sources have no decoder for
+    Decompressor nox(withHeader("NOX", 4, "data"));
+    EXPECT_TRUE(nox.failed());
+    char buffer[4];
+    EXPECT_EQ(nox.read(buffer, 4), 0u);
+    EXPECT_FALSE(decompress(withHeader("ZL9", 4, "data"), out));
+
+    // Anything else is passed through
+    ASSERT_TRUE(decompress("HeightMapData", out));
+    EXPECT_EQ(out, "HeightMapData");
+    Decompressor plain("HeightMapData");
+    EXPECT_EQ(readAll(plain, 4), "HeightMapData");
+}
+
+} // namespace
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "core/definition_evaluator.hpp"
+#include <map>
+#include <thread>
+
+namespace {
+
+using namespace ZeroSyntax;
+
+const std::string kDefaults = "file:///Data/INI/Default/Object.ini";
+const std::string kRetail = "file:///Data/INI/Object/Tank.ini";
+const std::string kMap = "file:///Maps/Alpine/map.ini";
+
+class DefinitionEvaluatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        write(kDefaults,
+            "Object DefaultThingTemplate\n"
+            "  InheritableModule\n"
+            "    Behavior = AutoHealBehavior ModuleTag_DefaultAutoHeal\n"
+            "      HealingAmount = 1\n"
+            "    End\n"
+            "  End\n"
+            "End\n");
+        write(kRetail,
+            "Object Tank\n"
+            "  BuildCost = 800\n"
+            "  BuildTime = 10.0\n"
+            "  ArmorSet\n"
+            "    Conditions = None\n"
+            "    Armor = TankArmor\n"
+            "  End\n"
+            "  ArmorSet\n"
+            "    Conditions = PLAYER_UPGRADE\n"
+            "    Armor = UpgradedArmor\n"
+            "  End\n"
+            "  Draw = W3DTankDraw ModuleTag_01\n"
+            "    OkToChangeModelColor = Yes\n"
+            "  End\n"
+            "  Body = ActiveBody ModuleTag_02\n"
+            "    MaxHealth = 480.0\n"
+            "    MaxHealth = 500.0\n"
+            "  End\n"
+            "  Behavior = AIUpdateInterface ModuleTag_03\n"
+            "  End\n"
+            "  Behavior = SlowDeathBehavior ModuleTag_04\n"
+            "  End\n"
+            "End\n"
+            "ObjectReskin TankSkin Tank\n"
+            "  Draw = W3DTankDraw ModuleTag_Skin\n"
+            "  End\n"
+            "End\n");
+        write(kMap,
+            "Object Tank\n"
+            "  BuildCost = 1000\n"
+            "  ArmorSet\n"
+            "    Conditions = None\n"
+            "    Armor = MapArmor\n"
+            "  End\n"
+            "  RemoveModule ModuleTag_04\n"
+            "  ReplaceModule ModuleTag_01\n"
+            "    Draw = W3DTankDraw ModuleTag_05\n"
+            "    End\n"
+            "  End\n"
+            "  AddModule\n"
+            "    Behavior = JetAIUpdate ModuleTag_06\n"
+            "    End\n"
+            "  End\n"
+            "End\n");
+        loads[kDefaults] = LoadPosition{0, Vfs::LoadMode::Overwrite};
+        loads[kRetail] = LoadPosition{1, Vfs::LoadMode::Overwrite};
+        loads[kMap] = LoadPosition{2, Vfs::LoadMode::CreateOverrides};
+    }
+
+    void write(const std::string& uri, const std::string& text) {
+        trees[uri] = std::make_shared<const Ini::SyntaxTree>(Ini::SyntaxTree::parse(text));
+        index.updateFile(uri, WorkspaceIndex::collect(uri, *trees[uri]));
+    }
+
+    std::vector<std::string> tags(const EffectiveObject& object) {
+        std::vector<std::string> result;
+        for (const auto& module : object.modules) {
+            result.push_back(module.tag);
+        }
+        return result;
+    }
+
+    WorkspaceIndex index;
+    std::map<std::string, std::shared_ptr<const Ini::SyntaxTree>> trees;
+    std::map<std::string, LoadPosition> loads;
+    size_t treeLoads = 0;
+    std::function<void()> onLoad;  // runs as a tree is read
+    DefinitionEvaluator evaluator{
+        index,
+        [this](const std::string& uri) {
+            ++treeLoads;
+            if (onLoad) {
+                onLoad();
+            }
+            auto it = trees.find(uri);
+            return it != trees.end() ? it->second : nullptr;
+        },
+        [this](const std::string& uri) -> std::optional<LoadPosition> {
+            auto it = loads.find(uri);
+            return it != loads.end() ? std::optional<LoadPosition>(it->second) : std::nullopt;
+        }};
+};
+
+TEST_F(DefinitionEvaluatorTest, FoldsEveryLayer) {
+    auto tank = evaluator.evaluate("Tank");
+    ASSERT_NE(tank, nullptr);
+    ASSERT_EQ(tank->layers.size(), 3u);
+    EXPECT_EQ(tank->layers[0].uri, kDefaults);
+    EXPECT_EQ(tank->layers[1].uri, kRetail);
+    EXPECT_EQ(tank->layers[2].uri, kMap);
+
+    // The override replaces values and, having copied the template, the armor sets
+    ASSERT_NE(tank->findField("BuildCost"), nullptr);
+    EXPECT_EQ(tank->findField("BuildCost")->value, "1000");
+    EXPECT_EQ(tank->findField("BuildCost")->uri, kMap);
+    EXPECT_EQ(tank->findField("BuildCost")->range.start.line, 1);
+    EXPECT_EQ(tank->findField("BuildTime")->value, "10.0");
+    EXPECT_EQ(tank->findField("BuildTime")->uri, kRetail);
+    size_t armorSets = std::count_if(tank->fields.begin(), tank->fields.end(),
+                                     [](const EffectiveField& field) { return field.token == "ArmorSet"; });
+    EXPECT_EQ(armorSets, 1u);
+
+    // The inheritable default survives, RemoveModule and ReplaceModule drop by
+    // tag, and a new AI module replaces the old one
+    EXPECT_THAT(tags(*tank), ::testing::ElementsAre("ModuleTag_DefaultAutoHeal", "ModuleTag_02", "ModuleTag_05",
+                                                    "ModuleTag_06"));
+    const EffectiveModule* body = tank->findModule("ModuleTag_02");
+    ASSERT_NE(body, nullptr);
+    EXPECT_TRUE(body->inherited);
+    EXPECT_EQ(body->findField("MaxHealth")->value, "500.0");
+    EXPECT_FALSE(tank->findModule("ModuleTag_06")->inherited);
+}
+
+TEST_F(DefinitionEvaluatorTest, ReskinsCopyTheSourceAsLoaded) {
+    auto skin = evaluator.evaluate("TankSkin");
+    ASSERT_NE(skin, nullptr);
+    EXPECT_EQ(skin->reskinOf, "Tank");
+
+    // The map override of Tank comes later and does not reach the reskin;
+    // the reskin's Draw replaces the copied one
+    EXPECT_EQ(skin->findField("BuildCost")->value, "800");
+    EXPECT_THAT(tags(*skin), ::testing::ElementsAre("ModuleTag_DefaultAutoHeal", "ModuleTag_02", "ModuleTag_03",
+                                                    "ModuleTag_04", "ModuleTag_Skin"));
+    EXPECT_EQ(evaluator.evaluate("Missing"), nullptr);
+}
+
+TEST_F(DefinitionEvaluatorTest, UnloadedFilesFoldInIndexOrder) {
+    loads.clear();
+    auto tank = evaluator.evaluate("Tank");
+    ASSERT_NE(tank, nullptr);
+    // "file:///Data..." sorts before "file:///Maps...", and both continue one template
+    EXPECT_EQ(tank->findField("BuildCost")->value, "1000");
+    size_t armorSets = std::count_if(tank->fields.begin(), tank->fields.end(),
+                                     [](const EffectiveField& field) { return field.token == "ArmorSet"; });
+    EXPECT_EQ(armorSets, 3u);
+}
+
+TEST_F(DefinitionEvaluatorTest, InvalidatesAlongDependencies) {
+    ASSERT_NE(evaluator.evaluate("TankSkin"), nullptr);
+    ASSERT_NE(evaluator.evaluate("Tank"), nullptr);
+    EXPECT_EQ(evaluator.cachedCount(), 3u);  // with DefaultThingTemplate
+    size_t loaded = treeLoads;
+    evaluator.evaluate("TankSkin");
+    EXPECT_EQ(treeLoads, loaded);
+
+    // A file nothing was folded from
+    write("file:///Data/INI/Weapon.ini", "Weapon Gun\nEnd\n");
+    evaluator.invalidateFile("file:///Data/INI/Weapon.ini", {"Gun"});
+    EXPECT_EQ(evaluator.cachedCount(), 3u);
+
+    // Editing Tank drops Tank and the reskin copied from it, not the defaults
+    write(kMap, "Object Tank\n  BuildCost = 1200\nEnd\n");
+    evaluator.invalidateFile(kMap, {"Tank"});
+    EXPECT_EQ(evaluator.cachedCount(), 1u);
+    EXPECT_EQ(evaluator.evaluate("Tank")->findField("BuildCost")->value, "1200");
+
+    // Editing the defaults reaches everything created from them
+    write(kDefaults, "Object DefaultThingTemplate\n  BuildTime = 1.0\nEnd\n");
+    evaluator.invalidateFile(kDefaults, {"DefaultThingTemplate"});
+    EXPECT_EQ(evaluator.cachedCount(), 0u);
+    auto skin = evaluator.evaluate("TankSkin");
+    EXPECT_THAT(tags(*skin), ::testing::ElementsAre("ModuleTag_02", "ModuleTag_03", "ModuleTag_04",
+                                                    "ModuleTag_Skin"));
+
+    // A new block for a name is picked up even though nothing read its file
+    write("file:///Data/INI/Object/More.ini", "Object TankSkin\n  BuildCost = 5\nEnd\n");
+    loads["file:///Data/INI/Object/More.ini"] = LoadPosition{3, Vfs::LoadMode::Overwrite};
+    evaluator.invalidateFile("file:///Data/INI/Object/More.ini", {"TankSkin"});
+    EXPECT_EQ(evaluator.evaluate("TankSkin")->findField("BuildCost")->value, "5");
+}
+
+TEST_F(DefinitionEvaluatorTest, RefreshesDroppedObjects) {
+    ASSERT_NE(evaluator.evaluate("TankSkin"), nullptr);
+    write(kMap, "Object Tank\n  BuildCost = 1200\nEnd\n");
+    evaluator.invalidateFile(kMap, {"Tank"});
+    EXPECT_EQ(evaluator.find("Tank"), nullptr);
+    EXPECT_EQ(evaluator.find("TankSkin"), nullptr);
+
+    evaluator.refresh();
+    ASSERT_NE(evaluator.find("Tank"), nullptr);
+    EXPECT_EQ(evaluator.find("Tank")->findField("BuildCost")->value, "1200");
+    EXPECT_NE(evaluator.find("TankSkin"), nullptr);
+
+    // Nothing is left to do until the next edit
+    size_t loaded = treeLoads;
+    evaluator.refresh();
+    EXPECT_EQ(treeLoads, loaded);
+}
+
+TEST_F(DefinitionEvaluatorTest, ReadsFilesWithoutHoldingTheLock) {
+    // An edit arriving while a file is read neither waits for the read nor
+    // ends up in a result folded from the old text
+    bool edited = false;
+    onLoad = [&] {
+        if (edited) {
+            return;
+        }
+        edited = true;
+        std::thread editor([&] {
+            write(kMap, "Object Tank\n  BuildCost = 1200\nEnd\n");
+            evaluator.invalidateFile(kMap, {"Tank"});
+        });
+        editor.join();
+    };
+    auto tank = evaluator.evaluate("Tank");
+    ASSERT_NE(tank, nullptr);
+    EXPECT_TRUE(edited);
+    EXPECT_EQ(tank->findField("BuildCost")->value, "1200");
+}
+
+} // namespace
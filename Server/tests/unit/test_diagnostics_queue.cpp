@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "protocol/diagnostics_queue.hpp"
+
+namespace {
+
+using namespace ZeroSyntax;
+using namespace std::chrono_literals;
+using Clock = DiagnosticsQueue::Clock;
+
+LSP::Diagnostic diagnostic(int line, const std::string& message) {
+    return LSP::Diagnostic{LSP::Range{{line, 0}, {line, 4}}, LSP::DiagnosticSeverity::Error, message,
+                           std::string("ZeroSyntax")};
+}
+
+TEST(DiagnosticsQueueTest, CoalescesBurstsOfChanges) {
+    DiagnosticsQueue queue(150ms);
+    Clock::time_point start = Clock::now();
+    EXPECT_FALSE(queue.timeUntilDue(start).has_value());
+
+    // Each change restarts the wait
+    queue.schedule("file:///a.ini", start);
+    queue.schedule("file:///a.ini", start + 100ms);
+    queue.schedule("file:///a.ini", start + 200ms);
+    EXPECT_EQ(queue.pendingCount(), 1u);
+    EXPECT_TRUE(queue.takeDue(start + 300ms).empty());
+    EXPECT_EQ(queue.timeUntilDue(start + 300ms), Clock::duration(50ms));
+
+    EXPECT_THAT(queue.takeDue(start + 350ms), ::testing::ElementsAre("file:///a.ini"));
+    EXPECT_EQ(queue.pendingCount(), 0u);
+    EXPECT_TRUE(queue.takeDue(start + 1s).empty());
+}
+
+TEST(DiagnosticsQueueTest, OrdersDueDocumentsAndCancels) {
+    DiagnosticsQueue queue(100ms);
+    Clock::time_point start = Clock::now();
+    queue.schedule("file:///a.ini", start);
+    queue.schedule("file:///b.ini", start + 10ms);
+    queue.scheduleNow("file:///c.ini", start + 20ms);
+    queue.schedule("file:///d.ini", start + 20ms);
+    EXPECT_EQ(queue.timeUntilDue(start + 50ms), Clock::duration::zero());
+
+    queue.cancel("file:///d.ini");
+    EXPECT_THAT(queue.takeDue(start + 1s), ::testing::ElementsAre("file:///c.ini", "file:///a.ini", "file:///b.ini"));
+}
+
+TEST(DiagnosticsQueueTest, SkipsUnchangedResults) {
+    DiagnosticsQueue queue(0ms);
+    const std::string uri = "file:///a.ini";
+
+    // The client starts out with no diagnostics
+    EXPECT_FALSE(queue.update(uri, {}));
+    EXPECT_TRUE(queue.update(uri, {diagnostic(1, "bad")}));
+    EXPECT_FALSE(queue.update(uri, {diagnostic(1, "bad")}));
+    EXPECT_FALSE(queue.update("file:///b.ini", {}));
+
+    EXPECT_TRUE(queue.update(uri, {diagnostic(2, "bad")}));
+    EXPECT_TRUE(queue.update(uri, {diagnostic(2, "worse")}));
+    EXPECT_TRUE(queue.update(uri, {diagnostic(2, "worse"), diagnostic(3, "bad")}));
+    EXPECT_TRUE(queue.update(uri, {}));
+    EXPECT_FALSE(queue.update(uri, {}));
+
+    LSP::Diagnostic unattributed = diagnostic(1, "bad");
+    unattributed.source.reset();
+    EXPECT_NE(DiagnosticsQueue::hash({unattributed}), DiagnosticsQueue::hash({diagnostic(1, "bad")}));
+}
+
+} // namespace
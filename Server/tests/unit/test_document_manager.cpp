@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "core/document_manager.hpp"
+#include "utils/uri.hpp"
+#include <filesystem>
+#include <fstream>
 
 namespace {
 
@@ -37,6 +40,23 @@ TEST_F(DocumentManagerTest, UpdateDocument) {
     EXPECT_EQ(manager.getDocumentText(uri), newContent);
 }
 
+TEST_F(DocumentManagerTest, ApplyIncrementalChanges) {
+    manager.addDocument(uri, content, languageId);
+    
+    // Replace "Value" with "Other", then append a line
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent edit{ZeroSyntax::LSP::Range{{1, 4}, {1, 9}}, "Other"};
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent append{ZeroSyntax::LSP::Range{{1, 9}, {1, 9}}, "\nKey2=2"};
+    manager.applyChanges(uri, 2, {edit, append});
+    
+    EXPECT_EQ(manager.getDocumentText(uri), "[Section]\nKey=Other\nKey2=2");
+    
+    // A change without a range replaces the whole document
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent full{std::nullopt, "Replaced"};
+    manager.applyChanges(uri, 3, {full});
+    
+    EXPECT_EQ(manager.getDocumentText(uri), "Replaced");
+}
+
 TEST_F(DocumentManagerTest, RemoveDocument) {
     // Add a document
     manager.addDocument(uri, content, languageId);
@@ -52,15 +72,17 @@ TEST_F(DocumentManagerTest, RemoveDocument) {
 }
 
 TEST_F(DocumentManagerTest, ValidateDocument) {
-    // Add a document
-    manager.addDocument(uri, content, languageId);
-    
-    // Validate the document (initially should return no diagnostics for a valid document)
+    // A valid document has no diagnostics
+    manager.addDocument(uri, "Object Tank\n  BuildCost = 800\nEnd\n", languageId);
     auto diagnostics = manager.validateDocument(uri);
     EXPECT_TRUE(diagnostics.empty());
     
-    // Note: More complex validation tests would be added as you implement
-    // the INI parsing logic
+    // The sample content is no block the game knows, and is never closed
+    manager.updateDocument(uri, 2, content);
+    diagnostics = manager.validateDocument(uri);
+    ASSERT_EQ(diagnostics.size(), 2u);
+    EXPECT_EQ(diagnostics[0].severity, ZeroSyntax::LSP::DiagnosticSeverity::Error);
+    EXPECT_EQ(diagnostics[0].range.end.character, 9);
 }
 
 TEST_F(DocumentManagerTest, NonExistentDocument) {
@@ -83,7 +105,295 @@ TEST_F(DocumentManagerTest, NonExistentDocument) {
     
     // No completions should be provided
     auto completions = manager.provideCompletions(nonExistentUri, {0, 0});
-    EXPECT_TRUE(completions.empty());
+    EXPECT_TRUE(completions.items.empty());
+}
+
+TEST_F(DocumentManagerTest, FindDefinition) {
+    std::string objects = "file:///test/object.ini";
+    std::string weapons = "file:///test/weapon.ini";
+    manager.addDocument(weapons, "Weapon TankGun\n  PrimaryDamage = 10\nEnd\n", languageId);
+    manager.addDocument(objects,
+        "Object Tank\n"
+        "  WeaponSet\n"
+        "    Weapon = PRIMARY TankGun\n"
+        "  End\n"
+        "  Behavior = FireWeaponWhenDeadBehavior ModuleTag_01\n"
+        "    DeathWeapon = TankGun\n"
+        "  End\n"
+        "End\n"
+        "ObjectReskin TankSkin Tank\n"
+        "End\n", languageId);
+    
+    // A typed reference inside a module
+    auto definition = manager.findDefinition(objects, {5, 20});
+    ASSERT_TRUE(definition.has_value());
+    EXPECT_EQ(definition->uri, weapons);
+    EXPECT_EQ(definition->range.start.line, 0);
+    EXPECT_EQ(definition->range.start.character, 7);
+    
+    // A field parsed by custom code
+    definition = manager.findDefinition(objects, {2, 22});
+    ASSERT_TRUE(definition.has_value());
+    EXPECT_EQ(definition->uri, weapons);
+    
+    // The source of a reskin
+    definition = manager.findDefinition(objects, {8, 23});
+    ASSERT_TRUE(definition.has_value());
+    EXPECT_EQ(definition->uri, objects);
+    EXPECT_EQ(definition->range.start.line, 0);
+    
+    // Field names and unknown names have no definition
+    EXPECT_FALSE(manager.findDefinition(objects, {5, 6}).has_value());
+    EXPECT_FALSE(manager.findDefinition(objects, {2, 14}).has_value());
+    
+    // Edits are indexed as they happen
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent rename{ZeroSyntax::LSP::Range{{0, 7}, {0, 14}}, "Cannon"};
+    manager.applyChanges(weapons, 2, {rename});
+    EXPECT_FALSE(manager.findDefinition(objects, {5, 20}).has_value());
+    EXPECT_EQ(manager.workspaceIndex().findDefinitions("Weapon", "Cannon").size(), 1u);
+    
+    // Closing a document that is not on disk drops its definitions
+    manager.removeDocument(weapons);
+    EXPECT_TRUE(manager.workspaceIndex().findDefinitions("Weapon", "Cannon").empty());
+}
+
+TEST_F(DocumentManagerTest, ProvideCompletions) {
+    std::string weapons = "file:///test/weapon.ini";
+    std::string objects = "file:///test/object.ini";
+    manager.addDocument(weapons, "Weapon TankGun\nEnd\nWeapon TankCannon\nEnd\n", languageId);
+    manager.addDocument(objects,
+        "Object Tank\n"
+        "  Behavior = FireWeaponWhenDeadBehavior ModuleTag_01\n"
+        "    DeathWeapon = TankC\n"
+        "  End\n"
+        "  \n"
+        "End\n",
+        languageId);
+    
+    auto labels = [](const ZeroSyntax::LSP::CompletionList& list) {
+        std::vector<std::string> result;
+        for (const auto& item : list.items) {
+            result.push_back(item.label);
+        }
+        return result;
+    };
+    
+    // Definitions of the field's reference type
+    auto completions = manager.provideCompletions(objects, {2, 23});
+    EXPECT_FALSE(completions.isIncomplete);
+    EXPECT_THAT(labels(completions), ::testing::ElementsAre("TankCannon"));
+    EXPECT_EQ(completions.items[0].kind, 18);
+    
+    // Fields of the Object table and End on an empty line
+    completions = manager.provideCompletions(objects, {4, 2});
+    EXPECT_THAT(labels(completions), ::testing::Contains("BuildCost"));
+    EXPECT_THAT(labels(completions), ::testing::Contains("End"));
+    
+    // Block types below the last block
+    completions = manager.provideCompletions(objects, {6, 0});
+    EXPECT_THAT(labels(completions), ::testing::Contains("Object"));
+    
+    // Module names
+    completions = manager.provideCompletions(objects, {1, 22});
+    EXPECT_THAT(labels(completions), ::testing::Contains("FireWeaponWhenDeadBehavior"));
+}
+
+TEST_F(DocumentManagerTest, Hover) {
+    std::string objects = "file:///test/a_object.ini";
+    std::string patch = "file:///test/b_patch.ini";
+    manager.addDocument(objects,
+        "Weapon TankGun\n"
+        "  ClipReloadTime = 1000\n"
+        "End\n"
+        "Object Tank\n"
+        "  BuildCost = 800\n"
+        "  Behavior = FireWeaponWhenDeadBehavior ModuleTag_01\n"
+        "    DeathWeapon = TankGun\n"
+        "  End\n"
+        "End\n", languageId);
+    manager.addDocument(patch, "Object Tank\n  BuildCost = 900\nEnd\n", languageId);
+    manager.refreshDefinitions();
+    
+    // The value as the engine stores it, and the range of the token
+    auto hover = manager.hover(objects, {1, 5});
+    ASSERT_TRUE(hover.has_value());
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("INI::parseDurationUnsignedInt"));
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("1000 ms = 30 frames"));
+    ASSERT_TRUE(hover->range.has_value());
+    EXPECT_EQ(hover->range->start.character, 2);
+    EXPECT_EQ(hover->range->end.character, 16);
+    
+    // Where a reference is defined
+    hover = manager.hover(objects, {6, 20});
+    ASSERT_TRUE(hover.has_value());
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("Weapon TankGun: `/test/a_object.ini` line 1"));
+    
+    // The module a header names
+    hover = manager.hover(objects, {5, 4});
+    ASSERT_TRUE(hover.has_value());
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("Module **FireWeaponWhenDeadBehavior**"));
+    
+    // The value a later layer sets
+    hover = manager.hover(objects, {4, 4});
+    ASSERT_TRUE(hover.has_value());
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("In effect: `BuildCost = 900` from `/test/b_patch.ini` line 2"));
+    
+    // Definitions of a header's name
+    hover = manager.hover(objects, {3, 8});
+    ASSERT_TRUE(hover.has_value());
+    EXPECT_THAT(hover->contents, ::testing::HasSubstr("Defined 2 times"));
+    
+    EXPECT_FALSE(manager.hover(objects, {2, 1}).has_value());
+    EXPECT_FALSE(manager.hover("file:///test/missing.ini", {0, 0}).has_value());
+}
+
+TEST_F(DocumentManagerTest, FindReferences) {
+    std::string powers = "file:///test/power.ini";
+    std::string buttons = "file:///test/button.ini";
+    manager.addDocument(powers, "SpecialPower SuperweaponNuke\n  ReloadTime = 1000\nEnd\n", languageId);
+    manager.addDocument(buttons,
+        "CommandButton Command_Nuke\n"
+        "  SpecialPower = SuperweaponNuke\n"
+        "End\n"
+        "CommandButton Command_NukeToo\n"
+        "  SpecialPower = SuperweaponNuke\n"
+        "End\n", languageId);
+    
+    // From the definition
+    auto references = manager.findReferences(powers, {0, 16}, false);
+    ASSERT_EQ(references.size(), 2u);
+    EXPECT_EQ(references[0].uri, buttons);
+    EXPECT_EQ(references[0].range.start.line, 1);
+    EXPECT_EQ(references[1].range.start.line, 4);
+    
+    // From a use site, with the declaration first
+    references = manager.findReferences(buttons, {4, 20}, true);
+    ASSERT_EQ(references.size(), 3u);
+    EXPECT_EQ(references[0].uri, powers);
+    EXPECT_EQ(references[0].range.start.character, 13);
+    
+    EXPECT_TRUE(manager.findReferences(buttons, {1, 4}, true).empty());
+    
+    // Edits are indexed as they happen
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent removal{ZeroSyntax::LSP::Range{{0, 0}, {3, 0}}, ""};
+    manager.applyChanges(buttons, 2, {removal});
+    EXPECT_EQ(manager.findReferences(powers, {0, 16}, false).size(), 1u);
+}
+
+TEST_F(DocumentManagerTest, EffectiveField) {
+    std::string objects = "file:///test/a_object.ini";
+    std::string patch = "file:///test/b_patch.ini";
+    manager.addDocument(objects,
+        "Object Tank\n"
+        "  BuildCost = 800\n"
+        "  Body = ActiveBody ModuleTag_Body\n"
+        "    MaxHealth = 480.0\n"
+        "  End\n"
+        "End\n", languageId);
+    manager.addDocument(patch, "Object Tank\n  BuildCost = 900\nEnd\n", languageId);
+    
+    // Only memoized objects are read
+    EXPECT_FALSE(manager.effectiveField(objects, {1, 4}).has_value());
+    manager.refreshDefinitions();
+    
+    // A later block of the same name wins
+    auto field = manager.effectiveField(objects, {1, 4});
+    ASSERT_TRUE(field.has_value());
+    EXPECT_EQ(field->value, "900");
+    EXPECT_EQ(field->uri, patch);
+    
+    field = manager.effectiveField(objects, {3, 6});
+    ASSERT_TRUE(field.has_value());
+    EXPECT_EQ(field->value, "480.0");
+    field = manager.effectiveField(objects, {2, 4});
+    ASSERT_TRUE(field.has_value());
+    EXPECT_EQ(field->value, "ActiveBody ModuleTag_Body");
+    EXPECT_FALSE(manager.effectiveField(objects, {0, 8}).has_value());
+    
+    // Edits reach the memoized object
+    ZeroSyntax::LSP::TextDocumentContentChangeEvent edit{ZeroSyntax::LSP::Range{{1, 14}, {1, 17}}, "950"};
+    manager.applyChanges(patch, 2, {edit});
+    manager.refreshDefinitions();
+    EXPECT_EQ(manager.effectiveField(objects, {1, 4})->value, "950");
+    EXPECT_EQ(manager.effectiveObject("Tank")->layers.size(), 2u);
+}
+
+TEST_F(DocumentManagerTest, FindsTheDefinitionLoadedLast) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_document_manager_effective_test";
+    fs::remove_all(root);
+    auto write = [&](const std::string& relative, const std::string& text) {
+        fs::create_directories((root / relative).parent_path());
+        std::ofstream(root / relative) << text;
+    };
+    write("Data/INI/Object/Tank.ini", "Object Tank\nEnd\n");
+    write("Data/INI/Default/Object.ini", "Object Tank\nEnd\nObject Tank\nEnd\n");
+    write("Scratch/Tank.ini", "Object Tank\nEnd\n");
+    manager.indexWorkspace(root.string());
+    
+    // Default\Object.ini sorts first but the Object directory is loaded after it
+    std::string skins = "file:///test/skins.ini";
+    manager.addDocument(skins, "ObjectReskin TankSkin Tank\nEnd\n", languageId);
+    auto definition = manager.findDefinition(skins, {0, 23});
+    ASSERT_TRUE(definition.has_value());
+    EXPECT_EQ(definition->uri, ZeroSyntax::pathToUri((root / "Data/INI/Object/Tank.ini").string()));
+    
+    fs::remove(root / "Data/INI/Object/Tank.ini");
+    manager.indexWorkspace(root.string());
+    definition = manager.findDefinition(skins, {0, 23});
+    ASSERT_TRUE(definition.has_value());
+    EXPECT_EQ(definition->uri, ZeroSyntax::pathToUri((root / "Data/INI/Default/Object.ini").string()));
+    EXPECT_EQ(definition->range.start.line, 2);
+    fs::remove_all(root);
+}
+
+TEST_F(DocumentManagerTest, LoadsTheStringTable) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_document_manager_strings_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "Data");
+    EXPECT_EQ(manager.stringTable(), nullptr);
+    manager.indexWorkspace(root.string());
+    ASSERT_NE(manager.stringTable(), nullptr);
+    EXPECT_TRUE(manager.stringTable()->empty());
+    
+    std::ofstream(root / "Data/generals.str") << "OBJECT:Ranger\n\"Ranger\"\nEND\n";
+    manager.indexWorkspace(root.string());
+    auto strings = manager.stringTable();
+    auto ranger = strings->find("OBJECT:Ranger");
+    ASSERT_TRUE(ranger.has_value());
+    EXPECT_EQ(strings->text(*ranger), "Ranger");
+    fs::remove_all(root);
+}
+
+TEST_F(DocumentManagerTest, ValidatesLabels) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_document_manager_labels_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "Data/INI/Object");
+    std::ofstream(root / "Data/Generals.str") << "OBJECT:Tank\n\"Tank\"\nEND\n\nOBJECT:Unused\n\"Unused\"\nEND\n";
+    std::ofstream(root / "Data/INI/Object/Tank.ini")
+        << "Object Tank\n  DisplayName = Object:TANK\nEnd\nObject Jeep\n  DisplayName = OBJECT:Jeep\nEnd\n";
+    manager.indexWorkspace(root.string());
+    
+    auto diagnostics = manager.validateLabels();
+    std::string objects = ZeroSyntax::pathToUri((root / "Data/INI/Object/Tank.ini").string());
+    std::string strings = ZeroSyntax::pathToUri((root / "Data/Generals.str").string());
+    ASSERT_EQ(diagnostics[objects].size(), 1u);
+    EXPECT_EQ(diagnostics[objects][0].severity, ZeroSyntax::LSP::DiagnosticSeverity::Warning);
+    EXPECT_EQ(diagnostics[objects][0].range.start.line, 4);
+    EXPECT_EQ(diagnostics[objects][0].range.start.character, 16);
+    ASSERT_EQ(diagnostics[strings].size(), 1u);
+    EXPECT_EQ(diagnostics[strings][0].severity, ZeroSyntax::LSP::DiagnosticSeverity::Hint);
+    EXPECT_EQ(diagnostics[strings][0].range.start.line, 4);
+    EXPECT_EQ(diagnostics[strings][0].range.end.character, 13);
+    
+    // An open document is checked as edited
+    manager.addDocument(objects, "Object Tank\n  DisplayName = OBJECT:Tanks\nEnd\n", languageId);
+    auto document = manager.validateDocument(objects);
+    ASSERT_EQ(document.size(), 1u);
+    EXPECT_EQ(document[0].range.start.line, 1);
+    fs::remove_all(root);
 }
 
-} // namespace
\ No newline at end of file
+} // namespace
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "ini/field_validator.hpp"
+
+namespace {
+
+using namespace ZeroSyntax;
+
+std::vector<LSP::Diagnostic> validate(const std::string& text) {
+    return Ini::validateTree(Ini::SyntaxTree::parse(text));
+}
+
+// The diagnostic on a line, failing when there is not exactly one
+const LSP::Diagnostic* onLine(const std::vector<LSP::Diagnostic>& diagnostics, int line) {
+    const LSP::Diagnostic* found = nullptr;
+    for (const auto& diagnostic : diagnostics) {
+        if (diagnostic.range.start.line == line) {
+            EXPECT_EQ(found, nullptr) << "several diagnostics on line " << line;
+            found = &diagnostic;
+        }
+    }
+    EXPECT_NE(found, nullptr) << "no diagnostic on line " << line;
+    return found;
+}
+
+void expectRange(const LSP::Diagnostic* diagnostic, int start, int end) {
+    ASSERT_NE(diagnostic, nullptr);
+    EXPECT_EQ(diagnostic->range.start.character, start) << diagnostic->message;
+    EXPECT_EQ(diagnostic->range.end.character, end) << diagnostic->message;
+}
+
+TEST(FieldValidatorTest, AcceptsWhatTheEngineReads) {
+    auto diagnostics = validate(
+        "Object Tank\n"
+        "  BuildCost = 800\n"
+        "  VisionRange = 150.0\n"
+        "  IsTrainable = yes\n"
+        "  KindOf = SELECTABLE VEHICLE\n"
+        "  EditorSorting = VEHICLE\n"
+        "  DisplayColor = R:255 G:0 B:0\n"
+        "  TransportSlotCount = 3\n"
+        "  Body = ActiveBody ModuleTag_01\n"
+        "    MaxHealth = 300.0\n"
+        "  End\n"
+        "  Behavior = PhysicsBehavior ModuleTag_02\n"
+        "    Mass = 50.0\n"
+        "  End\n"
+        "  Behavior = SlowDeathBehavior ModuleTag_03\n"
+        "    DeathTypes = ALL -CRUSHED\n"
+        "    ModifierBonusPerOverkillPercent = 20%\n"
+        "  End\n"
+        "End\n"
+        "Weapon Gun\n"
+        "  PrimaryDamage = 10\n"
+        "  DamageType = ARMOR_PIERCING\n"
+        "  RadiusDamageAffects = ALLIES ENEMIES\n"
+        "End\n"
+        "GameData\n"
+        "  AmmoPipWorldOffset = X:0 Y:-1.5 Z:1e1\n"
+        "  ShroudColor = R:1 G:2 B:3\n"
+        "End\n");
+    for (const auto& diagnostic : diagnostics) {
+        ADD_FAILURE() << diagnostic.range.start.line << ": " << diagnostic.message;
+    }
+}
+
+TEST(FieldValidatorTest, ReportsValuesTheEngineRejects) {
+    auto diagnostics = validate(
+        "Object Tank\n"
+        "  BuildCost = 70000\n"                    // 1: parseUnsignedShort
+        "  VisionRange = far\n"                    // 2
+        "  IsTrainable = True\n"                   // 3
+        "  KindOf = SELECTABLE +VEHICLE\n"         // 4
+        "  EditorSorting = TANKS\n"                // 5
+        "  DisplayColor = R:255 G:0\n"             // 6
+        "  TransportSlotCount = -1\n"              // 7
+        "  Behavior = PhysicsBehavior ModuleTag_02\n"
+        "    Mass = 0.0\n"                         // 9
+        "  End\n"
+        "  Behavior = SlowDeathBehavior ModuleTag_03\n"
+        "    DeathTypes = CRUSHED\n"               // 12
+        "  End\n"
+        "  KindOf = NONE VEHICLE\n"                // 14: NONE ends the list
+        "  VisionRange =\n"                        // 15
+        "End\n"
+        "GameData\n"
+        "  AmmoPipWorldOffset = X:0 Q:1 Z:1\n"     // 18
+        "  ShroudColor = R:1 G:256 B:3\n"          // 19
+        "End\n");
+    EXPECT_EQ(diagnostics.size(), 12u);
+    expectRange(onLine(diagnostics, 1), 14, 19);
+    expectRange(onLine(diagnostics, 2), 16, 19);
+    expectRange(onLine(diagnostics, 3), 16, 20);
+    expectRange(onLine(diagnostics, 4), 22, 30);
+    expectRange(onLine(diagnostics, 5), 18, 23);
+    expectRange(onLine(diagnostics, 6), 2, 14);  // missing B: is reported on the field
+    expectRange(onLine(diagnostics, 7), 23, 25);
+    expectRange(onLine(diagnostics, 9), 11, 14);
+    expectRange(onLine(diagnostics, 12), 17, 24);
+    EXPECT_FALSE([&] {
+        for (const auto& diagnostic : diagnostics) {
+            if (diagnostic.range.start.line == 14) {
+                return true;
+            }
+        }
+        return false;
+    }());
+    expectRange(onLine(diagnostics, 15), 2, 13);
+    expectRange(onLine(diagnostics, 18), 27, 28);  // the sub-token before the colon
+    expectRange(onLine(diagnostics, 19), 22, 25);  // the value after G:
+    for (const auto& diagnostic : diagnostics) {
+        EXPECT_EQ(diagnostic.severity, LSP::DiagnosticSeverity::Error) << diagnostic.message;
+    }
+}
+
+TEST(FieldValidatorTest, WarnsAboutValuesReadDifferently) {
+    auto diagnostics = validate(
+        "Object Tank\n"
+        "  VisionRange = 150.0f\n"
+        "  BuildTime = 1.5.2\n"
+        "End\n"
+        "Weapon Gun\n"
+        "  ClipSize = 4abc\n"
+        "  DelayBetweenShots = whatever\n"
+        "End\n");
+    ASSERT_EQ(diagnostics.size(), 3u);
+    for (const auto& diagnostic : diagnostics) {
+        EXPECT_EQ(diagnostic.severity, LSP::DiagnosticSeverity::Warning) << diagnostic.message;
+    }
+    expectRange(onLine(diagnostics, 1), 16, 22);
+    EXPECT_NE(onLine(diagnostics, 2)->message.find("as 1.5"), std::string::npos);
+    expectRange(onLine(diagnostics, 5), 13, 17);
+}
+
+TEST(FieldValidatorTest, ReportsUnknownFieldsModulesAndSyntax) {
+    auto diagnostics = validate(
+        "Object Tank\n"
+        "  BuildCosts = 800\n"                         // 1
+        "  Body = ActiveBod ModuleTag_01\n"            // 2
+        "  End\n"
+        "  Body = ActiveBody ModuleTag_02\n"
+        "    MaxHealthy = 300.0\n"                     // 5
+        "  End\n"
+        "  Draw = W3DModelDraw\n"                      // 7: no tag
+        "  End\n"
+        "End\n"
+        "Weapn Gun\n"                                  // 10
+        "End\n");
+    expectRange(onLine(diagnostics, 1), 2, 12);
+    expectRange(onLine(diagnostics, 2), 9, 18);
+    const LSP::Diagnostic* field = onLine(diagnostics, 5);
+    expectRange(field, 4, 14);
+    EXPECT_EQ(field->message, "'MaxHealthy' is not a field of 'ActiveBody'");
+    expectRange(onLine(diagnostics, 7), 2, 6);
+    expectRange(onLine(diagnostics, 10), 0, 5);
+    EXPECT_EQ(diagnostics.size(), 5u);
+}
+
+} // namespace
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "text/fuzzy_matcher.hpp"
+#include <random>
+
+namespace {
+
+using namespace ZeroSyntax::Text;
+
+int scoreOf(std::string_view query, std::string_view name) {
+    auto score = FuzzyMatcher(query).score(name);
+    EXPECT_TRUE(score.has_value()) << query << " in " << name;
+    return score.value_or(0);
+}
+
+TEST(FuzzyMatcherTest, MatchesSubsequencesIgnoringCase) {
+    FuzzyMatcher matcher("avt");
+    EXPECT_TRUE(matcher.score("AmericaVehicleTomahawk").has_value());
+    EXPECT_TRUE(matcher.score("AVT").has_value());
+    EXPECT_FALSE(matcher.score("TomahawkVehicleAmerica").has_value());  // out of order
+    EXPECT_FALSE(matcher.score("av").has_value());
+    EXPECT_EQ(FuzzyMatcher("").score("Anything"), 0);
+}
+
+TEST(FuzzyMatcherTest, PrefersWordStartsAndRuns) {
+    // Word starts beat letters inside words
+    EXPECT_GT(scoreOf("avt", "AmericaVehicleTomahawk"), scoreOf("avt", "Navigator"));
+    // A run beats the same letters spread out
+    EXPECT_GT(scoreOf("rang", "Ranger"), scoreOf("rang", "RoamingAge"));
+    // The query's case breaks ties
+    EXPECT_GT(scoreOf("Tank", "TankA"), scoreOf("Tank", "tankB"));
+}
+
+TEST(FuzzyMatcherTest, FilterMasksAgreesWithScalarTest) {
+    std::mt19937_64 random(7);
+    std::vector<uint64_t> masks(1027);
+    for (auto& mask : masks) {
+        // Sparse masks, so some pass and some do not
+        mask = random() & random() & random();
+    }
+    masks[5] = ~uint64_t(0);
+    uint64_t query = characterMask("ab");
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < masks.size(); ++i) {
+        if ((masks[i] & query) == query) {
+            expected.push_back(i);
+        }
+    }
+    std::vector<uint32_t> matches;
+    filterMasks(masks.data(), masks.size(), query, matches);
+    EXPECT_EQ(matches, expected);
+    EXPECT_FALSE(expected.empty());
+
+    EXPECT_EQ(characterMask("ABC"), characterMask("cab"));
+    EXPECT_NE(characterMask("a_1"), characterMask("a1"));
+}
+
+TEST(FuzzyMatcherTest, TopMatchesKeepsTheBest) {
+    TopMatches top(3);
+    top.add(0, 10, 5);
+    top.add(1, 30, 5);
+    top.add(2, 20, 9);
+    top.add(3, 5, 1);
+    top.add(4, 20, 4);  // ties with 2, shorter
+    auto matches = top.take();
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].index, 1u);
+    EXPECT_EQ(matches[1].index, 4u);
+    EXPECT_EQ(matches[2].index, 2u);
+    EXPECT_EQ(top.size(), 0u);
+}
+
+} // namespace
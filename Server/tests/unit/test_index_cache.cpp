@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "core/index_cache.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using namespace ZeroSyntax;
+namespace fs = std::filesystem;
+
+class IndexCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (fs::temp_directory_path() / "zs_index_cache_test.bin").string();
+        fs::remove(path);
+    }
+
+    void TearDown() override {
+        fs::remove(path);
+    }
+
+    static CachedFile fileOf(const std::string& uri, const std::string& text, int64_t modified) {
+        return CachedFile{uri, FileStamp{modified, text.size(), IndexCache::contentHash(text)},
+                          WorkspaceIndex::collect(uri, Ini::SyntaxTree::parse(text))};
+    }
+
+    std::string path;
+};
+
+TEST_F(IndexCacheTest, RoundTrip) {
+    std::string weapons = "Weapon Gun\nEnd\nWeapon Cannon\nEnd\n";
+    std::string objects = "Object Tank\n  DisplayName = OBJECT:Tank\n  Behavior = FireWeaponWhenDeadBehavior Tag\n"
+                          "    DeathWeapon = Cannon\n  End\nEnd\n";
+    ASSERT_TRUE(IndexCache::write(path, {fileOf("file:///w.ini", weapons, 7), fileOf("file:///o.ini", objects, 9)}));
+
+    IndexCache cache;
+    ASSERT_TRUE(cache.load(path));
+    EXPECT_EQ(cache.fileCount(), 2u);
+    EXPECT_FALSE(cache.findFile("file:///missing.ini").has_value());
+
+    auto file = cache.findFile("file:///w.ini");
+    ASSERT_TRUE(file.has_value());
+    FileStamp stamp = cache.stamp(*file);
+    EXPECT_EQ(stamp.modified, 7);
+    EXPECT_EQ(stamp.size, weapons.size());
+    EXPECT_EQ(stamp.hash, IndexCache::contentHash(weapons));
+    FileSymbols symbols = cache.symbols(*file);
+    ASSERT_EQ(symbols.definitions.size(), 2u);
+    EXPECT_EQ(symbols.definitions[1].name, "Cannon");
+    EXPECT_EQ(symbols.definitions[1].blockType, "Weapon");
+    EXPECT_EQ(symbols.definitions[1].uri, "file:///w.ini");
+    EXPECT_EQ(symbols.definitions[1].range.start.line, 2);
+
+    file = cache.findFile("file:///o.ini");
+    ASSERT_TRUE(file.has_value());
+    symbols = cache.symbols(*file);
+    ASSERT_EQ(symbols.references.size(), 1u);
+    EXPECT_EQ(symbols.references[0].name, "Cannon");
+    EXPECT_EQ(symbols.references[0].blockType, "Weapon");
+    EXPECT_EQ(symbols.references[0].range.start.character, 18);
+    EXPECT_EQ(symbols.references[0].range.end.character, 24);
+    ASSERT_EQ(symbols.labels.size(), 1u);
+    EXPECT_EQ(symbols.labels[0].name, "OBJECT:Tank");
+    EXPECT_TRUE(symbols.labels[0].blockType.empty());
+    EXPECT_EQ(symbols.labels[0].range.start.line, 1);
+}
+
+TEST_F(IndexCacheTest, RejectsDamagedFiles) {
+    IndexCache cache;
+    EXPECT_FALSE(cache.load(path));
+
+    ASSERT_TRUE(IndexCache::write(path, {fileOf("file:///w.ini", "Weapon Gun\nEnd\n", 1)}));
+    fs::resize_file(path, fs::file_size(path) - 1);
+    EXPECT_FALSE(cache.load(path));
+    EXPECT_EQ(cache.fileCount(), 0u);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << std::string(64, 'x');
+    EXPECT_FALSE(cache.load(path));
+}
+
+TEST_F(IndexCacheTest, DefaultPathDependsOnRoot) {
+    EXPECT_NE(IndexCache::defaultPath("/mods/a"), IndexCache::defaultPath("/mods/b"));
+    EXPECT_EQ(IndexCache::defaultPath("/mods/a"), IndexCache::defaultPath("/mods/a/"));
+}
+
+} // namespace
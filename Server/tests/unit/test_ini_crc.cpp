@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "ini/ini_crc.hpp"
+#include "core/ini_checksum.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+
+using namespace ZeroSyntax;
+namespace fs = std::filesystem;
+
+// INI::readLine and XferCRC as the engine writes them, one byte at a time
+class EngineCrc {
+public:
+    void load(const std::string& text) {
+        size_t next = 0;
+        bool endOfFile = false;
+        while (!endOfFile) {
+            char buffer[1028 + 1];
+            char* p = buffer;
+            while (p != buffer + 1028) {
+                if (next == text.size()) {
+                    endOfFile = true;
+                    *p = 0;
+                    break;
+                }
+                *p = text[next++];
+                if (*p == '\n') {
+                    *p = 0;
+                    break;
+                }
+                if (*p == ';') {
+                    *p = 0;
+                } else if (*p > 0 && *p < 32) {
+                    *p = ' ';
+                }
+                p++;
+            }
+            *p = 0;
+            xfer(buffer, static_cast<int>(std::strlen(buffer)));
+        }
+    }
+
+    uint32_t getCRC() const { return htonl(crc_); }
+
+private:
+    static uint32_t htonl(uint32_t value) { return Ini::crcValue(value); }
+
+    void addCRC(uint32_t val) {
+        val = htonl(val);
+        int hibit = (crc_ & 0x80000000) ? 1 : 0;
+        crc_ <<= 1;
+        crc_ += val;
+        crc_ += hibit;
+    }
+
+    void xfer(const char* data, int dataSize) {
+        for (int i = 0; i < dataSize / 4; i++) {
+            uint32_t word;
+            std::memcpy(&word, data + i * 4, 4);  // little-endian host
+            addCRC(word);
+        }
+        int leftover = dataSize & 3;
+        if (leftover) {
+            uint32_t val = 0;
+            const unsigned char* c = reinterpret_cast<const unsigned char*>(data + (dataSize & ~3));
+            for (int i = 0; i < leftover; i++) {
+                val += (c[i] << (i * 8));
+            }
+            val = htonl(val);
+            addCRC(val);
+        }
+    }
+
+    uint32_t crc_ = 0;
+};
+
+uint32_t crcOf(const std::vector<std::string>& files) {
+    std::vector<uint32_t> terms;
+    for (const auto& text : files) {
+        Ini::appendCrcTerms(text, terms);
+    }
+    return Ini::crcValue(Ini::foldCrcTerms(0, terms.data(), terms.size()));
+}
+
+TEST(IniCrcTest, FoldsWordsLikeXferCRC) {
+    // A whole word in big-endian order, leftovers little-endian
+    std::vector<uint32_t> terms;
+    Ini::appendCrcTerms("ABCDE", terms);
+    ASSERT_EQ(terms.size(), 2u);
+    EXPECT_EQ(terms[0], 0x41424344u);
+    EXPECT_EQ(terms[1], 0x45u);
+    EXPECT_EQ(Ini::foldCrcTerms(0x80000000u, terms.data(), 1), 0x41424345u);
+
+    // Comments and empty lines add nothing; control characters are spaces
+    EXPECT_EQ(crcOf({"AB\tD ; note\n\n;only\n"}), crcOf({"AB D "}));
+    EXPECT_NE(crcOf({"A\nB"}), crcOf({"AB"}));
+    EXPECT_EQ(crcOf({}), 0u);
+}
+
+TEST(IniCrcTest, MatchesTheEngine) {
+    std::mt19937 random(21);
+    const char alphabet[] = "Object Tank\n  BuildCost = 800 ;\r\t\x01\xe9\0End";
+    for (int round = 0; round < 40; ++round) {
+        EngineCrc engine;
+        std::vector<std::string> files;
+        for (int f = 0; f < 3; ++f) {
+            std::string text;
+            size_t size = random() % 3000;
+            for (size_t i = 0; i < size; ++i) {
+                text.push_back(alphabet[random() % (sizeof(alphabet) - 1)]);
+            }
+            if (round % 4 == 0) {
+                text += std::string(1028 + random() % 10, 'x');  // a line the engine splits
+            }
+            engine.load(text);
+            files.push_back(text);
+        }
+        EXPECT_EQ(crcOf(files), engine.getCRC()) << "round " << round;
+    }
+}
+
+TEST(IniCrcTest, ChecksumFollowsTheLoadOrder) {
+    fs::path root = fs::temp_directory_path() / "zs_ini_crc_test";
+    fs::remove_all(root);
+    auto write = [&](const std::string& relative, const std::string& text) {
+        fs::create_directories((root / relative).parent_path());
+        std::ofstream(root / relative, std::ios::binary) << text;
+    };
+    const std::string weapon = "Weapon Gun\n  AttackRange = 100\nEnd\n";
+    const std::string armor = "Armor Plate\nEnd\n";
+    const std::string object = "Object Tank\nEnd\n";
+    write("Data/INI/Weapon.ini", weapon);
+    write("Data/INI/Armor.ini", armor);
+    write("Data/INI/Object/Tank.ini", object);
+    write("Data/INI/InGameUI.ini", "InGameUI\nEnd\n");  // not checksummed
+
+    Vfs::LayeredFileSystem files;
+    files.addDirectory(root.string());
+    IniChecksum checksum;
+    checksum.rebuild(files);
+    EXPECT_EQ(checksum.fileCount(), 3u);
+    EXPECT_EQ(checksum.value(), crcOf({weapon, armor, object}));
+
+    // A changed file is folded in at its place in the order
+    const std::string stronger = "Armor Plate\n  Armor = DEFAULT 50%\nEnd\n";
+    EXPECT_TRUE(checksum.update("data/ini/armor.ini", stronger));
+    EXPECT_EQ(checksum.value(), crcOf({weapon, stronger, object}));
+    EXPECT_TRUE(checksum.update("data/ini/armor.ini", armor + "; comment\n"));
+    EXPECT_EQ(checksum.value(), crcOf({weapon, armor, object}));
+    EXPECT_FALSE(checksum.update("data/ini/ingameui.ini", "InGameUI\n  Changed = Yes\nEnd\n"));
+
+    fs::remove_all(root);
+}
+
+} // namespace
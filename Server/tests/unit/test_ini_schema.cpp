@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "ini/ini_schema.hpp"
+#include "ini/ini_grammar.hpp"
+#include <algorithm>
+#include <string>
+
+namespace {
+
+using namespace ZeroSyntax::Ini;
+
+const FieldSchema* blockField(std::string_view block, std::string_view token) {
+    const BlockSchema* schema = Schema::findBlock(block);
+    if (!schema || schema->table == kNoIndex) {
+        return nullptr;
+    }
+    return Schema::findField(Schema::table(schema->table), token);
+}
+
+const FieldSchema* moduleField(std::string_view module, std::string_view token) {
+    const ModuleSchema* schema = Schema::findModule(module);
+    if (!schema || schema->table == kNoIndex) {
+        return nullptr;
+    }
+    return Schema::findField(Schema::table(schema->table), token);
+}
+
+bool listContains(uint16_t index, std::string_view name) {
+    auto names = Schema::names(Schema::list(index));
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+std::string lower(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(), asciiLower);
+    return result;
+}
+
+TEST(IniSchemaTest, BlocksMatchTheTypeTable) {
+    EXPECT_EQ(Schema::blocks().size(), 62u);
+    ASSERT_NE(Schema::findBlock("Object"), nullptr);
+    EXPECT_EQ(Schema::findBlock("Object")->proc, "INI::parseObjectDefinition");
+    EXPECT_EQ(Schema::findBlock("object"), nullptr);
+    EXPECT_EQ(Schema::findBlock("FooBar"), nullptr);
+
+    EXPECT_TRUE(isTopLevelBlock("WaterTransparency"));
+    EXPECT_FALSE(isTopLevelBlock("End"));
+
+    // Blocks read by hand-written code have no table
+    ASSERT_NE(Schema::findBlock("ReallyLowMHz"), nullptr);
+    EXPECT_EQ(Schema::findBlock("ReallyLowMHz")->table, kNoIndex);
+}
+
+TEST(IniSchemaTest, FieldKinds) {
+    const FieldSchema* damage = blockField("Weapon", "PrimaryDamage");
+    ASSERT_NE(damage, nullptr);
+    EXPECT_EQ(damage->kind, FieldKind::Real);
+
+    const FieldSchema* draw = blockField("Object", "Draw");
+    ASSERT_NE(draw, nullptr);
+    EXPECT_EQ(draw->kind, FieldKind::Module);
+
+    const FieldSchema* armorSet = blockField("Object", "ArmorSet");
+    ASSERT_NE(armorSet, nullptr);
+    EXPECT_EQ(armorSet->kind, FieldKind::Block);
+    EXPECT_NE(armorSet->table, kNoIndex);
+
+    const FieldSchema* sound = blockField("Weapon", "FireSound");
+    ASSERT_NE(sound, nullptr);
+    EXPECT_EQ(sound->kind, FieldKind::Reference);
+    EXPECT_EQ(sound->reference, "AudioEvent");
+
+    // Nuggets filling a MultiIniFieldParse of their own
+    const FieldSchema* createObject = blockField("ObjectCreationList", "CreateObject");
+    ASSERT_NE(createObject, nullptr);
+    EXPECT_EQ(createObject->kind, FieldKind::Block);
+    ASSERT_NE(createObject->table, kNoIndex);
+    EXPECT_NE(Schema::findField(Schema::table(createObject->table), "ObjectNames"), nullptr);
+
+    EXPECT_EQ(blockField("Weapon", "NoSuchField"), nullptr);
+}
+
+TEST(IniSchemaTest, ObjectAndReskinTables) {
+    const BlockSchema* object = Schema::findBlock("Object");
+    const BlockSchema* reskin = Schema::findBlock("ObjectReskin");
+    ASSERT_NE(object, nullptr);
+    ASSERT_NE(reskin, nullptr);
+    EXPECT_NE(object->table, reskin->table);
+    EXPECT_GT(Schema::table(object->table).fieldCount, Schema::table(reskin->table).fieldCount);
+    EXPECT_NE(blockField("Object", "BuildCost"), nullptr);
+    EXPECT_EQ(blockField("ObjectReskin", "BuildCost"), nullptr);
+}
+
+TEST(IniSchemaTest, NameLists) {
+    const FieldSchema* kindOf = blockField("Object", "KindOf");
+    ASSERT_NE(kindOf, nullptr);
+    EXPECT_EQ(kindOf->kind, FieldKind::BitFlags);
+    ASSERT_NE(kindOf->list, kNoIndex);
+    EXPECT_TRUE(listContains(kindOf->list, "INFANTRY"));
+    EXPECT_FALSE(listContains(kindOf->list, "infantry"));
+
+    const FieldSchema* surfaces = blockField("Locomotor", "Surfaces");
+    ASSERT_NE(surfaces, nullptr);
+    EXPECT_EQ(surfaces->kind, FieldKind::BitString);
+    ASSERT_NE(surfaces->list, kNoIndex);
+    EXPECT_TRUE(listContains(surfaces->list, "GROUND"));
+}
+
+TEST(IniSchemaTest, Modules) {
+    const ModuleSchema* ai = Schema::findModule("AIUpdateInterface");
+    ASSERT_NE(ai, nullptr);
+    EXPECT_EQ(ai->type, ModuleType::Behavior);
+    EXPECT_EQ(ai->dataClass, "AIUpdateModuleData");
+
+    const ModuleSchema* draw = Schema::findModule("W3DModelDraw");
+    ASSERT_NE(draw, nullptr);
+    EXPECT_EQ(draw->type, ModuleType::Draw);
+
+    // buildFieldParse chains include the base class tables
+    const FieldSchema* turret = moduleField("AIUpdateInterface", "Turret");
+    ASSERT_NE(turret, nullptr);
+    EXPECT_EQ(turret->kind, FieldKind::Block);
+    EXPECT_NE(moduleField("W3DModelDraw", "DefaultConditionState"), nullptr);
+    EXPECT_NE(moduleField("W3DTankDraw", "TreadDebrisLeft"), nullptr);
+    EXPECT_NE(moduleField("W3DTankDraw", "DefaultConditionState"), nullptr);
+
+    // parseConditionState reads an alias's flags on its line
+    const FieldSchema* alias = moduleField("W3DModelDraw", "AliasConditionState");
+    ASSERT_NE(alias, nullptr);
+    EXPECT_EQ(alias->kind, FieldKind::BitFlags);
+    ASSERT_NE(alias->list, kNoIndex);
+    EXPECT_TRUE(listContains(alias->list, "DAMAGED"));
+
+    // Modules without data of their own have an empty table
+    const ModuleSchema* inactive = Schema::findModule("InactiveBody");
+    ASSERT_NE(inactive, nullptr);
+    EXPECT_EQ(Schema::table(inactive->table).fieldCount, 0u);
+}
+
+TEST(IniSchemaTest, CaseInsensitiveLookups) {
+    EXPECT_EQ(Schema::findBlock("object", MatchCase::Ignore), Schema::findBlock("Object"));
+    EXPECT_EQ(Schema::findModule("w3dmodeldraw", MatchCase::Ignore), Schema::findModule("W3DModelDraw"));
+    EXPECT_EQ(Schema::findModule("w3dmodeldraw"), nullptr);
+
+    const FieldTable& weapon = Schema::table(Schema::findBlock("Weapon")->table);
+    EXPECT_EQ(Schema::findField(weapon, "PRIMARYDAMAGE", MatchCase::Ignore), Schema::findField(weapon, "PrimaryDamage"));
+    EXPECT_EQ(Schema::findField(weapon, "PRIMARYDAMAGE"), nullptr);
+
+    const NameList& kindOf = Schema::list(blockField("Object", "KindOf")->list);
+    std::optional<uint32_t> infantry = Schema::findName(kindOf, "Infantry");
+    ASSERT_TRUE(infantry.has_value());
+    EXPECT_EQ(Schema::names(kindOf)[*infantry], "INFANTRY");
+    EXPECT_FALSE(Schema::findName(kindOf, "INFANTRYX").has_value());
+    EXPECT_FALSE(Schema::findName(kindOf, "").has_value());
+}
+
+TEST(IniSchemaTest, EveryRecordHashesToItself) {
+    for (const BlockSchema& block : Schema::blocks()) {
+        EXPECT_EQ(Schema::findBlock(block.name), &block);
+        EXPECT_EQ(Schema::findBlock(lower(block.name), MatchCase::Ignore), &block);
+    }
+    for (const ModuleSchema& module : Schema::modules()) {
+        EXPECT_EQ(Schema::findModule(module.name), &module);
+    }
+    for (const FieldTable& table : Schema::tables()) {
+        for (const FieldSchema& field : Schema::fields(table)) {
+            const FieldSchema* found = Schema::findField(table, field.token);
+            ASSERT_NE(found, nullptr) << table.name << "." << field.token;
+            EXPECT_EQ(found->token, field.token);
+            EXPECT_LE(found, &field);
+        }
+        EXPECT_EQ(Schema::findField(table, "NotAFieldOfAnyTable"), nullptr);
+    }
+    for (const NameList& list : Schema::lists()) {
+        auto names = Schema::names(list);
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            std::optional<uint32_t> found = Schema::findName(list, lower(names[i]));
+            ASSERT_TRUE(found.has_value()) << list.name << "." << names[i];
+            EXPECT_LE(*found, i);
+            EXPECT_EQ(lower(names[*found]), lower(names[i]));
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "ini/syntax_tree.hpp"
+#include <random>
+#include <string>
+
+namespace {
+
+using namespace ZeroSyntax::Ini;
+
+// Keywords of a section's nodes in preorder
+std::vector<std::string> keywords(const Section& section) {
+    std::vector<std::string> result;
+    for (const auto& node : section.nodes) {
+        result.emplace_back(section.keyword(node));
+    }
+    return result;
+}
+
+// Structural comparison of two trees, section by section
+void expectSameTree(const SyntaxTree& actual, const SyntaxTree& expected) {
+    ASSERT_EQ(actual.sectionCount(), expected.sectionCount());
+    EXPECT_EQ(actual.length(), expected.length());
+    for (size_t i = 0; i < expected.sectionCount(); ++i) {
+        const Section& a = actual.section(i);
+        const Section& e = expected.section(i);
+        EXPECT_EQ(a.text, e.text) << "section " << i;
+        EXPECT_EQ(a.lines.size(), e.lines.size()) << "section " << i;
+        EXPECT_EQ(keywords(a), keywords(e)) << "section " << i;
+        EXPECT_EQ(a.errors.size(), e.errors.size()) << "section " << i;
+        EXPECT_EQ(actual.sectionOffset(i), expected.sectionOffset(i));
+        EXPECT_EQ(actual.sectionRow(i), expected.sectionRow(i));
+    }
+}
+
+bool hasError(const Section& section, SyntaxErrorKind kind) {
+    for (const auto& error : section.errors) {
+        if (error.kind == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(IniSyntaxTreeTest, LosslessRoundTrip) {
+    std::string source =
+        "; header comment\r\n"
+        "\r\n"
+        "Weapon Gun ; trailing\r\n"
+        "  PrimaryDamage = 10.0\r\n"
+        "End\r\n"
+        "\n"
+        "Object Tank\n"
+        "  Side = America\n"
+        "END";
+    SyntaxTree tree = SyntaxTree::parse(source);
+
+    EXPECT_EQ(tree.text(), source);
+    EXPECT_EQ(tree.length(), source.size());
+    ASSERT_EQ(tree.sectionCount(), 3u);
+    EXPECT_FALSE(tree.section(0).hasRoot());
+    EXPECT_THAT(keywords(tree.section(1)), ::testing::ElementsAre("Weapon", "PrimaryDamage"));
+    EXPECT_THAT(keywords(tree.section(2)), ::testing::ElementsAre("Object", "Side"));
+    EXPECT_EQ(tree.sectionRow(2), 6u);
+    EXPECT_TRUE(tree.section(1).errors.empty());
+    EXPECT_TRUE(tree.section(2).errors.empty());
+}
+
+TEST(IniSyntaxTreeTest, TokensFollowReadLine) {
+    SyntaxTree tree = SyntaxTree::parse("Armor A\n\tArmor=DEFAULT\x01" "50% ; 100%\nEnd\n");
+    const Section& section = tree.section(0);
+    const Line& line = section.lines[1];
+
+    ASSERT_EQ(line.tokenCount, 3u);
+    EXPECT_EQ(section.tokenText(section.lineTokens(line)[0]), "Armor");
+    EXPECT_EQ(section.tokenText(section.lineTokens(line)[1]), "DEFAULT");
+    EXPECT_EQ(section.tokenText(section.lineTokens(line)[2]), "50%");
+    EXPECT_EQ(section.nodes[1].kind, NodeKind::Field);
+    EXPECT_EQ(section.nodes[1].parent, 0u);
+}
+
+TEST(IniSyntaxTreeTest, NestedBlocks) {
+    SyntaxTree tree = SyntaxTree::parse(
+        "Object Tank\n"
+        "  Draw = W3DTankDraw ModuleTag_01\n"
+        "    DefaultConditionState\n"
+        "      Model = Tank\n"
+        "    End\n"
+        "  End\n"
+        "  Behavior = AIUpdateInterface ModuleTag_02\n"
+        "    Turret\n"
+        "      TurretTurnRate = 100\n"
+        "    end\n"
+        "  End\n"
+        "  Side = America\n"
+        "End\n");
+    ASSERT_EQ(tree.sectionCount(), 1u);
+    const Section& section = tree.section(0);
+
+    EXPECT_THAT(keywords(section), ::testing::ElementsAre("Object", "Draw", "DefaultConditionState", "Model",
+                                                          "Behavior", "Turret", "TurretTurnRate", "Side"));
+    EXPECT_TRUE(section.errors.empty());
+    EXPECT_EQ(section.nodes[0].subtreeEnd, 8u);
+    EXPECT_EQ(section.nodes[1].subtreeEnd, 4u);
+    EXPECT_EQ(section.nodes[4].subtreeEnd, 7u);
+    EXPECT_EQ(section.nodes[5].parent, 4u);
+    EXPECT_EQ(section.nodes[5].endLine, 9u);
+    EXPECT_EQ(section.nodeToken(section.nodes[4], 2), "ModuleTag_02");
+}
+
+TEST(IniSyntaxTreeTest, NestedBlocksFollowTheSchema) {
+    SyntaxTree tree = SyntaxTree::parse(
+        "Object Tank\n"
+        "  Draw = W3DModelDraw ModuleTag_01\n"
+        "    AliasConditionState = DAMAGED\n"
+        "    Model = Tank\n"
+        "  End\n"
+        "End\n"
+        "ObjectCreationList OCL_Tank\n"
+        "  CreateObject\n"
+        "    ObjectNames = Tank\n"
+        "  End\n"
+        "End\n");
+    ASSERT_EQ(tree.sectionCount(), 2u);
+    const Section& object = tree.section(0);
+    EXPECT_THAT(keywords(object), ::testing::ElementsAre("Object", "Draw", "AliasConditionState", "Model"));
+    EXPECT_TRUE(object.errors.empty());
+    EXPECT_EQ(object.nodes[2].kind, NodeKind::Field);
+    EXPECT_EQ(object.nodes[3].parent, 1u);
+
+    const Section& ocl = tree.section(1);
+    EXPECT_THAT(keywords(ocl), ::testing::ElementsAre("ObjectCreationList", "CreateObject", "ObjectNames"));
+    EXPECT_TRUE(ocl.errors.empty());
+    EXPECT_EQ(ocl.nodes[2].parent, 1u);
+}
+
+TEST(IniSyntaxTreeTest, ModuleOverrideBlocks) {
+    SyntaxTree tree = SyntaxTree::parse(
+        "Object Tank\n"
+        "  RemoveModule ModuleTag_01\n"
+        "  ReplaceModule ModuleTag_02\n"
+        "    Draw = W3DTankDraw ModuleTag_03\n"
+        "    End\n"
+        "  End\n"
+        "End\n");
+    const Section& section = tree.section(0);
+    EXPECT_THAT(keywords(section), ::testing::ElementsAre("Object", "RemoveModule", "ReplaceModule", "Draw"));
+    EXPECT_TRUE(section.errors.empty());
+    EXPECT_EQ(section.nodes[1].kind, NodeKind::Field);
+    EXPECT_EQ(section.nodes[3].parent, 2u);
+}
+
+TEST(IniSyntaxTreeTest, RecoversFromMissingEnd) {
+    SyntaxTree tree = SyntaxTree::parse(
+        "Object Tank\n"
+        "  Armor = TankArmor\n"
+        "Weapon Gun\n"
+        "  PrimaryDamage = 10\n"
+        "End\n");
+    ASSERT_EQ(tree.sectionCount(), 2u);
+
+    EXPECT_TRUE(hasError(tree.section(0), SyntaxErrorKind::MissingEnd));
+    EXPECT_EQ(tree.section(0).nodes[0].endLine, kNone);
+    EXPECT_THAT(keywords(tree.section(1)), ::testing::ElementsAre("Weapon", "PrimaryDamage"));
+    EXPECT_TRUE(tree.section(1).errors.empty());
+}
+
+TEST(IniSyntaxTreeTest, BlockTypeAsFieldName) {
+    // "Armor = ..." at column 0 is a field of the open Object, not a new block
+    SyntaxTree tree = SyntaxTree::parse("Object Tank\nArmorSet\nArmor = TankArmor\nEnd\nEnd\n");
+
+    ASSERT_EQ(tree.sectionCount(), 1u);
+    EXPECT_TRUE(tree.section(0).errors.empty());
+}
+
+TEST(IniSyntaxTreeTest, SingleLineAndUnknownBlocks) {
+    SyntaxTree tree = SyntaxTree::parse("ReallyLowMHz = 400\nFooBar Baz\nEnd\nEnd\n");
+    ASSERT_EQ(tree.sectionCount(), 3u);
+
+    EXPECT_EQ(tree.section(0).nodes[0].kind, NodeKind::Field);
+    EXPECT_TRUE(tree.section(0).errors.empty());
+    EXPECT_TRUE(hasError(tree.section(1), SyntaxErrorKind::UnknownBlock));
+    EXPECT_TRUE(hasError(tree.section(2), SyntaxErrorKind::UnexpectedEnd));
+}
+
+TEST(IniSyntaxTreeTest, SplitsOverlongLines) {
+    std::string longValue(1100, 'x');
+    std::string source = "Object Tank\n  Description = " + longValue + "\nEnd\n";
+    SyntaxTree tree = SyntaxTree::parse(source);
+    const Section& section = tree.section(0);
+
+    ASSERT_EQ(section.lines.size(), 4u);
+    EXPECT_TRUE(section.lines[1].truncated);
+    EXPECT_EQ(section.lines[1].length, 1028u);
+    EXPECT_EQ(section.lines[2].row, 1u);
+    EXPECT_EQ(section.lines[2].column, 1028u);
+    EXPECT_TRUE(hasError(section, SyntaxErrorKind::LineTooLong));
+    EXPECT_EQ(tree.text(), source);
+
+    // The continuation is a field of its own, as in the engine
+    const Token& token = section.tokens[section.lines[2].firstToken];
+    EXPECT_EQ(tree.positionAt(0, token.offset).line, 1);
+    EXPECT_EQ(tree.positionAt(0, token.offset).character, 1028);
+}
+
+TEST(IniSyntaxTreeTest, Positions) {
+    SyntaxTree tree = SyntaxTree::parse("; \xC3\xA9\nObject Tank\n  Side = \xF0\x9F\x98\x80" "America\nEnd\n");
+    ASSERT_EQ(tree.sectionCount(), 2u);
+    const Section& section = tree.section(1);
+    const Token& side = section.tokens[section.lines[1].firstToken + 1];
+
+    ZeroSyntax::LSP::Range range = tree.tokenRange(1, side);
+    EXPECT_EQ(range.start.line, 2);
+    EXPECT_EQ(range.start.character, 9);
+    EXPECT_EQ(range.end.character, 18);
+    EXPECT_EQ(tree.offsetAt(1, range.start), side.offset);
+    EXPECT_EQ(tree.findSection(tree.sectionOffset(1) + side.offset), 1u);
+    EXPECT_EQ(tree.findSectionByRow(2), 1u);
+}
+
+TEST(IniSyntaxTreeTest, EditReusesUntouchedSections) {
+    std::string source =
+        "Weapon A\n  PrimaryDamage = 1\nEnd\n\n"
+        "Weapon B\n  PrimaryDamage = 2\nEnd\n\n"
+        "Weapon C\n  PrimaryDamage = 3\nEnd\n";
+    ZeroSyntax::PieceTable text(source);
+    SyntaxTree tree = SyntaxTree::parse(source);
+
+    // Change B's damage to 20
+    size_t offset = source.find("2\n");
+    text.insert(offset + 1, "0");
+    SyntaxTree edited = tree.edit(text, offset + 1, 0, 1);
+
+    expectSameTree(edited, SyntaxTree::parse(text.text()));
+    EXPECT_EQ(edited.sectionPtr(0), tree.sectionPtr(0));
+    EXPECT_NE(edited.sectionPtr(1), tree.sectionPtr(1));
+    EXPECT_EQ(edited.sectionPtr(2), tree.sectionPtr(2));
+    EXPECT_EQ(edited.sectionOffset(2), tree.sectionOffset(2) + 1);
+}
+
+TEST(IniSyntaxTreeTest, EditShiftsBlockBoundaries) {
+    std::string source = "Weapon A\n  PrimaryDamage = 1\nEnd\nWeapon B\nEnd\n";
+    ZeroSyntax::PieceTable text(source);
+    SyntaxTree tree = SyntaxTree::parse(source);
+
+    // Deleting A's End makes B's header close A with a missing End
+    size_t offset = source.find("End");
+    text.erase(offset, 4);
+    SyntaxTree edited = tree.edit(text, offset, 4, 0);
+    expectSameTree(edited, SyntaxTree::parse(text.text()));
+
+    // Commenting out B's header turns its lines into trivia and fields
+    offset = text.text().find("Weapon B");
+    text.insert(offset, ";");
+    edited = edited.edit(text, offset, 0, 1);
+    expectSameTree(edited, SyntaxTree::parse(text.text()));
+}
+
+TEST(IniSyntaxTreeTest, RandomEditsMatchFullParse) {
+    const char* snippets[] = {"Object ", "End", "\n", "  ", "Draw = X\n", "Weapon W\n", "; c", "= ", "Side", "x"};
+    std::string source;
+    for (int i = 0; i < 20; ++i) {
+        source += "Object O" + std::to_string(i) + "\n  Draw = W3DModelDraw M\n    DefaultConditionState\n"
+                  "      Model = M\n    End\n  End\n  Side = America\nEnd\n\n";
+    }
+    ZeroSyntax::PieceTable text(source);
+    SyntaxTree tree = SyntaxTree::parse(source);
+
+    std::mt19937 random(1234);
+    for (int i = 0; i < 500; ++i) {
+        size_t offset = random() % (text.length() + 1);
+        size_t removed = std::min<size_t>(random() % 12, text.length() - offset);
+        std::string inserted = random() % 3 == 0 ? "" : snippets[random() % 10];
+        text.replace(offset, removed, inserted);
+        tree = tree.edit(text, offset, removed, inserted.size());
+
+        expectSameTree(tree, SyntaxTree::parse(text.text()));
+        if (::testing::Test::HasFailure()) {
+            FAIL() << "edit " << i << " at " << offset;
+        }
+    }
+}
+
+} // namespace
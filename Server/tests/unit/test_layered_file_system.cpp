@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "vfs/layered_file_system.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using namespace ZeroSyntax::Vfs;
+namespace fs = std::filesystem;
+
+void putBigEndian(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+// A BIGF archive holding files in the given order
+std::string makeArchive(const std::vector<std::pair<std::string, std::string>>& files) {
+    size_t directorySize = 16;
+    for (const auto& file : files) {
+        directorySize += 8 + file.first.size() + 1;
+    }
+    std::string archive = "BIGF";
+    archive.append(4, '\0');
+    putBigEndian(archive, static_cast<uint32_t>(files.size()));
+    putBigEndian(archive, static_cast<uint32_t>(directorySize));
+    size_t offset = directorySize;
+    for (const auto& file : files) {
+        putBigEndian(archive, static_cast<uint32_t>(offset));
+        putBigEndian(archive, static_cast<uint32_t>(file.second.size()));
+        archive += file.first;
+        archive.push_back('\0');
+        offset += file.second.size();
+    }
+    for (const auto& file : files) {
+        archive += file.second;
+    }
+    return archive;
+}
+
+class LayeredFileSystemTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / "zs_layered_file_system_test";
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    void write(const std::string& relative, const std::string& bytes) {
+        fs::path path = root / relative;
+        fs::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+    }
+
+    std::string text(const LayeredFileSystem& files, std::string_view path) {
+        std::string contents;
+        const FileSource* source = files.resolve(path);
+        if (!source || !files.read(*source, path, contents)) {
+            return "<missing>";
+        }
+        return contents;
+    }
+
+    fs::path root;
+};
+
+TEST_F(LayeredFileSystemTest, LooseFilesShadowArchives) {
+    write("game/INIZH.big", makeArchive({{"Data\\INI\\Weapon.ini", "archived"},
+                                         {"Data\\INI\\Armor.ini", "archived armor"}}));
+    write("mod/Data/INI/Weapon.ini", "loose");
+
+    LayeredFileSystem files;
+    files.addDirectory((root / "mod").string());
+    EXPECT_EQ(files.addArchiveDirectory((root / "game").string()), 1u);
+
+    EXPECT_EQ(text(files, "data\\ini\\WEAPON.ini"), "loose");
+    EXPECT_EQ(text(files, "Data/INI/Armor.ini"), "archived armor");
+    EXPECT_EQ(text(files, "Data/INI/Missing.ini"), "<missing>");
+
+    auto copies = files.sources("Data\\INI\\Weapon.ini");
+    ASSERT_EQ(copies.size(), 2u);
+    EXPECT_EQ(copies[0].entry, nullptr);
+    ASSERT_NE(copies[1].entry, nullptr);
+    EXPECT_EQ(files.physicalPath(copies[0], "data/ini/weapon.ini"),
+              (root / "mod").generic_string() + "/Data/INI/Weapon.ini");
+    EXPECT_EQ(files.physicalPath(copies[1], "data/ini/weapon.ini"), (root / "game" / "INIZH.big").string());
+
+    EXPECT_EQ(files.gamePathOf((root / "mod" / "Data" / "INI" / "Weapon.ini").string()), "data/ini/weapon.ini");
+    EXPECT_EQ(files.gamePathOf((root / "elsewhere.ini").string()), std::nullopt);
+}
+
+TEST_F(LayeredFileSystemTest, FirstArchiveKeepsAPath) {
+    // loadBigFilesFromDirectory reads INIZH.big before W3DZH.big and never overwrites
+    write("game/W3DZH.big", makeArchive({{"Data\\INI\\Weapon.ini", "second"}}));
+    write("game/INIZH.big", makeArchive({{"Data\\INI\\Weapon.ini", "first"}}));
+
+    LayeredFileSystem files;
+    EXPECT_EQ(files.addArchiveDirectory((root / "game").string()), 2u);
+    EXPECT_EQ(text(files, "Data\\INI\\Weapon.ini"), "first");
+    EXPECT_EQ(files.sources("Data\\INI\\Weapon.ini").size(), 2u);
+
+    write("Patch.big", makeArchive({{"Data\\INI\\Weapon.ini", "third"}}));
+    EXPECT_TRUE(files.addArchive((root / "Patch.big").string()));
+    EXPECT_FALSE(files.addArchive((root / "Missing.big").string()));
+    EXPECT_EQ(text(files, "Data\\INI\\Weapon.ini"), "first");
+}
+
+TEST_F(LayeredFileSystemTest, FollowsTheEngineLoadOrder) {
+    write("Data/INI/Weapon.ini", "");
+    write("Data/INI/Default/Object.ini", "");
+    write("Data/INI/Object/Sub/Nested.ini", "");
+    write("Data/INI/Object/ChinaTank.ini", "");
+    write("Data/INI/Object/AmericaTank.ini", "");
+    write("Data/INI/Object/ReadMe.txt", "");
+    write("Data/INI/Object/Civ/Farm.ini", "");
+    write("Data/INI/Object/Civ2/Barn.ini", "");
+    write("Data/INI/Default/GameData.ini", "");
+    write("Data/INI/GameData.ini", "");
+    write("Data/INI/Unused.ini", "");
+    write("Maps/Alpine/map.ini", "");
+    write("Maps/Alpine/solo.ini", "");
+    write("Maps/Alpine/Extra/map.ini", "");
+
+    LayeredFileSystem files;
+    files.addDirectory(root.string());
+
+    std::vector<std::string> paths;
+    for (const LoadedFile& file : files.loadOrder()) {
+        paths.push_back(file.path);
+    }
+    EXPECT_THAT(paths, ::testing::ElementsAre(
+        "data/ini/default/gamedata.ini", "data/ini/gamedata.ini", "data/ini/weapon.ini",
+        "data/ini/default/object.ini", "data/ini/object/americatank.ini", "data/ini/object/chinatank.ini",
+        "data/ini/object/civ2/barn.ini", "data/ini/object/civ/farm.ini", "data/ini/object/sub/nested.ini",
+        "maps/alpine/map.ini", "maps/alpine/solo.ini"));
+    EXPECT_EQ(files.loadOrder().front().mode, LoadMode::Overwrite);
+    EXPECT_EQ(files.loadOrder().back().mode, LoadMode::CreateOverrides);
+
+    EXPECT_EQ(files.loadRank("Data\\INI\\Default\\GameData.ini"), 0u);
+    EXPECT_LT(files.loadRank("Data\\INI\\Default\\Object.ini"), files.loadRank("Data\\INI\\Object\\ChinaTank.ini"));
+    EXPECT_EQ(files.loadRank("Data\\INI\\Unused.ini"), std::nullopt);
+}
+
+} // namespace
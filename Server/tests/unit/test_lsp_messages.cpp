@@ -64,6 +64,38 @@ TEST(LspMessagesTest, LocationSerialization) {
     EXPECT_EQ(j["range"]["end"]["character"], 4);
 }
 
+TEST(LspMessagesTest, SymbolInformationSerialization) {
+    ZeroSyntax::LSP::SymbolInformation symbol{
+        "AmericaTankCrusader",
+        5,
+        {"file:///mod/Object/Tank.ini", {{3, 7}, {3, 26}}},
+        "Object"
+    };
+    
+    nlohmann::json j = symbol;
+    
+    EXPECT_EQ(j["name"], "AmericaTankCrusader");
+    EXPECT_EQ(j["kind"], 5);
+    EXPECT_EQ(j["location"]["range"]["end"]["character"], 26);
+    EXPECT_EQ(j["containerName"], "Object");
+    EXPECT_EQ(j.get<ZeroSyntax::LSP::SymbolInformation>().location.uri, "file:///mod/Object/Tank.ini");
+}
+
+TEST(LspMessagesTest, HoverSerialization) {
+    ZeroSyntax::LSP::Hover hover{"**BuildTime** = 10", ZeroSyntax::LSP::Range{{2, 2}, {2, 11}}};
+    
+    nlohmann::json j = hover;
+    
+    EXPECT_EQ(j["contents"]["kind"], "markdown");
+    EXPECT_EQ(j["contents"]["value"], "**BuildTime** = 10");
+    EXPECT_EQ(j["range"]["end"]["character"], 11);
+    
+    auto parsed = j.get<ZeroSyntax::LSP::Hover>();
+    EXPECT_EQ(parsed.contents, hover.contents);
+    ASSERT_TRUE(parsed.range.has_value());
+    EXPECT_EQ(parsed.range->start.line, 2);
+}
+
 TEST(LspMessagesTest, DiagnosticSerialization) {
     ZeroSyntax::LSP::Diagnostic diag{
         {{1, 2}, {3, 4}},
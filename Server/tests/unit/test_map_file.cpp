@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+#include "map/map_file.hpp"
+#include <cstring>
+#include <map>
+
+namespace {
+
+using namespace ZeroSyntax::Map;
+
+void putInt(std::string& out, uint32_t value, int bytes = 4) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void putReal(std::string& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putInt(out, bits);
+}
+
+void putAscii(std::string& out, const std::string& text) {
+    putInt(out, static_cast<uint32_t>(text.size()), 2);
+    out += text;
+}
+
+// Writes chunks as DataChunkOutput does, numbering names as they are used
+class MapWriter {
+public:
+    uint32_t id(const std::string& name) {
+        auto found = ids_.find(name);
+        if (found != ids_.end()) {
+            return found->second;
+        }
+        uint32_t next = static_cast<uint32_t>(ids_.size()) + 1;
+        ids_.emplace(name, next);
+        return next;
+    }
+
+    std::string chunk(const std::string& name, uint16_t version, const std::string& payload) {
+        std::string out;
+        putInt(out, id(name));
+        putInt(out, version, 2);
+        putInt(out, static_cast<uint32_t>(payload.size()));
+        return out + payload;
+    }
+
+    void dictInt(std::string& out, const std::string& key, int32_t value) {
+        putInt(out, (id(key) << 8) | 1);
+        putInt(out, static_cast<uint32_t>(value));
+    }
+
+    void dictAscii(std::string& out, const std::string& key, const std::string& value) {
+        putInt(out, (id(key) << 8) | 3);
+        putAscii(out, value);
+    }
+
+    // The table of contents, then the chunks
+    std::string finish(const std::string& chunks) const {
+        std::string out = "CkMp";
+        putInt(out, static_cast<uint32_t>(ids_.size()));
+        for (const auto& [name, value] : ids_) {
+            out.push_back(static_cast<char>(name.size()));
+            out += name;
+            putInt(out, value);
+        }
+        return out + chunks;
+    }
+
+private:
+    std::map<std::string, uint32_t> ids_;
+};
+
+// Literal-only RefPack: the format at its simplest
+std::string refPack(const std::string& data) {
+    std::string out = "EAR";
+    out.push_back('\0');
+    putInt(out, static_cast<uint32_t>(data.size()));
+    out.push_back('\x10');
+    out.push_back('\xFB');
+    for (int shift = 16; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((data.size() >> shift) & 0xFF));
+    }
+    size_t offset = 0;
+    while (data.size() - offset >= 4) {
+        size_t n = std::min<size_t>(112, (data.size() - offset) & ~size_t(3));
+        out.push_back(static_cast<char>(0xE0 | ((n - 4) >> 2)));
+        out.append(data, offset, n);
+        offset += n;
+    }
+    out.push_back(static_cast<char>(0xFC | (data.size() - offset)));
+    out.append(data, offset, std::string::npos);
+    return out;
+}
+
+std::string object(MapWriter& writer, float x, float y, const std::string& name, const std::string& dict) {
+    std::string payload;
+    putReal(payload, x);
+    putReal(payload, y);
+    putReal(payload, 5);
+    putReal(payload, 0.5f);
+    putInt(payload, 0);
+    putAscii(payload, name);
+    payload += dict;
+    return writer.chunk("Object", 3, payload);
+}
+
+std::string sampleMap() {
+    MapWriter writer;
+    std::string chunks;
+
+    std::string heights;
+    putInt(heights, 3);  // width
+    putInt(heights, 2);  // height
+    putInt(heights, 1);  // border
+    putInt(heights, 1);  // boundaries
+    putInt(heights, 3);
+    putInt(heights, 2);
+    putInt(heights, 6);
+    heights += "abcdef";
+    chunks += writer.chunk("HeightMapData", 4, heights);
+    chunks += writer.chunk("BlendTileData", 8, std::string(4096, 'b'));
+
+    std::string world;
+    putInt(world, 1, 2);
+    writer.dictInt(world, "weather", 1);
+    chunks += writer.chunk("WorldInfo", 1, world);
+
+    std::string sides;
+    putInt(sides, 1);
+    putInt(sides, 1, 2);
+    writer.dictAscii(sides, "playerName", "ThePlayer");
+    putInt(sides, 1);  // build list
+    putAscii(sides, "Barracks1");
+    putAscii(sides, "AmericaBarracks");
+    for (float value : {10.0f, 20.0f, 0.0f, 0.0f}) {
+        putReal(sides, value);
+    }
+    sides.push_back(1);
+    putInt(sides, 2);
+    putAscii(sides, "");
+    putInt(sides, 100);
+    sides += std::string("\x01\x00\x01", 3);
+    putInt(sides, 1);  // teams
+    putInt(sides, 1, 2);
+    writer.dictAscii(sides, "teamName", "teamThePlayer");
+    sides += writer.chunk("PlayerScriptsList", 1, "scripts");
+    chunks += writer.chunk("SidesList", 3, sides);
+
+    std::string objects;
+    std::string waypoint;
+    putInt(waypoint, 2, 2);
+    writer.dictInt(waypoint, "waypointID", 7);
+    writer.dictAscii(waypoint, "waypointName", "Start");
+    objects += object(writer, 1, 2, "*Waypoints/Waypoint", waypoint);
+    std::string none;
+    putInt(none, 0, 2);
+    objects += object(writer, 3, 4, "AmericaTankCrusader", none);
+    chunks += writer.chunk("ObjectsList", 3, objects);
+
+    std::string links;
+    putInt(links, 1);
+    putInt(links, 7);
+    putInt(links, 8);
+    chunks += writer.chunk("WaypointsList", 1, links);
+    return writer.finish(chunks);
+}
+
+void expectSample(const MapFile& map) {
+    EXPECT_TRUE(map.has(ChunkKind::HeightMapData));
+    EXPECT_FALSE(map.has(ChunkKind::PolygonTriggers));
+
+    const HeightMap* heights = map.heightMap();
+    ASSERT_NE(heights, nullptr);
+    EXPECT_EQ(heights->width, 3);
+    EXPECT_EQ(heights->height, 2);
+    EXPECT_EQ(heights->border, 1);
+    ASSERT_EQ(heights->boundaries.size(), 1u);
+    EXPECT_EQ(heights->boundaries[0], std::make_pair(3, 2));
+    EXPECT_EQ(heights->heights, "abcdef");
+
+    std::optional<Chunk> blend = map.section(ChunkKind::BlendTileData);
+    ASSERT_TRUE(blend);
+    EXPECT_EQ(blend->version, 8);
+    EXPECT_EQ(blend->data, std::string(4096, 'b'));
+
+    const DictEntry* weather = findEntry(map.worldInfo(), "weather");
+    ASSERT_NE(weather, nullptr);
+    EXPECT_EQ(weather->intValue, 1);
+
+    const auto& objects = map.objects();
+    ASSERT_EQ(objects.size(), 2u);
+    EXPECT_EQ(objects[1].name, "AmericaTankCrusader");
+    EXPECT_EQ(objects[1].x, 3);
+    EXPECT_EQ(objects[1].z, 5);
+
+    ASSERT_EQ(map.waypoints().size(), 1u);
+    EXPECT_EQ(map.waypoints()[0].id, 7);
+    EXPECT_EQ(map.waypoints()[0].name, "Start");
+    ASSERT_EQ(map.waypointLinks().size(), 1u);
+    EXPECT_EQ(map.waypointLinks()[0].to, 8);
+
+    ASSERT_EQ(map.sides().size(), 1u);
+    ASSERT_EQ(map.sides()[0].buildList.size(), 1u);
+    EXPECT_EQ(map.sides()[0].buildList[0].templateName, "AmericaBarracks");
+    ASSERT_EQ(map.teams().size(), 1u);
+    EXPECT_EQ(findEntry(map.teams()[0], "teamName")->text, "teamThePlayer");
+
+    std::optional<Chunk> scripts = map.playerScripts();
+    ASSERT_TRUE(scripts);
+    EXPECT_EQ(scripts->data, "scripts");
+}
+
+TEST(MapFileTest, ReadsTheTable) {
+    std::string data = sampleMap();
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    EXPECT_EQ(map.table().kind(map.section(ChunkKind::WorldInfo)->id), ChunkKind::WorldInfo);
+    EXPECT_EQ(map.table().name(map.section(ChunkKind::ObjectsList)->id), "ObjectsList");
+    EXPECT_EQ(chunkKindOf("ScriptActionFalse"), ChunkKind::ScriptActionFalse);
+    EXPECT_EQ(chunkKindOf("NotAChunk"), ChunkKind::Unknown);
+}
+
+TEST(MapFileTest, Uncompressed) {
+    std::string data = sampleMap();
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    EXPECT_EQ(map.compression(), ZeroSyntax::Vfs::Compression::None);
+    expectSample(map);
+    // Read in place
+    EXPECT_EQ(map.heightMap()->heights.data(), data.data() + data.find("abcdef"));
+}
+
+TEST(MapFileTest, Compressed) {
+    std::string data = refPack(sampleMap());
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    EXPECT_EQ(map.compression(), ZeroSyntax::Vfs::Compression::RefPack);
+    expectSample(map);
+}
+
+TEST(MapFileTest, RejectsCorruptMaps) {
+    std::string data = sampleMap();
+    MapFile map;
+    for (size_t size : {size_t(0), size_t(3), size_t(30), data.size() - 5}) {
+        EXPECT_FALSE(map.load(data.substr(0, size))) << size;
+        EXPECT_FALSE(map.has(ChunkKind::HeightMapData));
+    }
+    std::string compressed = refPack(data);
+    EXPECT_FALSE(map.load(compressed.substr(0, compressed.size() - 4)));
+    EXPECT_FALSE(map.load("HeightMapData"));
+
+    // A section whose contents are cut short reads as empty
+    std::string flawed = data;
+    size_t links = flawed.rfind('\x07');
+    flawed[links - 4] = 9;  // nine links
+    ASSERT_TRUE(map.load(flawed));
+    EXPECT_TRUE(map.waypointLinks().empty());
+    EXPECT_EQ(map.objects().size(), 2u);
+
+    EXPECT_FALSE(map.open("no/such/file.map"));
+}
+
+} // namespace
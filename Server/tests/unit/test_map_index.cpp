@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "core/map_index.hpp"
+#include "core/workspace_index.hpp"
+#include "map/map_file.hpp"
+#include "utils/uri.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using namespace ZeroSyntax;
+
+void putInt(std::string& out, uint32_t value, int bytes = 4) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// An uncompressed map holding only an ObjectsList. Ids: 1 ObjectsList,
+// 2 Object, 3 waypointID, 4 lightHeightAboveTerrain.
+class ObjectsWriter {
+public:
+    void add(const std::string& name, int32_t flags = 0, const std::string& dict = std::string(2, '\0')) {
+        std::string payload(16, '\0');  // position and angle
+        putInt(payload, static_cast<uint32_t>(flags));
+        putInt(payload, static_cast<uint32_t>(name.size()), 2);
+        payload += name + dict;
+        putInt(objects_, 2);
+        putInt(objects_, 3, 2);
+        putInt(objects_, static_cast<uint32_t>(payload.size()));
+        objects_ += payload;
+    }
+
+    std::string finish() const {
+        std::string out = "CkMp";
+        putInt(out, 4);
+        uint32_t id = 1;
+        for (const char* name : {"ObjectsList", "Object", "waypointID", "lightHeightAboveTerrain"}) {
+            out.push_back(static_cast<char>(std::strlen(name)));
+            out += name;
+            putInt(out, id++);
+        }
+        putInt(out, 1);
+        putInt(out, 1, 2);
+        putInt(out, static_cast<uint32_t>(objects_.size()));
+        return out + objects_;
+    }
+
+private:
+    std::string objects_;
+};
+
+std::string dictOf(uint32_t keyId, uint8_t type, const std::string& value) {
+    std::string dict;
+    putInt(dict, 1, 2);
+    putInt(dict, (keyId << 8) | type);
+    return dict + value;
+}
+
+TEST(MapIndexTest, CollectsPlacedTemplates) {
+    ObjectsWriter writer;
+    writer.add("Tank");
+    writer.add("Barracks");
+    writer.add("Tank");
+    writer.add("*Waypoints/Waypoint", 0, dictOf(3, 1, std::string("\x05\0\0\0", 4)));
+    writer.add("*Lights/Light", 0, dictOf(4, 2, std::string(4, '\0')));
+    writer.add("TwoLaneRoad", 0x02);
+    writer.add("WoodBridge", 0x20);
+    std::string data = writer.finish();
+
+    Map::MapFile map;
+    ASSERT_TRUE(map.load(data));
+    ASSERT_EQ(map.objects().size(), 7u);
+    auto templates = MapIndex::collect(map);
+    ASSERT_EQ(templates.size(), 2u);
+    EXPECT_EQ(templates[0].name, "Barracks");
+    EXPECT_EQ(templates[0].count, 1u);
+    EXPECT_EQ(templates[1].name, "Tank");
+    EXPECT_EQ(templates[1].count, 2u);
+}
+
+TEST(MapIndexTest, JoinsTemplatesWithDefinitions) {
+    WorkspaceIndex index;
+    index.updateFile("file:///Object.ini", WorkspaceIndex::collect("file:///Object.ini", Ini::SyntaxTree::parse(
+        "Object Tank\nEnd\nObjectReskin tank Tank\nEnd\nWeapon Barracks\nEnd\n")));
+    std::vector<std::string> names = {"Tank", "Barracks", "tank", "Zebra", "TANK"};
+    std::vector<bool> defined = index.defines("Object", names);
+    EXPECT_EQ(defined, std::vector<bool>({true, false, true, false, false}));
+
+    MapIndex maps;
+    maps.updateFile("file:///a.map", {{"Barracks", 3}, {"Tank", 1}});
+    maps.updateFile("file:///b.map", {{"Tank", 2}});
+    EXPECT_EQ(maps.referencedNames(), StoreNames({{"Object", {"Barracks", "Tank"}}}));
+
+    auto diagnostics = maps.diagnose({{"Object", {"Barracks"}}});
+    ASSERT_EQ(diagnostics.size(), 2u);
+    EXPECT_TRUE(diagnostics["file:///b.map"].empty());
+    ASSERT_EQ(diagnostics["file:///a.map"].size(), 1u);
+    EXPECT_EQ(diagnostics["file:///a.map"][0].severity, LSP::DiagnosticSeverity::Warning);
+    EXPECT_NE(diagnostics["file:///a.map"][0].message.find("'Barracks' is placed 3 times"), std::string::npos);
+    EXPECT_TRUE(maps.diagnose("file:///a.map", {{"Object", {"Apc", "Zebra"}}, {"Upgrade", {"Barracks"}}}).empty());
+    EXPECT_TRUE(maps.diagnose("file:///c.map", {{"Object", {"Barracks"}}}).empty());
+}
+
+TEST(MapIndexTest, ReadsOnlyChangedMaps) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_map_index_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "Maps" / "Alpine");
+    ObjectsWriter first;
+    first.add("Tank");
+    std::ofstream(root / "Maps" / "Alpine" / "Alpine.MAP", std::ios::binary) << first.finish();
+    std::ofstream(root / "Maps" / "notes.txt") << "Tank";
+
+    MapIndex maps;
+    EXPECT_EQ(maps.indexDirectory(root.string(), 2), 1u);
+    std::string uri = pathToUri((fs::absolute(root) / "Maps" / "Alpine" / "Alpine.MAP").generic_string());
+    ASSERT_EQ(maps.templates(uri).size(), 1u);
+    EXPECT_FALSE(maps.indexFile(uri));
+
+    ObjectsWriter second;
+    second.add("Tank");
+    second.add("Humvee");
+    std::ofstream(root / "Maps" / "Alpine" / "Alpine.MAP", std::ios::binary | std::ios::trunc) << second.finish();
+    EXPECT_TRUE(maps.indexFile(uri));
+    EXPECT_EQ(maps.referencedNames(uri), StoreNames({{"Object", {"Humvee", "Tank"}}}));
+
+    fs::remove_all(root);
+    EXPECT_TRUE(maps.indexFile(uri));
+    EXPECT_EQ(maps.fileCount(), 0u);
+}
+
+} // namespace
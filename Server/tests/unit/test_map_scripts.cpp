@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include "core/map_index.hpp"
+#include "map/map_file.hpp"
+#include "map/map_scripts.hpp"
+#include <cstring>
+#include <map>
+
+namespace {
+
+using namespace ZeroSyntax;
+using namespace ZeroSyntax::Map;
+
+void putInt(std::string& out, uint32_t value, int bytes = 4) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void putReal(std::string& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putInt(out, bits);
+}
+
+void putAscii(std::string& out, const std::string& text) {
+    putInt(out, static_cast<uint32_t>(text.size()), 2);
+    out += text;
+}
+
+// Writes chunks as DataChunkOutput does, numbering names as they are used
+class ScriptWriter {
+public:
+    uint32_t id(const std::string& name) {
+        auto found = ids_.find(name);
+        if (found != ids_.end()) {
+            return found->second;
+        }
+        uint32_t next = static_cast<uint32_t>(ids_.size()) + 1;
+        ids_.emplace(name, next);
+        return next;
+    }
+
+    std::string chunk(const std::string& name, uint16_t version, const std::string& payload) {
+        std::string out;
+        putInt(out, id(name));
+        putInt(out, version, 2);
+        putInt(out, static_cast<uint32_t>(payload.size()));
+        return out + payload;
+    }
+
+    void dictAscii(std::string& out, const std::string& key, const std::string& value) {
+        putInt(out, (id(key) << 8) | 3);
+        putAscii(out, value);
+    }
+
+    // Parameter::WriteParameter
+    static std::string parameter(ParameterType type, const std::string& text) {
+        std::string out;
+        putInt(out, static_cast<uint32_t>(type));
+        putInt(out, 0);
+        putReal(out, 0);
+        putAscii(out, text);
+        return out;
+    }
+
+    std::string clause(const std::string& label, const std::string& name, const std::vector<std::string>& parameters) {
+        std::string payload;
+        putInt(payload, 7);
+        putInt(payload, id(name) << 8);
+        putInt(payload, static_cast<uint32_t>(countOverride >= 0 ? countOverride : int32_t(parameters.size())));
+        countOverride = -1;
+        for (const std::string& parameter : parameters) {
+            payload += parameter;
+        }
+        return chunk(label, label == "Condition" ? 4 : 2, payload);
+    }
+
+    std::string script(const std::string& name, const std::string& clauses) {
+        std::string payload;
+        putAscii(payload, name);
+        putAscii(payload, "comment");
+        putAscii(payload, "");
+        putAscii(payload, "");
+        payload += std::string("\x01\x01\x01\x01\x01\x00", 6);
+        putInt(payload, 2);  // delay
+        return chunk("Script", 2, payload + clauses);
+    }
+
+    std::string finish(const std::string& chunks) const {
+        std::string out = "CkMp";
+        putInt(out, static_cast<uint32_t>(ids_.size()));
+        for (const auto& [name, value] : ids_) {
+            out.push_back(static_cast<char>(name.size()));
+            out += name;
+            putInt(out, value);
+        }
+        return out + chunks;
+    }
+
+    int32_t countOverride = -1;  // parameter count the next clause claims
+
+private:
+    std::map<std::string, uint32_t> ids_;
+};
+
+// One player with a team and a waypoint, and scripts naming both, others
+// the map lacks, and definitions
+std::string scriptedMap(int32_t parameterCount = -1) {
+    ScriptWriter writer;
+    writer.countOverride = parameterCount;
+    using P = ParameterType;
+    std::string intro = writer.script(
+        "Intro",
+        writer.chunk("OrCondition", 1, writer.clause("Condition", "TEAM_DESTROYED", {writer.parameter(P::Team, "Raiders")})) +
+            writer.chunk("OrCondition", 1,
+                         writer.clause("Condition", "TEAM_DESTROYED",
+                                       {writer.parameter(P::Team, "Ghosts"), writer.parameter(P::Waypoint, "Nowhere"),
+                                        writer.parameter(P::Team, "Ghosts")})) +
+            writer.clause("ScriptAction", "CREATE_OBJECT",
+                          {writer.parameter(P::ObjectType, "FundamentalistTechnical"),
+                           [] {
+                               std::string coord;
+                               putInt(coord, static_cast<uint32_t>(P::Coord3D));
+                               for (float value : {1.0f, 2.0f, 3.0f}) {
+                                   putReal(coord, value);
+                               }
+                               return coord;
+                           }(),
+                           writer.parameter(P::Upgrade, "Upgrade_GLARebelCaptureBuilding")}) +
+            writer.clause("ScriptActionFalse", "GRANT_SCIENCE",
+                          {writer.parameter(P::Science, "SCIENCE_Missing"), writer.parameter(P::Team, "<This Team>")}));
+    std::string later = writer.script(
+        "Later", writer.clause("ScriptAction", "OBJECTLIST_ADDOBJECTTYPE",
+                               {writer.parameter(P::ObjectTypeList, "MyList"), writer.parameter(P::ObjectType, "MyList"),
+                                writer.parameter(P::ObjectType, "GLATechnical"),
+                                writer.parameter(P::SpecialPower, "SuperweaponX"),
+                                writer.parameter(P::Waypoint, "Start"), writer.parameter(P::Team, "teamThePlayer")}));
+    std::string group;
+    putAscii(group, "Group");
+    group += std::string("\x01\x00", 2);
+    std::string list = intro + writer.chunk("ScriptGroup", 2, group + later);
+    std::string scripts = writer.chunk("ScriptList", 1, list) + writer.chunk("ScriptList", 1, "");
+
+    std::string sides;
+    putInt(sides, 1);
+    putInt(sides, 1, 2);
+    writer.dictAscii(sides, "playerName", "ThePlayer");
+    putInt(sides, 0);  // build list
+    putInt(sides, 1);  // teams
+    putInt(sides, 1, 2);
+    writer.dictAscii(sides, "teamName", "Raiders");
+    sides += writer.chunk("PlayerScriptsList", 1, scripts);
+    std::string chunks = writer.chunk("SidesList", 3, sides);
+
+    std::string waypoint;
+    putInt(waypoint, 2, 2);
+    putInt(waypoint, (writer.id("waypointID") << 8) | 1);
+    putInt(waypoint, 1);
+    writer.dictAscii(waypoint, "waypointName", "Start");
+    std::string object(16, '\0');
+    putInt(object, 0);
+    putAscii(object, "*Waypoints/Waypoint");
+    chunks += writer.chunk("ObjectsList", 3, writer.chunk("Object", 3, object + waypoint));
+    return writer.finish(chunks);
+}
+
+TEST(MapScriptsTest, DecodesScripts) {
+    std::string data = scriptedMap();
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    std::optional<Chunk> chunk = map.playerScripts();
+    ASSERT_TRUE(chunk);
+    MapScripts scripts;
+    ASSERT_TRUE(scripts.decode(*chunk, map.table()));
+    EXPECT_EQ(scripts.playerCount(), 2u);
+
+    ASSERT_EQ(scripts.scripts().size(), 2u);
+    const Script& intro = scripts.scripts()[0];
+    EXPECT_EQ(intro.name, "Intro");
+    EXPECT_EQ(intro.comment, "comment");
+    EXPECT_EQ(intro.group, MapScripts::kNoGroup);
+    EXPECT_TRUE(intro.hard);
+    EXPECT_FALSE(intro.subroutine);
+    EXPECT_EQ(intro.delaySeconds, 2);
+    ASSERT_EQ(intro.clauseCount, 4u);
+    ASSERT_EQ(scripts.groups().size(), 1u);
+    EXPECT_EQ(scripts.groups()[0].name, "Group");
+    EXPECT_EQ(scripts.scripts()[1].group, 0u);
+
+    const auto& clauses = scripts.clauses();
+    EXPECT_EQ(clauses[0].kind, ClauseKind::Condition);
+    EXPECT_EQ(clauses[0].orGroup, 0u);
+    EXPECT_EQ(clauses[1].orGroup, 1u);
+    EXPECT_EQ(clauses[1].parameterCount, 3u);
+    EXPECT_EQ(clauses[2].kind, ClauseKind::Action);
+    EXPECT_EQ(clauses[2].name, "CREATE_OBJECT");
+    EXPECT_EQ(clauses[3].kind, ClauseKind::ActionFalse);
+
+    // The engine's renames
+    const ScriptParameter* create = &scripts.parameters()[clauses[2].firstParameter];
+    EXPECT_EQ(create[0].text, "GLATechnical");
+    EXPECT_EQ(create[1].type, ParameterType::Coord3D);
+    EXPECT_EQ(create[1].y, 2);
+    EXPECT_EQ(create[2].text, "Upgrade_InfantryCaptureBuilding");
+
+    uint32_t first = clauses[2].firstParameter;
+    MapScripts moved = std::move(scripts);
+    EXPECT_EQ(moved.parameters()[first].text, "GLATechnical");
+}
+
+TEST(MapScriptsTest, RejectsCorruptScripts) {
+    std::string data = scriptedMap(13);
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    MapScripts scripts;
+    EXPECT_FALSE(scripts.decode(*map.playerScripts(), map.table()));
+    EXPECT_LT(scripts.clauses().size(), 5u);
+}
+
+TEST(MapScriptsTest, ChecksReferences) {
+    std::string data = scriptedMap();
+    MapFile map;
+    ASSERT_TRUE(map.load(data));
+    ScriptCheck check = MapIndex::checkScripts(map);
+
+    ASSERT_EQ(check.references.size(), 4u);
+    EXPECT_EQ(check.references[0].blockType, "Object");
+    EXPECT_EQ(check.references[0].name, "GLATechnical");
+    EXPECT_EQ(check.references[0].script, "Intro");
+    EXPECT_EQ(check.references[0].count, 2u);
+    EXPECT_EQ(check.references[1].name, "SCIENCE_Missing");
+    EXPECT_EQ(check.references[2].blockType, "SpecialPower");
+    EXPECT_EQ(check.references[3].name, "Upgrade_InfantryCaptureBuilding");
+
+    // Ghosts once, though named twice
+    ASSERT_EQ(check.warnings.size(), 2u);
+    EXPECT_EQ(check.warnings[0].message, "Script 'Intro' names team 'Ghosts', which the map does not define");
+    EXPECT_EQ(check.warnings[1].message, "Script 'Intro' names waypoint 'Nowhere', which the map does not define");
+
+    MapIndex maps;
+    maps.updateFile("file:///a.map", MapIndex::collect(map), std::move(check));
+    StoreNames names = maps.referencedNames();
+    EXPECT_EQ(names["Science"], std::vector<std::string>({"SCIENCE_Missing"}));
+    EXPECT_TRUE(names["Object"].size() == 1u);
+
+    auto diagnostics = maps.diagnose("file:///a.map", {{"Object", {"GLATechnical"}}, {"Science", {"SCIENCE_Missing"}}});
+    ASSERT_EQ(diagnostics.size(), 4u);
+    EXPECT_EQ(diagnostics[0].message, "Script 'Intro' names Object 'GLATechnical' (used 2 times), which no INI file defines");
+    EXPECT_EQ(diagnostics[1].message, "Script 'Intro' names Science 'SCIENCE_Missing', which no INI file defines");
+    EXPECT_EQ(maps.diagnose("file:///a.map", {}).size(), 2u);
+}
+
+} // namespace
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "utils/parallel.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace ZeroSyntax;
+
+TEST(ParallelTest, RunsEveryIndexOnce) {
+    std::vector<std::atomic<int>> runs(1000);
+    size_t threads = parallelFor(runs.size(), 4, [&](size_t index, size_t worker) {
+        EXPECT_LT(worker, 4u);
+        ++runs[index];
+    });
+    EXPECT_EQ(threads, 4u);
+    for (const auto& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ParallelTest, SmallInputsUseFewerThreads) {
+    EXPECT_EQ(parallelFor(0, 8, [](size_t, size_t) { FAIL(); }), 1u);
+
+    std::atomic<int> runs{0};
+    EXPECT_EQ(parallelFor(2, 8, [&](size_t, size_t) { ++runs; }), 2u);
+    EXPECT_EQ(runs.load(), 2);
+}
+
+TEST(ParallelTest, IdleThreadsStealFromBusyOnes) {
+    // All slow items start out in the first thread's slice; without stealing
+    // they would run one after another
+    auto started = std::chrono::steady_clock::now();
+    parallelFor(64, 4, [](size_t index, size_t) {
+        if (index < 8) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+    });
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    EXPECT_LT(elapsed, std::chrono::milliseconds(150));
+}
+
+} // namespace
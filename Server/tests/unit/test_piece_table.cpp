@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "core/piece_table.hpp"
+#include <random>
+
+namespace {
+
+using ZeroSyntax::PieceTable;
+
+TEST(PieceTableTest, EmptyDocument) {
+    PieceTable table;
+
+    EXPECT_EQ(table.length(), 0u);
+    EXPECT_EQ(table.lineCount(), 1u);
+    EXPECT_EQ(table.text(), "");
+    EXPECT_EQ(table.offsetAt({0, 5}), 0u);
+}
+
+TEST(PieceTableTest, InsertAndErase) {
+    PieceTable table("Object Foo\nEnd\n");
+
+    table.insert(11, "  Side = America\n");
+    EXPECT_EQ(table.text(), "Object Foo\n  Side = America\nEnd\n");
+
+    table.erase(0, 7);
+    EXPECT_EQ(table.text(), "Foo\n  Side = America\nEnd\n");
+
+    table.replace(0, 3, "Bar");
+    EXPECT_EQ(table.text(), "Bar\n  Side = America\nEnd\n");
+    EXPECT_EQ(table.lineCount(), 4u);
+}
+
+TEST(PieceTableTest, LineOffsets) {
+    PieceTable table("a\nbb\n\nccc");
+
+    EXPECT_EQ(table.lineOffset(0), 0u);
+    EXPECT_EQ(table.lineOffset(1), 2u);
+    EXPECT_EQ(table.lineOffset(2), 5u);
+    EXPECT_EQ(table.lineOffset(3), 6u);
+    EXPECT_EQ(table.lineOffset(4), table.length());
+}
+
+TEST(PieceTableTest, Utf16Positions) {
+    // "é" is 2 bytes / 1 UTF-16 unit, U+1F600 is 4 bytes / 2 UTF-16 units
+    PieceTable table("x\n\xC3\xA9" "a\xF0\x9F\x98\x80" "b\n");
+
+    EXPECT_EQ(table.offsetAt({1, 0}), 2u);
+    EXPECT_EQ(table.offsetAt({1, 1}), 4u);
+    EXPECT_EQ(table.offsetAt({1, 2}), 5u);
+    EXPECT_EQ(table.offsetAt({1, 4}), 9u);
+    EXPECT_EQ(table.offsetAt({1, 99}), 10u);  // clamped to the end of the line
+
+    auto position = table.positionAt(9);
+    EXPECT_EQ(position.line, 1);
+    EXPECT_EQ(position.character, 4);
+}
+
+TEST(PieceTableTest, RangeReplace) {
+    PieceTable table("Weapon Gun\n  Damage = 10\nEnd\n");
+
+    // Replace "10" with "25"
+    table.replace(ZeroSyntax::LSP::Range{{1, 11}, {1, 13}}, "25");
+    EXPECT_EQ(table.text(), "Weapon Gun\n  Damage = 25\nEnd\n");
+
+    // Insert a whole line
+    table.replace(ZeroSyntax::LSP::Range{{2, 0}, {2, 0}}, "  Radius = 5\n");
+    EXPECT_EQ(table.text(), "Weapon Gun\n  Damage = 25\n  Radius = 5\nEnd\n");
+}
+
+TEST(PieceTableTest, SnapshotsAreIndependent) {
+    PieceTable table("abc");
+    PieceTable snapshot = table;
+
+    table.insert(1, "XYZ");
+
+    EXPECT_EQ(table.text(), "aXYZbc");
+    EXPECT_EQ(snapshot.text(), "abc");
+}
+
+TEST(PieceTableTest, RandomEditsMatchString) {
+    std::mt19937 rng(1234);
+    std::string model = "Object A\n  KindOf = INFANTRY\nEnd\n";
+    PieceTable table(model);
+
+    for (int i = 0; i < 2000; ++i) {
+        size_t offset = rng() % (model.size() + 1);
+        if (rng() % 3 == 0 && !model.empty()) {
+            size_t count = rng() % 8;
+            table.erase(offset, count);
+            model.erase(std::min(offset, model.size()), count);
+        } else {
+            std::string text = (rng() % 4 == 0) ? "\n" : std::string(1 + rng() % 4, static_cast<char>('a' + rng() % 26));
+            table.insert(offset, text);
+            model.insert(offset, text);
+        }
+    }
+
+    ASSERT_EQ(table.text(), model);
+
+    size_t lines = 1 + std::count(model.begin(), model.end(), '\n');
+    ASSERT_EQ(table.lineCount(), lines);
+
+    size_t lineStart = 0;
+    for (size_t line = 0; line < lines; ++line) {
+        EXPECT_EQ(table.lineOffset(line), lineStart);
+        lineStart = model.find('\n', lineStart) + 1;
+    }
+
+    for (size_t offset = 0; offset < model.size(); offset += 7) {
+        EXPECT_EQ(table.at(offset), model[offset]);
+        EXPECT_EQ(table.offsetAt(table.positionAt(offset)), offset);
+    }
+}
+
+} // namespace
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "protocol/json_rpc_handler.hpp"
+#include "protocol/request_scheduler.hpp"
+#include <chrono>
+#include <future>
+
+namespace {
+
+using ZeroSyntax::RequestScheduler;
+
+// Collect completed responses until count have arrived
+std::vector<std::string> waitForResponses(RequestScheduler& scheduler, size_t count) {
+    std::vector<std::string> responses;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (responses.size() < count && std::chrono::steady_clock::now() < deadline) {
+        for (auto& response : scheduler.takeCompleted()) {
+            responses.push_back(std::move(response));
+        }
+        std::this_thread::yield();
+    }
+    return responses;
+}
+
+RequestScheduler::Reject rejectWith(const std::string& id) {
+    return [id](int code, const std::string& message) {
+        return id + ":" + std::to_string(code) + ":" + message;
+    };
+}
+
+TEST(RequestSchedulerTest, RunsInlineWithoutWorkers) {
+    RequestScheduler scheduler(0);
+
+    scheduler.submit("1", "completion a", "a", [] { return std::string("done"); }, rejectWith("1"));
+
+    EXPECT_EQ(scheduler.inFlight(), 0u);
+    EXPECT_THAT(scheduler.takeCompleted(), ::testing::ElementsAre("done"));
+}
+
+TEST(RequestSchedulerTest, PostedTasksYieldToRequests) {
+    RequestScheduler scheduler(1);
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    scheduler.submit("1", "busy", "x", [released] { released.wait(); return std::string("1:ok"); }, rejectWith("1"));
+    while (scheduler.inFlight() != 1) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // Queued before the request, run after it, and answered to nobody
+    std::vector<std::string> order;
+    std::promise<void> posted;
+    scheduler.post([&] { order.push_back("task"); posted.set_value(); });
+    scheduler.submit("2", "hover a", "a", [&] { order.push_back("request"); return std::string("2:ok"); },
+                     rejectWith("2"));
+    release.set_value();
+
+    ASSERT_EQ(posted.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_THAT(order, ::testing::ElementsAre("request", "task"));
+    EXPECT_THAT(waitForResponses(scheduler, 2), ::testing::UnorderedElementsAre("1:ok", "2:ok"));
+}
+
+TEST(RequestSchedulerTest, DropsCancelledAndSupersededRequests) {
+    RequestScheduler scheduler(1);
+
+    // Keep the only worker busy so the following requests stay pending
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    scheduler.submit("1", "busy", "x", [released] { released.wait(); return std::string("1:ok"); }, rejectWith("1"));
+    while (scheduler.inFlight() != 1) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    scheduler.submit("2", "completion a", "a", [] { return std::string("2:ok"); }, rejectWith("2"));
+    scheduler.submit("3", "completion a", "a", [] { return std::string("3:ok"); }, rejectWith("3"));
+    scheduler.submit("4", "definition b", "b", [] { return std::string("4:ok"); }, rejectWith("4"));
+    scheduler.submit("5", "definition c", "c", [] { return std::string("5:ok"); }, rejectWith("5"));
+
+    scheduler.cancel("4");
+    scheduler.documentChanged("c");
+    release.set_value();
+
+    auto responses = waitForResponses(scheduler, 5);
+    EXPECT_THAT(responses, ::testing::UnorderedElementsAre(
+        "1:ok",
+        "2:-32800:Request superseded",
+        "3:ok",
+        "4:-32800:Request cancelled",
+        "5:-32801:Content modified"));
+    EXPECT_EQ(scheduler.inFlight(), 0u);
+}
+
+TEST(RequestSchedulerTest, RunningRequestInvalidatedByChange) {
+    RequestScheduler scheduler(1);
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    scheduler.submit("1", "hover a", "a", [released] { released.wait(); return std::string("1:ok"); }, rejectWith("1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    scheduler.documentChanged("a");
+    release.set_value();
+
+    EXPECT_THAT(waitForResponses(scheduler, 1), ::testing::ElementsAre("1:-32801:Content modified"));
+}
+
+TEST(RequestSchedulerTest, JsonRpcHandlerDispatchesConcurrentMethods) {
+    RequestScheduler scheduler(2);
+    ZeroSyntax::JsonRpcHandler handler;
+    handler.setScheduler(&scheduler);
+
+    handler.registerConcurrentMethod("test/read", [](const nlohmann::json& params) {
+        return nlohmann::json({{"echo", params["value"]}});
+    });
+
+    auto inlineResponse = handler.handleRequest(R"({"jsonrpc": "2.0", "id": 7, "method": "test/read", "params": {"value": 42}})");
+    EXPECT_FALSE(inlineResponse.has_value());
+
+    auto responses = waitForResponses(scheduler, 1);
+    ASSERT_EQ(responses.size(), 1u);
+
+    auto parsed = nlohmann::json::parse(responses[0]);
+    EXPECT_EQ(parsed["id"], 7);
+    EXPECT_EQ(parsed["result"]["echo"], 42);
+
+    // Cancellation notifications never produce a reply of their own
+    EXPECT_FALSE(handler.handleRequest(R"({"jsonrpc": "2.0", "method": "$/cancelRequest", "params": {"id": 7}})").has_value());
+}
+
+} // namespace
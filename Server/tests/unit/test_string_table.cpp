@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "text/string_table.hpp"
+
+namespace {
+
+using ZeroSyntax::Text::StringTable;
+
+void putLittleEndian(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void putId(std::string& out, const char* id) {
+    // Ids are compared as integers built from the characters in reading order
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(id[i]);
+    }
+}
+
+struct CsfLabel {
+    std::string label;
+    std::vector<std::u16string> strings;
+    std::string speech;
+};
+
+// A version 3 CSF holding the labels in the given order
+std::string makeCsf(const std::vector<CsfLabel>& labels, uint32_t language = 0) {
+    std::string csf;
+    putId(csf, "CSF ");
+    putLittleEndian(csf, 3);
+    putLittleEndian(csf, static_cast<uint32_t>(labels.size()));
+    putLittleEndian(csf, static_cast<uint32_t>(labels.size()));
+    putLittleEndian(csf, 0);
+    putLittleEndian(csf, language);
+    for (const auto& label : labels) {
+        putId(csf, "LBL ");
+        putLittleEndian(csf, static_cast<uint32_t>(label.strings.size()));
+        putLittleEndian(csf, static_cast<uint32_t>(label.label.size()));
+        csf += label.label;
+        for (const auto& text : label.strings) {
+            putId(csf, label.speech.empty() ? "STR " : "STRW");
+            putLittleEndian(csf, static_cast<uint32_t>(text.size()));
+            for (char16_t unit : text) {
+                auto inverted = static_cast<char16_t>(~unit);
+                csf.push_back(static_cast<char>(inverted & 0xFF));
+                csf.push_back(static_cast<char>(inverted >> 8));
+            }
+            if (!label.speech.empty()) {
+                putLittleEndian(csf, static_cast<uint32_t>(label.speech.size()));
+                csf += label.speech;
+            }
+        }
+    }
+    return csf;
+}
+
+TEST(StringTableTest, LoadsCompiledStrings) {
+    StringTable table;
+    ASSERT_TRUE(table.loadCsf(makeCsf({
+        {"OBJECT:Ranger", {u"  Ranger  ", u"Ignored"}, ""},
+        {"GUI:Command&ConquerGenerals", {u"Command & Conquer\u2122 Generals"}, ""},
+        {"Dialog:Hello", {u"Hello"}, "hello01"},
+        {"OBJECT:Crusader", {u"Crusader  Tank\n  Second line"}, ""},
+        {"object:ranger", {u"Repeated"}, ""},
+    }, 1)));
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.language(), 1u);
+
+    // Labels are found in any case, and the first of a repeated label wins
+    auto ranger = table.find("Object:RANGER");
+    ASSERT_TRUE(ranger.has_value());
+    EXPECT_EQ(table.label(*ranger), "OBJECT:Ranger");
+    EXPECT_EQ(table.text(*ranger), "Ranger");
+    EXPECT_EQ(table.text(*table.find("OBJECT:Crusader")), "Crusader Tank\nSecond line");
+    EXPECT_EQ(table.text(*table.find("GUI:Command&ConquerGenerals")), "Command & Conquer\xE2\x84\xA2 Generals");
+    EXPECT_EQ(table.speech(*table.find("Dialog:Hello")), "hello01");
+    EXPECT_FALSE(table.find("OBJECT:Missing").has_value());
+
+    // Decoded once; later reads return the same view
+    EXPECT_EQ(table.text(*ranger).data(), table.text(*ranger).data());
+
+    auto objects = table.withPrefix("object:");
+    ASSERT_EQ(objects.second - objects.first, 2u);
+    EXPECT_EQ(table.label(objects.first), "OBJECT:Crusader");
+    EXPECT_EQ(table.label(objects.first + 1), "OBJECT:Ranger");
+    auto none = table.withPrefix("zzz");
+    EXPECT_EQ(none.first, none.second);
+}
+
+TEST(StringTableTest, ResolvesLabelsInBulk) {
+    StringTable table;
+    ASSERT_TRUE(table.loadStr("OBJECT:B\n\"B\"\nEND\nOBJECT:A\n\"A\"\nEND\nGUI:Ok\n\"Ok\"\nEND\n"));
+    std::vector<std::string_view> labels = {"object:b", "OBJECT:Missing", "gui:ok", "OBJECT:A", "OBJECT:B", ""};
+    std::vector<uint32_t> indices = table.resolve(labels);
+    ASSERT_EQ(indices.size(), labels.size());
+    EXPECT_EQ(indices[0], *table.find("OBJECT:B"));
+    EXPECT_EQ(indices[1], StringTable::kMissing);
+    EXPECT_EQ(indices[2], *table.find("GUI:Ok"));
+    EXPECT_EQ(indices[3], *table.find("OBJECT:A"));
+    EXPECT_EQ(indices[4], indices[0]);
+    EXPECT_EQ(indices[5], StringTable::kMissing);
+    EXPECT_EQ(table.source().substr(table.labelOffset(indices[3]), 8), "OBJECT:A");
+}
+
+TEST(StringTableTest, RejectsMalformedCompiledStrings) {
+    StringTable table;
+    std::string csf = makeCsf({{"OBJECT:Ranger", {u"Ranger"}, ""}, {"OBJECT:Humvee", {u"Humvee"}, ""}});
+    EXPECT_FALSE(table.loadCsf("not a string table at all"));
+    EXPECT_FALSE(table.loadCsf(csf.substr(0, csf.size() - 3)));
+    EXPECT_TRUE(table.empty());
+    // Bytes too few to hold another label id are ignored, as in parseCSF
+    EXPECT_TRUE(table.loadCsf(csf + "xy"));
+    EXPECT_EQ(table.size(), 2u);
+}
+
+TEST(StringTableTest, LoadsStringSources) {
+    StringTable table;
+    ASSERT_TRUE(table.loadStr(
+        "// Generals.str\r\n"
+        "\r\n"
+        "  OBJECT:Ranger\r\n"
+        "  \"Ranger\"\r\n"
+        "  \"Second string\"\r\n"
+        "END\r\n"
+        "DIALOG:Hello\n"
+        "Not a string\n"
+        "\"Say \\\"hello\\\"\\nand\tgoodbye   \" = hello01\n"
+        "end\n"
+        "OBJECT:Long\n"
+        "\"First line\n"
+        "   second line \\\\\"\n"
+        "End\n"
+        "OBJECT:Empty\n"
+        "END\n"));
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.language(), 0u);
+    EXPECT_EQ(table.text(*table.find("object:ranger")), "Ranger");
+    auto hello = table.find("DIALOG:Hello");
+    ASSERT_TRUE(hello.has_value());
+    EXPECT_EQ(table.text(*hello), "Say \"hello\"\nand goodbye");
+    EXPECT_EQ(table.speech(*hello), "hello01");
+    EXPECT_EQ(table.text(*table.find("OBJECT:Long")), "First line second line \\");
+    EXPECT_EQ(table.text(*table.find("OBJECT:Empty")), "");
+
+    // A label the file leaves open discards the table
+    EXPECT_FALSE(table.loadStr("OBJECT:Ranger\n\"Ranger\"\n"));
+    EXPECT_TRUE(table.empty());
+}
+
+} // namespace
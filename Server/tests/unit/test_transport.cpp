@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "protocol/transport.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+
+namespace {
+
+class TransportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(pipe(input), 0);
+        ASSERT_EQ(pipe(output), 0);
+    }
+
+    void TearDown() override {
+        for (int fd : {input[0], input[1], output[0], output[1]}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    void writeInput(const std::string& data) {
+        ASSERT_EQ(write(input[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    }
+
+    void closeInput() {
+        close(input[1]);
+        input[1] = -1;
+    }
+
+    std::string readOutput() {
+        close(output[1]);
+        output[1] = -1;
+        std::string result;
+        char buffer[4096];
+        ssize_t count;
+        while ((count = read(output[0], buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, static_cast<size_t>(count));
+        }
+        return result;
+    }
+
+    int input[2] = {-1, -1};
+    int output[2] = {-1, -1};
+};
+
+TEST_F(TransportTest, ReadsFramedMessages) {
+    writeInput("Content-Length: 2\r\n\r\n{}Content-Length: 7\r\nContent-Type: x\r\n\r\n[1,2,3]");
+    closeInput();
+
+    ZeroSyntax::Transport transport(input[0], output[1]);
+
+    auto first = transport.readMessage();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(*first, "{}");
+
+    // The second message was read in the same block
+    EXPECT_TRUE(transport.hasBufferedMessage());
+    auto second = transport.readMessage();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(*second, "[1,2,3]");
+
+    EXPECT_FALSE(transport.readMessage().has_value());
+}
+
+TEST_F(TransportTest, ReadsMessagesLargerThanTheBuffer) {
+    std::string body(200 * 1024, 'x');
+    closeInput();  // reopened below with a large payload
+
+    int large[2];
+    ASSERT_EQ(pipe(large), 0);
+    std::string frame = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    ZeroSyntax::Transport transport(large[0], output[1]);
+
+    // Write from a child so the pipe does not fill up
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        close(large[0]);
+        size_t written = 0;
+        while (written < frame.size()) {
+            ssize_t count = write(large[1], frame.data() + written, frame.size() - written);
+            if (count <= 0) {
+                _exit(1);
+            }
+            written += static_cast<size_t>(count);
+        }
+        _exit(0);
+    }
+    close(large[1]);
+
+    auto message = transport.readMessage();
+    ASSERT_TRUE(message.has_value());
+    EXPECT_EQ(message->size(), body.size());
+    EXPECT_EQ(*message, body);
+
+    close(large[0]);
+}
+
+TEST_F(TransportTest, FlushWritesAllQueuedMessages) {
+    ZeroSyntax::Transport transport(input[0], output[1]);
+
+    transport.queueMessage("{\"a\":1}");
+    transport.queueMessage("{\"b\":22}");
+    EXPECT_EQ(transport.pendingMessages(), 2u);
+
+    EXPECT_TRUE(transport.flush());
+    EXPECT_EQ(transport.pendingMessages(), 0u);
+
+    EXPECT_EQ(readOutput(), "Content-Length: 7\r\n\r\n{\"a\":1}Content-Length: 8\r\n\r\n{\"b\":22}");
+}
+
+} // namespace
+
+#endif // _WIN32
@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+#include "utils/uri.hpp"
+
+namespace {
+
+using namespace ZeroSyntax;
+
+TEST(UriTest, PathToUri) {
+    EXPECT_EQ(pathToUri("/mod/Data/INI/Object/America Vehicle.ini"), "file:///mod/Data/INI/Object/America%20Vehicle.ini");
+    EXPECT_EQ(pathToUri("C:\\Games\\Zero Hour\\Weapon.ini"), "file:///C:/Games/Zero%20Hour/Weapon.ini");
+}
+
+TEST(UriTest, UriToPath) {
+    EXPECT_EQ(uriToPath("file:///mod/Data/INI/America%20Vehicle.ini"), "/mod/Data/INI/America Vehicle.ini");
+    EXPECT_EQ(uriToPath("file:///c%3A/mod/Weapon.ini"), "c:/mod/Weapon.ini");
+    EXPECT_EQ(uriToPath("untitled:Untitled-1"), std::nullopt);
+}
+
+TEST(UriTest, RoundTrip) {
+    std::string path = "/mod/100% #1/Object.ini";
+    EXPECT_EQ(uriToPath(pathToUri(path)), path);
+}
+
+} // namespace
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include "ini/value_units.hpp"
+
+namespace {
+
+using ZeroSyntax::Ini::convertedValue;
+
+TEST(ValueUnitsTest, DurationsRoundUpToFrames) {
+    EXPECT_EQ(convertedValue("INI::parseDurationUnsignedInt", "3000"), "3000 ms = 90 frames");
+    EXPECT_EQ(convertedValue("INI::parseDurationUnsignedInt", "10"), "10 ms = 1 frame");
+    EXPECT_EQ(convertedValue("INI::parseDurationUnsignedInt", "0"), "0 ms = 0 frames");
+    EXPECT_EQ(convertedValue("INI::parseDurationUnsignedShort", "100"), "100 ms = 3 frames");
+    EXPECT_EQ(convertedValue("INI::parseDurationReal", "50"), "50 ms = 1.5 frames");
+}
+
+TEST(ValueUnitsTest, ConvertsToPerFrameUnits) {
+    EXPECT_EQ(convertedValue("INI::parseAngleReal", "180"), "180° = 3.14159 rad");
+    EXPECT_EQ(convertedValue("INI::parseAngularVelocityReal", "30"), "30°/s = 0.0174533 rad/frame");
+    EXPECT_EQ(convertedValue("INI::parseVelocityReal", "60"), "60/s = 2/frame");
+    EXPECT_EQ(convertedValue("INI::parseAccelerationReal", "90"), "90/s² = 0.1/frame²");
+    EXPECT_EQ(convertedValue("INI::parsePercentToReal", "25%"), "25% = 0.25");
+    EXPECT_EQ(convertedValue("INI::parsePercentToReal", "150"), "150% = 1.5");
+}
+
+TEST(ValueUnitsTest, KeepsOtherValues) {
+    EXPECT_FALSE(convertedValue("INI::parseReal", "1.5").has_value());
+    EXPECT_FALSE(convertedValue("INI::parseAngleReal", "Yes").has_value());
+    EXPECT_FALSE(convertedValue("INI::parseDurationUnsignedInt", "").has_value());
+}
+
+} // namespace
@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "core/workspace_index.hpp"
+#include "utils/uri.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using namespace ZeroSyntax;
+
+FileSymbols symbolsOf(const std::string& uri, const std::string& text) {
+    return WorkspaceIndex::collect(uri, Ini::SyntaxTree::parse(text));
+}
+
+template <typename Entry>
+std::vector<std::string> names(const std::vector<Entry>& entries) {
+    std::vector<std::string> result;
+    for (const auto& entry : entries) {
+        result.push_back(entry.name);
+    }
+    return result;
+}
+
+TEST(WorkspaceIndexTest, CollectsNamedTopLevelBlocks) {
+    auto definitions = symbolsOf("file:///a.ini",
+        "; comment\n"
+        "Object Tank\n  Side = America\nEnd\n"
+        "GameData\n  MaxCameraHeight = 300\nEnd\n"
+        "Weapon  Gun\nEnd\n"
+        "FooBar Baz\nEnd\n").definitions;
+
+    EXPECT_THAT(names(definitions), ::testing::ElementsAre("Tank", "Gun"));
+    EXPECT_EQ(definitions[0].blockType, "Object");
+    EXPECT_EQ(definitions[1].range.start.line, 7);
+    EXPECT_EQ(definitions[1].range.start.character, 8);
+    EXPECT_EQ(definitions[1].range.end.character, 11);
+}
+
+TEST(WorkspaceIndexTest, CollectsTypedReferences) {
+    auto references = symbolsOf("file:///a.ini",
+        "Object Tank\n"
+        "  Behavior = FireWeaponWhenDeadBehavior ModuleTag_01\n"
+        "    DeathWeapon = TankDeathGun\n"
+        "  End\n"
+        "  Behavior = SlowDeathBehavior ModuleTag_02\n"
+        "    FX = FINAL None\n"
+        "  End\n"
+        "End\n"
+        "CommandButton Command_Nuke\n"
+        "  SpecialPower = SuperweaponNuke\n"
+        "  Object = Tank\n"
+        "End\n"
+        "ObjectReskin TankSkin Tank\n"
+        "End\n").references;
+
+    EXPECT_THAT(names(references), ::testing::ElementsAre("TankDeathGun", "SuperweaponNuke", "Tank", "Tank"));
+    EXPECT_EQ(references[0].blockType, "Weapon");
+    EXPECT_EQ(references[0].range.start.line, 2);
+    EXPECT_EQ(references[0].range.start.character, 18);
+    EXPECT_EQ(references[1].blockType, "SpecialPower");
+    EXPECT_EQ(references[3].blockType, "Object");
+    EXPECT_EQ(references[3].range.start.line, 12);
+    EXPECT_EQ(references[3].range.start.character, 22);
+}
+
+TEST(WorkspaceIndexTest, CollectsLabels) {
+    auto labels = symbolsOf("file:///a.ini",
+        "Object Tank\n"
+        "  DisplayName = OBJECT:Tank\n"
+        "End\n"
+        "CommandButton Command_ConstructTank\n"
+        "  TextLabel = CONTROLBAR:ConstructTank\n"
+        "  DescriptLabel = CONTROLBAR:ToolTipTank\n"
+        "  ButtonImage = SNTank\n"
+        "End\n"
+        "Upgrade Upgrade_Armor\n"
+        "  DisplayName = UPGRADE:Armor\n"
+        "End\n").labels;
+
+    EXPECT_THAT(names(labels), ::testing::ElementsAre("OBJECT:Tank", "CONTROLBAR:ConstructTank",
+                                                      "CONTROLBAR:ToolTipTank", "UPGRADE:Armor"));
+    EXPECT_TRUE(labels[0].blockType.empty());
+    EXPECT_EQ(labels[0].range.start.line, 1);
+    EXPECT_EQ(labels[0].range.start.character, 16);
+    EXPECT_EQ(labels[0].range.end.character, 27);
+
+    WorkspaceIndex index;
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini", "Object Jeep\n  DisplayName = OBJECT:Jeep\nEnd\n"));
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini", "Object Tank\n  DisplayName = OBJECT:Tank\nEnd\n"));
+    EXPECT_EQ(index.labelReferenceCount(), 2u);
+    EXPECT_THAT(names(index.labelReferences()), ::testing::ElementsAre("OBJECT:Tank", "OBJECT:Jeep"));
+    index.removeFile("file:///a.ini");
+    EXPECT_THAT(names(index.labelReferences()), ::testing::ElementsAre("OBJECT:Jeep"));
+    EXPECT_THAT(names(index.labelReferences("file:///b.ini")), ::testing::ElementsAre("OBJECT:Jeep"));
+}
+
+TEST(WorkspaceIndexTest, LooksUpReferencesByStore) {
+    WorkspaceIndex index;
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini",
+        "CommandButton Command_Nuke\n  SpecialPower = Nuke\nEnd\n"));
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini",
+        "CommandButton Command_Nuke2\n  SpecialPower = Nuke\nEnd\n"
+        "CommandButton Command_Build\n  Object = Nuke\nEnd\n"));
+
+    auto powers = index.findReferences("SpecialPower", "Nuke");
+    ASSERT_EQ(powers.size(), 2u);
+    EXPECT_EQ(powers[0].uri, "file:///a.ini");
+    EXPECT_EQ(powers[1].uri, "file:///b.ini");
+    EXPECT_EQ(index.findReferences("ObjectReskin", "Nuke").size(), 1u);
+    EXPECT_EQ(index.referenceCount(), 3u);
+
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini", "CommandButton Command_Nuke2\nEnd\n"));
+    EXPECT_EQ(index.findReferences("SpecialPower", "Nuke").size(), 1u);
+    EXPECT_TRUE(index.findReferences("Object", "Nuke").empty());
+    index.removeFile("file:///b.ini");
+    EXPECT_TRUE(index.findReferences("SpecialPower", "Nuke").empty());
+    EXPECT_EQ(index.referenceCount(), 0u);
+}
+
+TEST(WorkspaceIndexTest, LooksUpByStore) {
+    WorkspaceIndex index;
+    index.updateFile("file:///object.ini", symbolsOf("file:///object.ini",
+        "Object Tank\nEnd\nObjectReskin TankSkin Tank\nEnd\n"));
+    index.updateFile("file:///weapon.ini", symbolsOf("file:///weapon.ini", "Weapon Tank\nEnd\n"));
+    index.updateFile("file:///audio.ini", symbolsOf("file:///audio.ini", "MusicTrack Theme\nEnd\n"));
+
+    EXPECT_EQ(index.definitionCount(), 4u);
+    EXPECT_EQ(index.fileCount(), 3u);
+    ASSERT_EQ(index.findDefinitions("Object", "Tank").size(), 1u);
+    EXPECT_EQ(index.findDefinitions("Object", "Tank")[0].uri, "file:///object.ini");
+    EXPECT_EQ(index.findDefinitions("Object", "TankSkin").size(), 1u);
+    EXPECT_EQ(index.findDefinitions("Weapon", "Tank")[0].uri, "file:///weapon.ini");
+    EXPECT_EQ(index.findDefinitions("AudioEvent", "Theme").size(), 1u);
+    EXPECT_EQ(index.findDefinitions("Tank").size(), 2u);
+    EXPECT_TRUE(index.findDefinitions("Object", "tank").empty());
+    EXPECT_THAT(names(index.search("SKIN", 10)), ::testing::ElementsAre("TankSkin"));
+}
+
+TEST(WorkspaceIndexTest, UpdatesFilesIncrementally) {
+    WorkspaceIndex index;
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini", "Weapon Gun\nEnd\n"));
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini", "Weapon Gun\nEnd\nWeapon Cannon\nEnd\n"));
+
+    // Duplicates are ordered by file
+    auto guns = index.findDefinitions("Weapon", "Gun");
+    ASSERT_EQ(guns.size(), 2u);
+    EXPECT_EQ(guns[0].uri, "file:///a.ini");
+
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini", "Weapon Cannon2\nEnd\n"));
+    EXPECT_EQ(index.findDefinitions("Weapon", "Gun").size(), 1u);
+    EXPECT_TRUE(index.findDefinitions("Weapon", "Cannon").empty());
+    EXPECT_EQ(index.findDefinitions("Weapon", "Cannon2").size(), 1u);
+
+    index.removeFile("file:///b.ini");
+    EXPECT_TRUE(index.findDefinitions("Weapon", "Gun").empty());
+    EXPECT_EQ(index.definitionCount(), 1u);
+    EXPECT_EQ(index.fileCount(), 1u);
+}
+
+TEST(WorkspaceIndexTest, CompletesNamesByStore) {
+    WorkspaceIndex index;
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini",
+        "Object tankB\nEnd\nObject TankA\nEnd\nObjectReskin TankSkin TankA\nEnd\nObject Jeep\nEnd\n"));
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini", "Object TankA\nEnd\nWeapon TankGun\nEnd\n"));
+
+    // Best match first: the case of "tank" decides between the two of the same length
+    EXPECT_THAT(index.completeNames("Object", "tank", 10), ::testing::ElementsAre("tankB", "TankA", "TankSkin"));
+    EXPECT_THAT(index.completeNames("ObjectReskin", "TSkin", 10), ::testing::ElementsAre("TankSkin"));
+    EXPECT_THAT(index.completeNames("Weapon", "", 10), ::testing::ElementsAre("TankGun"));
+    EXPECT_THAT(index.completeNames("Object", "", 2), ::testing::ElementsAre("Jeep", "TankA"));
+    EXPECT_TRUE(index.completeNames("Armor", "", 10).empty());
+
+    // A name stays while any file defines it
+    index.removeFile("file:///a.ini");
+    EXPECT_THAT(index.completeNames("Object", "", 10), ::testing::ElementsAre("TankA"));
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini", "Weapon TankGun\nEnd\n"));
+    EXPECT_TRUE(index.completeNames("Object", "", 10).empty());
+}
+
+TEST(WorkspaceIndexTest, SearchesFuzzily) {
+    WorkspaceIndex index;
+    index.updateFile("file:///a.ini", symbolsOf("file:///a.ini",
+        "Object AmericaVehicleTomahawk\nEnd\nObject Navigator\nEnd\nWeapon TomahawkMissileWeapon\nEnd\n"));
+    index.updateFile("file:///b.ini", symbolsOf("file:///b.ini", "Object AmericaVehicleTomahawk\nEnd\n"));
+
+    // Both definitions of the best name come first
+    auto found = index.search("avt", 10);
+    EXPECT_THAT(names(found), ::testing::ElementsAre("AmericaVehicleTomahawk", "AmericaVehicleTomahawk", "Navigator"));
+    EXPECT_THAT(names(index.search("tomahawk", 1)), ::testing::ElementsAre("TomahawkMissileWeapon"));
+    EXPECT_TRUE(index.search("xyz", 10).empty());
+
+    index.removeFile("file:///a.ini");
+    EXPECT_THAT(names(index.search("avt", 10)), ::testing::ElementsAre("AmericaVehicleTomahawk"));
+}
+
+TEST(WorkspaceIndexTest, IndexesDirectoryInParallel) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_workspace_index_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "Object");
+    for (int i = 0; i < 40; ++i) {
+        std::ofstream(root / "Object" / ("Unit" + std::to_string(i) + ".INI"))
+            << "Object Unit" << i << "\n  Side = America\nEnd\n";
+    }
+    std::ofstream(root / "Weapon.ini") << "Weapon Gun\nEnd\n";
+    std::ofstream(root / "readme.txt") << "Weapon NotIni\nEnd\n";
+
+    // Files reported as open are left alone
+    std::string skipped = pathToUri((fs::absolute(root) / "Weapon.ini").generic_string());
+    WorkspaceIndex index;
+    IndexOptions options;
+    options.threadCount = 4;
+    options.skip = [&](const std::string& uri) { return uri == skipped; };
+    EXPECT_EQ(index.indexDirectory(root.string(), options).files, 40u);
+    EXPECT_EQ(index.definitionCount(), 40u);
+    EXPECT_TRUE(index.findDefinitions("Weapon", "Gun").empty());
+
+    options.skip = nullptr;
+    index.indexDirectory(root.string(), options);
+    EXPECT_EQ(index.definitionCount(), 41u);
+    ASSERT_EQ(index.findDefinitions("Object", "Unit7").size(), 1u);
+    EXPECT_EQ(uriToPath(index.findDefinitions("Object", "Unit7")[0].uri),
+              (fs::absolute(root) / "Object" / "Unit7.INI").generic_string());
+    EXPECT_TRUE(index.findDefinitions("NotIni").empty());
+
+    // A file deleted from disk disappears when re-read
+    fs::remove(root / "Weapon.ini");
+    index.indexFile(skipped);
+    EXPECT_TRUE(index.findDefinitions("Weapon", "Gun").empty());
+    fs::remove_all(root);
+}
+
+TEST(WorkspaceIndexTest, ReusesTheOnDiskCache) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "zs_workspace_cache_test";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    for (int i = 0; i < 10; ++i) {
+        std::ofstream(root / ("Power" + std::to_string(i) + ".ini"))
+            << "SpecialPower Power" << i << "\nEnd\nCommandButton Command_" << i
+            << "\n  SpecialPower = Power" << i << "\nEnd\n";
+    }
+    IndexOptions options;
+    options.cachePath = (root / "cache" / "index.bin").string();
+
+    WorkspaceIndex cold;
+    IndexStats stats = cold.indexDirectory(root.string(), options);
+    EXPECT_EQ(stats.files, 10u);
+    EXPECT_EQ(stats.parsed, 10u);
+    ASSERT_TRUE(fs::exists(options.cachePath));
+
+    // A second session parses nothing and sees the same symbols
+    WorkspaceIndex warm;
+    stats = warm.indexDirectory(root.string(), options);
+    EXPECT_EQ(stats.files, 10u);
+    EXPECT_EQ(stats.parsed, 0u);
+    EXPECT_EQ(warm.definitionCount(), cold.definitionCount());
+    EXPECT_EQ(warm.referenceCount(), cold.referenceCount());
+    auto references = warm.findReferences("SpecialPower", "Power3");
+    ASSERT_EQ(references.size(), 1u);
+    EXPECT_EQ(references[0].range.start.line, 3);
+    EXPECT_EQ(references[0].range.start.character, 17);
+
+    // Only files that changed on disk are parsed again
+    std::ofstream(root / "Power3.ini", std::ios::trunc) << "SpecialPower Power3b\nEnd\n";
+    fs::last_write_time(root / "Power3.ini", fs::last_write_time(root / "Power3.ini") + std::chrono::seconds(5));
+    fs::remove(root / "Power4.ini");
+    WorkspaceIndex edited;
+    stats = edited.indexDirectory(root.string(), options);
+    EXPECT_EQ(stats.files, 9u);
+    EXPECT_EQ(stats.parsed, 1u);
+    EXPECT_EQ(edited.findDefinitions("SpecialPower", "Power3b").size(), 1u);
+    EXPECT_TRUE(edited.findReferences("SpecialPower", "Power3").empty());
+
+    // A damaged cache is ignored
+    std::ofstream(options.cachePath, std::ios::trunc) << "garbage";
+    WorkspaceIndex recovered;
+    EXPECT_EQ(recovered.indexDirectory(root.string(), options).parsed, 9u);
+    fs::remove_all(root);
+}
+
+} // namespace
@@ -0,0 +1,193 @@
+// Decompression throughput over a corpus of game files.
+//
+// The counterpart of DoCompressTest (GameEngine/Source/Common/System/Compression.cpp),
+// which runs every map in TheMapCache through CompressionManager NUM_TIMES
+// times: here every compressed .map file below the given paths, and every
+// compressed entry of the .big archives among them, is decoded NUM_TIMES
+// times in one shot (Vfs::decompress) and NUM_TIMES times in 64 KiB reads
+// (Vfs::Decompressor), and the throughput is reported per format. The server
+// has no encoders, so the files are measured as they are stored.
+//
+// Usage: ZS_DecompressBenchmark <file or directory>...
+
+#include "../include/utils/mapped_file.hpp"
+#include "../include/vfs/big_archive.hpp"
+#include "../include/vfs/decompressor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace ZeroSyntax;
+
+namespace {
+
+constexpr int kTimes = 10;  // NUM_TIMES
+
+struct Sample {
+    std::string name;
+    std::string_view data;
+};
+
+struct Totals {
+    size_t files = 0;
+    size_t compressedBytes = 0;
+    size_t uncompressedBytes = 0;
+    double oneShotSeconds = 0;
+    double streamedSeconds = 0;
+    size_t failures = 0;
+};
+
+const char* formatName(Vfs::Compression compression) {
+    switch (compression) {
+    case Vfs::Compression::RefPack:
+        return "RefPack";
+    case Vfs::Compression::BTree:
+        return "BTree";
+    case Vfs::Compression::Huffman:
+        return "Huffman";
+    case Vfs::Compression::NoxLzh:
+        return "LZHL";
+    case Vfs::Compression::ZLib:
+        return "ZLib";
+    default:
+        return "None";
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void measure(const Sample& sample, Totals& totals) {
+    std::string expected;
+    if (!Vfs::decompress(sample.data, expected)) {
+        std::cerr << sample.name << ": cannot decompress\n";
+        ++totals.failures;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string out;
+    for (int i = 0; i < kTimes; ++i) {
+        Vfs::decompress(sample.data, out);
+    }
+    totals.oneShotSeconds += secondsSince(start);
+
+    std::vector<char> chunk(64 * 1024);
+    std::string streamed;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTimes; ++i) {
+        Vfs::Decompressor decompressor(sample.data);
+        size_t read;
+        while ((read = decompressor.read(chunk.data(), chunk.size())) > 0) {
+            // Only the first pass is kept for the comparison
+            if (i == 0) {
+                streamed.append(chunk.data(), read);
+            }
+        }
+        if (decompressor.failed()) {
+            ++totals.failures;
+        }
+    }
+    totals.streamedSeconds += secondsSince(start);
+
+    if (out != expected || streamed != expected) {
+        std::cerr << sample.name << ": outputs differ\n";
+        ++totals.failures;
+    }
+    ++totals.files;
+    totals.compressedBytes += sample.data.size();
+    totals.uncompressedBytes += expected.size();
+}
+
+std::string lowerExtension(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <file or directory>...\n";
+        return 2;
+    }
+
+    std::vector<fs::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        fs::path path(argv[i]);
+        if (fs::is_directory(path)) {
+            for (const auto& entry : fs::recursive_directory_iterator(path)) {
+                std::string extension = lowerExtension(entry.path());
+                if (entry.is_regular_file() && (extension == ".map" || extension == ".big")) {
+                    paths.push_back(entry.path());
+                }
+            }
+        } else {
+            paths.push_back(path);
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // Every file stays open (mapped) while it is measured
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::unique_ptr<Vfs::BigArchive>> archives;
+    std::vector<Sample> samples;
+    for (const auto& path : paths) {
+        if (lowerExtension(path) == ".big") {
+            auto archive = std::make_unique<Vfs::BigArchive>();
+            if (!archive->open(path.string())) {
+                std::cerr << "cannot open " << path.string() << "\n";
+                continue;
+            }
+            for (const Vfs::BigEntry& entry : archive->entries()) {
+                std::string_view data = archive->contents(entry);
+                if (Vfs::compressionOf(data) != Vfs::Compression::None) {
+                    samples.push_back({path.string() + ":" + std::string(entry.path), data});
+                }
+            }
+            archives.push_back(std::move(archive));
+            continue;
+        }
+        auto file = std::make_unique<MappedFile>();
+        if (!file->open(path.string())) {
+            std::cerr << "cannot open " << path.string() << "\n";
+            continue;
+        }
+        if (Vfs::compressionOf(file->contents()) != Vfs::Compression::None) {
+            samples.push_back({path.string(), file->contents()});
+            files.push_back(std::move(file));
+        }
+    }
+
+    std::map<Vfs::Compression, Totals> totals;
+    for (const Sample& sample : samples) {
+        measure(sample, totals[Vfs::compressionOf(sample.data)]);
+    }
+
+    size_t failures = 0;
+    for (const auto& [compression, total] : totals) {
+        failures += total.failures;
+        if (!total.files) {
+            continue;
+        }
+        double megabytes = static_cast<double>(total.uncompressedBytes) * kTimes / 1e6;
+        std::printf("%-8s %zu files, %zu bytes from %zu (%.1f%%)\n", formatName(compression), total.files,
+                    total.uncompressedBytes, total.compressedBytes,
+                    100.0 * static_cast<double>(total.compressedBytes) / static_cast<double>(std::max<size_t>(total.uncompressedBytes, 1)));
+        std::printf("         one shot %.1f MB/s, streamed %.1f MB/s\n", megabytes / total.oneShotSeconds,
+                    megabytes / total.streamedSeconds);
+    }
+    if (samples.empty()) {
+        std::printf("no compressed files found\n");
+    }
+    return failures ? 1 : 0;
+}
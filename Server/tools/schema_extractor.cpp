@@ -0,0 +1,1698 @@
+// Build-time extractor for the INI schema.
+//
+// Scans the engine sources under GameCode/Code/GameEngine and
+// GameEngineDevice for the static FieldParse tables, the buildFieldParse
+// chains of the module data classes, the ModuleFactory registrations,
+// theTypeTable and the name/lookup lists used by the parse procs, and writes
+// them out as a header of constexpr records (see Server/include/ini/ini_schema.hpp).
+//
+// Usage: ZS_SchemaExtractor <GameCode/Code directory> <output header>
+
+#include "../include/ini/ini_schema.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+// Tokenizer
+// ------------------------------------------------------------------------------------------------
+
+enum class TokenKind { Identifier, Number, String, Punct };
+
+struct Token {
+    TokenKind kind;
+    std::string text;
+};
+
+bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isIdentifierChar(char c) {
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+// Skip a preprocessor directive starting at i (which points at '#'), honouring
+// line continuations. Returns the directive text.
+std::string readDirective(const std::string& src, size_t& i) {
+    std::string directive;
+    while (i < src.size() && src[i] != '\n') {
+        if (src[i] == '\\' && i + 1 < src.size() && (src[i + 1] == '\n' || src[i + 1] == '\r')) {
+            i += src[i + 1] == '\r' && i + 2 < src.size() && src[i + 2] == '\n' ? 3 : 2;
+            directive += ' ';
+            continue;
+        }
+        if (src[i] == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+            while (i < src.size() && src[i] != '\n') {
+                ++i;
+            }
+            break;
+        }
+        directive += src[i++];
+    }
+    return directive;
+}
+
+// Tokenize C++ source. Comments, preprocessor directives and code inside
+// "#if 0" are dropped; both branches of every other conditional are kept.
+std::vector<Token> tokenize(const std::string& src) {
+    std::vector<Token> tokens;
+    bool atLineStart = true;
+    int disabledDepth = 0;  // nesting inside an "#if 0" region
+
+    size_t i = 0;
+    while (i < src.size()) {
+        char c = src[i];
+        if (c == '\n') {
+            atLineStart = true;
+            ++i;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v' || c == '\\') {
+            ++i;
+            continue;
+        }
+        if (c == '#' && atLineStart) {
+            std::istringstream directive(readDirective(src, i).substr(1));
+            std::string name, argument;
+            directive >> name >> argument;
+            if (disabledDepth > 0) {
+                if (name == "if" || name == "ifdef" || name == "ifndef") {
+                    ++disabledDepth;
+                } else if (name == "endif" || ((name == "else" || name == "elif") && disabledDepth == 1)) {
+                    --disabledDepth;
+                }
+            } else if (name == "if" && argument == "0") {
+                disabledDepth = 1;
+            }
+            continue;
+        }
+        atLineStart = false;
+
+        if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+            while (i < src.size() && src[i] != '\n') {
+                ++i;
+            }
+            continue;
+        }
+        if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+            size_t end = src.find("*/", i + 2);
+            i = end == std::string::npos ? src.size() : end + 2;
+            continue;
+        }
+
+        if (disabledDepth > 0) {
+            ++i;
+            continue;
+        }
+
+        if (c == '"' || c == '\'') {
+            std::string text;
+            ++i;
+            while (i < src.size() && src[i] != c && src[i] != '\n') {
+                if (src[i] == '\\' && i + 1 < src.size()) {
+                    text += src[i++];
+                }
+                text += src[i++];
+            }
+            ++i;
+            tokens.push_back(Token{c == '"' ? TokenKind::String : TokenKind::Number, text});
+        } else if (isIdentifierStart(c)) {
+            size_t begin = i;
+            while (i < src.size() && isIdentifierChar(src[i])) {
+                ++i;
+            }
+            tokens.push_back(Token{TokenKind::Identifier, src.substr(begin, i - begin)});
+        } else if (c >= '0' && c <= '9') {
+            size_t begin = i;
+            while (i < src.size() && (isIdentifierChar(src[i]) || src[i] == '.')) {
+                ++i;
+            }
+            tokens.push_back(Token{TokenKind::Number, src.substr(begin, i - begin)});
+        } else if (c == ':' && i + 1 < src.size() && src[i + 1] == ':') {
+            tokens.push_back(Token{TokenKind::Punct, "::"});
+            i += 2;
+        } else if (c == '-' && i + 1 < src.size() && src[i + 1] == '>') {
+            tokens.push_back(Token{TokenKind::Punct, "->"});
+            i += 2;
+        } else {
+            tokens.push_back(Token{TokenKind::Punct, std::string(1, c)});
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Source model
+// ------------------------------------------------------------------------------------------------
+
+struct Function {
+    std::string cls;      // enclosing or qualifying class, may be empty
+    std::string name;
+    size_t file;
+    size_t params;        // token index of the parameter list's '('
+    size_t begin;         // token index of the body's '{'
+    size_t end;           // token index of the body's '}'
+};
+
+struct ClassInfo {
+    std::string name;
+    std::vector<std::string> bases;
+    std::string dataClass;   // from the MAKE_STANDARD_MODULE_* macros
+    std::string moduleType;  // MODULETYPE_* returned by getModuleType
+};
+
+struct Entry {
+    std::string token;  // empty for a catch-all entry
+    std::string proc;
+    std::vector<Token> userData;
+};
+
+struct Table {
+    std::string name;
+    std::string scope;  // "Class::function" for function-local tables, else ""
+    std::vector<Entry> entries;
+};
+
+struct NameList {
+    std::string name;
+    std::vector<std::string> names;
+    bool lookup;  // LookupListRec rather than a const char* array
+};
+
+struct SourceFile {
+    std::string path;
+    std::vector<Token> tokens;
+};
+
+class Extractor {
+public:
+    void addFile(const fs::path& path, const std::string& relative);
+    void finish();
+    bool write(const std::string& output) const;
+    void printSummary() const;
+
+private:
+    // Scanning
+    void scanFile(size_t fileIndex);
+    size_t matching(const std::vector<Token>& tokens, size_t open) const;
+    size_t parseTable(size_t fileIndex, size_t nameEnd, const std::string& name, const std::string& scope);
+    size_t parseNameList(size_t fileIndex, size_t open, const std::string& name, bool lookup);
+    std::string qualifiedNameBefore(const std::vector<Token>& tokens, size_t end, size_t& begin) const;
+
+    // Resolution of FieldParse tables
+    using Parts = std::vector<size_t>;
+    bool resolveClass(const std::string& cls, Parts& parts);
+    bool resolveProc(const std::string& proc, Parts& parts);
+    bool resolveFunctionInit(size_t fn, Parts& parts, int depth);
+    bool resolveExpression(size_t fn, size_t begin, size_t end, Parts& parts);
+    void walkBuildFieldParse(size_t fn, Parts& parts);
+    std::string variableType(size_t fn, const std::string& variable) const;
+    const Table* findTable(size_t fn, const std::string& name) const;
+    std::vector<size_t> findFunctions(const std::string& cls, const std::string& name) const;
+
+    // Schema assembly
+    size_t tableFor(const std::string& name, const Parts& parts);
+    std::string listFor(const Entry& entry, const std::string& hint) const;
+    void classifyFields(size_t tableIndex);
+
+    std::vector<SourceFile> files_;
+    std::vector<Function> functions_;
+    std::unordered_map<std::string, std::vector<size_t>> functionsByName_;
+    std::map<std::string, ClassInfo> classes_;
+    std::unordered_map<std::string, std::string> globals_;  // extern variable -> class
+    std::vector<Table> tables_;
+    std::unordered_map<std::string, std::vector<size_t>> tablesByName_;
+    std::map<std::string, NameList> lists_;
+    std::vector<std::pair<std::string, std::string>> blockProcs_;  // theTypeTable
+    std::vector<std::string> moduleNames_;                         // addModule registrations
+
+    std::map<std::string, std::pair<bool, Parts>> resolved_;  // found, tables
+    std::set<std::string> resolving_;
+    std::string procHint_;  // parse function being resolved, to pick between init sites
+
+    // Output model
+    struct OutField {
+        std::string token;
+        std::string kind;
+        std::string proc;
+        std::string list;
+        int table = -1;
+        std::string reference;
+    };
+    struct OutTable {
+        std::string name;
+        std::vector<OutField> fields;
+        bool acceptsAnyField = false;
+    };
+    struct OutBlock {
+        std::string name;
+        std::string proc;
+        int table = -1;
+    };
+    struct OutModule {
+        std::string name;
+        std::string dataClass;
+        std::string type;
+        int table = -1;
+    };
+    std::vector<OutTable> outTables_;
+    std::map<std::string, size_t> outTableByParts_;
+    std::vector<Parts> outTableParts_;
+    std::vector<OutBlock> outBlocks_;
+    std::vector<OutModule> outModules_;
+};
+
+std::string joinTokens(const std::vector<Token>& tokens, size_t begin, size_t end) {
+    std::string text;
+    for (size_t i = begin; i < end; ++i) {
+        text += tokens[i].text;
+    }
+    return text;
+}
+
+bool isKeyword(const std::string& text) {
+    static const std::set<std::string> keywords = {
+        "if", "while", "for", "switch", "catch", "return", "sizeof", "else", "do", "new", "delete",
+        "const", "static", "class", "struct", "enum", "namespace", "typedef", "template", "public",
+        "private", "protected", "virtual", "inline", "void", "operator",
+    };
+    return keywords.count(text) != 0;
+}
+
+void Extractor::addFile(const fs::path& path, const std::string& relative) {
+    std::ifstream stream(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    files_.push_back(SourceFile{relative, tokenize(buffer.str())});
+    scanFile(files_.size() - 1);
+}
+
+size_t Extractor::matching(const std::vector<Token>& tokens, size_t open) const {
+    const std::string& openText = tokens[open].text;
+    std::string closeText = openText == "{" ? "}" : openText == "(" ? ")" : openText == "[" ? "]" : ">";
+    int depth = 0;
+    for (size_t i = open; i < tokens.size(); ++i) {
+        if (tokens[i].kind != TokenKind::Punct) {
+            continue;
+        }
+        if (tokens[i].text == openText) {
+            ++depth;
+        } else if (tokens[i].text == closeText && --depth == 0) {
+            return i;
+        }
+    }
+    return tokens.size();
+}
+
+// Read a (possibly qualified) name ending just before end; begin receives its first token
+std::string Extractor::qualifiedNameBefore(const std::vector<Token>& tokens, size_t end, size_t& begin) const {
+    if (end == 0 || tokens[end - 1].kind != TokenKind::Identifier) {
+        begin = end;
+        return "";
+    }
+    begin = end - 1;
+    while (begin >= 2 && tokens[begin - 1].text == "::" && tokens[begin - 2].kind == TokenKind::Identifier) {
+        begin -= 2;
+    }
+    return joinTokens(tokens, begin, end);
+}
+
+void Extractor::scanFile(size_t fileIndex) {
+    const auto& tokens = files_[fileIndex].tokens;
+
+    enum class ScopeKind { Namespace, Class, Function, Block };
+    struct Scope {
+        ScopeKind kind;
+        std::string name;
+        size_t function;
+    };
+    std::vector<Scope> scopes;
+
+    auto currentClass = [&]() -> std::string {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            if (it->kind == ScopeKind::Class) {
+                return it->name;
+            }
+            if (it->kind == ScopeKind::Function) {
+                return "";
+            }
+        }
+        return "";
+    };
+    auto currentFunction = [&]() -> size_t {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            if (it->kind == ScopeKind::Function) {
+                return it->function;
+            }
+        }
+        return SIZE_MAX;
+    };
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const Token& token = tokens[i];
+
+        if (token.kind == TokenKind::Identifier) {
+            // FieldParse NAME[] = { ... }
+            if (token.text == "FieldParse" && i + 1 < tokens.size() && tokens[i + 1].kind == TokenKind::Identifier) {
+                size_t end = i + 1;
+                while (end + 2 < tokens.size() && tokens[end + 1].text == "::") {
+                    end += 2;
+                }
+                if (end + 3 < tokens.size() && tokens[end + 1].text == "[") {
+                    size_t close = matching(tokens, end + 1);
+                    if (close + 2 < tokens.size() && tokens[close + 1].text == "=" && tokens[close + 2].text == "{") {
+                        std::string scope;
+                        size_t fn = currentFunction();
+                        if (fn != SIZE_MAX) {
+                            scope = functions_[fn].cls + "::" + functions_[fn].name;
+                        }
+                        std::string name = joinTokens(tokens, i + 1, end + 1);
+                        i = parseTable(fileIndex, close + 2, name, scope);
+                        continue;
+                    }
+                }
+            }
+
+            // const char *NAME[] = { "A", "B", NULL }
+            if (token.text == "char" && i + 2 < tokens.size() && tokens[i + 1].text == "*") {
+                size_t nameStart = i + 2;
+                if (tokens[nameStart].text == "const") {
+                    ++nameStart;
+                }
+                size_t end = nameStart;
+                while (end + 2 < tokens.size() && tokens[end + 1].text == "::") {
+                    end += 2;
+                }
+                if (end + 1 < tokens.size() && tokens[nameStart].kind == TokenKind::Identifier &&
+                    tokens[end + 1].text == "[") {
+                    size_t close = matching(tokens, end + 1);
+                    if (close + 2 < tokens.size() && tokens[close + 1].text == "=" && tokens[close + 2].text == "{") {
+                        std::string name = joinTokens(tokens, nameStart, end + 1);
+                        i = parseNameList(fileIndex, close + 2, name, false);
+                        continue;
+                    }
+                }
+            }
+
+            // LookupListRec NAME[] = { { "A", 1 }, ... }
+            if (token.text == "LookupListRec" && i + 2 < tokens.size() && tokens[i + 1].kind == TokenKind::Identifier &&
+                tokens[i + 2].text == "[") {
+                size_t close = matching(tokens, i + 2);
+                if (close + 2 < tokens.size() && tokens[close + 1].text == "=" && tokens[close + 2].text == "{") {
+                    i = parseNameList(fileIndex, close + 2, tokens[i + 1].text, true);
+                    continue;
+                }
+            }
+
+            // extern Type *TheThing; / extern OVERRIDE<Type> TheThing;
+            if (token.text == "extern" && currentFunction() == SIZE_MAX) {
+                size_t end = i + 1;
+                while (end < tokens.size() && tokens[end].text != ";" && tokens[end].text != "(" &&
+                       tokens[end].text != "{") {
+                    ++end;
+                }
+                if (end < tokens.size() && tokens[end].text == ";" && end >= i + 3 &&
+                    tokens[end - 1].kind == TokenKind::Identifier) {
+                    std::string type;
+                    for (size_t k = i + 1; k < end - 1; ++k) {
+                        if (tokens[k].text == "<" && tokens[k + 1].kind == TokenKind::Identifier) {
+                            type = tokens[k + 1].text;
+                            break;
+                        }
+                        if (type.empty() && tokens[k].kind == TokenKind::Identifier && !isKeyword(tokens[k].text)) {
+                            type = tokens[k].text;
+                        }
+                    }
+                    if (!type.empty()) {
+                        globals_[tokens[end - 1].text] = type;
+                    }
+                }
+            }
+
+            // Module macros inside a class body
+            if ((token.text == "MAKE_STANDARD_MODULE_MACRO_WITH_MODULE_DATA" ||
+                 token.text == "MAKE_STANDARD_MODULE_DATA_MACRO_ABC") &&
+                i + 4 < tokens.size() && tokens[i + 1].text == "(" && tokens[i + 3].text == ",") {
+                std::string cls = currentClass();
+                if (!cls.empty()) {
+                    classes_[cls].dataClass = tokens[i + 4].text;
+                }
+            }
+
+            // addModule( Name )
+            if (token.text == "addModule" && i + 3 < tokens.size() && tokens[i + 1].text == "(" &&
+                tokens[i + 2].kind == TokenKind::Identifier && tokens[i + 3].text == ")" &&
+                currentFunction() != SIZE_MAX) {
+                moduleNames_.push_back(tokens[i + 2].text);
+            }
+
+            // theTypeTable entries: BlockParse theTypeTable[] = { { "Name", proc }, ... }
+            if (token.text == "theTypeTable" && i >= 1 && tokens[i - 1].text == "BlockParse") {
+                size_t open = i;
+                while (open < tokens.size() && tokens[open].text != "{") {
+                    ++open;
+                }
+                size_t close = matching(tokens, open);
+                for (size_t j = open + 1; j < close; ++j) {
+                    if (tokens[j].text == "{" && tokens[j + 1].kind == TokenKind::String) {
+                        size_t entryClose = matching(tokens, j);
+                        blockProcs_.emplace_back(tokens[j + 1].text, joinTokens(tokens, j + 3, entryClose));
+                        j = entryClose;
+                    }
+                }
+                i = close;
+                continue;
+            }
+        }
+
+        if (token.text == "{" && token.kind == TokenKind::Punct) {
+            Scope scope{ScopeKind::Block, "", SIZE_MAX};
+
+            // class NAME [: bases] {
+            size_t j = i;
+            while (j > 0) {
+                const std::string& text = tokens[j - 1].text;
+                if (text == ";" || text == "{" || text == "}" || text == "(" || text == ")" || text == "=") {
+                    break;
+                }
+                --j;
+            }
+            size_t keyword = SIZE_MAX;
+            for (size_t k = j; k < i; ++k) {
+                if ((tokens[k].text == "class" || tokens[k].text == "struct") &&
+                    (k == 0 || tokens[k - 1].text != "enum")) {
+                    keyword = k;
+                    break;
+                }
+            }
+            if (keyword != SIZE_MAX && keyword + 1 < i && tokens[keyword + 1].kind == TokenKind::Identifier) {
+                // Skip export macros such as "class DLL_EXPORT Name"
+                size_t nameIndex = keyword + 1;
+                while (nameIndex + 1 < i && tokens[nameIndex + 1].kind == TokenKind::Identifier &&
+                       tokens[nameIndex + 1].text != "public" && tokens[nameIndex + 1].text != "final") {
+                    ++nameIndex;
+                }
+                scope.kind = ScopeKind::Class;
+                scope.name = tokens[nameIndex].text;
+                ClassInfo& info = classes_[scope.name];
+                info.name = scope.name;
+                info.bases.clear();
+                for (size_t k = nameIndex + 1; k < i; ++k) {
+                    if (tokens[k].kind == TokenKind::Identifier && tokens[k].text != "public" &&
+                        tokens[k].text != "protected" && tokens[k].text != "private" && tokens[k].text != "virtual" &&
+                        (k + 1 == i || tokens[k + 1].text != "::")) {
+                        info.bases.push_back(tokens[k].text);
+                    }
+                }
+            } else if (j < i && tokens[j].text == "namespace") {
+                scope.kind = ScopeKind::Namespace;
+            } else if (currentFunction() == SIZE_MAX) {
+                // NAME ( params ) [const] {
+                size_t k = i;
+                while (k > 0 && tokens[k - 1].kind == TokenKind::Identifier &&
+                       (tokens[k - 1].text == "const" || tokens[k - 1].text == "override")) {
+                    --k;
+                }
+                if (k > 0 && tokens[k - 1].text == ")") {
+                    // Walk back to the matching '('
+                    int depth = 0;
+                    size_t open = k - 1;
+                    for (; open != SIZE_MAX; --open) {
+                        if (tokens[open].text == ")") {
+                            ++depth;
+                        } else if (tokens[open].text == "(" && --depth == 0) {
+                            break;
+                        }
+                    }
+                    size_t nameBegin = 0;
+                    std::string name = open != SIZE_MAX ? qualifiedNameBefore(tokens, open, nameBegin) : "";
+                    if (!name.empty() && !isKeyword(tokens[open - 1].text)) {
+                        Function fn;
+                        size_t split = name.rfind("::");
+                        fn.name = split == std::string::npos ? name : name.substr(split + 2);
+                        fn.cls = split == std::string::npos ? currentClass() : name.substr(0, split);
+                        size_t clsSplit = fn.cls.rfind("::");
+                        if (clsSplit != std::string::npos) {
+                            fn.cls = fn.cls.substr(clsSplit + 2);
+                        }
+                        fn.file = fileIndex;
+                        fn.params = open;
+                        fn.begin = i;
+                        fn.end = matching(tokens, i);
+                        scope.kind = ScopeKind::Function;
+                        scope.function = functions_.size();
+                        functionsByName_[fn.name].push_back(functions_.size());
+                        functions_.push_back(fn);
+
+                        if (fn.name == "getModuleType" && !fn.cls.empty()) {
+                            for (size_t t = fn.begin; t < fn.end; ++t) {
+                                if (tokens[t].text.rfind("MODULETYPE_", 0) == 0) {
+                                    classes_[fn.cls].moduleType = tokens[t].text;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            scopes.push_back(scope);
+        } else if (token.text == "}" && token.kind == TokenKind::Punct) {
+            if (!scopes.empty()) {
+                scopes.pop_back();
+            }
+        }
+    }
+}
+
+size_t Extractor::parseTable(size_t fileIndex, size_t open, const std::string& name, const std::string& scope) {
+    const auto& tokens = files_[fileIndex].tokens;
+    size_t close = matching(tokens, open);
+
+    Table table;
+    table.name = name;
+    table.scope = scope;
+    for (size_t i = open + 1; i < close; ++i) {
+        if (tokens[i].text != "{") {
+            continue;
+        }
+        size_t entryClose = matching(tokens, i);
+
+        // Split the entry into its four fields
+        std::vector<std::pair<size_t, size_t>> fields;
+        size_t start = i + 1;
+        int depth = 0;
+        for (size_t j = i + 1; j < entryClose; ++j) {
+            const std::string& text = tokens[j].text;
+            if (text == "(" || text == "[" || text == "{") {
+                ++depth;
+            } else if (text == ")" || text == "]" || text == "}") {
+                --depth;
+            } else if (text == "," && depth == 0) {
+                fields.emplace_back(start, j);
+                start = j + 1;
+            }
+        }
+        fields.emplace_back(start, entryClose);
+        i = entryClose;
+
+        if (fields.size() < 2) {
+            continue;
+        }
+        Entry entry;
+        if (tokens[fields[0].first].kind == TokenKind::String) {
+            entry.token = tokens[fields[0].first].text;
+        }
+        size_t procBegin = fields[1].first;
+        while (procBegin < fields[1].second && tokens[procBegin].text == "&") {
+            ++procBegin;
+        }
+        entry.proc = joinTokens(tokens, procBegin, fields[1].second);
+        if (entry.token.empty() && (entry.proc.empty() || entry.proc == "0" || entry.proc == "NULL")) {
+            break;  // end of table
+        }
+        if (fields.size() > 2) {
+            entry.userData.assign(tokens.begin() + fields[2].first, tokens.begin() + fields[2].second);
+        }
+        table.entries.push_back(std::move(entry));
+    }
+
+    size_t split = name.rfind("::");
+    tablesByName_[split == std::string::npos ? name : name.substr(split + 2)].push_back(tables_.size());
+    tables_.push_back(std::move(table));
+    return close;
+}
+
+size_t Extractor::parseNameList(size_t fileIndex, size_t open, const std::string& name, bool lookup) {
+    const auto& tokens = files_[fileIndex].tokens;
+    size_t close = matching(tokens, open);
+
+    NameList list;
+    list.name = name;
+    list.lookup = lookup;
+
+    // BitFlags name lists are defined as "Type::s_bitNameList"
+    const std::string bitNames = "::s_bitNameList";
+    if (list.name.size() > bitNames.size() &&
+        list.name.compare(list.name.size() - bitNames.size(), bitNames.size(), bitNames) == 0) {
+        list.name.erase(list.name.size() - bitNames.size());
+    }
+
+    for (size_t i = open + 1; i < close; ++i) {
+        if (tokens[i].kind == TokenKind::String) {
+            list.names.push_back(tokens[i].text);
+            if (lookup) {
+                // Skip the value
+                while (i < close && tokens[i].text != "}") {
+                    ++i;
+                }
+            }
+        }
+    }
+    if (!list.names.empty()) {
+        lists_[list.name] = std::move(list);
+    }
+    return close;
+}
+
+// "getReskinFieldParse" -> {"get", "Reskin", "Field", "Parse"}
+static std::vector<std::string> camelWords(const std::string& identifier) {
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : identifier) {
+        bool upper = c >= 'A' && c <= 'Z';
+        if ((upper || c == '_') && !word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+        if (c != '_') {
+            word += c;
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+std::vector<size_t> Extractor::findFunctions(const std::string& cls, const std::string& name) const {
+    std::vector<size_t> result;
+    auto it = functionsByName_.find(name);
+    if (it == functionsByName_.end()) {
+        return result;
+    }
+    for (size_t fn : it->second) {
+        if (cls.empty() || functions_[fn].cls == cls) {
+            result.push_back(fn);
+        }
+    }
+    return result;
+}
+
+const Table* Extractor::findTable(size_t fn, const std::string& name) const {
+    size_t split = name.rfind("::");
+    std::string shortName = split == std::string::npos ? name : name.substr(split + 2);
+    std::string qualifier = split == std::string::npos ? "" : name.substr(0, split);
+
+    auto it = tablesByName_.find(shortName);
+    if (it == tablesByName_.end()) {
+        return nullptr;
+    }
+
+    const Function* function = fn != SIZE_MAX ? &functions_[fn] : nullptr;
+    const Table* best = nullptr;
+    int bestScore = -1;
+    for (size_t index : it->second) {
+        const Table& table = tables_[index];
+        int score = 0;
+        if (function && table.scope == function->cls + "::" + function->name) {
+            score = 3;  // local to the referencing function
+        } else if (!table.scope.empty()) {
+            continue;   // local to another function
+        } else if (!qualifier.empty() && table.name == name) {
+            score = 2;
+        } else if (function && table.name == function->cls + "::" + shortName) {
+            score = 2;
+        } else {
+            score = 1;
+        }
+        if (score > bestScore) {
+            best = &table;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+std::string Extractor::variableType(size_t fn, const std::string& variable) const {
+    const Function& function = functions_[fn];
+    const auto& tokens = files_[function.file].tokens;
+    for (size_t i = function.params + 1; i < function.end; ++i) {
+        if (tokens[i].text != variable || tokens[i].kind != TokenKind::Identifier) {
+            continue;
+        }
+        size_t j = i;
+        while (j > function.params && (tokens[j - 1].text == "*" || tokens[j - 1].text == "&" ||
+                                        tokens[j - 1].text == "const")) {
+            --j;
+        }
+        if (j > function.params && tokens[j - 1].kind == TokenKind::Identifier && !isKeyword(tokens[j - 1].text)) {
+            return tokens[j - 1].text;
+        }
+    }
+    auto global = globals_.find(variable);
+    return global != globals_.end() ? global->second : "";
+}
+
+bool Extractor::resolveExpression(size_t fn, size_t begin, size_t end, Parts& parts) {
+    const Function& function = functions_[fn];
+    const auto& tokens = files_[function.file].tokens;
+
+    // Drop casts and address-of operators
+    while (begin < end && (tokens[begin].text == "&" || tokens[begin].text == "(")) {
+        if (tokens[begin].text == "(") {
+            size_t close = matching(tokens, begin);
+            if (close >= end) {
+                break;
+            }
+            begin = close + 1;
+        } else {
+            ++begin;
+        }
+    }
+    if (begin >= end) {
+        return false;
+    }
+
+    // Find a getter or builder call in the expression
+    for (size_t i = begin; i < end; ++i) {
+        const std::string& text = tokens[i].text;
+        bool builder = text == "buildFieldParse";
+        bool getter = !builder && text.find("FieldParse") != std::string::npos && i + 1 < end &&
+                      tokens[i + 1].text == "(";
+        if (!getter && !builder) {
+            continue;
+        }
+        std::string cls;
+        if (i >= 2 && tokens[i - 1].text == "::") {
+            cls = tokens[i - 2].text;
+        } else if (i >= 2 && (tokens[i - 1].text == "->" || tokens[i - 1].text == ".")) {
+            cls = variableType(fn, tokens[i - 2].text);
+        } else {
+            cls = function.cls;
+        }
+        if (cls.empty()) {
+            return false;
+        }
+        if (builder) {
+            return resolveClass(cls, parts);
+        }
+        for (size_t getterFn : findFunctions(cls, text)) {
+            if (resolveFunctionInit(getterFn, parts, 0)) {
+                return true;
+            }
+        }
+        // A pure virtual getter on an interface is implemented by the concrete class
+        for (const auto& entry : classes_) {
+            const auto& bases = entry.second.bases;
+            if (std::find(bases.begin(), bases.end(), cls) == bases.end()) {
+                continue;
+            }
+            for (size_t getterFn : findFunctions(entry.first, text)) {
+                if (resolveFunctionInit(getterFn, parts, 0)) {
+                    return true;
+                }
+            }
+        }
+        return resolveClass(cls, parts);
+    }
+
+    // A table named directly
+    size_t nameBegin = 0;
+    std::string name = qualifiedNameBefore(tokens, end, nameBegin);
+    if (!name.empty() && nameBegin == begin) {
+        if (const Table* table = findTable(fn, name)) {
+            parts.push_back(static_cast<size_t>(table - tables_.data()));
+            return true;
+        }
+        // A MultiIniFieldParse the function fills itself (the ObjectCreationList nuggets)
+        if (variableType(fn, name) == "MultiIniFieldParse") {
+            size_t before = parts.size();
+            walkBuildFieldParse(fn, parts);
+            return parts.size() > before;
+        }
+    }
+    return false;
+}
+
+void Extractor::walkBuildFieldParse(size_t fn, Parts& parts) {
+    const Function& function = functions_[fn];
+    const auto& tokens = files_[function.file].tokens;
+    for (size_t i = function.begin; i < function.end; ++i) {
+        // Base::buildFieldParse(p)
+        if (tokens[i].text == "buildFieldParse" && i >= 2 && tokens[i - 1].text == "::" &&
+            i + 1 < function.end && tokens[i + 1].text == "(") {
+            resolveClass(tokens[i - 2].text, parts);
+            continue;
+        }
+        // p.add(table[, offset])
+        if (tokens[i].text == "add" && i >= 1 && (tokens[i - 1].text == "." || tokens[i - 1].text == "->") &&
+            i + 1 < function.end && tokens[i + 1].text == "(") {
+            size_t close = matching(tokens, i + 1);
+            size_t argumentEnd = i + 2;
+            int depth = 0;
+            for (; argumentEnd < close; ++argumentEnd) {
+                const std::string& text = tokens[argumentEnd].text;
+                if (text == "(") {
+                    ++depth;
+                } else if (text == ")") {
+                    --depth;
+                } else if (text == "," && depth == 0) {
+                    break;
+                }
+            }
+            resolveExpression(fn, i + 2, argumentEnd, parts);
+            i = close;
+        }
+    }
+}
+
+// Find the FieldParse table a function hands to INI::initFromINI (or returns),
+// following calls to other parse functions
+bool Extractor::resolveFunctionInit(size_t fn, Parts& parts, int depth) {
+    const Function& function = functions_[fn];
+    const auto& tokens = files_[function.file].tokens;
+
+    if (function.name == "buildFieldParse") {
+        walkBuildFieldParse(fn, parts);
+        return true;
+    }
+
+    // Candidate table expressions: initFromINI* second arguments and returned getters
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t i = function.begin; i < function.end; ++i) {
+        const std::string& text = tokens[i].text;
+        bool init = text == "initFromINI" || text == "initFromINIMulti" || text == "initFromINIMultiProc";
+        if (init && i + 1 < function.end && tokens[i + 1].text == "(") {
+            size_t close = matching(tokens, i + 1);
+            size_t comma = i + 2;
+            int level = 0;
+            for (; comma < close; ++comma) {
+                if (tokens[comma].text == "(") {
+                    ++level;
+                } else if (tokens[comma].text == ")") {
+                    --level;
+                } else if (tokens[comma].text == "," && level == 0) {
+                    break;
+                }
+            }
+            size_t argumentEnd = comma + 1;
+            level = 0;
+            for (; argumentEnd < close; ++argumentEnd) {
+                if (tokens[argumentEnd].text == "(") {
+                    ++level;
+                } else if (tokens[argumentEnd].text == ")") {
+                    --level;
+                } else if (tokens[argumentEnd].text == "," && level == 0) {
+                    break;
+                }
+            }
+            if (comma < close) {
+                candidates.emplace_back(comma + 1, argumentEnd);
+            }
+        }
+        if (text == "return" && function.name.find("FieldParse") != std::string::npos) {
+            size_t end = i + 1;
+            while (end < function.end && tokens[end].text != ";") {
+                ++end;
+            }
+            candidates.emplace_back(i + 1, end);
+        }
+    }
+
+    // A function that serves several blocks (Object and ObjectReskin) picks the
+    // site whose distinguishing words appear in the block's parse function name
+    if (candidates.size() > 1 && !procHint_.empty()) {
+        std::vector<std::set<std::string>> words(candidates.size());
+        std::map<std::string, int> counts;
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            for (size_t i = candidates[c].first; i < candidates[c].second; ++i) {
+                if (tokens[i].kind == TokenKind::Identifier) {
+                    for (const auto& word : camelWords(tokens[i].text)) {
+                        words[c].insert(word);
+                    }
+                }
+            }
+            for (const auto& word : words[c]) {
+                ++counts[word];
+            }
+        }
+        std::set<std::string> hintWords;
+        for (const auto& word : camelWords(procHint_)) {
+            hintWords.insert(word);
+        }
+        std::vector<int> scores(candidates.size(), 0);
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            for (const auto& word : words[c]) {
+                if (counts[word] == 1) {
+                    scores[c] += hintWords.count(word) ? 1 : -1;
+                }
+            }
+        }
+        std::vector<size_t> order(candidates.size());
+        for (size_t c = 0; c < order.size(); ++c) {
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] > scores[b]; });
+        std::vector<std::pair<size_t, size_t>> sorted;
+        for (size_t c : order) {
+            sorted.push_back(candidates[c]);
+        }
+        candidates = std::move(sorted);
+    }
+    for (const auto& candidate : candidates) {
+        if (resolveExpression(fn, candidate.first, candidate.second, parts)) {
+            return true;
+        }
+    }
+
+    // Follow calls to the parse functions this one delegates to
+    if (depth >= 3) {
+        return false;
+    }
+    for (size_t i = function.begin; i < function.end; ++i) {
+        if (tokens[i].kind != TokenKind::Identifier || i + 1 >= function.end || tokens[i + 1].text != "(") {
+            continue;
+        }
+        const std::string& name = tokens[i].text;
+        bool delegate = name == function.name || name.find("Definition") != std::string::npos ||
+                        name.rfind("friend_parse", 0) == 0 || name.rfind("parse", 0) == 0;
+        if (!delegate) {
+            continue;
+        }
+        std::string cls = i >= 2 && tokens[i - 1].text == "::" ? tokens[i - 2].text : "";
+        for (size_t callee : findFunctions(cls, name)) {
+            if (callee != fn && resolveFunctionInit(callee, parts, depth + 1)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Extractor::resolveClass(const std::string& cls, Parts& parts) {
+    std::string key = "class " + cls;
+    auto cached = resolved_.find(key);
+    if (cached != resolved_.end()) {
+        parts.insert(parts.end(), cached->second.second.begin(), cached->second.second.end());
+        return cached->second.first;
+    }
+    if (!resolving_.insert(key).second) {
+        return false;
+    }
+
+    // A buildFieldParse chain, a FieldParse getter, or the same from a base class
+    Parts result;
+    bool found = false;
+    for (size_t fn : findFunctions(cls, "buildFieldParse")) {
+        walkBuildFieldParse(fn, result);
+        found = true;
+        break;
+    }
+    if (!found) {
+        for (const char* getter : {"getFieldParse", "friend_getFieldParse"}) {
+            for (size_t fn : findFunctions(cls, getter)) {
+                if (resolveFunctionInit(fn, result, 0)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                break;
+            }
+        }
+    }
+    auto it = classes_.find(cls);
+    if (!found && it != classes_.end()) {
+        for (const auto& base : it->second.bases) {
+            if (resolveClass(base, result)) {
+                found = true;
+                break;
+            }
+        }
+    }
+
+
+    resolving_.erase(key);
+    resolved_[key] = {found, result};
+    parts.insert(parts.end(), result.begin(), result.end());
+    return found;
+}
+
+bool Extractor::resolveProc(const std::string& proc, Parts& parts) {
+    std::string key = "proc " + proc;
+    auto cached = resolved_.find(key);
+    if (cached != resolved_.end()) {
+        parts = cached->second.second;
+        return cached->second.first;
+    }
+    if (!resolving_.insert(key).second) {
+        return false;
+    }
+
+    size_t split = proc.rfind("::");
+    std::string name = split == std::string::npos ? proc : proc.substr(split + 2);
+    std::string cls = split == std::string::npos ? "" : proc.substr(0, split);
+    size_t clsSplit = cls.rfind("::");
+    if (clsSplit != std::string::npos) {
+        cls = cls.substr(clsSplit + 2);
+    }
+
+    Parts result;
+    bool found = false;
+    std::string outerHint = procHint_;
+    procHint_ = name;
+    for (size_t fn : findFunctions(cls, name)) {
+        if (resolveFunctionInit(fn, result, 0)) {
+            found = true;
+            break;
+        }
+    }
+    procHint_ = outerHint;
+
+    resolving_.erase(key);
+    resolved_[key] = {found, result};
+    parts = result;
+    return found;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Schema assembly
+// ------------------------------------------------------------------------------------------------
+
+struct ProcInfo {
+    const char* kind;
+    const char* reference;  // referenced top-level block type
+    const char* list;       // name list the proc always uses
+};
+
+// Field parse procs of INI.h and friends, by the kind of value they read
+const std::map<std::string, ProcInfo>& knownProcs() {
+    static const std::map<std::string, ProcInfo> procs = {
+        {"INI::parseBool", {"Bool", "", ""}},
+        {"INI::parseInt", {"Int", "", ""}},
+        {"INI::parseShort", {"Int", "", ""}},
+        {"INI::parseUnsignedByte", {"UnsignedInt", "", ""}},
+        {"INI::parseUnsignedShort", {"UnsignedInt", "", ""}},
+        {"INI::parseUnsignedInt", {"UnsignedInt", "", ""}},
+        {"INI::parseDurationUnsignedInt", {"UnsignedInt", "", ""}},
+        {"INI::parseDurationUnsignedShort", {"UnsignedInt", "", ""}},
+        {"INI::parseReal", {"Real", "", ""}},
+        {"INI::parsePositiveNonZeroReal", {"Real", "", ""}},
+        {"INI::parseVelocityReal", {"Real", "", ""}},
+        {"INI::parseAccelerationReal", {"Real", "", ""}},
+        {"INI::parseAngleReal", {"Real", "", ""}},
+        {"INI::parseAngularVelocityReal", {"Real", "", ""}},
+        {"INI::parseDurationReal", {"Real", "", ""}},
+        {"INI::parsePercentToReal", {"Percent", "", ""}},
+        {"INI::parseAsciiString", {"String", "", ""}},
+        {"INI::parseQuotedAsciiString", {"String", "", ""}},
+        {"INI::parseAsciiStringVector", {"String", "", ""}},
+        {"INI::parseAsciiStringVectorAppend", {"String", "", ""}},
+        {"INI::parseAndTranslateLabel", {"Label", "", ""}},
+        {"INI::parseRGBColor", {"Color", "", ""}},
+        {"INI::parseRGBAColorInt", {"Color", "", ""}},
+        {"INI::parseColorInt", {"Color", "", ""}},
+        {"INI::parseCoord2D", {"Coord2D", "", ""}},
+        {"INI::parseICoord2D", {"Coord2D", "", ""}},
+        {"INI::parseCoord3D", {"Coord3D", "", ""}},
+        {"INI::parseIndexList", {"Index", "", ""}},
+        {"INI::parseByteSizedIndexList", {"Index", "", ""}},
+        {"INI::parseLookupList", {"Lookup", "", ""}},
+        {"INI::parseBitString8", {"BitString", "", ""}},
+        {"INI::parseBitString32", {"BitString", "", ""}},
+        {"INI::parseDamageTypeFlags", {"FlagSet", "", "DamageTypeFlags"}},
+        {"INI::parseDeathTypeFlags", {"FlagSet", "", "TheDeathNames"}},
+        {"INI::parseVeterancyLevelFlags", {"FlagSet", "", "TheVeterancyNames"}},
+        {"INI::parseMappedImage", {"Reference", "MappedImage", ""}},
+        {"INI::parseAnim2DTemplate", {"Reference", "Animation", ""}},
+        {"INI::parseAudioEventRTS", {"Reference", "AudioEvent", ""}},
+        {"INI::parseDynamicAudioEventRTS", {"Reference", "AudioEvent", ""}},
+        {"INI::parseFXList", {"Reference", "FXList", ""}},
+        {"INI::parseParticleSystemTemplate", {"Reference", "ParticleSystem", ""}},
+        {"INI::parseObjectCreationList", {"Reference", "ObjectCreationList", ""}},
+        {"INI::parseSpecialPowerTemplate", {"Reference", "SpecialPower", ""}},
+        {"INI::parseUpgradeTemplate", {"Reference", "Upgrade", ""}},
+        {"INI::parseScience", {"Reference", "Science", ""}},
+        {"INI::parseScienceVector", {"Reference", "Science", ""}},
+        {"INI::parseThingTemplate", {"Reference", "Object", ""}},
+        {"INI::parseArmorTemplate", {"Reference", "Armor", ""}},
+        {"INI::parseDamageFX", {"Reference", "DamageFX", ""}},
+        {"INI::parseWeaponTemplate", {"Reference", "Weapon", ""}},
+        {"CommandSet::parseCommandButton", {"Reference", "CommandButton", ""}},
+        {"ThingTemplate::parseModuleName", {"Module", "", ""}},
+    };
+    return procs;
+}
+
+// Block procs that read a value on the field's line instead for some user
+// data, by proc and user data.
+// W3DModelDrawModuleData::parseConditionState returns before
+// initFromINI for PARSE_ALIAS.
+const std::map<std::pair<std::string, std::string>, ProcInfo>& valueModes() {
+    static const std::map<std::pair<std::string, std::string>, ProcInfo> modes = {
+        {{"W3DModelDrawModuleData::parseConditionState", "PARSE_ALIAS"}, {"BitFlags", "", "ModelConditionFlags"}},
+    };
+    return modes;
+}
+
+const ProcInfo* valueMode(const Entry& entry) {
+    for (const Token& token : entry.userData) {
+        auto it = valueModes().find({entry.proc, token.text});
+        if (it != valueModes().end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+// Fields read with parseAsciiString whose value the game later passes to
+// TheGameText->fetch, by table; they are labels as much as those read with
+// parseAndTranslateLabel
+const std::set<std::pair<std::string, std::string>>& translatedStrings() {
+    static const std::set<std::pair<std::string, std::string>> fields = {
+        {"CommandButton", "TextLabel"},
+        {"CommandButton", "DescriptLabel"},
+        {"CommandButton", "PurchasedLabel"},
+        {"CommandButton", "ConflictingLabel"},
+        {"Upgrade", "DisplayName"},
+        {"BattlePlanUpdateModuleData", "BombardmentMessageLabel"},
+        {"BattlePlanUpdateModuleData", "SearchAndDestroyMessageLabel"},
+        {"BattlePlanUpdateModuleData", "HoldTheLineMessageLabel"},
+        {"Campaign", "CampaignNameLabel"},
+        {"Mission", "ObjectiveLine0"},
+        {"Mission", "ObjectiveLine1"},
+        {"Mission", "ObjectiveLine2"},
+        {"Mission", "ObjectiveLine3"},
+        {"Mission", "ObjectiveLine4"},
+        {"Mission", "UnitNames0"},
+        {"Mission", "UnitNames1"},
+        {"Mission", "UnitNames2"},
+        {"Mission", "LocationNameLabel"},
+    };
+    return fields;
+}
+
+// Name list referenced by an entry's user data, or the hint
+std::string Extractor::listFor(const Entry& entry, const std::string& hint) const {
+    if (!hint.empty()) {
+        return lists_.count(hint) ? hint : "";
+    }
+    // "Type::getBitNames()" names a BitFlags list
+    for (size_t i = 0; i + 2 < entry.userData.size(); ++i) {
+        if (entry.userData[i + 1].text == "::" && entry.userData[i + 2].text == "getBitNames" &&
+            lists_.count(entry.userData[i].text)) {
+            return entry.userData[i].text;
+        }
+    }
+    for (auto it = entry.userData.rbegin(); it != entry.userData.rend(); ++it) {
+        if (it->kind == TokenKind::Identifier && lists_.count(it->text)) {
+            return it->text;
+        }
+    }
+    return "";
+}
+
+size_t Extractor::tableFor(const std::string& name, const Parts& parts) {
+    std::string key;
+    for (size_t part : parts) {
+        key += std::to_string(part) + ",";
+    }
+    auto it = outTableByParts_.find(key);
+    if (it != outTableByParts_.end()) {
+        return it->second;
+    }
+    size_t index = outTables_.size();
+    outTableByParts_[key] = index;
+    outTables_.push_back(OutTable{name, {}, false});
+    outTableParts_.push_back(parts);
+    return index;
+}
+
+void Extractor::classifyFields(size_t tableIndex) {
+    Parts parts = outTableParts_[tableIndex];
+    std::vector<OutField> fields;
+    std::set<std::string> seen;
+    bool acceptsAnyField = false;
+
+    for (size_t part : parts) {
+        for (const Entry& entry : tables_[part].entries) {
+            if (entry.token.empty()) {
+                acceptsAnyField = true;
+                continue;
+            }
+            // MultiIniFieldParse searches its tables in order, so the first definition wins
+            if (!seen.insert(entry.token).second) {
+                continue;
+            }
+
+            OutField field;
+            field.token = entry.token;
+            field.proc = entry.proc;
+            field.kind = "Custom";
+
+            auto known = knownProcs().find(entry.proc);
+            size_t split = entry.proc.rfind("::");
+            std::string procClass = split == std::string::npos ? "" : entry.proc.substr(0, split);
+            std::string procName = split == std::string::npos ? entry.proc : entry.proc.substr(split + 2);
+
+            if (const ProcInfo* mode = valueMode(entry)) {
+                field.kind = mode->kind;
+                field.list = listFor(entry, mode->list);
+            } else if (known != knownProcs().end()) {
+                field.kind = known->second.kind;
+                field.reference = known->second.reference;
+                if (field.kind == "Index" || field.kind == "Lookup" || field.kind == "BitString" ||
+                    field.kind == "FlagSet") {
+                    field.list = listFor(entry, known->second.list);
+                }
+                if (field.kind == "String" && translatedStrings().count({outTables_[tableIndex].name, field.token})) {
+                    field.kind = "Label";
+                }
+            } else if (procName == "parseFromINI" && lists_.count(procClass)) {
+                field.kind = "BitFlags";
+                field.list = procClass;
+            } else if (procName == "parseSingleBitFromINI" && lists_.count(procClass)) {
+                field.kind = "Index";
+                field.list = procClass;
+            } else {
+                Parts nested;
+                if (resolveProc(entry.proc, nested)) {
+                    field.kind = "Block";
+                    field.table = static_cast<int>(tableFor(entry.token, nested));
+                }
+            }
+            fields.push_back(std::move(field));
+        }
+    }
+
+    outTables_[tableIndex].fields = std::move(fields);
+    outTables_[tableIndex].acceptsAnyField = acceptsAnyField;
+}
+
+void Extractor::finish() {
+    for (const auto& block : blockProcs_) {
+        OutBlock out{block.first, block.second, -1};
+        Parts parts;
+        if (resolveProc(block.second, parts)) {
+            out.table = static_cast<int>(tableFor(block.first, parts));
+        }
+        outBlocks_.push_back(out);
+    }
+
+    std::set<std::string> seenModules;
+    for (const auto& name : moduleNames_) {
+        if (!seenModules.insert(name).second) {
+            continue;
+        }
+        OutModule out{name, "", "Behavior", -1};
+
+        // Walk up the class hierarchy for the module data class and module type
+        std::string cls = name;
+        std::set<std::string> visited;
+        while (!cls.empty() && visited.insert(cls).second) {
+            auto it = classes_.find(cls);
+            if (it == classes_.end()) {
+                break;
+            }
+            if (out.dataClass.empty()) {
+                out.dataClass = it->second.dataClass;
+            }
+            if (!it->second.moduleType.empty()) {
+                const std::string& type = it->second.moduleType;
+                out.type = type == "MODULETYPE_DRAW" ? "Draw" : type == "MODULETYPE_CLIENT_UPDATE" ? "ClientUpdate" : "Behavior";
+                if (!out.dataClass.empty()) {
+                    break;
+                }
+            }
+            cls = it->second.bases.empty() ? "" : it->second.bases.front();
+        }
+
+        // MAKE_STANDARD_MODULE_MACRO modules use the plain ModuleData
+        if (out.dataClass.empty()) {
+            out.dataClass = "ModuleData";
+        }
+
+        Parts parts;
+        if (resolveClass(out.dataClass, parts)) {
+            out.table = static_cast<int>(tableFor(out.dataClass, parts));
+        }
+        outModules_.push_back(out);
+    }
+
+    // Classifying fields can discover nested tables; keep going until none are new
+    for (size_t i = 0; i < outTables_.size(); ++i) {
+        classifyFields(i);
+    }
+
+    std::sort(outBlocks_.begin(), outBlocks_.end(),
+              [](const OutBlock& a, const OutBlock& b) { return a.name < b.name; });
+    std::sort(outModules_.begin(), outModules_.end(),
+              [](const OutModule& a, const OutModule& b) { return a.name < b.name; });
+}
+
+void Extractor::printSummary() const {
+    size_t blocks = 0;
+    for (const auto& block : outBlocks_) {
+        blocks += block.table >= 0;
+    }
+    size_t modules = 0;
+    for (const auto& module : outModules_) {
+        modules += module.table >= 0;
+    }
+    size_t fields = 0;
+    for (const auto& table : outTables_) {
+        fields += table.fields.size();
+    }
+    std::cout << "INI schema: " << blocks << "/" << outBlocks_.size() << " blocks and " << modules << "/"
+              << outModules_.size() << " modules resolved, " << outTables_.size() << " tables, " << fields
+              << " fields from " << files_.size() << " files\n";
+    for (const auto& block : outBlocks_) {
+        if (block.table < 0) {
+            std::cout << "  unresolved block " << block.name << " (" << block.proc << ")\n";
+        }
+    }
+    for (const auto& module : outModules_) {
+        if (module.table < 0) {
+            std::cout << "  unresolved module " << module.name << "\n";
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Perfect hashing
+// ------------------------------------------------------------------------------------------------
+
+// Hash-and-displace index over keys, ignoring case: keys go into buckets by
+// schemaHash(key, 0); the largest buckets are placed first by searching a
+// seed that sends all their keys to free positions, and single-key buckets
+// take the remaining positions directly. A slot holds one key, so keys
+// equal ignoring case cannot share an index: a later one would never be
+// found. Such keys are reported to collisions and left out.
+std::vector<ZeroSyntax::Ini::HashSlot> buildHash(const std::vector<std::string>& keys,
+                                                 std::vector<std::pair<std::string, std::string>>& collisions) {
+    using ZeroSyntax::Ini::hashPosition;
+    using ZeroSyntax::Ini::schemaHash;
+
+    uint32_t size = static_cast<uint32_t>(keys.size());
+    std::vector<ZeroSyntax::Ini::HashSlot> slots(size, {0, ZeroSyntax::Ini::kNoIndex});
+    std::vector<std::vector<uint16_t>> buckets(size);
+    std::map<std::string, size_t> seen;  // folded key -> first key
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string lower = keys[i];
+        std::transform(lower.begin(), lower.end(), lower.begin(), ZeroSyntax::Ini::asciiLower);
+        auto inserted = seen.emplace(lower, i);
+        if (inserted.second) {
+            buckets[hashPosition(schemaHash(keys[i], 0), size)].push_back(static_cast<uint16_t>(i));
+        } else {
+            collisions.emplace_back(keys[inserted.first->second], keys[i]);
+        }
+    }
+
+    std::vector<uint32_t> order(size);
+    for (uint32_t b = 0; b < size; ++b) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<bool> used(size, false);
+    std::vector<uint32_t> positions;
+    for (uint32_t b : order) {
+        const auto& bucket = buckets[b];
+        if (bucket.size() < 2) {
+            break;
+        }
+        for (uint32_t seed = 1;; ++seed) {
+            positions.clear();
+            for (uint16_t key : bucket) {
+                uint32_t position = hashPosition(schemaHash(keys[key], seed), size);
+                if (used[position] || std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                    break;
+                }
+                positions.push_back(position);
+            }
+            if (positions.size() == bucket.size()) {
+                for (size_t k = 0; k < bucket.size(); ++k) {
+                    used[positions[k]] = true;
+                    slots[positions[k]].entry = bucket[k];
+                }
+                slots[b].displacement = static_cast<int32_t>(seed);
+                break;
+            }
+        }
+    }
+
+    uint32_t free = 0;
+    for (uint32_t b : order) {
+        if (buckets[b].size() != 1) {
+            continue;
+        }
+        while (used[free]) {
+            ++free;
+        }
+        used[free] = true;
+        slots[free].entry = buckets[b].front();
+        slots[b].displacement = -static_cast<int32_t>(free) - 1;
+    }
+    return slots;
+}
+
+// Append the slots of one set to a generated HashSlot array; false, with
+// the colliding keys reported, when two keys are equal ignoring case
+bool writeHash(std::ostream& out, const std::string& comment, const std::vector<std::string>& keys) {
+    if (keys.empty()) {
+        return true;
+    }
+    out << "    // " << comment << "\n";
+    std::vector<std::pair<std::string, std::string>> collisions;
+    for (const auto& slot : buildHash(keys, collisions)) {
+        out << "    {" << slot.displacement << ", "
+            << (slot.entry == ZeroSyntax::Ini::kNoIndex ? std::string("kNoIndex") : std::to_string(slot.entry))
+            << "},\n";
+    }
+    for (const auto& collision : collisions) {
+        std::cerr << comment << ": '" << collision.second << "' equals '" << collision.first
+                  << "' ignoring case; the perfect hash cannot index both\n";
+    }
+    return collisions.empty();
+}
+
+std::string quote(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+bool Extractor::write(const std::string& output) const {
+    // Lists used by at least one field, in name order
+    std::map<std::string, size_t> listIndex;
+    for (const auto& table : outTables_) {
+        for (const auto& field : table.fields) {
+            if (!field.list.empty()) {
+                listIndex[field.list] = 0;
+            }
+        }
+    }
+    size_t next = 0;
+    for (auto& entry : listIndex) {
+        entry.second = next++;
+    }
+
+    std::ostringstream out;
+    out << "// Generated by ZS_SchemaExtractor from the engine's FieldParse tables. Do not edit.\n"
+        << "#pragma once\n\n"
+        << "#include \"ini/ini_schema.hpp\"\n\n"
+        << "namespace ZeroSyntax {\nnamespace Ini {\nnamespace SchemaData {\n\n";
+
+    out << "constexpr std::string_view kListNames[] = {\n";
+    for (const auto& entry : listIndex) {
+        out << "    // " << entry.first << "\n";
+        for (const auto& name : lists_.at(entry.first).names) {
+            out << "    " << quote(name) << ",\n";
+        }
+    }
+    if (listIndex.empty()) {
+        out << "    \"\",\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr NameList kLists[] = {\n";
+    size_t firstName = 0;
+    for (const auto& entry : listIndex) {
+        const NameList& list = lists_.at(entry.first);
+        out << "    {" << quote(entry.first) << ", " << (list.lookup ? "true" : "false") << ", " << firstName << ", "
+            << list.names.size() << "},\n";
+        firstName += list.names.size();
+    }
+    if (listIndex.empty()) {
+        out << "    {\"\", false, 0, 0},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr FieldSchema kFields[] = {\n";
+    size_t fieldCount = 0;
+    for (const auto& table : outTables_) {
+        out << "    // " << table.name << "\n";
+        for (const auto& field : table.fields) {
+            out << "    {" << quote(field.token) << ", FieldKind::" << field.kind << ", " << quote(field.proc) << ", "
+                << (field.list.empty() ? std::string("kNoIndex") : std::to_string(listIndex.at(field.list))) << ", "
+                << (field.table < 0 ? std::string("kNoIndex") : std::to_string(field.table)) << ", "
+                << quote(field.reference) << "},\n";
+            ++fieldCount;
+        }
+    }
+    if (fieldCount == 0) {
+        out << "    {\"\", FieldKind::Custom, \"\", kNoIndex, kNoIndex, \"\"},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr FieldTable kTables[] = {\n";
+    size_t firstField = 0;
+    for (const auto& table : outTables_) {
+        out << "    {" << quote(table.name) << ", " << firstField << ", " << table.fields.size() << ", "
+            << (table.acceptsAnyField ? "true" : "false") << "},\n";
+        firstField += table.fields.size();
+    }
+    if (outTables_.empty()) {
+        out << "    {\"\", 0, 0, false},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr BlockSchema kBlocks[] = {\n";
+    for (const auto& block : outBlocks_) {
+        out << "    {" << quote(block.name) << ", " << quote(block.proc) << ", "
+            << (block.table < 0 ? std::string("kNoIndex") : std::to_string(block.table)) << "},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr ModuleSchema kModules[] = {\n";
+    for (const auto& module : outModules_) {
+        out << "    {" << quote(module.name) << ", " << quote(module.dataClass) << ", ModuleType::" << module.type << ", "
+            << (module.table < 0 ? std::string("kNoIndex") : std::to_string(module.table)) << "},\n";
+    }
+    out << "};\n\n";
+
+    // Perfect-hash indexes, parallel to kListNames, kFields, kBlocks and kModules
+    bool hashed = true;
+    out << "constexpr HashSlot kListNameHash[] = {\n";
+    for (const auto& entry : listIndex) {
+        hashed &= writeHash(out, entry.first, lists_.at(entry.first).names);
+    }
+    if (listIndex.empty()) {
+        out << "    {0, kNoIndex},\n";
+    }
+    out << "};\n\n";
+
+    out << "constexpr HashSlot kFieldHash[] = {\n";
+    for (const auto& table : outTables_) {
+        std::vector<std::string> tokens;
+        for (const auto& field : table.fields) {
+            tokens.push_back(field.token);
+        }
+        hashed &= writeHash(out, table.name, tokens);
+    }
+    if (fieldCount == 0) {
+        out << "    {0, kNoIndex},\n";
+    }
+    out << "};\n\n";
+
+    std::vector<std::string> blockNames;
+    for (const auto& block : outBlocks_) {
+        blockNames.push_back(block.name);
+    }
+    out << "constexpr HashSlot kBlockHash[] = {\n";
+    hashed &= writeHash(out, "theTypeTable", blockNames);
+    out << "};\n\n";
+
+    std::vector<std::string> moduleNames;
+    for (const auto& module : outModules_) {
+        moduleNames.push_back(module.name);
+    }
+    out << "constexpr HashSlot kModuleHash[] = {\n";
+    hashed &= writeHash(out, "ModuleFactory", moduleNames);
+    out << "};\n\n";
+
+    out << "constexpr size_t kListCount = " << listIndex.size() << ";\n"
+        << "constexpr size_t kFieldCount = " << fieldCount << ";\n"
+        << "constexpr size_t kTableCount = " << outTables_.size() << ";\n"
+        << "constexpr size_t kBlockCount = " << outBlocks_.size() << ";\n"
+        << "constexpr size_t kModuleCount = " << outModules_.size() << ";\n\n"
+        << "} // namespace SchemaData\n} // namespace Ini\n} // namespace ZeroSyntax\n";
+
+    if (!hashed) {
+        std::cerr << "names differing only in case; not writing " << output << "\n";
+        return false;
+    }
+
+    // Leave the file untouched when nothing changed so dependents are not rebuilt
+    std::string content = out.str();
+    {
+        std::ifstream existing(output, std::ios::binary);
+        std::stringstream buffer;
+        buffer << existing.rdbuf();
+        if (existing && buffer.str() == content) {
+            return true;
+        }
+    }
+    fs::create_directories(fs::path(output).parent_path());
+    std::ofstream file(output, std::ios::binary);
+    file << content;
+    if (!file) {
+        std::cerr << "cannot write " << output << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <GameCode/Code> <output header>\n";
+        return 2;
+    }
+
+    fs::path root(argv[1]);
+    Extractor extractor;
+    std::vector<fs::path> paths;
+    for (const char* project : {"GameEngine", "GameEngineDevice"}) {
+        fs::path directory = root / project;
+        if (!fs::exists(directory)) {
+            std::cerr << "missing engine sources: " << directory << "\n";
+            return 1;
+        }
+        for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (entry.is_regular_file() && (extension == ".cpp" || extension == ".h")) {
+                paths.push_back(entry.path());
+            }
+        }
+    }
+
+    // Headers first so class declarations are known before their out-of-line members
+    std::sort(paths.begin(), paths.end(), [](const fs::path& a, const fs::path& b) {
+        bool aHeader = a.extension() == ".h";
+        bool bHeader = b.extension() == ".h";
+        return aHeader != bHeader ? aHeader : a < b;
+    });
+    for (const auto& path : paths) {
+        extractor.addFile(path, fs::relative(path, root).generic_string());
+    }
+
+    extractor.finish();
+    extractor.printSummary();
+    if (!extractor.write(argv[2])) {
+        return 1;
+    }
+    return 0;
+}